@@ -0,0 +1,153 @@
+/** Copyright (c) 2011, Edgar Solomonik, all rights reserved.
+  * \addtogroup benchmarks
+  * @{
+  * \addtogroup bench_compare
+  * @{
+  * \brief Compares JSON records written by bench_suite against those of a baseline run,
+  *        exiting with status 1 if any benchmark became slower by more than a tolerance
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+/**
+ * \brief benchmark record, keyed by name and number of processes
+ */
+struct bench_entry {
+  std::string name;
+  int         np;
+  double      time;
+  double      gflops;
+  double      bytes;
+  std::string mapping;
+};
+
+/**
+ * \brief finds the value of field key in the flat JSON object obj
+ * \param[in] obj text of the object without braces
+ * \param[in] key field name
+ * \param[out] val value, without quotes if it is a string
+ * \return whether the field is present
+ */
+bool get_field(std::string const & obj, char const * key, std::string & val){
+  std::string pat = std::string("\"") + key + "\"";
+  size_t pos = obj.find(pat);
+  if (pos == std::string::npos) return false;
+  pos = obj.find(':', pos+pat.size());
+  if (pos == std::string::npos) return false;
+  pos = obj.find_first_not_of(" \t\n\r", pos+1);
+  if (pos == std::string::npos) return false;
+  if (obj[pos] == '"'){
+    size_t end = obj.find('"', pos+1);
+    if (end == std::string::npos) return false;
+    val = obj.substr(pos+1, end-pos-1);
+  } else {
+    size_t end = obj.find_first_of(",}", pos);
+    val = obj.substr(pos, end == std::string::npos ? std::string::npos : end-pos);
+  }
+  return true;
+}
+
+/**
+ * \brief reads the records of a file written by bench_suite
+ * \param[in] fname file name
+ * \param[out] entries records by name and number of processes
+ * \return whether the file could be read
+ */
+bool read_records(char const * fname, std::map<std::pair<std::string,int>, bench_entry> & entries){
+  FILE * f = fopen(fname, "r");
+  if (f == NULL){
+    fprintf(stderr, "bench_compare: cannot open %s\n", fname);
+    return false;
+  }
+  std::string txt;
+  char buf[4096];
+  size_t nr;
+  while ((nr = fread(buf, 1, sizeof(buf), f)) > 0){
+    txt.append(buf, nr);
+  }
+  fclose(f);
+  size_t pos = 0;
+  while ((pos = txt.find('{', pos)) != std::string::npos){
+    size_t end = txt.find('}', pos);
+    if (end == std::string::npos) break;
+    std::string obj = txt.substr(pos+1, end-pos-1);
+    std::string val;
+    bench_entry e;
+    if (get_field(obj, "name", val)){
+      e.name = val;
+      e.np = get_field(obj, "np", val) ? atoi(val.c_str()) : 1;
+      e.time = get_field(obj, "time", val) ? atof(val.c_str()) : 0.;
+      e.gflops = get_field(obj, "gflops", val) ? atof(val.c_str()) : 0.;
+      e.bytes = get_field(obj, "bytes", val) ? atof(val.c_str()) : 0.;
+      e.mapping = get_field(obj, "mapping", val) ? val : "";
+      entries[std::make_pair(e.name, e.np)] = e;
+    }
+    pos = end+1;
+  }
+  return true;
+}
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+int main(int argc, char ** argv){
+  double tol;
+  if (argc < 3){
+    printf("usage: %s baseline.json current.json [-tol 0.1]\n", argv[0]);
+    return 2;
+  }
+  // relative slowdown beyond which a benchmark is reported as a regression
+  if (getCmdOption(argv, argv+argc, "-tol")){
+    tol = atof(getCmdOption(argv, argv+argc, "-tol"));
+    if (tol < 0.) tol = .1;
+  } else tol = .1;
+
+  std::map<std::pair<std::string,int>, bench_entry> base, cur;
+  if (!read_records(argv[1], base) || !read_records(argv[2], cur)) return 2;
+
+  int nreg = 0;
+  printf("%-20s %4s %12s %12s %8s %12s  %s\n", "benchmark", "np", "base [s]", "current [s]", "ratio", "bytes ratio", "mapping");
+  for (std::map<std::pair<std::string,int>, bench_entry>::iterator it=cur.begin(); it!=cur.end(); it++){
+    bench_entry const & c = it->second;
+    std::map<std::pair<std::string,int>, bench_entry>::iterator bit = base.find(it->first);
+    if (bit == base.end()){
+      printf("%-20s %4d %12s %12.4e %8s %12s  %s (new)\n", c.name.c_str(), c.np, "-", c.time, "-", "-", c.mapping.c_str());
+      continue;
+    }
+    bench_entry const & b = bit->second;
+    double ratio = b.time > 0. ? c.time/b.time : 1.;
+    double bratio = b.bytes > 0. ? c.bytes/b.bytes : (c.bytes > 0. ? 2. : 1.);
+    bool is_reg = ratio > 1.+tol;
+    if (is_reg) nreg++;
+    printf("%-20s %4d %12.4e %12.4e %8.3f %12.3f  %s%s%s\n", c.name.c_str(), c.np, b.time, c.time, ratio, bratio,
+           c.mapping.c_str(), c.mapping != b.mapping ? (" (was " + b.mapping + ")").c_str() : "",
+           is_reg ? " REGRESSION" : "");
+  }
+  for (std::map<std::pair<std::string,int>, bench_entry>::iterator it=base.begin(); it!=base.end(); it++){
+    if (cur.find(it->first) == cur.end())
+      printf("%-20s %4d %12.4e %12s %8s %12s  (missing)\n", it->second.name.c_str(), it->second.np, it->second.time, "-", "-", "-");
+  }
+  if (nreg > 0)
+    printf("%d benchmark(s) slower than the baseline by more than %.0lf%%\n", nreg, tol*100.);
+  else
+    printf("no benchmark slower than the baseline by more than %.0lf%%\n", tol*100.);
+  return nreg > 0;
+}
+/**
+ * @}
+ * @}
+ */
+
@@ -0,0 +1,123 @@
+/** Copyright (c) 2011, Edgar Solomonik, all rights reserved.
+  * \addtogroup benchmarks
+  * @{
+  * \addtogroup bench_node_alltoallv
+  * @{
+  * \brief Benchmarks all-to-all-v exchanges through the shared-memory window of a node against
+  *        MPI_Alltoallv, to place CTF::NODE_ALLTOALLV_MIN_BYTES
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <ctf.hpp>
+
+using namespace CTF;
+
+/**
+ * \brief median time of niter all-to-all-v exchanges of m doubles between each pair of ranks
+ * \param[in] dw world whose communicator exchanges
+ * \param[in] m number of doubles sent to each rank
+ * \param[in] niter number of timed exchanges
+ * \param[in] min_bytes value of NODE_ALLTOALLV_MIN_BYTES during the exchanges
+ */
+double time_all_to_allv(World & dw, int64_t m, int niter, int64_t min_bytes){
+  int np = dw.np;
+  std::vector<int64_t> counts(np, m), displs(np);
+  for (int p=0; p<np; p++){
+    displs[p] = p*m;
+  }
+  std::vector<double> sbuf(np*m), rbuf(np*m);
+  for (int64_t i=0; i<np*m; i++){
+    sbuf[i] = dw.rank+.5*i;
+  }
+  int64_t prev_min_bytes = NODE_ALLTOALLV_MIN_BYTES;
+  NODE_ALLTOALLV_MIN_BYTES = min_bytes;
+  std::vector<double> times;
+  //the first exchange grows the shared-memory window and is not timed
+  for (int i=0; i<=niter; i++){
+    MPI_Barrier(dw.comm);
+    double t_st = MPI_Wtime();
+    dw.cdt.all_to_allv(sbuf.data(), counts.data(), displs.data(), sizeof(double),
+                       rbuf.data(), counts.data(), displs.data());
+    double t = MPI_Wtime()-t_st;
+    MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, dw.comm);
+    if (i > 0) times.push_back(t);
+  }
+  NODE_ALLTOALLV_MIN_BYTES = prev_min_bytes;
+  std::sort(times.begin(), times.end());
+  return times[niter/2];
+}
+
+void bench_node_alltoallv(int     max_m,
+                          int     niter,
+                          World & dw){
+  if (dw.cdt.node_cm == MPI_COMM_NULL){
+    if (dw.rank == 0) printf("No two ranks share a node, exchanges use MPI alone\n");
+    return;
+  }
+  if (dw.rank == 0){
+    printf("%d ranks, %d per node, default NODE_ALLTOALLV_MIN_BYTES = %ld\n",
+           dw.np, dw.cdt.ppn, NODE_ALLTOALLV_MIN_BYTES);
+    printf("bytes to node, median sec via MPI, via shared memory, speedup, default path\n");
+  }
+  for (int64_t m=1; m<=max_m; m*=4){
+    int64_t node_bytes = m*dw.cdt.ppn*sizeof(double);
+    double t_mpi = time_all_to_allv(dw, m, niter, INT64_MAX);
+    double t_shm = time_all_to_allv(dw, m, niter, 0);
+    if (dw.rank == 0){
+      printf("%ld %lf %lf %lf %s\n", node_bytes, t_mpi, t_shm, t_mpi/t_shm,
+             node_bytes >= NODE_ALLTOALLV_MIN_BYTES ? "shared memory" : "MPI");
+    }
+  }
+}
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, max_m, niter;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-m")){
+    max_m = atoi(getCmdOption(input_str, input_str+in_num, "-m"));
+    if (max_m < 1) max_m = 1<<18;
+  } else max_m = 1<<18;
+
+  if (getCmdOption(input_str, input_str+in_num, "-niter")){
+    niter = atoi(getCmdOption(input_str, input_str+in_num, "-niter"));
+    if (niter < 1) niter = 11;
+  } else niter = 11;
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+    if (rank == 0){
+      printf("Exchanging up to %d doubles with each rank, %d times per size\n", max_m, niter);
+    }
+    bench_node_alltoallv(max_m, niter, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,260 @@
+/** Copyright (c) 2011, Edgar Solomonik, all rights reserved.
+  * \addtogroup benchmarks
+  * @{
+  * \addtogroup bench_suite
+  * @{
+  * \brief Benchmarks a fixed set of dense, symmetric and sparse contractions, redistribution,
+  *        transposition, slicing, reading and writing, reporting each as a JSON record
+  *        to be compared against a baseline by bench_compare
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <math.h>
+#include <float.h>
+#include <assert.h>
+#include <algorithm>
+#include <functional>
+#include <ctf.hpp>
+#include "../src/shared/util.h"
+
+using namespace CTF;
+
+/**
+ * \brief measurements of one benchmark, all but time are totals over processes per iteration
+ */
+struct bench_record {
+  std::string name;
+  double      time;
+  double      gflops;
+  int64_t     bytes;
+  std::string mapping;
+};
+
+/**
+ * \brief times niter calls of op after a warm-up call
+ * \param[in] name benchmark name
+ * \param[in] niter number of timed iterations
+ * \param[in] op operation to time
+ * \param[in] out tensor whose mapping is reported after the operation, or NULL
+ * \param[in] dw world the operation is collective on
+ */
+bench_record time_op(char const *                  name,
+                     int                           niter,
+                     std::function<void()> const & op,
+                     CTF_int::tensor const *       out,
+                     World &                       dw){
+  op();
+  MPI_Barrier(dw.comm);
+  Flop_counter fc;
+  int64_t bytes = CTF_int::get_comm_bytes();
+  double st_time = MPI_Wtime();
+  for (int i=0; i<niter; i++){
+    op();
+  }
+  MPI_Barrier(dw.comm);
+  double t = (MPI_Wtime()-st_time)/niter;
+  bytes = CTF_int::get_comm_bytes()-bytes;
+
+  bench_record rec;
+  rec.name = name;
+  MPI_Allreduce(&t, &rec.time, 1, MPI_DOUBLE, MPI_MAX, dw.comm);
+  MPI_Allreduce(&bytes, &rec.bytes, 1, MPI_INT64_T, MPI_SUM, dw.comm);
+  rec.bytes /= niter;
+  rec.gflops = (fc.count(dw.comm)/(double)niter)/rec.time*1.E-9;
+  rec.mapping = out == NULL ? "" : out->get_map_str();
+  if (dw.rank == 0){
+    fprintf(stderr, "%-20s %10.4e sec/iter\n", name, rec.time);
+  }
+  return rec;
+}
+
+/**
+ * \brief runs all benchmarks whose name contains filter
+ * \param[in] n problem size, matrices have 4n rows and order 4 tensors n/2 indices per mode
+ * \param[in] niter number of timed iterations of each benchmark
+ * \param[in] filter substring of benchmark names to run, NULL for all
+ * \param[in] dw world to run in
+ * \return records of the benchmarks run
+ */
+std::vector<bench_record> bench_suite(int          n,
+                                      int          niter,
+                                      char const * filter,
+                                      World &      dw){
+  std::vector<bench_record> recs;
+  int m = 4*n;
+  int h = std::max(2, n/2);
+  int np = dw.np;
+#define BENCH(nm, out, ...) \
+  if (filter == NULL || strstr(nm, filter) != NULL) \
+    recs.push_back(time_op(nm, niter, [&](){ __VA_ARGS__; }, out, dw));
+
+  srand48(dw.rank);
+  Matrix<> A(m, m, NS, dw);
+  Matrix<> B(m, m, NS, dw);
+  Matrix<> C(m, m, NS, dw);
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  BENCH("gemm", &C, C["ij"] += A["ik"]*B["kj"]);
+
+  Matrix<> T(m*4, h, NS, dw);
+  Matrix<> W(h, h, NS, dw);
+  T.fill_random(-1., 1.);
+  BENCH("gemm_tall_skinny", &W, W["ij"] += T["ki"]*T["kj"]);
+
+  int sizeN4[] = {h,h,h,h};
+  int shapeN4[] = {NS,NS,NS,NS};
+  Tensor<> A4(4, sizeN4, shapeN4, dw);
+  Tensor<> B4(4, sizeN4, shapeN4, dw);
+  Tensor<> C4(4, sizeN4, shapeN4, dw);
+  A4.fill_random(-1., 1.);
+  B4.fill_random(-1., 1.);
+  BENCH("ctr_order4", &C4, C4["abij"] += A4["abkl"]*B4["klij"]);
+  BENCH("ctr_order4_perm", &C4, C4["abij"] += A4["akbl"]*B4["ljki"]);
+
+  Matrix<> S(m, m, SY, dw);
+  S.fill_random(-1., 1.);
+  BENCH("symm", &C, C["ij"] += S["ik"]*B["kj"]);
+
+  int shapeA4[] = {AS,NS,AS,NS};
+  Tensor<> AS4(4, sizeN4, shapeA4, dw);
+  Tensor<> AS4C(4, sizeN4, shapeA4, dw);
+  AS4.fill_random(-1., 1.);
+  BENCH("ctr_order4_antisym", &AS4C, AS4C["abij"] += AS4["abkl"]*AS4["klij"]);
+
+  Matrix<> SpA(m, m, SP, dw);
+  Matrix<> SpB(m, m, SP, dw);
+  Matrix<> SpC(m, m, SP, dw);
+  SpA.fill_sp_random(-1., 1., .05);
+  SpB.fill_sp_random(-1., 1., .05);
+  BENCH("spmm", &C, C["ij"] += SpA["ik"]*B["kj"]);
+  BENCH("spgemm", &SpC, SpC["ij"] = SpA["ik"]*SpB["kj"]);
+  BENCH("spsum", &SpC, SpC["ij"] += SpA["ij"]);
+
+  Semiring<> trop(DBL_MAX/2,
+                  [](double a, double b){ return std::min(a,b); },
+                  MPI_MIN,
+                  0.,
+                  [](double a, double b){ return a+b; });
+  Matrix<> TA(m, m, SP, dw, trop);
+  Matrix<> TB(m, m, SP, dw, trop);
+  Matrix<> TC(m, m, SP, dw, trop);
+  TA.fill_sp_random(0., 1., .05);
+  TB.fill_sp_random(0., 1., .05);
+  BENCH("spgemm_tropical", &TC, TC["ij"] = TA["ik"]*TB["kj"]);
+
+  int sizeN3[] = {m,m,np};
+  int shapeN3[] = {NS,NS,NS};
+  Partition pe_line(1, &np);
+  Tensor<> R(3, sizeN3, shapeN3, dw, "ijk", pe_line["i"]);
+  R.fill_random(-1., 1.);
+  BENCH("redistribution", &R, {
+    double * data = R.read("ijk", pe_line["k"], Idx_Partition());
+    free(data);
+  });
+
+  int sizeP3[] = {np,m,m};
+  Tensor<> P(3, sizeP3, shapeN3, dw);
+  BENCH("transpose", &P, P["kji"] += R["ijk"]);
+
+  int off[] = {m/4, m/4};
+  int end[] = {3*m/4, 3*m/4};
+  int off_C[] = {0, 0};
+  int end_C[] = {m/2, m/2};
+  BENCH("slice", &C, C.slice(off_C, end_C, 1., A, off, end, 1.));
+
+  int64_t nloc = (int64_t)m*m/np;
+  int64_t * inds = (int64_t*)malloc(sizeof(int64_t)*nloc);
+  double * vals = (double*)malloc(sizeof(double)*nloc);
+  for (int64_t i=0; i<nloc; i++){
+    inds[i] = (int64_t)(drand48()*m*m);
+    vals[i] = drand48();
+  }
+  BENCH("write", &C, C.write(nloc, 1., 1., inds, vals));
+  BENCH("read", &C, C.read(nloc, inds, vals));
+  free(inds);
+  free(vals);
+#undef BENCH
+  return recs;
+}
+
+/**
+ * \brief writes records as a JSON array with one object per line
+ */
+void print_records(FILE *                            f,
+                   std::vector<bench_record> const & recs,
+                   int                               n,
+                   int                               niter,
+                   World &                           dw){
+  int nthreads = 1;
+#ifdef USE_OMP
+  nthreads = omp_get_max_threads();
+#endif
+  fprintf(f, "[\n");
+  for (int i=0; i<(int)recs.size(); i++){
+    fprintf(f, "{\"name\": \"%s\", \"np\": %d, \"nthreads\": %d, \"n\": %d, \"niter\": %d, "
+               "\"time\": %.6e, \"gflops\": %.6e, \"bytes\": %ld, \"mapping\": \"%s\"}%s\n",
+               recs[i].name.c_str(), dw.np, nthreads, n, niter, recs[i].time, recs[i].gflops,
+               recs[i].bytes, recs[i].mapping.c_str(), i+1 < (int)recs.size() ? "," : "");
+  }
+  fprintf(f, "]\n");
+}
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, niter, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+  char const * filter;
+  char const * fname;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 64;
+  } else n = 64;
+
+  if (getCmdOption(input_str, input_str+in_num, "-niter")){
+    niter = atoi(getCmdOption(input_str, input_str+in_num, "-niter"));
+    if (niter < 1) niter = 5;
+  } else niter = 5;
+
+  // runs only the benchmarks whose name contains this string
+  filter = getCmdOption(input_str, input_str+in_num, "-bench");
+  // file to write JSON records to, stdout if not given
+  fname = getCmdOption(input_str, input_str+in_num, "-o");
+
+  {
+    World dw(argc, argv);
+    std::vector<bench_record> recs = bench_suite(n, niter, filter, dw);
+    if (rank == 0){
+      FILE * f = fname == NULL ? stdout : fopen(fname, "w");
+      assert(f != NULL);
+      print_records(f, recs, n, niter, dw);
+      if (f != stdout) fclose(f);
+    }
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
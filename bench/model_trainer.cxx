@@ -137,6 +137,23 @@ void train_sps_vec_mat(int64_t n, int64_t m, World & dw, bool sp_A, bool sp_B, b
   }
 }
 
+void train_spmspv(int64_t n, int64_t m, World & dw){
+  Matrix<> A(m, n, SP, dw, "A");
+  Vector<> c(m, dw);
+  Vector<> c_sp(m, SP, dw, "c_sp");
+  srand48(dw.rank);
+  for (double sp = .01; sp<.32; sp*=2.){
+    A.fill_sp_random(-.5, .5, sp);
+    // frontiers of growing size, all sparse enough to be multiplied with the CSC layout of A
+    for (double fsp = .001; fsp<.1; fsp*=3.){
+      Vector<> b(n, SP, dw, "b");
+      b.fill_sp_random(-.5, .5, fsp);
+      c["i"] += A["ij"]*b["j"];
+      c_sp["i"] += A["ij"]*b["j"];
+    }
+  }
+}
+
 void train_ccsd(int64_t n, int64_t m, World & dw){
   int nv = sqrt(n);
   int no = sqrt(m);
@@ -185,6 +202,7 @@ void train_world(double dtime, World & dw){
       train_off_vec_mat(n-2, m+6, dw, 1, 0, 0);
       train_off_vec_mat(n-5, m+2, dw, 1, 1, 0);
       train_off_vec_mat(n-3, m-1, dw, 1, 1, 1);
+      train_spmspv(n+4, m-1, dw);
       train_ccsd(n/2, m/2, dw);
       train_sparse_mp3(n,m,dw);
       niter++;
@@ -218,7 +236,7 @@ void train_all(double time, World & dw){
     int np = *it;
     int mw = dw.rank/np;
     int mr = dw.rank%np;
-    int cm;
+    MPI_Comm cm;
     MPI_Comm_split(dw.comm, mw, mr, &cm);
     World w(cm);
     train_world(dtime, w);
@@ -151,7 +151,8 @@
  * 
  * CTF_MEMORY_SIZE tells CTF how much memory on the node there is for usage. By default CTF will try to read the available memory using system calls.
  *
- * CTF_PPN tells CTF how many processes per node you are using. The default is 1.
+ * CTF_PPN tells CTF how many processes per node you are using, which is used to determine memory limits. The default is 1.
+ * Independently, with MPI-3 CTF detects ranks sharing a node via MPI_Comm_split_type; if each node holds the same number of consecutive ranks, topologies are built so that processor grid dimensions may reside within a node, the mapper accounts for faster intra-node communication, and node-local parts of all-to-all redistributions are performed through shared-memory windows.
  *
  * \section source Source organization
  * 
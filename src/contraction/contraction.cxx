@@ -6,6 +6,7 @@
 #include "../tensor/untyped_tensor.h"
 #include "../shared/util.h"
 #include "../shared/memcontrol.h"
+#include "../interface/timer.h"
 #include "sym_seq_ctr.h"
 #include "spctr_comm.h"
 #include "ctr_tsr.h"
@@ -47,6 +48,7 @@ namespace CTF_int {
     func      = other.func;
     alpha = other.alpha;
     beta  = other.beta;
+    keep_map = other.keep_map;
   }
  
   contraction::contraction(tensor *               A_,
@@ -66,6 +68,7 @@ namespace CTF_int {
     func = func_;
     alpha = alpha_;
     beta  = beta_;
+    keep_map = 0;
     
     idx_A = (int*)alloc(sizeof(int)*A->order);
     idx_B = (int*)alloc(sizeof(int)*B->order);
@@ -92,6 +95,7 @@ namespace CTF_int {
     func = func_;
     alpha = alpha_;
     beta  = beta_;
+    keep_map = 0;
     
     conv_idx(A->order, cidx_A, &idx_A, B->order, cidx_B, &idx_B, C->order, cidx_C, &idx_C);
   }
@@ -108,8 +112,12 @@ namespace CTF_int {
 //      update_all_models(A->wrld->cdt.cm);
     //}
     
+    bool do_stats = begin_op_stats("contraction", op_stats_expr(A, idx_A, B, idx_B, C, idx_C,
+                                   beta != NULL && !C->sr->isequal(beta, C->sr->addid())));
+    C->data_modified();
     int stat = home_contract();
     assert(stat == SUCCESS); 
+    if (do_stats) end_op_stats(A->wrld->rank);
   }
   
   template<typename ptype>
@@ -160,8 +168,30 @@ namespace CTF_int {
 
 
   double contraction::estimate_time(){
-    assert(0); //FIXME
-    return 0.0;
+    // analytical estimate for a communication-optimal mapping onto all processes of the world,
+    // symmetry, sparsity, and redistribution costs are not taken into account
+    int num_tot;
+    int * idx_arr;
+    inv_idx(A->order, idx_A, B->order, idx_B, C->order, idx_C, &num_tot, &idx_arr);
+    double flops = 2.;
+    for (int i=0; i<num_tot; i++){
+      if (idx_arr[3*i] != -1) flops *= A->lens[idx_arr[3*i]];
+      else if (idx_arr[3*i+1] != -1) flops *= B->lens[idx_arr[3*i+1]];
+      else if (idx_arr[3*i+2] != -1) flops *= C->lens[idx_arr[3*i+2]];
+    }
+    cdealloc(idx_arr);
+    double nel = 0.;
+    double sz;
+    sz = 1.; for (int i=0; i<A->order; i++) sz *= A->lens[i];
+    nel += sz;
+    sz = 1.; for (int i=0; i<B->order; i++) sz *= B->lens[i];
+    nel += sz;
+    sz = 1.; for (int i=0; i<C->order; i++) sz *= C->lens[i];
+    nel += sz;
+    double np = A->wrld->np;
+    double nbyte = nel*C->sr->el_size;
+    return COST_FLOP*flops/np + COST_MEMBW*nbyte/np + COST_NETWBW*nbyte/pow(np, 2./3.)
+           + COST_LATENCY*(1.+log2(np));
   }
 
   int contraction::is_equal(contraction const & os){
@@ -241,6 +271,11 @@ namespace CTF_int {
     return A->is_sparse || B->is_sparse || C->is_sparse;
   }
 
+  bool contraction::is_spmspv(){
+    if (!A->is_sparse || !B->is_sparse || is_custom || A == B || A == C) return false;
+    return B->nnz_tot <= SPMSPV_MAX_NNZ_FRAC*((double)B->size)*B->calc_npe();
+  }
+
   void contraction::get_fold_indices(int *  num_fold,
                                      int ** fold_idx){
     int i, in, num_tot, nfold, broken;
@@ -746,7 +781,10 @@ namespace CTF_int {
             if (idx_A[i] == idx_C[j]) nrow_idx++;
           }
         }
-        A->spmatricize(iprm.m, iprm.k, nrow_idx, csr_or_coo);
+        if (is_spmspv())
+          A->spmatricize_csc(iprm.m, iprm.k, nrow_idx);
+        else
+          A->spmatricize(iprm.m, iprm.k, nrow_idx, csr_or_coo);
       }
       nvirt_B = B->calc_nvirt();
       if (!B->is_sparse){
@@ -2378,6 +2416,16 @@ namespace CTF_int {
 
   }
 
+  /**
+   * \brief bytes of the largest operand in its current distribution, buffers of which dominate
+   *        the memory use of a mapping of the contraction
+   */
+  static int64_t max_operand_bytes(tensor const * A, distribution const * dA,
+                                   tensor const * B, distribution const * dB,
+                                   tensor const * C, distribution const * dC){
+    return std::max(A->sr->el_size*dA->size, std::max(B->sr->el_size*dB->size, C->sr->el_size*dC->size));
+  }
+
   void contraction::get_best_sel_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int & idx, double & time){
     int ret, j, d;
     int need_remap_A, need_remap_B, need_remap_C;
@@ -2395,7 +2443,7 @@ namespace CTF_int {
             B->order, idx_B,
             C->order, idx_C,
             &num_tot, &idx_arr);
-    int64_t max_memuse = proc_bytes_available();
+    int64_t max_memuse = proc_bytes_available(max_operand_bytes(A, dA, B, dB, C, dC));
     for (j=0; j<6; j++){
       // Attempt to map to all possible permutations of processor topology 
   #if DEBUG < 3 
@@ -2403,6 +2451,7 @@ namespace CTF_int {
   #else
       for (int t=1; t<(int)wrld->topovec.size()+8; t++){
   #endif
+        if (keep_map != 0 && (t >= 8 || (t & keep_map) != keep_map)) continue;
         A->clear_mapping();
         B->clear_mapping();
         C->clear_mapping();
@@ -2459,6 +2508,20 @@ namespace CTF_int {
           continue;
         }
         TAU_FSTOP(check_ctr_mapping);
+        if (keep_map != 0){
+          // mapping the other operands may have extended a kept mapping
+          bool kept = true;
+          for (d=0; d<A->order && (keep_map & 1); d++){
+            if (!comp_dim_map(&A->edge_map[d], &old_map_A[d])) kept = false;
+          }
+          for (d=0; d<B->order && (keep_map & 2); d++){
+            if (!comp_dim_map(&B->edge_map[d], &old_map_B[d])) kept = false;
+          }
+          for (d=0; d<C->order && (keep_map & 4); d++){
+            if (!comp_dim_map(&C->edge_map[d], &old_map_C[d])) kept = false;
+          }
+          if (!kept) continue;
+        }
         est_time = 0.0;
         TAU_FSTART(est_ctr_map_time);
         A->set_padding();
@@ -2632,7 +2695,7 @@ namespace CTF_int {
     }
     int64_t valid_mappings = 0;
     int64_t choice_offset = 0;
-    int64_t max_memuse = proc_bytes_available();
+    int64_t max_memuse = proc_bytes_available(max_operand_bytes(A, dA, B, dB, C, dC));
     TAU_FSTOP(init_select_ctr_map);
     for (int i=0; i<(int)wrld->topovec.size(); i++){
 //      int tnum_choices = pow(num_choices,(int) wrld->topovec[i]->order);
@@ -2833,7 +2896,7 @@ namespace CTF_int {
 
   }
 
-  int contraction::map(ctr ** ctrf, bool do_remap){
+  int contraction::map(ctr ** ctrf, bool do_remap, bool do_redist){
     int ret, j, need_remap, d;
     int * old_phase_A, * old_phase_B, * old_phase_C;
     topology * old_topo_A, * old_topo_B, * old_topo_C;
@@ -2862,6 +2925,13 @@ namespace CTF_int {
     ASSERT(A->is_mapped);
     ASSERT(B->is_mapped);
     ASSERT(C->is_mapped);
+    // the CSC layout of the matrix of a product with a sparse vector is cached for its mapping,
+    // so once it exists the matrix is kept in place unless no mapping allows it
+    if (keep_map == 0 && is_spmspv()){
+      int csc_ok = A->has_csc();
+      MPI_Allreduce(MPI_IN_PLACE, &csc_ok, 1, MPI_INT, MPI_MIN, global_comm.cm);
+      if (csc_ok) keep_map = 1;
+    }
     if (do_remap){
     #if DEBUG >= 2
       if (global_comm.rank == 0)
@@ -2900,8 +2970,13 @@ namespace CTF_int {
   
     TAU_FSTART(get_best_sel_map);
     get_best_sel_map(dA, dB, dC, old_topo_A, old_topo_B, old_topo_C, old_map_A, old_map_B, old_map_C, ttopo_sel, gbest_time_sel);
+    if (keep_map != 0 && (ttopo_sel == INT_MAX || ttopo_sel == -1)){
+      // no mapping keeps the requested operands in place, so any mapping is considered
+      keep_map = 0;
+      get_best_sel_map(dA, dB, dC, old_topo_A, old_topo_B, old_topo_C, old_map_A, old_map_B, old_map_C, ttopo_sel, gbest_time_sel);
+    }
     TAU_FSTOP(get_best_sel_map);
-    if (gbest_time_sel < 1.){
+    if (gbest_time_sel < 1. || keep_map != 0){
       gbest_time_exh = gbest_time_sel+1.;
       ttopo_exh = ttopo_sel;
     } else {
@@ -3003,6 +3078,19 @@ namespace CTF_int {
     A->set_padding();
     B->set_padding();
     C->set_padding();
+    if (!do_redist){
+      CTF_int::cdealloc(old_phase_A);
+      CTF_int::cdealloc(old_phase_B);
+      CTF_int::cdealloc(old_phase_C);
+      delete [] old_map_A;
+      delete [] old_map_B;
+      delete [] old_map_C;
+      delete dA;
+      delete dB;
+      delete dC;
+      *ctrf = NULL;
+      return SUCCESS;
+    }
     if (can_fold()){
       iparam prm = map_fold(false);
       *ctrf = construct_ctr(1, &prm);
@@ -3081,8 +3169,11 @@ namespace CTF_int {
       }
     } else
       need_remap = 1;
-    if (need_remap)
+    if (need_remap){
+      int64_t st_bytes = get_comm_bytes();
       A->redistribute(*dA);
+      if (cur_op_stats() != NULL) cur_op_stats()->redist_bytes_A += get_comm_bytes()-st_bytes;
+    }
     need_remap = 0;
     if (B->topo == old_topo_B){
       for (d=0; d<B->order; d++){
@@ -3091,8 +3182,11 @@ namespace CTF_int {
       }
     } else
       need_remap = 1;
-    if (need_remap)
+    if (need_remap){
+      int64_t st_bytes = get_comm_bytes();
       B->redistribute(*dB);
+      if (cur_op_stats() != NULL) cur_op_stats()->redist_bytes_B += get_comm_bytes()-st_bytes;
+    }
     need_remap = 0;
     if (C->topo == old_topo_C){
       for (d=0; d<C->order; d++){
@@ -3101,8 +3195,11 @@ namespace CTF_int {
       }
     } else
       need_remap = 1;
-    if (need_remap)
+    if (need_remap){
+      int64_t st_bytes = get_comm_bytes();
       C->redistribute(*dC);
+      if (cur_op_stats() != NULL) cur_op_stats()->redist_bytes_C += get_comm_bytes()-st_bytes;
+    }
                    
     TAU_FSTOP(redistribute_for_contraction);
     
@@ -3123,6 +3220,58 @@ namespace CTF_int {
   }
 
 
+  int contraction::premap_operand(tensor * tsr){
+    ASSERT(tsr == A || tsr == B || tsr == C);
+    if ((tsr == A) + (tsr == B) + (tsr == C) != 1) return ERROR;
+    if (A->is_sparse || B->is_sparse || C->is_sparse) return ERROR;
+    tensor * tsrs[3] = {A, B, C};
+    topology * old_topo[3];
+    mapping * old_map[3];
+    int old_is_cyclic[3];
+    for (int i=0; i<3; i++){
+      tsrs[i]->unfold();
+      old_topo[i] = tsrs[i]->topo;
+      old_map[i] = new mapping[tsrs[i]->order];
+      copy_mapping(tsrs[i]->order, tsrs[i]->edge_map, old_map[i]);
+      old_is_cyclic[i] = tsrs[i]->is_cyclic;
+    }
+    ctr * ctrf;
+    int ret = map(&ctrf, 1, 0);
+    // a layout replicated over some processors cannot be written by the contraction
+    // producing tsr, which would then redistribute it anyway
+    if (ret == SUCCESS && tsr->calc_npe() < tsr->wrld->np) ret = NEGATIVE;
+    for (int i=0; i<3; i++){
+      // operands other than tsr keep their mapping, as their data has not moved
+      if (tsrs[i] != tsr || ret != SUCCESS){
+        tsrs[i]->clear_mapping();
+        tsrs[i]->topo = old_topo[i];
+        copy_mapping(tsrs[i]->order, old_map[i], tsrs[i]->edge_map);
+        tsrs[i]->is_cyclic = old_is_cyclic[i];
+        tsrs[i]->is_mapped = 1;
+        tsrs[i]->set_padding();
+      }
+      delete [] old_map[i];
+    }
+    if (ret != SUCCESS) return ret;
+
+    // reallocate tsr with zeros in its new mapping
+    if (tsr->has_home){
+      if (!tsr->is_home) cdealloc(tsr->data);
+      cdealloc(tsr->home_buffer);
+      tsr->deregister_size();
+      tsr->home_size = tsr->size;
+      CTF_int::alloc_ptr(tsr->home_size*tsr->sr->el_size, (void**)&tsr->home_buffer);
+      tsr->register_size(tsr->size*tsr->sr->el_size);
+      tsr->data = tsr->home_buffer;
+      tsr->is_home = 1;
+    } else {
+      cdealloc(tsr->data);
+      CTF_int::alloc_ptr(tsr->size*tsr->sr->el_size, (void**)&tsr->data);
+    }
+    tsr->sr->set(tsr->data, tsr->sr->addid(), tsr->size);
+    return SUCCESS;
+  }
+
   ctr * contraction::construct_dense_ctr(int            is_inner,
                                          iparam const * inner_params,
                                          int *          nvirt_all,
@@ -3878,6 +4027,9 @@ namespace CTF_int {
       if (A->is_sparse && B->is_sparse && C->is_sparse){
         krnl_type = 4;
       }
+      if (is_spmspv()){
+        krnl_type = 5;
+      }
     } else {
       ASSERT(!B->is_sparse && !C->is_sparse);
       assert(!B->is_sparse && !C->is_sparse); // FIXME: currently this type of contraction cannot be done with sparse tensors
@@ -3970,6 +4122,40 @@ namespace CTF_int {
     return hctr;
   }
 
+  void contraction::record_op_stats(ctr * ctrf, bool is_inner){
+    CTF::Op_stats * st = cur_op_stats();
+    st->topo.clear();
+    for (int i=0; i<A->topo->order; i++){
+      if (i > 0) st->topo += "x";
+      st->topo += std::to_string(A->topo->lens[i]);
+    }
+    // a single process is mapped onto a topology of order zero
+    if (A->topo->order == 0) st->topo = "1";
+    st->map_A = A->get_map_str();
+    st->map_B = B->get_map_str();
+    st->map_C = C->get_map_str();
+    st->folded |= is_inner;
+    if (is_sparse()){
+      if (!is_inner) st->kernel = "sparse_reference";
+      else if (!B->is_sparse && !C->is_sparse)
+        st->kernel = (is_custom || !A->sr->has_coo_ker) ? "csrmm" : "coomm";
+      else if (is_spmspv()) st->kernel = C->is_sparse ? "cscmultcsr" : "cscmultd";
+      else if (!C->is_sparse) st->kernel = "csrmultd";
+      else st->kernel = "csrmultcsr";
+      double nnz_frac_A = 1.0;
+      double nnz_frac_B = 1.0;
+      double nnz_frac_C = 1.0;
+      if (A->is_sparse) nnz_frac_A = std::min(1.,((double)A->nnz_tot)/(A->size*A->calc_npe()));
+      if (B->is_sparse) nnz_frac_B = std::min(1.,((double)B->nnz_tot)/(B->size*B->calc_npe()));
+      if (C->is_sparse) nnz_frac_C = std::min(1.,((double)C->nnz_tot)/(C->size*C->calc_npe()));
+      st->est_time += ((spctr*)ctrf)->est_time_rec(1, nnz_frac_A, nnz_frac_B, nnz_frac_C);
+    } else {
+      if (is_inner) st->kernel = "gemm";
+      else st->kernel = is_custom ? "custom" : "reference";
+      st->est_time += ctrf->est_time_rec(1);
+    }
+  }
+
   int contraction::contract(){
     int stat;
     ctr * ctrf;
@@ -4224,6 +4410,7 @@ namespace CTF_int {
       ctrf = construct_ctr(1, &prm);
     } 
   #endif
+    if (cur_op_stats() != NULL) record_op_stats(ctrf, is_inner);
   #if DEBUG >=2
   if (global_comm.rank == 0){
     ctrf->print();
@@ -4329,7 +4516,7 @@ namespace CTF_int {
       }
     } else
       ctrf->run(A->data, B->data, C->data);
-    A->topo->deactivate();
+    A->topo->release();
 
   #ifdef PROFILE
     TAU_FSTART(post_ctr_func_barrier);
@@ -4517,6 +4704,7 @@ namespace CTF_int {
     else fptr = NULL;
 
     contraction new_ctr = contraction(tnsr_A, map_A, tnsr_B, map_B, alpha, tnsr_C, map_C, beta, fptr);
+    new_ctr.keep_map = (tnsr_A == A ? keep_map & 1 : 0) | (tnsr_B == B ? keep_map & 2 : 0) | (tnsr_C == C ? keep_map & 4 : 0);
     tnsr_A->unfold();
     tnsr_B->unfold();
     tnsr_C->unfold();
@@ -4591,7 +4779,38 @@ namespace CTF_int {
 
         contraction * unfold_ctr;
         new_ctr.unfold_broken_sym(&unfold_ctr);
-        if (unfold_ctr->map(&ctrf, 0) == SUCCESS){
+        // desymmetrization materializes unpacked copies of the operands whose symmetry is broken,
+        // if these would not fit, contract the packed operands directly, one permutation at a time
+        // (the permutation sum counts diagonals of SY groups repeatedly, so only AS/SH groups qualify)
+        bool use_packed = false;
+        double desym_memuse = 0.0;
+        int64_t desym_min_bytes = INT64_MAX;
+        tensor * tsrs_old[3] = {tnsr_A, tnsr_B, tnsr_C};
+        tensor * tsrs_new[3] = {unfold_ctr->A, unfold_ctr->B, unfold_ctr->C};
+        for (int it=0; it<3; it++){
+          if (memcmp(tsrs_old[it]->sym, tsrs_new[it]->sym, sizeof(int)*tsrs_old[it]->order) != 0 ||
+              (it == 1 && tnsr_A == tnsr_B)){
+            double copy_bytes = ((double)packed_size(tsrs_new[it]->order, tsrs_new[it]->lens, tsrs_new[it]->sym))
+                                *tsrs_new[it]->sr->el_size/global_comm.np;
+            desym_memuse += copy_bytes;
+            desym_min_bytes = std::min(desym_min_bytes, (int64_t)copy_bytes);
+          }
+        }
+        if (desym_memuse > get_desym_mem_frac()*proc_bytes_available(desym_min_bytes)){
+          use_packed = true;
+          for (int it=0; it<3; it++){
+            for (int j=0; j<tsrs_old[it]->order; j++){
+              if (tsrs_old[it]->sym[j] == SY) use_packed = false;
+            }
+          }
+          if (global_comm.rank == 0){
+            if (use_packed)
+              DPRINTF(1,"Unpacked operands need %E bytes, contracting packed operands instead\n", desym_memuse);
+            else
+              DPRINTF(1,"Unpacked operands need %E bytes, but SY operands must be unpacked\n", desym_memuse);
+          }
+        }
+        if (!use_packed && unfold_ctr->map(&ctrf, 0) == SUCCESS){
 /*  #else
         int sy = 0;
         for (i=0; i<A->order; i++){
@@ -4657,8 +4876,12 @@ namespace CTF_int {
             stat = perm_types[i].contract();
             dbeta = new_ctr.C->sr->mulid();
           }
+          CTF_int::cdealloc(new_alpha);
           perm_types.clear();
           signs.clear();
+          delete unfold_ctr->A;
+          delete unfold_ctr->B;
+          delete unfold_ctr->C;
         }
         delete unfold_ctr;
       } else {
@@ -4790,6 +5013,7 @@ namespace CTF_int {
       if (A->is_sparse){
         CTF_int::alloc_ptr(new_ctr.A->calc_nvirt()*sizeof(int64_t), (void**)&new_ctr.A->nnz_blk);
         new_ctr.A->set_new_nnz_glb(A->nnz_blk);
+        new_ctr.A->take_csc(A);
       }
     }     
     if (was_home_B){
@@ -4879,9 +5103,12 @@ namespace CTF_int {
         if (A->is_sparse){
           A->data = new_ctr.A->home_buffer;
           new_ctr.A->home_buffer = NULL;
+          // the CSC layout built for the mapping the contraction chose serves the next one
+          A->take_csc(new_ctr.A);
         }
         delete new_ctr.A;
       } else if (was_home_A) {
+        if (A->is_sparse) A->take_csc(new_ctr.A);
         new_ctr.A->is_data_aliased = 1;
         delete new_ctr.A;
       }
@@ -5039,7 +5266,7 @@ namespace CTF_int {
         if (T->is_home){
           if (T->wrld->cdt.rank == 0)
             DPRINTF(2,"Tensor %s leaving home\n", T->name);
-          T->data = (char*)CTF_int::mst_alloc(T->size*T->sr->el_size);
+          T->data = (char*)CTF_int::data_alloc(T->size*T->sr->el_size);
           memcpy(T->data, T->home_buffer, T->size*T->sr->el_size);
           T->is_home = 0;
         }
@@ -5067,7 +5294,7 @@ namespace CTF_int {
         if (V->is_home){
           if (V->wrld->cdt.rank == 0)
             DPRINTF(2,"Tensor %s leaving home\n", V->name);
-          V->data = (char*)CTF_int::mst_alloc(V->size*V->sr->el_size);
+          V->data = (char*)CTF_int::data_alloc(V->size*V->sr->el_size);
           memcpy(V->data, V->home_buffer, V->size*V->sr->el_size);
           V->is_home = 0;
         }
@@ -37,9 +37,12 @@ namespace CTF_int {
       bool is_custom;
       /** \brief function to execute on elements */
       bivar_function const * func;
+      /** \brief operands (1 for A, 2 for B, 4 for C) whose current mapping the mapping search
+       *         keeps, unless no mapping that keeps them is valid */
+      int keep_map;
 
       /** \brief lazy constructor */
-      contraction(){ idx_A = NULL; idx_B = NULL; idx_C=NULL; is_custom=0; alpha=NULL; beta=NULL; };
+      contraction(){ idx_A = NULL; idx_B = NULL; idx_C=NULL; is_custom=0; alpha=NULL; beta=NULL; keep_map=0; };
       
       /** \brief destructor */
       ~contraction();
@@ -116,12 +119,28 @@ namespace CTF_int {
        */
       int is_equal(contraction const & os);
 
+      /**
+       * \brief selects the mapping this contraction would use, without moving any data,
+       *        and lays out operand tsr, which must not hold data yet (e.g. a new intermediate),
+       *        in it, allocating it anew with zeros; the other operands are left as they are
+       * \param[in,out] tsr one of A, B, C, dense and not also another operand
+       * \return SUCCESS if tsr was mapped, otherwise (also if the selected mapping replicates
+       *         tsr, so that no contraction could write it in place) tsr keeps its mapping
+       */
+      int premap_operand(tensor * tsr);
+
     private:
       /**
        * \brief returns true if one of the tensors is sparse 
        */
       bool is_sparse();
 
+      /**
+       * \brief returns true if A and B are sparse and B has so few nonzeros that the folded contraction
+       *        should gather only the columns of A needed by them, from A in CSC layout
+       */
+      bool is_spmspv();
+
       /**
        * \brief finds and return all contraction indices which can be folded into
        *    dgemm, for which they must (1) not break symmetry (2) belong to 
@@ -273,9 +292,11 @@ namespace CTF_int {
        * \brief find best possible mapping for contraction and redistribute tensors to this mapping
        * \param[out] ctrf contraction class to run
        * \param[in] do_remap whether to redistribute tensors
+       * \param[in] do_redist if false, the mapping of the tensors is set but their data is not
+       *                      redistributed and no contraction class is constructed
        * \return SUCCESS if valid mapping found, ERROR if not enough memory or another issue
        */
-      int map(ctr ** ctrf, bool do_remap=1);
+      int map(ctr ** ctrf, bool do_remap=1, bool do_redist=1);
  
       /**
         * \brief contracts tensors alpha*A*B+beta*C -> C.
@@ -311,6 +332,13 @@ namespace CTF_int {
        */
       int contract();
 
+      /**
+       * \brief fills the mapping, kernel and estimated time of the operation being recorded
+       * \param[in] ctrf contraction plan chosen for the mapped tensors
+       * \param[in] is_inner whether the local contraction is folded into a matrix kernel
+       */
+      void record_op_stats(ctr * ctrf, bool is_inner);
+
       /**
        * \brief contracts tensors alpha*A*B+beta*C -> C performs all symmetric permutations
        * \return completion status
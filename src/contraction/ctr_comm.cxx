@@ -184,7 +184,12 @@ namespace CTF_int {
     }
     for (i=0; i<ncdt_C; i++){
       ASSERT(cdt_C[i]->np > 0);
-      tot_sz += cdt_C[i]->estimate_red_time(size_C*sr_C->el_size, sr_C->addmop());
+      double red_time = cdt_C[i]->estimate_red_time(size_C*sr_C->el_size, sr_C->addmop());
+      if (CTF::REDSCAT_SWITCH != 1){
+        double redscat_time = cdt_C[i]->estimate_redscat_time(size_C*sr_C->el_size, sr_C->addmop());
+        red_time = CTF::REDSCAT_SWITCH == 2 ? redscat_time : std::min(red_time, redscat_time);
+      }
+      tot_sz += red_time;
     }
     return tot_sz;
   }
@@ -247,12 +252,13 @@ namespace CTF_int {
     /*for (i=0; i<size_C; i++){
       printf("P%d C[%d]  = %lf\n",crank,i, ((double*)C)[i]);
     }*/
-    for (i=0; i<ncdt_C; i++){
+    // after reducing along a dimension only its root holds a partial sum, so the
+    // remaining dimensions are reduced only by processes that are roots of all prior ones
+    crank = 0;
+    for (i=0; i<ncdt_C && crank == 0; i++){
       //ALLREDUCE(MPI_IN_PLACE, C, size_C, sr_C->mdtype(), sr_C->addmop(), cdt_C[i]->;
-      if (cdt_C[i]->rank == 0)
-        cdt_C[i]->red(MPI_IN_PLACE, C, size_C, sr_C->mdtype(), sr_C->addmop(), 0);
-      else
-        cdt_C[i]->red(C, NULL, size_C, sr_C->mdtype(), sr_C->addmop(), 0);
+      cdt_C[i]->red(C, size_C, sr_C, 0);
+      crank += cdt_C[i]->rank;
     }
 
     if (arank != 0 && this->sr_A->addid() != NULL){
@@ -7,6 +7,7 @@
 #include "contraction.h"
 #include "../tensor/untyped_tensor.h"
 #include "../shared/model.h"
+#include "../shared/memcontrol.h"
 #ifdef USE_OMP
 #include <omp.h>
 #endif
@@ -182,6 +183,26 @@ namespace CTF_int {
         off_A = 0, off_B = 0, off_C = 0;
         for (;;){
           if (off_C >= start_off && off_C < end_off) {
+            if (is_out_of_core()){
+              // read ahead the blocks of the next iteration while this one is contracted
+              int64_t nxt_A = off_A, nxt_B = off_B, nxt_C = off_C;
+              for (i=0; i<num_dim; i++){
+                nxt_A -= ilda_A[i]*tidx_arr[i];
+                nxt_B -= ilda_B[i]*tidx_arr[i];
+                nxt_C -= ilda_C[i]*tidx_arr[i];
+                if (tidx_arr[i]+1 < virt_dim[i]){
+                  nxt_A += ilda_A[i]*(tidx_arr[i]+1);
+                  nxt_B += ilda_B[i]*(tidx_arr[i]+1);
+                  nxt_C += ilda_C[i]*(tidx_arr[i]+1);
+                  break;
+                }
+              }
+              if (i < num_dim){
+                prefetch_mem(A + nxt_A*blk_sz_A*sr_A->el_size, blk_sz_A*sr_A->el_size);
+                prefetch_mem(B + nxt_B*blk_sz_B*sr_A->el_size, blk_sz_B*sr_A->el_size);
+                prefetch_mem(C + nxt_C*blk_sz_C*sr_A->el_size, blk_sz_C*sr_A->el_size);
+              }
+            }
             if (beta_arr[off_C]>0)
               rec_ctr->beta = sr_C->mulid();
             else
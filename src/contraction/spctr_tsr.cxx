@@ -247,6 +247,7 @@ namespace CTF_int {
   LinModel<3> seq_tsr_spctr_k2(seq_tsr_spctr_k2_init,"seq_tsr_spctr_k2");
   LinModel<3> seq_tsr_spctr_k3(seq_tsr_spctr_k3_init,"seq_tsr_spctr_k3");
   LinModel<3> seq_tsr_spctr_k4(seq_tsr_spctr_k4_init,"seq_tsr_spctr_k4");
+  LinModel<3> seq_tsr_spctr_k5(seq_tsr_spctr_k5_init,"seq_tsr_spctr_k5");
 
   double seq_tsr_spctr::est_time_fp(int nlyr, double nnz_frac_A, double nnz_frac_B, double nnz_frac_C){ 
 //    return COST_MEMBW*(size_A+size_B+size_C)+COST_FLOP*flops;
@@ -305,6 +306,9 @@ namespace CTF_int {
           return seq_tsr_spctr_k4.est_time(ps);
         }
         break;
+      case 5:
+        return seq_tsr_spctr_k5.est_time(ps);
+        break;
     }
     assert(0); //wont make it here
     return 0.0;
@@ -412,6 +416,22 @@ namespace CTF_int {
         TAU_FSTOP(CSRMULTCSR);
       }
       break;
+
+      case 5:
+      {
+        // Do mm gathering the columns of A (in CSC format) that match nonzeros of B (in CSR format)
+        TAU_FSTART(CSCMULT);
+        if (is_sparse_C){
+          CSR_Matrix::cscmultcsr(A, sr_A, inner_params.m, inner_params.n, inner_params.k,
+                                 alpha, B, sr_B, sr_C->mulid(), new_C, sr_C);
+          size_blk_C[0] = ((CSR_Matrix)new_C).size();
+        } else {
+          CSR_Matrix::cscmultd(A, sr_A, inner_params.m, inner_params.n, inner_params.k,
+                               alpha, B, sr_B, sr_C->mulid(), C, sr_C);
+        }
+        TAU_FSTOP(CSCMULT);
+      }
+      break;
     }
     double nnz_frac_A = 1.0, nnz_frac_B = 1.0, nnz_frac_C = 1.0;
     if (is_sparse_A){
@@ -483,6 +503,9 @@ namespace CTF_int {
           seq_tsr_spctr_k4.observe(tps);
         }
         break;
+      case 5:
+        seq_tsr_spctr_k5.observe(tps);
+        break;
     }
 
   }
@@ -0,0 +1,364 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "common.h"
+#ifdef _OPENMP
+#include "omp.h"
+#endif
+
+namespace CTF_int {
+  /**
+   * \brief transposes a dense tensor stored with its first index fastest
+   * \param[in] order number of modes
+   * \param[in] lens lengths of the modes of the untransposed tensor
+   * \param[in] perm mode of the untransposed tensor that is mode i of the transposed one
+   * \param[in] is_fwd if true, in is untransposed and out transposed, otherwise the reverse
+   * \param[in] in input data
+   * \param[out] out output data
+   */
+  template <typename dtype>
+  void batched_ctr_transpose(int           order,
+                             int const *   lens,
+                             int const *   perm,
+                             bool          is_fwd,
+                             dtype const * in,
+                             dtype *       out){
+    std::vector<int64_t> str(order);
+    int64_t sz = 1;
+    bool is_id = true;
+    for (int i=0; i<order; i++){
+      str[i] = sz;
+      sz *= lens[i];
+      if (perm[i] != i) is_id = false;
+    }
+    if (is_id){
+      std::copy(in, in+sz, out);
+      return;
+    }
+    std::vector<int> idx(order, 0);
+    int64_t off = 0;
+    for (int64_t j=0; j<sz; j++){
+      if (is_fwd) out[j] = in[off];
+      else out[off] = in[j];
+      for (int p=0; p<order; p++){
+        idx[p]++;
+        off += str[perm[p]];
+        if (idx[p] < lens[perm[p]]) break;
+        off -= idx[p]*str[perm[p]];
+        idx[p] = 0;
+      }
+    }
+  }
+}
+
+namespace CTF {
+  template<typename dtype>
+  Batched_Contraction<dtype>::Batched_Contraction(char const * idx_A_,
+                                                  char const * idx_B_,
+                                                  char const * idx_C_,
+                                                  World &      wrld_){
+    wrld  = &wrld_;
+    idx_A = idx_A_;
+    idx_B = idx_B_;
+    idx_C = idx_C_;
+    // each index has to appear at most once in each tensor and in at least two of them
+    is_gemm_pattern = true;
+    std::string idx_all = idx_A + idx_B + idx_C;
+    for (int i=0; i<(int)idx_all.size(); i++){
+      char c = idx_all[i];
+      int64_t nA = std::count(idx_A.begin(), idx_A.end(), c);
+      int64_t nB = std::count(idx_B.begin(), idx_B.end(), c);
+      int64_t nC = std::count(idx_C.begin(), idx_C.end(), c);
+      if (nA > 1 || nB > 1 || nC > 1 || nA+nB+nC < 2) is_gemm_pattern = false;
+    }
+  }
+
+  template<typename dtype>
+  int Batched_Contraction<dtype>::add(Tensor<dtype> & A, Tensor<dtype> & B, Tensor<dtype> & C){
+    return add(A, B, C, ((dtype const*)C.sr->mulid())[0], ((dtype const*)C.sr->addid())[0]);
+  }
+
+  template<typename dtype>
+  int Batched_Contraction<dtype>::add(Tensor<dtype> & A, Tensor<dtype> & B, Tensor<dtype> & C, dtype alpha, dtype beta){
+    IASSERT(A.wrld->comm == wrld->comm && B.wrld->comm == wrld->comm && C.wrld->comm == wrld->comm);
+    IASSERT(A.order == (int)idx_A.size() && B.order == (int)idx_B.size() && C.order == (int)idx_C.size());
+    if (tasks.size() > 0){
+      ctr_task const & t0 = tasks[0];
+      for (int i=0; i<A.order; i++) IASSERT(A.lens[i] == t0.A->lens[i]);
+      for (int i=0; i<B.order; i++) IASSERT(B.lens[i] == t0.B->lens[i]);
+      for (int i=0; i<C.order; i++) IASSERT(C.lens[i] == t0.C->lens[i]);
+    }
+    // the outputs are written back independently, so they may not alias
+    for (int i=0; i<(int)tasks.size(); i++) IASSERT(tasks[i].C != &C);
+    ctr_task t;
+    t.A     = &A;
+    t.B     = &B;
+    t.C     = &C;
+    t.alpha = alpha;
+    t.beta  = beta;
+    tasks.push_back(t);
+    return (int)tasks.size()-1;
+  }
+
+  template<typename dtype>
+  bool Batched_Contraction<dtype>::is_batchable() const {
+    if (!is_gemm_pattern || tasks.size() == 0) return false;
+    if (!tasks[0].C->sr->has_mul()) return false;
+    int64_t tot_sz = 0;
+    for (int i=0; i<(int)tasks.size(); i++){
+      Tensor<dtype> const * T[3] = {tasks[i].A, tasks[i].B, tasks[i].C};
+      for (int j=0; j<3; j++){
+        if (T[j]->is_sparse || T[j]->has_zero_edge_len) return false;
+        int64_t nel = 1;
+        for (int k=0; k<T[j]->order; k++){
+          if (T[j]->sym[k] != NS) return false;
+          nel *= T[j]->lens[k];
+        }
+        if (i == 0) tot_sz += nel;
+      }
+    }
+    return tot_sz <= BATCHED_CTR_MAX_SIZE;
+  }
+
+  template<typename dtype>
+  void Batched_Contraction<dtype>::execute(){
+    if (is_batchable()){
+      execute_batched();
+    } else {
+      for (int i=0; i<(int)tasks.size(); i++){
+        ctr_task & t = tasks[i];
+        t.C->contract(t.alpha, *t.A, idx_A.c_str(), *t.B, idx_B.c_str(), t.beta, idx_C.c_str());
+      }
+    }
+  }
+
+  template<typename dtype>
+  void Batched_Contraction<dtype>::execute_batched(){
+    int np    = wrld->np;
+    int rank  = wrld->rank;
+    int ntask = (int)tasks.size();
+    int ds    = sizeof(dtype);
+    int ks    = sizeof(int64_t);
+    CTF_int::algstrct const * sr = tasks[0].C->sr;
+
+    // contraction i is done by process i mod np
+    int nmy = rank < ntask ? (ntask-rank+np-1)/np : 0;
+
+    int order[3] = {(int)idx_A.size(), (int)idx_B.size(), (int)idx_C.size()};
+    int const * lens[3] = {tasks[0].A->lens, tasks[0].B->lens, tasks[0].C->lens};
+    int64_t nel[3];
+    for (int j=0; j<3; j++){
+      nel[j] = 1;
+      for (int k=0; k<order[j]; k++) nel[j] *= lens[j][k];
+    }
+
+    // local elements of every operand, those of A and B from one copy, those of C from every
+    // copy, since all of them are overwritten
+    std::vector<int64_t> nloc(3*ntask), nval(3*ntask);
+    std::vector<int64_t*> keys(3*ntask), offs(3*ntask);
+    std::vector<bool> has_beta(ntask);
+    for (int i=0; i<ntask; i++){
+      Tensor<dtype> * T[3] = {tasks[i].A, tasks[i].B, tasks[i].C};
+      has_beta[i] = !sr->isequal((char const*)&tasks[i].beta, sr->addid());
+      for (int j=0; j<3; j++){
+        T[j]->unfold();
+        bool is_root = T[j]->is_replica_root();
+        if (j == 2 || is_root){
+          T[j]->read_local_offsets(&nloc[3*i+j], &keys[3*i+j], &offs[3*i+j]);
+        } else {
+          nloc[3*i+j] = 0;
+          keys[3*i+j] = NULL;
+          offs[3*i+j] = NULL;
+        }
+        // values of C are needed only if it is scaled rather than overwritten
+        nval[3*i+j] = (j < 2 || (has_beta[i] && is_root)) ? nloc[3*i+j] : 0;
+      }
+    }
+
+    // to the process doing each contraction: the counts of keys and values of A, B and C,
+    // followed by the keys and values of each
+    std::vector<int64_t> send_counts(np, 0), send_displs(np, 0), recv_counts(np), recv_displs(np, 0);
+    for (int i=0; i<ntask; i++){
+      send_counts[i%np] += 6*ks;
+      for (int j=0; j<3; j++){
+        send_counts[i%np] += nloc[3*i+j]*ks + nval[3*i+j]*ds;
+      }
+    }
+    for (int p=1; p<np; p++){
+      send_displs[p] = send_displs[p-1]+send_counts[p-1];
+    }
+    char * sbuf = (char*)CTF_int::alloc(std::max((int64_t)1, send_displs[np-1]+send_counts[np-1]));
+    std::vector<int64_t> pos(send_displs);
+    for (int i=0; i<ntask; i++){
+      Tensor<dtype> * T[3] = {tasks[i].A, tasks[i].B, tasks[i].C};
+      int64_t & p = pos[i%np];
+      for (int j=0; j<3; j++){
+        memcpy(sbuf+p, &nloc[3*i+j], ks);
+        memcpy(sbuf+p+ks, &nval[3*i+j], ks);
+        p += 2*ks;
+      }
+      for (int j=0; j<3; j++){
+        memcpy(sbuf+p, keys[3*i+j], nloc[3*i+j]*ks);
+        p += nloc[3*i+j]*ks;
+        for (int64_t k=0; k<nval[3*i+j]; k++){
+          memcpy(sbuf+p, T[j]->data+offs[3*i+j][k]*ds, ds);
+          p += ds;
+        }
+        if (j < 2){
+          if (keys[3*i+j] != NULL) CTF_int::cdealloc(keys[3*i+j]);
+          if (offs[3*i+j] != NULL) CTF_int::cdealloc(offs[3*i+j]);
+        }
+      }
+    }
+    MPI_Alltoall(&send_counts[0], 1, MPI_INT64_T, &recv_counts[0], 1, MPI_INT64_T, wrld->comm);
+    for (int p=1; p<np; p++){
+      recv_displs[p] = recv_displs[p-1]+recv_counts[p-1];
+    }
+    char * rbuf = (char*)CTF_int::alloc(std::max((int64_t)1, recv_displs[np-1]+recv_counts[np-1]));
+    wrld->cdt.all_to_allv(sbuf, &send_counts[0], &send_displs[0], 1, rbuf, &recv_counts[0], &recv_displs[0]);
+    CTF_int::cdealloc(sbuf);
+
+    // assemble the operands of each local contraction, remembering where the keys of C
+    // of each process are to reply with its values in the same order
+    dtype * dense[3];
+    for (int j=0; j<3; j++){
+      dense[j] = (dtype*)CTF_int::alloc(std::max((int64_t)1, nmy*nel[j])*ds);
+    }
+    for (int m=0; m<nmy; m++){
+      if (!has_beta[rank+m*np]) sr->set((char*)(dense[2]+m*nel[2]), sr->addid(), nel[2]);
+    }
+    std::vector<int64_t> ckey_pos(np*nmy), nckey(np*nmy);
+    for (int s=0; s<np; s++){
+      int64_t p = recv_displs[s];
+      for (int m=0; m<nmy; m++){
+        int64_t n[3], nv[3];
+        for (int j=0; j<3; j++){
+          memcpy(n+j, rbuf+p, ks);
+          memcpy(nv+j, rbuf+p+ks, ks);
+          p += 2*ks;
+        }
+        for (int j=0; j<3; j++){
+          if (j == 2){
+            ckey_pos[s*nmy+m] = p;
+            nckey[s*nmy+m]    = n[j];
+          }
+          char const * kbuf = rbuf+p;
+          p += n[j]*ks;
+          for (int64_t k=0; k<nv[j]; k++){
+            int64_t key;
+            memcpy(&key, kbuf+k*ks, ks);
+            memcpy(dense[j]+m*nel[j]+key, rbuf+p, ds);
+            p += ds;
+          }
+        }
+      }
+    }
+
+    // modes ordered so that A is I-by-K, B is K-by-J and C is I-by-J for each of H
+    // contractions along indices that appear in all three tensors
+    std::string ii, jj, kk, hh;
+    for (int k=0; k<order[2]; k++){
+      char c = idx_C[k];
+      bool in_A = idx_A.find(c) != std::string::npos;
+      bool in_B = idx_B.find(c) != std::string::npos;
+      if (in_A && in_B) hh += c;
+      else if (in_A) ii += c;
+      else jj += c;
+    }
+    for (int k=0; k<order[0]; k++){
+      if (idx_C.find(idx_A[k]) == std::string::npos) kk += idx_A[k];
+    }
+    std::string pidx[3] = {ii+kk+hh, kk+jj+hh, ii+jj+hh};
+    std::string const * sidx[3] = {&idx_A, &idx_B, &idx_C};
+    std::vector<int> perm[3];
+    for (int j=0; j<3; j++){
+      for (int k=0; k<order[j]; k++){
+        perm[j].push_back((int)sidx[j]->find(pidx[j][k]));
+      }
+    }
+    int64_t I = 1, J = 1, K = 1, H = 1;
+    for (int k=0; k<(int)ii.size(); k++) I *= lens[2][idx_C.find(ii[k])];
+    for (int k=0; k<(int)jj.size(); k++) J *= lens[2][idx_C.find(jj[k])];
+    for (int k=0; k<(int)kk.size(); k++) K *= lens[0][idx_A.find(kk[k])];
+    for (int k=0; k<(int)hh.size(); k++) H *= lens[2][idx_C.find(hh[k])];
+
+    dtype * tsp[3];
+    for (int j=0; j<3; j++){
+      tsp[j] = (dtype*)CTF_int::alloc(std::max((int64_t)1, nmy*nel[j])*ds);
+    }
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int m=0; m<nmy; m++){
+      ctr_task const & t = tasks[rank+m*np];
+      for (int j=0; j<3; j++){
+        CTF_int::batched_ctr_transpose<dtype>(order[j], lens[j], perm[j].data(), true,
+                                              dense[j]+m*nel[j], tsp[j]+m*nel[j]);
+      }
+      char const * beta = has_beta[rank+m*np] ? (char const*)&t.beta : sr->addid();
+      for (int64_t h=0; h<H; h++){
+        sr->gemm('N', 'N', I, J, K, (char const*)&t.alpha,
+                 (char const*)(tsp[0]+m*nel[0]+h*I*K), (char const*)(tsp[1]+m*nel[1]+h*K*J),
+                 beta, (char*)(tsp[2]+m*nel[2]+h*I*J));
+      }
+      CTF_int::batched_ctr_transpose<dtype>(order[2], lens[2], perm[2].data(), false,
+                                            tsp[2]+m*nel[2], dense[2]+m*nel[2]);
+    }
+    CTF_int::flops_add(2*I*J*K*H*nmy);
+    for (int j=0; j<3; j++){
+      CTF_int::cdealloc(tsp[j]);
+    }
+    CTF_int::cdealloc(dense[0]);
+    CTF_int::cdealloc(dense[1]);
+
+    // reply to each process with the values of C for the keys it sent
+    std::vector<int64_t> rep_counts(np, 0), rep_displs(np, 0), back_counts(np, 0), back_displs(np, 0);
+    for (int s=0; s<np; s++){
+      for (int m=0; m<nmy; m++){
+        rep_counts[s] += nckey[s*nmy+m]*ds;
+      }
+    }
+    for (int i=0; i<ntask; i++){
+      back_counts[i%np] += nloc[3*i+2]*ds;
+    }
+    for (int p=1; p<np; p++){
+      rep_displs[p]  = rep_displs[p-1]+rep_counts[p-1];
+      back_displs[p] = back_displs[p-1]+back_counts[p-1];
+    }
+    char * rep_buf = (char*)CTF_int::alloc(std::max((int64_t)1, rep_displs[np-1]+rep_counts[np-1]));
+    for (int s=0; s<np; s++){
+      int64_t p = rep_displs[s];
+      for (int m=0; m<nmy; m++){
+        char const * kbuf = rbuf+ckey_pos[s*nmy+m];
+        for (int64_t k=0; k<nckey[s*nmy+m]; k++){
+          int64_t key;
+          memcpy(&key, kbuf+k*ks, ks);
+          memcpy(rep_buf+p, dense[2]+m*nel[2]+key, ds);
+          p += ds;
+        }
+      }
+    }
+    CTF_int::cdealloc(rbuf);
+    CTF_int::cdealloc(dense[2]);
+    char * back_buf = (char*)CTF_int::alloc(std::max((int64_t)1, back_displs[np-1]+back_counts[np-1]));
+    wrld->cdt.all_to_allv(rep_buf, &rep_counts[0], &rep_displs[0], 1, back_buf, &back_counts[0], &back_displs[0]);
+    CTF_int::cdealloc(rep_buf);
+
+    std::vector<int64_t> bpos(back_displs);
+    for (int i=0; i<ntask; i++){
+      int64_t & p = bpos[i%np];
+      for (int64_t k=0; k<nloc[3*i+2]; k++){
+        memcpy(tasks[i].C->data+offs[3*i+2][k]*ds, back_buf+p, ds);
+        p += ds;
+      }
+      tasks[i].C->data_modified();
+      if (keys[3*i+2] != NULL) CTF_int::cdealloc(keys[3*i+2]);
+      if (offs[3*i+2] != NULL) CTF_int::cdealloc(offs[3*i+2]);
+    }
+    CTF_int::cdealloc(back_buf);
+  }
+
+  template<typename dtype>
+  void Batched_Contraction<dtype>::clear(){
+    tasks.clear();
+  }
+}
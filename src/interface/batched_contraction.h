@@ -0,0 +1,120 @@
+#ifndef __BATCHED_CONTRACTION_H__
+#define __BATCHED_CONTRACTION_H__
+
+#ifndef BATCHED_CTR_MAX_SIZE
+/** \brief maximum number of elements of A, B and C together for which a contraction of a batch is done by a single process */
+#define BATCHED_CTR_MAX_SIZE 262144
+#endif
+
+namespace CTF {
+  /**
+   * \defgroup CTF CTF Tensor
+   * \addtogroup CTF
+   * @{
+   */
+  /**
+   * \brief a batch of independent contractions C[idx_C] = beta*C[idx_C] + alpha*A[idx_A]*B[idx_B]
+   *        with the same index pattern and the same tensor shapes, e.g. one per block or k-point,
+   *        which are too small to profit from being spread over all processes
+   *
+   *        Batched_Contraction<> bc("ik", "kj", "ij", dw);
+   *        for (int b=0; b<nb; b++) bc.add(A[b], B[b], C[b]);
+   *        bc.execute();
+   *
+   *        execute() assigns whole contractions to processes round-robin, gathers the operands of
+   *        each on its process with one all-to-all for the batch, contracts them there with a GEMM
+   *        per contraction, threaded over contractions, and returns the outputs with a second
+   *        all-to-all, so the cost does not grow with a collective per contraction;
+   *        index patterns with indices that appear in only one tensor or repeat within one,
+   *        symmetric or sparse tensors, algebraic structures without multiplication and tensors
+   *        larger than BATCHED_CTR_MAX_SIZE are contracted one at a time as usual
+   */
+  template<typename dtype=double>
+  class Batched_Contraction {
+    protected:
+      /** \brief a single registered contraction */
+      struct ctr_task {
+        Tensor<dtype> * A;
+        Tensor<dtype> * B;
+        Tensor<dtype> * C;
+        dtype           alpha;
+        dtype           beta;
+      };
+
+      /** \brief registered contractions, in order of registration */
+      std::vector<ctr_task> tasks;
+
+      /** \brief index strings of the operands and the output */
+      std::string idx_A, idx_B, idx_C;
+
+      /** \brief whether the index pattern can be contracted by GEMM after transposition */
+      bool is_gemm_pattern;
+
+      /**
+       * \brief whether the registered contractions may be done by one process each
+       */
+      bool is_batchable() const;
+
+      /**
+       * \brief contracts all registered contractions, each on a single process
+       */
+      void execute_batched();
+
+    public:
+      /** \brief world in which all operands live */
+      World * wrld;
+
+      /**
+       * \brief creates an empty batch of contractions
+       * \param[in] idx_A indices of the first operand of each contraction
+       * \param[in] idx_B indices of the second operand of each contraction
+       * \param[in] idx_C indices of the output of each contraction
+       * \param[in] wrld world in which all operands live
+       */
+      Batched_Contraction(char const * idx_A,
+                          char const * idx_B,
+                          char const * idx_C,
+                          World &      wrld=get_universe());
+
+      /**
+       * \brief registers C[idx_C] = A[idx_A]*B[idx_B]
+       * \param[in] A first operand, of the same shape as the first operands of the batch
+       * \param[in] B second operand, of the same shape as the second operands of the batch
+       * \param[in,out] C output, distinct from the outputs of other contractions of the batch
+       * \return position of the contraction in the batch
+       */
+      int add(Tensor<dtype> & A, Tensor<dtype> & B, Tensor<dtype> & C);
+
+      /**
+       * \brief registers C[idx_C] = beta*C[idx_C] + alpha*A[idx_A]*B[idx_B]
+       * \param[in] A first operand, of the same shape as the first operands of the batch
+       * \param[in] B second operand, of the same shape as the second operands of the batch
+       * \param[in,out] C output, distinct from the outputs of other contractions of the batch
+       * \param[in] alpha scaling factor of the product
+       * \param[in] beta scaling factor of the previous value of C
+       * \return position of the contraction in the batch
+       */
+      int add(Tensor<dtype> & A, Tensor<dtype> & B, Tensor<dtype> & C, dtype alpha, dtype beta);
+
+      /**
+       * \brief performs all registered contractions, collective over wrld
+       */
+      void execute();
+
+      /**
+       * \brief number of registered contractions
+       */
+      int size() const { return (int)tasks.size(); }
+
+      /**
+       * \brief removes all registered contractions
+       */
+      void clear();
+  };
+  /**
+   * @}
+   */
+}
+
+#include "batched_contraction.cxx"
+#endif
@@ -2,10 +2,45 @@
 
 #include "common.h"
 #include "../shared/util.h"
+#include "../tensor/algstrct.h"
+#include "../shared/memcontrol.h"
+#include "../mapping/topology.h"
+#include "../redistribution/sparse_rw.h"
+#include "world.h"
 #include <random>
 
 namespace CTF {
   int DGTOG_SWITCH = 1;
+  int REDSCAT_SWITCH = 1;
+  int64_t BOUNDED_REDIST_BYTES = 0;
+  int64_t NODE_ALLTOALLV_MIN_BYTES = NODE_ALLTOALLV_MIN_SZ;
+
+  void set_out_of_core(char const * dir, int64_t min_bytes){
+    // the file system is shared by the processes of a node, which the universe has detected
+    CTF_int::set_out_of_core(dir, min_bytes, get_universe().cdt.ppn);
+  }
+
+  bool is_out_of_core(){
+    return CTF_int::is_out_of_core();
+  }
+
+  double set_desym_mem_frac(double frac){
+    double prev_frac = CTF_int::get_desym_mem_frac();
+    CTF_int::set_desym_mem_frac(frac);
+    return prev_frac;
+  }
+
+  int set_topo_pool_comms(int ncomm){
+    int prev_ncomm = CTF_int::get_topo_pool_comms();
+    CTF_int::set_topo_pool_comms(ncomm);
+    return prev_ncomm;
+  }
+
+  int64_t set_sparse_pipeline_chunk_size(int64_t bytes){
+    int64_t prev_bytes = CTF_int::get_sparse_pipeline_chunk_size();
+    CTF_int::set_sparse_pipeline_chunk_size(bytes);
+    return prev_bytes;
+  }
 }
 
 namespace CTF_int {
@@ -37,6 +72,8 @@ namespace CTF_int {
 #endif
   LinModel<3> red_mdl(red_mdl_init,"red_mdl");
   LinModel<3> red_mdl_cst(red_mdl_cst_init,"red_mdl_cst");
+  LinModel<3> redscat_mdl(redscat_mdl_init,"redscat_mdl");
+  LinModel<3> redscat_mdl_cst(redscat_mdl_cst_init,"redscat_mdl_cst");
   LinModel<3> allred_mdl(allred_mdl_init,"allred_mdl");
   LinModel<3> allred_mdl_cst(allred_mdl_cst_init,"allred_mdl_cst");
   LinModel<3> bcast_mdl(bcast_mdl_init,"bcast_mdl");
@@ -174,6 +211,16 @@ namespace CTF_int {
     return total_flop_count;
   }
 
+  int64_t total_comm_bytes = 0;
+
+  void comm_bytes_add(int64_t n){
+    total_comm_bytes+=n;
+  }
+
+  int64_t get_comm_bytes(){
+    return total_comm_bytes;
+  }
+
   void handler() {
   #if (!BGP && !BGQ && !HOPPER)
     int i, size;
@@ -210,9 +257,21 @@ namespace CTF_int {
   #endif
   }
 
+  /**
+   * \brief factor by which to scale message volume in communication models,
+   *        accounting for faster shared-memory transfers within a node
+   */
+  static double vol_scale(CommData const * cdt){
+    return cdt->intra_node ? COST_SHMBW/COST_NETWBW : 1.0;
+  }
+
   CommData::CommData(){
-    alive = 0;
-    created = 0;
+    alive      = 0;
+    created    = 0;
+    ppn        = 1;
+    intra_node = 0;
+    node_cm    = MPI_COMM_NULL;
+    node_win   = NULL;
   }
 
   CommData::~CommData(){
@@ -220,21 +279,29 @@ namespace CTF_int {
   }
 
   CommData::CommData(CommData const & other){
-    cm      = other.cm;
-    alive   = other.alive;
-    rank    = other.rank;
-    np      = other.np;
-    color   = other.color;
-    created = 0;
+    cm         = other.cm;
+    alive      = other.alive;
+    rank       = other.rank;
+    np         = other.np;
+    color      = other.color;
+    created    = 0;
+    ppn        = other.ppn;
+    intra_node = other.intra_node;
+    node_cm    = other.node_cm;
+    node_win   = other.node_win;
   }
 
   CommData& CommData::operator=(CommData const & other){
-    cm      = other.cm;
-    alive   = other.alive;
-    rank    = other.rank;
-    np      = other.np;
-    color   = other.color;
-    created = 0;
+    cm         = other.cm;
+    alive      = other.alive;
+    rank       = other.rank;
+    np         = other.np;
+    color      = other.color;
+    created    = 0;
+    ppn        = other.ppn;
+    intra_node = other.intra_node;
+    node_cm    = other.node_cm;
+    node_win   = other.node_win;
     return *this;
   }
 
@@ -243,16 +310,24 @@ namespace CTF_int {
     cm = cm_;
     MPI_Comm_rank(cm, &rank);
     MPI_Comm_size(cm, &np);
-    alive = 1;
-    created = 0;
+    alive      = 1;
+    created    = 0;
+    ppn        = 1;
+    intra_node = 0;
+    node_cm    = MPI_COMM_NULL;
+    node_win   = NULL;
   }
 
   CommData::CommData(int rank_, int color_, int np_){
-    rank    = rank_;
-    color   = color_;
-    np      = np_;
-    alive   = 0;
-    created = 0;
+    rank       = rank_;
+    color      = color_;
+    np         = np_;
+    alive      = 0;
+    created    = 0;
+    ppn        = 1;
+    intra_node = 0;
+    node_cm    = MPI_COMM_NULL;
+    node_win   = NULL;
   }
 
   CommData::CommData(int rank_, int color_, CommData parent){
@@ -261,8 +336,12 @@ namespace CTF_int {
     ASSERT(parent.alive);
     MPI_Comm_split(parent.cm, color, rank_, &cm);
     MPI_Comm_size(cm, &np);
-    alive   = 1;
-    created = 1;
+    alive      = 1;
+    created    = 1;
+    ppn        = 1;
+    intra_node = 0;
+    node_cm    = MPI_COMM_NULL;
+    node_win   = NULL;
   }
 
   void CommData::activate(MPI_Comm parent){
@@ -287,14 +366,69 @@ namespace CTF_int {
       created = 0;
     }
   }
+
+  void CommData::init_node_comm(){
+    ASSERT(alive);
+    ppn        = 1;
+    intra_node = 0;
+    node_cm    = MPI_COMM_NULL;
+    node_win   = NULL;
+#if MPI_VERSION >= 3
+    MPI_Comm ncm;
+    MPI_Comm_split_type(cm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &ncm);
+    int nrank, nnp;
+    MPI_Comm_rank(ncm, &nrank);
+    MPI_Comm_size(ncm, &nnp);
+    //a node may be declared to hold fewer processes, in which case it is split into blocks of them
+    char * env_ppn = getenv("CTF_PPN");
+    if (env_ppn != NULL && atoi(env_ppn) >= 1 && atoi(env_ppn) < nnp && nnp%atoi(env_ppn) == 0){
+      MPI_Comm bcm;
+      MPI_Comm_split(ncm, nrank/atoi(env_ppn), nrank, &bcm);
+      MPI_Comm_free(&ncm);
+      ncm = bcm;
+      MPI_Comm_rank(ncm, &nrank);
+      MPI_Comm_size(ncm, &nnp);
+    }
+    //node-aware layouts assume each node holds the same number of consecutive ranks
+    int lyt[3] = {nnp, -nnp, (rank%nnp == nrank && np%nnp == 0)};
+    int glyt[3];
+    MPI_Allreduce(lyt, glyt, 2, MPI_INT, MPI_MAX, cm);
+    MPI_Allreduce(lyt+2, glyt+2, 1, MPI_INT, MPI_LAND, cm);
+    if (nnp > 1 && glyt[0] == -glyt[1] && glyt[2]){
+      ppn        = nnp;
+      intra_node = (ppn == np);
+      node_cm    = ncm;
+      node_win   = new shm_window;
+      node_win->seg_size = 0;
+      MPI_Win_allocate_shared(0, 1, MPI_INFO_NULL, node_cm, &node_win->seg, &node_win->win);
+    } else
+      MPI_Comm_free(&ncm);
+#endif
+  }
+
+  void CommData::free_node_comm(){
+    if (node_cm != MPI_COMM_NULL){
+      int is_finalized;
+      MPI_Finalized(&is_finalized);
+      if (!is_finalized){
+        MPI_Win_free(&node_win->win);
+        MPI_Comm_free(&node_cm);
+      }
+      delete node_win;
+      node_win = NULL;
+      node_cm = MPI_COMM_NULL;
+    }
+    ppn        = 1;
+    intra_node = 0;
+  }
      
   double CommData::estimate_bcast_time(int64_t msg_sz){
-    double ps[] = {1.0, log2((double)np), (double)msg_sz};
+    double ps[] = {1.0, log2((double)np), (double)msg_sz*vol_scale(this)};
     return bcast_mdl.est_time(ps);
   }
      
   double CommData::estimate_allred_time(int64_t msg_sz, MPI_Op op){
-    double ps[] = {1.0, log2((double)np), (double)msg_sz*log2((double)(np))};
+    double ps[] = {1.0, log2((double)np), (double)msg_sz*log2((double)(np))*vol_scale(this)};
     if (op >= MPI_MAX && op <= MPI_REPLACE)
       return allred_mdl.est_time(ps);
     else
@@ -302,12 +436,19 @@ namespace CTF_int {
   }
 
   double CommData::estimate_red_time(int64_t msg_sz, MPI_Op op){
-    double ps[] = {1.0, log2((double)np), (double)msg_sz*log2((double)(np))};
+    double ps[] = {1.0, log2((double)np), (double)msg_sz*log2((double)(np))*vol_scale(this)};
     if (op >= MPI_MAX && op <= MPI_REPLACE)
       return red_mdl.est_time(ps);
     else
       return red_mdl_cst.est_time(ps);
   }
+  double CommData::estimate_redscat_time(int64_t msg_sz, MPI_Op op){
+    double ps[] = {1.0, log2((double)np), (double)msg_sz*2.*(np-1.)/np*vol_scale(this)};
+    if (op >= MPI_MAX && op <= MPI_REPLACE)
+      return redscat_mdl.est_time(ps);
+    else
+      return redscat_mdl_cst.est_time(ps);
+  }
 /* 
   double CommData::estimate_csrred_time(int64_t msg_sz, MPI_Op op){
     double ps[] = {1.0, log2((double)np), (double)msg_sz};
@@ -319,12 +460,12 @@ namespace CTF_int {
 
   
   double CommData::estimate_alltoall_time(int64_t chunk_sz) {
-    double ps[] = {1.0, log2((double)np), log2((double)np)*np*chunk_sz};
+    double ps[] = {1.0, log2((double)np), log2((double)np)*np*chunk_sz*vol_scale(this)};
     return alltoall_mdl.est_time(ps);
   }
   
   double CommData::estimate_alltoallv_time(int64_t tot_sz) {
-    double ps[] = {1.0, log2((double)np), log2((double)np)*tot_sz};
+    double ps[] = {1.0, log2((double)np), log2((double)np)*tot_sz*vol_scale(this)};
     return alltoallv_mdl.est_time(ps);
   }
 
@@ -341,7 +482,8 @@ namespace CTF_int {
     double exe_time = MPI_Wtime()-st_time;
     int tsize;
     MPI_Type_size(mdtype, &tsize);
-    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize};
+    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*vol_scale(this)};
+    comm_bytes_add(count*tsize);
     bcast_mdl.observe(tps);
   }
 
@@ -357,7 +499,8 @@ namespace CTF_int {
     double exe_time = MPI_Wtime()-st_time;
     int tsize;
     MPI_Type_size(mdtype, &tsize);
-    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*std::max(.5,(double)log2(np))};
+    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*std::max(.5,(double)log2(np))*vol_scale(this)};
+    comm_bytes_add(count*tsize);
     if (op >= MPI_MAX && op <= MPI_REPLACE)
       allred_mdl.observe(tps);
     else
@@ -376,13 +519,308 @@ namespace CTF_int {
     double exe_time = MPI_Wtime()-st_time;
     int tsize;
     MPI_Type_size(mdtype, &tsize);
-    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*std::max(.5,(double)log2(np))};
+    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*std::max(.5,(double)log2(np))*vol_scale(this)};
+    comm_bytes_add(count*tsize);
     if (op >= MPI_MAX && op <= MPI_REPLACE)
       red_mdl.observe(tps);
     else
       red_mdl_cst.observe(tps);
   }
 
+  void CommData::redscat_gather(void * buf, int64_t count, MPI_Datatype mdtype, MPI_Op op, int root){
+    if (np == 1) return;
+    if (count > INT_MAX){
+      if (rank == root)
+        red(MPI_IN_PLACE, buf, count, mdtype, op, root);
+      else
+        red(buf, NULL, count, mdtype, op, root);
+      return;
+    }
+#ifdef TUNE
+    MPI_Barrier(cm);
+#endif
+    double st_time = MPI_Wtime();
+    int tsize;
+    MPI_Type_size(mdtype, &tsize);
+    int * counts, * displs;
+    CTF_int::alloc_ptr(sizeof(int)*np, (void**)&counts);
+    CTF_int::alloc_ptr(sizeof(int)*np, (void**)&displs);
+    for (int i=0; i<np; i++){
+      displs[i] = (count*i)/np;
+      counts[i] = (count*(i+1))/np - displs[i];
+    }
+    // in place, the reduced block owned by each process is left at the start of buf
+    MPI_Reduce_scatter(MPI_IN_PLACE, buf, counts, mdtype, op, cm);
+    if (rank == root){
+      memmove(((char*)buf)+((int64_t)displs[rank])*tsize, buf, ((int64_t)counts[rank])*tsize);
+      MPI_Gatherv(MPI_IN_PLACE, counts[rank], mdtype, buf, counts, displs, mdtype, root, cm);
+    } else
+      MPI_Gatherv(buf, counts[rank], mdtype, NULL, NULL, NULL, mdtype, root, cm);
+    CTF_int::cdealloc(counts);
+    CTF_int::cdealloc(displs);
+#ifdef TUNE
+    MPI_Barrier(cm);
+#endif
+    double exe_time = MPI_Wtime()-st_time;
+    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*2.*(np-1.)/np*vol_scale(this)};
+    comm_bytes_add(count*tsize);
+    if (op >= MPI_MAX && op <= MPI_REPLACE)
+      redscat_mdl.observe(tps);
+    else
+      redscat_mdl_cst.observe(tps);
+  }
+  /**
+   * \brief whether op is one of the predefined MPI reduction operators
+   */
+  static bool is_builtin_mop(MPI_Op op){
+    return op == MPI_SUM  || op == MPI_PROD || op == MPI_MAX  || op == MPI_MIN    ||
+           op == MPI_LAND || op == MPI_LOR  || op == MPI_LXOR || op == MPI_BAND   ||
+           op == MPI_BOR  || op == MPI_BXOR || op == MPI_MINLOC || op == MPI_MAXLOC ||
+           op == MPI_REPLACE;
+  }
+
+  /**
+   * \brief Y = X + Y with the addition of sr, split among threads
+   */
+  static void par_accum(algstrct const * sr, int64_t n, char const * X, char * Y){
+    int ntd = 1;
+#ifdef USE_OMP
+    ntd = std::min((int64_t)omp_get_max_threads(), std::max((int64_t)1, n*sr->el_size/4096));
+    #pragma omp parallel for num_threads(ntd)
+#endif
+    for (int t=0; t<ntd; t++){
+      int64_t st = (n*t)/ntd;
+      int64_t en = (n*(t+1))/ntd;
+      if (en > st)
+        sr->axpy(en-st, sr->mulid(), X+st*sr->el_size, 1, Y+st*sr->el_size, 1);
+    }
+  }
+
+  /**
+   * \brief ring reduce-scatter of buf with the addition of sr, each block is exchanged in chunks
+   *        of PIPE_RED_CHUNK_SZ bytes, which are added as soon as they arrive while the rest of
+   *        the block is in flight; afterwards process r holds the fully reduced block (r+1)%np
+   *        at its place in buf
+   * \param[in] cdt communicator
+   * \param[in,out] buf data to reduce
+   * \param[in] displs offsets of the np blocks in elements
+   * \param[in] counts sizes of the np blocks in elements
+   * \param[in] sr algebraic structure whose addition reduces the elements
+   */
+  static void pipe_ring_redscat(CommData const * cdt, char * buf, int64_t const * displs, int64_t const * counts, algstrct const * sr){
+    int np = cdt->np;
+    int left  = (cdt->rank+np-1)%np;
+    int right = (cdt->rank+1)%np;
+    int64_t el_size = sr->el_size;
+    int64_t chnk = std::max((int64_t)1, (int64_t)PIPE_RED_CHUNK_SZ/el_size);
+    int64_t max_cnt = 0;
+    for (int i=0; i<np; i++){
+      max_cnt = std::max(max_cnt, counts[i]);
+    }
+    int64_t max_nchnk = (max_cnt+chnk-1)/chnk;
+    char * rbuf;
+    MPI_Request * sreqs, * rreqs;
+    CTF_int::alloc_ptr(std::max((int64_t)1,max_cnt)*el_size, (void**)&rbuf);
+    CTF_int::alloc_ptr(std::max((int64_t)1,max_nchnk)*sizeof(MPI_Request), (void**)&sreqs);
+    CTF_int::alloc_ptr(std::max((int64_t)1,max_nchnk)*sizeof(MPI_Request), (void**)&rreqs);
+    for (int s=0; s<np-1; s++){
+      int sblk = (cdt->rank-s+np)%np;
+      int rblk = (cdt->rank-s-1+2*np)%np;
+      int nsc = (counts[sblk]+chnk-1)/chnk;
+      int nrc = (counts[rblk]+chnk-1)/chnk;
+      for (int k=0; k<nrc; k++){
+        int64_t n = std::min(chnk, counts[rblk]-k*chnk);
+        MPI_Irecv(rbuf+k*chnk*el_size, n*el_size, MPI_CHAR, left, s, cdt->cm, rreqs+k);
+      }
+      for (int k=0; k<nsc; k++){
+        int64_t n = std::min(chnk, counts[sblk]-k*chnk);
+        MPI_Isend(buf+(displs[sblk]+k*chnk)*el_size, n*el_size, MPI_CHAR, right, s, cdt->cm, sreqs+k);
+      }
+      for (int k=0; k<nrc; k++){
+        int64_t n = std::min(chnk, counts[rblk]-k*chnk);
+        MPI_Wait(rreqs+k, MPI_STATUS_IGNORE);
+        par_accum(sr, n, rbuf+k*chnk*el_size, buf+(displs[rblk]+k*chnk)*el_size);
+      }
+      MPI_Waitall(nsc, sreqs, MPI_STATUSES_IGNORE);
+    }
+    CTF_int::cdealloc(rbuf);
+    CTF_int::cdealloc(sreqs);
+    CTF_int::cdealloc(rreqs);
+  }
+
+  /**
+   * \brief whether a reduction with sr on count elements should use pipe_ring_redscat
+   */
+  static bool use_pipe_red(CommData const * cdt, int64_t count, algstrct const * sr){
+    return cdt->np > 1 && !is_builtin_mop(sr->addmop()) &&
+           count*sr->el_size >= PIPE_RED_MIN_SZ && count*sr->el_size <= INT_MAX;
+  }
+
+  void CommData::red(void * buf, int64_t count, algstrct const * sr, int root){
+    if (np == 1) return;
+    if (!use_pipe_red(this, count, sr)){
+      int64_t sz = count*sr->el_size;
+      bool is_redscat;
+      if (CTF::REDSCAT_SWITCH == 0)
+        is_redscat = estimate_redscat_time(sz, sr->addmop()) < estimate_red_time(sz, sr->addmop());
+      else
+        is_redscat = CTF::REDSCAT_SWITCH == 2;
+      if (is_redscat)
+        redscat_gather(buf, count, sr->mdtype(), sr->addmop(), root);
+      else if (rank == root)
+        red(MPI_IN_PLACE, buf, count, sr->mdtype(), sr->addmop(), root);
+      else
+        red(buf, NULL, count, sr->mdtype(), sr->addmop(), root);
+      return;
+    }
+#ifdef TUNE
+    MPI_Barrier(cm);
+#endif
+    double st_time = MPI_Wtime();
+    int64_t * displs, * counts;
+    int * gdispls, * gcounts;
+    CTF_int::alloc_ptr(sizeof(int64_t)*np, (void**)&displs);
+    CTF_int::alloc_ptr(sizeof(int64_t)*np, (void**)&counts);
+    CTF_int::alloc_ptr(sizeof(int)*np, (void**)&gdispls);
+    CTF_int::alloc_ptr(sizeof(int)*np, (void**)&gcounts);
+    for (int i=0; i<np; i++){
+      displs[i] = (count*i)/np;
+      counts[i] = (count*(i+1))/np - displs[i];
+    }
+    pipe_ring_redscat(this, (char*)buf, displs, counts, sr);
+    // process i holds block (i+1)%np, gathered in bytes so counts stay below INT_MAX
+    for (int i=0; i<np; i++){
+      gdispls[i] = displs[(i+1)%np]*sr->el_size;
+      gcounts[i] = counts[(i+1)%np]*sr->el_size;
+    }
+    if (rank == root)
+      MPI_Gatherv(MPI_IN_PLACE, gcounts[rank], MPI_CHAR, buf, gcounts, gdispls, MPI_CHAR, root, cm);
+    else
+      MPI_Gatherv(((char*)buf)+gdispls[rank], gcounts[rank], MPI_CHAR, NULL, NULL, NULL, MPI_CHAR, root, cm);
+    CTF_int::cdealloc(displs);
+    CTF_int::cdealloc(counts);
+    CTF_int::cdealloc(gdispls);
+    CTF_int::cdealloc(gcounts);
+#ifdef TUNE
+    MPI_Barrier(cm);
+#endif
+    double exe_time = MPI_Wtime()-st_time;
+    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*sr->el_size*2.*(np-1.)/np*vol_scale(this)};
+    comm_bytes_add(count*sr->el_size);
+    redscat_mdl_cst.observe(tps);
+  }
+
+  void CommData::allred(void * buf, int64_t count, algstrct const * sr){
+    if (np == 1) return;
+    if (!use_pipe_red(this, count, sr)){
+      allred(MPI_IN_PLACE, buf, count, sr->mdtype(), sr->addmop());
+      return;
+    }
+#ifdef TUNE
+    MPI_Barrier(cm);
+#endif
+    double st_time = MPI_Wtime();
+    int64_t * displs, * counts;
+    int * gdispls, * gcounts;
+    CTF_int::alloc_ptr(sizeof(int64_t)*np, (void**)&displs);
+    CTF_int::alloc_ptr(sizeof(int64_t)*np, (void**)&counts);
+    CTF_int::alloc_ptr(sizeof(int)*np, (void**)&gdispls);
+    CTF_int::alloc_ptr(sizeof(int)*np, (void**)&gcounts);
+    for (int i=0; i<np; i++){
+      displs[i] = (count*i)/np;
+      counts[i] = (count*(i+1))/np - displs[i];
+    }
+    pipe_ring_redscat(this, (char*)buf, displs, counts, sr);
+    for (int i=0; i<np; i++){
+      gdispls[i] = displs[(i+1)%np]*sr->el_size;
+      gcounts[i] = counts[(i+1)%np]*sr->el_size;
+    }
+    MPI_Allgatherv(MPI_IN_PLACE, gcounts[rank], MPI_CHAR, buf, gcounts, gdispls, MPI_CHAR, cm);
+    CTF_int::cdealloc(displs);
+    CTF_int::cdealloc(counts);
+    CTF_int::cdealloc(gdispls);
+    CTF_int::cdealloc(gcounts);
+#ifdef TUNE
+    MPI_Barrier(cm);
+#endif
+    double exe_time = MPI_Wtime()-st_time;
+    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*sr->el_size*std::max(.5,(double)log2(np))*vol_scale(this)};
+    comm_bytes_add(count*sr->el_size);
+    allred_mdl_cst.observe(tps);
+  }
+
+
+
+  /**
+   * \brief performs the part of an all-to-all-v destined to ranks on the same node
+   *        by staging send data in the shared-memory window of the node, from which each
+   *        node-local receiver copies its data directly
+   * \param[in] cdt communicator with node_cm and node_win defined
+   * \param[in] send_buffer data to send
+   * \param[in] send_counts number of datums to send to each process
+   * \param[in] send_displs displacements of datum sets in sen_buffer
+   * \param[in] datum_size size of MPI_datatype to use
+   * \param[in,out] recv_buffer data to recv
+   * \param[in] recv_counts number of datums to recv to each process
+   * \param[in] recv_displs displacements of datum sets in sen_buffer
+   */
+  static void node_all_to_allv(CommData const & cdt,
+                               void *           send_buffer,
+                               int64_t const *  send_counts,
+                               int64_t const *  send_displs,
+                               int64_t          datum_size,
+                               void *           recv_buffer,
+                               int64_t const *  recv_counts,
+                               int64_t const *  recv_displs){
+#if MPI_VERSION >= 3
+    int ppn = cdt.ppn;
+    int base = (cdt.rank/ppn)*ppn;
+    int64_t seg_st = INT64_MAX, seg_end = 0;
+    for (int q=0; q<ppn; q++){
+      if (send_counts[base+q] != 0){
+        seg_st  = std::min(seg_st, send_displs[base+q]);
+        seg_end = std::max(seg_end, send_displs[base+q]+send_counts[base+q]);
+      }
+    }
+    if (seg_st > seg_end) seg_st = seg_end;
+    int64_t * my_displs = (int64_t*)CTF_int::alloc(sizeof(int64_t)*ppn);
+    int64_t * peer_displs = (int64_t*)CTF_int::alloc(sizeof(int64_t)*ppn);
+    for (int q=0; q<ppn; q++){
+      my_displs[q] = send_displs[base+q]-seg_st;
+    }
+    MPI_Alltoall(my_displs, 1, MPI_INT64_T, peer_displs, 1, MPI_INT64_T, cdt.node_cm);
+
+    //the window is reallocated (collectively) only when some rank needs a larger segment
+    shm_window * nw = cdt.node_win;
+    int64_t seg_size = (seg_end-seg_st)*datum_size;
+    MPI_Allreduce(MPI_IN_PLACE, &seg_size, 1, MPI_INT64_T, MPI_MAX, cdt.node_cm);
+    if (seg_size > nw->seg_size){
+      MPI_Win_free(&nw->win);
+      nw->seg_size = std::max(seg_size, 2*nw->seg_size);
+      MPI_Win_allocate_shared(nw->seg_size, 1, MPI_INFO_NULL, cdt.node_cm, &nw->seg, &nw->win);
+    }
+    memcpy(nw->seg, ((char*)send_buffer)+seg_st*datum_size, (seg_end-seg_st)*datum_size);
+    MPI_Win_fence(0, nw->win);
+    for (int lq=0; lq<ppn; lq++){
+      int q = (lq+cdt.rank)%ppn;
+      if (recv_counts[base+q] != 0){
+        MPI_Aint qsz;
+        int qdu;
+        char * qseg;
+        MPI_Win_shared_query(nw->win, q, &qsz, &qdu, &qseg);
+        memcpy(((char*)recv_buffer)+recv_displs[base+q]*datum_size,
+               qseg+peer_displs[q]*datum_size,
+               recv_counts[base+q]*datum_size);
+      }
+    }
+    //no rank overwrites its segment in a later call before the others have read it
+    MPI_Win_fence(0, nw->win);
+    CTF_int::cdealloc(my_displs);
+    CTF_int::cdealloc(peer_displs);
+#else
+    ABORT;
+#endif
+  }
 
   void CommData::all_to_allv(void *          send_buffer,
                              int64_t const * send_counts,
@@ -395,6 +833,38 @@ namespace CTF_int {
     MPI_Barrier(cm);
 #endif
     double st_time = MPI_Wtime();
+    int64_t tot_sz = std::max(send_displs[np-1]+send_counts[np-1], recv_displs[np-1]+recv_counts[np-1])*datum_size;
+    for (int p=0; p<np; p++){
+      if (p != rank) comm_bytes_add(send_counts[p]*datum_size);
+    }
+    int64_t * rmt_send_counts = NULL;
+    int64_t * rmt_recv_counts = NULL;
+    //largest displacement and largest volume any rank sends within its node
+    int64_t max_szs[2] = {std::max(recv_displs[np-1], send_displs[np-1]), 0};
+    if (node_cm != MPI_COMM_NULL){
+      int base = (rank/ppn)*ppn;
+      for (int q=0; q<ppn; q++){
+        max_szs[1] += send_counts[base+q]*datum_size;
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, max_szs, 2, MPI_INT64_T, MPI_MAX, cm);
+    int64_t tot_max_displs = max_szs[0];
+    if (node_cm != MPI_COMM_NULL && max_szs[1] >= CTF::NODE_ALLTOALLV_MIN_BYTES){
+      //exchange with ranks on this node through shared memory, leave only off-node messages to MPI,
+      //worth its extra node collectives, fences and copies only for large enough volumes
+      node_all_to_allv(*this, send_buffer, send_counts, send_displs, datum_size,
+                       recv_buffer, recv_counts, recv_displs);
+      CTF_int::mst_alloc_ptr(np*sizeof(int64_t), (void**)&rmt_send_counts);
+      CTF_int::mst_alloc_ptr(np*sizeof(int64_t), (void**)&rmt_recv_counts);
+      int base = (rank/ppn)*ppn;
+      for (int p=0; p<np; p++){
+        bool is_lcl = p >= base && p < base+ppn;
+        rmt_send_counts[p] = is_lcl ? 0 : send_counts[p];
+        rmt_recv_counts[p] = is_lcl ? 0 : recv_counts[p];
+      }
+      send_counts = rmt_send_counts;
+      recv_counts = rmt_recv_counts;
+    }
     int num_nnz_trgt = 0;
     int num_nnz_recv = 0;
     for (int p=0; p<np; p++){
@@ -406,11 +876,6 @@ namespace CTF_int {
     MPI_Allreduce(&frac_nnz, &tot_frac_nnz, 1, MPI_DOUBLE, MPI_SUM, cm);
     tot_frac_nnz = tot_frac_nnz / np;
 
-    int64_t max_displs = std::max(recv_displs[np-1], send_displs[np-1]);
-    int64_t tot_max_displs;
-    
-    MPI_Allreduce(&max_displs, &tot_max_displs, 1, MPI_INT64_T, MPI_MAX, cm);
-    
     if (tot_max_displs >= INT32_MAX ||
         (datum_size != 4 && datum_size != 8 && datum_size != 16) ||
         (tot_frac_nnz <= .25 && tot_frac_nnz*np < 100)){
@@ -481,9 +946,12 @@ namespace CTF_int {
 #ifdef TUNE
     MPI_Barrier(cm);
 #endif
+    if (rmt_send_counts != NULL){
+      CTF_int::cdealloc(rmt_send_counts);
+      CTF_int::cdealloc(rmt_recv_counts);
+    }
     double exe_time = MPI_Wtime()-st_time;
-    int64_t tot_sz = std::max(send_displs[np-1]+send_counts[np-1], recv_displs[np-1]+recv_counts[np-1])*datum_size;
-    double tps[] = {exe_time, 1.0, log2(np), (double)tot_sz};
+    double tps[] = {exe_time, 1.0, log2(np), (double)tot_sz*vol_scale(this)};
     alltoallv_mdl.observe(tps);
   }
 
@@ -48,6 +48,60 @@ namespace CTF {
    */
   extern int DGTOG_SWITCH;
 
+  /**
+   * \brief reduction of partial sums of contraction outputs: 1 (default) by MPI_Reduce, 2 by
+   *        reduce-scatter and gather, 0 by whichever is modeled to be faster, though the
+   *        reduce-scatter models are unfitted seeds derived from those of MPI_Reduce
+   */
+  extern int REDSCAT_SWITCH;
+
+  /**
+   * \brief bytes per round of bounded-memory redistribution, if zero used only when memory is short
+   */
+  extern int64_t BOUNDED_REDIST_BYTES;
+
+  /**
+   * \brief all-to-all-v exchanges in which some rank sends at least this many bytes within its node
+   *        pass those through the shared-memory window of the node, smaller ones use MPI alone
+   */
+  extern int64_t NODE_ALLTOALLV_MIN_BYTES;
+
+  /**
+   * \brief backs tensor data of at least min_bytes by files in dir (NULL for memory), to page tensors larger than memory
+   * \param[in] dir directory on local storage, such as a node-local NVMe scratch file system
+   * \param[in] min_bytes smallest buffer to back by a file
+   */
+  void set_out_of_core(char const * dir, int64_t min_bytes=(1<<26));
+
+  /**
+   * \brief whether the data of any tensor is currently backed by a file
+   */
+  bool is_out_of_core();
+
+  /**
+   * \brief sets the memory fraction for unpacked copies of AS/SH operands with broken symmetry (SY ones are always unpacked)
+   * \param[in] frac memory fraction, also set by the CTF_DESYM_MEM_FRAC environment variable
+   * \return previous fraction
+   */
+  double set_desym_mem_frac(double frac);
+
+  /**
+   * \brief sets how many subcommunicators the topologies of each World may keep alive between
+   *        operations (TOPO_POOL_COMMS by default), beyond which those of the least recently used
+   *        topologies are freed at the next activation
+   * \param[in] ncomm number of communicators
+   * \return previous number
+   */
+  int set_topo_pool_comms(int ncomm);
+
+  /**
+   * \brief sets the bytes of pairs per message (SPARSE_PIPELINE_CHUNK_SIZE by default) of writes of
+   *        pairs exchanged point-to-point, which happens when some process writes two chunks or more
+   * \param[in] bytes chunk size
+   * \return previous chunk size
+   */
+  int64_t set_sparse_pipeline_chunk_size(int64_t bytes);
+
   /**
    * \brief reduction types for tensor data
    *        deprecated types: OP_NORM1=OP_SUMABS, OP_NORM2=call norm2(), OP_NORM_INFTY=OP_MAXABS
@@ -128,6 +182,26 @@ namespace CTF_int {
 
   int64_t get_flops();
 
+  /** \brief counts n bytes sent by this process through CommData or by redistribution */
+  void comm_bytes_add(int64_t n);
+
+  /** \brief number of bytes this process has sent through CommData or by redistribution */
+  int64_t get_comm_bytes();
+
+  class algstrct;
+
+  /**
+   * \brief MPI-3 shared-memory window of a node communicator, through which node-local
+   *        all-to-all-v data is staged, kept between calls and grown when too small
+   */
+  struct shm_window {
+    MPI_Win win;
+    /** \brief this rank's segment of the window */
+    char * seg;
+    /** \brief size in bytes of the segment of each rank */
+    int64_t seg_size;
+  };
+
   class CommData {
     public:
       MPI_Comm cm;
@@ -136,6 +210,14 @@ namespace CTF_int {
       int color;
       int alive;
       int created;
+      /** \brief number of consecutive ranks of this comm residing on each node (1 if unknown or irregular) */
+      int ppn;
+      /** \brief whether all ranks of this comm reside on a single node */
+      int intra_node;
+      /** \brief shared-memory communicator of ranks on this node (not owned, MPI_COMM_NULL if unavailable) */
+      MPI_Comm node_cm;
+      /** \brief shared-memory window on node_cm (not owned, NULL if node_cm is unavailable) */
+      shm_window * node_win;
   
       CommData();
       ~CommData();
@@ -174,6 +256,15 @@ namespace CTF_int {
 
       /* \brief deactivate (MPI_Free) this comm */
       void deactivate();
+
+      /**
+       * \brief detects ranks sharing a node via MPI_Comm_split_type and sets ppn, node_cm, and node_win
+       *        if nodes hold equal-sized contiguous blocks of ranks (of CTF_PPN ranks if it is set), collective on cm
+       */
+      void init_node_comm();
+
+      /* \brief frees node_cm and node_win, should be called only by the owner of the comm (World) */
+      void free_node_comm();
      
       /* \brief provide estimate of broadcast execution time */
       double estimate_bcast_time(int64_t msg_sz);
@@ -184,6 +275,9 @@ namespace CTF_int {
       /* \brief provide estimate of reduction execution time */
       double estimate_red_time(int64_t msg_sz, MPI_Op op);
      
+      /* \brief provide estimate of reduction execution time via reduce-scatter and gather */
+      double estimate_redscat_time(int64_t msg_sz, MPI_Op op);
+     
       /* \brief provide estimate of sparse reduction execution time */
 //      double estimate_csrred_time(int64_t msg_sz, MPI_Op op);
      
@@ -208,6 +302,39 @@ namespace CTF_int {
        */
       void red(void * inbuf, void * outbuf, int64_t count, MPI_Datatype mdtype, MPI_Op op, int root);
 
+      /**
+       * \brief in-place reduction of buf to root performed as a reduce-scatter followed by
+       *        a gather, which moves 2(np-1)/np*count data per process rather than log(np)*count
+       * \param[in,out] buf data to reduce, result on root, contents undefined elsewhere
+       * \param[in] count number of elements in buf
+       * \param[in] mdtype MPI datatype of elements
+       * \param[in] op reduction operator
+       * \param[in] root rank to reduce to
+       */
+      void redscat_gather(void * buf, int64_t count, MPI_Datatype mdtype, MPI_Op op, int root);
+
+      /**
+       * \brief in-place reduction of buf to root with the addition of sr, for non-builtin MPI ops
+       *        on at least PIPE_RED_MIN_SZ bytes done by a pipelined ring reduce-scatter that adds
+       *        received chunks with threads while later chunks are in flight, followed by a gather,
+       *        otherwise by MPI_Reduce or redscat_gather as chosen by CTF::REDSCAT_SWITCH
+       * \param[in,out] buf data to reduce, result on root, contents undefined elsewhere
+       * \param[in] count number of elements in buf
+       * \param[in] sr algebraic structure whose addition reduces the elements
+       * \param[in] root rank to reduce to
+       */
+      void red(void * buf, int64_t count, algstrct const * sr, int root);
+
+      /**
+       * \brief in-place allreduction of buf with the addition of sr, for non-builtin MPI ops
+       *        on at least PIPE_RED_MIN_SZ bytes done by a pipelined ring reduce-scatter followed
+       *        by an allgather, otherwise by MPI_Allreduce
+       * \param[in,out] buf data to reduce
+       * \param[in] count number of elements in buf
+       * \param[in] sr algebraic structure whose addition reduces the elements
+       */
+      void allred(void * buf, int64_t count, algstrct const * sr);
+
       /**
        * \brief performs all-to-all-v with 64-bit integer counts and offset on arbitrary
        *        length types (datum_size), and uses point-to-point when all-to-all-v sparse
@@ -24,8 +24,8 @@ namespace CTF_int {
   
   Unifun_Term::Unifun_Term(
       Unifun_Term const & other,
-      std::map<tensor*, tensor*>* remap) : Term(other.sr) {
-    sr->safecopy(this->scale, other.scale);
+      std::map<tensor*, tensor*>* remap) : Term(other.sr, !other.shares_sr() || remap != NULL) {
+    set_scale(other.scale);
     func = other.func;
     A = other.A->clone(remap);
   }
@@ -83,8 +83,8 @@ namespace CTF_int {
   
   Bifun_Term::Bifun_Term(
       Bifun_Term const & other,
-      std::map<tensor*, tensor*>* remap) : Term(other.sr) {
-    sr->safecopy(this->scale, other.scale);
+      std::map<tensor*, tensor*>* remap) : Term(other.sr, !other.shares_sr() || remap != NULL) {
+    set_scale(other.scale);
     func = other.func;
     A = other.A->clone(remap);
     B = other.B->clone(remap);
@@ -4,10 +4,12 @@
 #include "../scaling/scaling.h"
 #include "../summation/summation.h"
 #include "../contraction/contraction.h"
+#include "../shared/util.h"
+#include <type_traits>
+#include <new>
 
 
 namespace CTF {
-
 /**
  * @defgroup CTF_func CTF functions
  * \brief user-defined function interface
@@ -18,21 +20,23 @@ namespace CTF {
 
   /**
    * \brief custom scalar function on tensor: e.g. A["ij"] = f(A["ij"])
+   *        if F is the type of the functor (e.g. decltype of a lambda) rather than
+   *        std::function, f is inlined into the batched kernel apply_f_n
    */
-  template<typename dtype=double>
+  template<typename dtype=double, typename F=std::function<void(dtype&)>>
   class Endomorphism : public CTF_int::endomorphism {
     public:
       /**
        * \brief function signature for element-wise operation a=f(a)
        */
       //dtype (*f)(dtype);
-      std::function<void(dtype&)> f;
+      F f;
      
       /**
        * \brief constructor takes function pointer
        * \param[in] f_ scalar function: (type) -> (type)
        */
-      Endomorphism(std::function<void(dtype&)> f_){ f = f_; }
+      Endomorphism(F f_) : f(f_) { }
       /**
        * \brief default constructor
        */
@@ -44,27 +48,40 @@ namespace CTF {
        *                  is set to result of applying f on value at a
        */
       void apply_f(char * a) const { f(((dtype*)a)[0]); }
+
+      /**
+       * \brief apply function f to n consecutive values starting at a
+       * \param[in] n number of values
+       * \param[in,out] a pointer to first operand that will be cast to dtype
+       * \param[in] sr_A algebraic structure of operands
+       */
+      void apply_f_n(int64_t n, char * a, CTF_int::algstrct const * sr_A) const {
+        dtype * ta = (dtype*)a;
+        for (int64_t i=0; i<n; i++){
+          f(ta[i]);
+        }
+      }
   };
 
 
   /**
    * \brief custom function f : X -> Y to be applied to tensor elemetns: 
-   *          e.g. B["ij"] = f(A["ij"])
+   *          e.g. B["ij"] = f(A["ij"]), F may be the type of the functor to inline f
    */
-  template<typename dtype_A=double, typename dtype_B=dtype_A>
+  template<typename dtype_A=double, typename dtype_B=dtype_A, typename F=std::function<dtype_B(dtype_A)>>
   class Univar_Function : public CTF_int::univar_function {
     public:
       /**
        * \brief function signature for element-wise multiplication, compute b=f(a)
        */
       //dtype_B (*f)(dtype_A);
-      std::function<dtype_B(dtype_A)> f;
+      F f;
       
       /**
        * \brief constructor takes function pointers to compute B=f(A));
        * \param[in] f_ linear function (type_A)->(type_B)
        */
-      Univar_Function(std::function<dtype_B(dtype_A)> f_){ f = f_; }
+      Univar_Function(F f_) : f(f_) { }
 
       
       /**
@@ -85,27 +102,59 @@ namespace CTF {
         sr_B->add(b, (char const *)&tb, b);
       }
 
+      /**
+       * \brief compute b[i]=b[i]+f(a[i]) for n consecutive values, for trivially copyable
+       *        dtype_B with a multiplication, f is evaluated in blocks and accumulated with
+       *        a single axpy per block
+       * \param[in] n number of values
+       * \param[in] a pointer to first operand that will be cast to dtype_A
+       * \param[in,out] b pointer to first output that will be cast to dtype_B
+       * \param[in] sr_A algebraic structure for a
+       * \param[in] sr_B algebraic structure for b, needed to do add
+       */
+      void acc_f_n(int64_t n, char const * a, char * b, CTF_int::algstrct const * sr_A, CTF_int::algstrct const * sr_B) const {
+        dtype_A const * ta = (dtype_A const*)a;
+        dtype_B * tb = (dtype_B*)b;
+        if (!std::is_trivially_copyable<dtype_B>::value || !sr_B->has_mul()){
+          for (int64_t i=0; i<n; i++){
+            dtype_B tbi = f(ta[i]);
+            sr_B->add((char const*)(tb+i), (char const*)&tbi, (char*)(tb+i));
+          }
+          return;
+        }
+        // raw storage, as dtype_B need not be default-constructible
+        alignas(dtype_B) char buf[FUNC_BLK_SZ*sizeof(dtype_B)];
+        dtype_B * tbuf = (dtype_B*)buf;
+        for (int64_t i=0; i<n; i+=FUNC_BLK_SZ){
+          int blk = (int)std::min((int64_t)FUNC_BLK_SZ, n-i);
+          for (int j=0; j<blk; j++){
+            new (tbuf+j) dtype_B(f(ta[i+j]));
+          }
+          sr_B->axpy(blk, sr_B->mulid(), (char const*)tbuf, 1, (char*)(tb+i), 1);
+        }
+      }
+
   };
 
 
   /**
    * \brief custom function f : (X * Y) -> X applied on two tensors as summation: 
-   *          e.g. B["ij"] = f(A["ij"],B["ij"])
+   *          e.g. B["ij"] = f(A["ij"],B["ij"]), F may be the type of the functor to inline f
    */
-  template<typename dtype_A=double, typename dtype_B=dtype_A>
+  template<typename dtype_A=double, typename dtype_B=dtype_A, typename F=std::function<void(dtype_A, dtype_B &)>>
   class Univar_Transform : public CTF_int::univar_function {
     public:
       /**
        * \brief function signature for element-wise multiplication, compute b=f(a)
        */
       //void (*f)(dtype_A, dtype_B &);
-      std::function<void(dtype_A, dtype_B &)> f;
+      F f;
       
       /**
        * \brief constructor takes function pointers to compute B=f(A));
        * \param[in] f_ linear function (type_A)->(type_B)
        */
-      Univar_Transform(std::function<void(dtype_A, dtype_B &)> f_){ f = f_; }
+      Univar_Transform(F f_) : f(f_) { }
 
       
       /**
@@ -125,30 +174,47 @@ namespace CTF {
         f(((dtype_A*)a)[0], ((dtype_B*)b)[0]);
       }
 
+      /**
+       * \brief compute f(a[i],b[i]) for n consecutive values
+       * \param[in] n number of values
+       * \param[in] a pointer to first accumulated operand
+       * \param[in,out] b pointer to first value that is accumulated to
+       * \param[in] sr_A algebraic structure for a, here is ignored
+       * \param[in] sr_B algebraic structure for b, here is ignored
+       */
+      void acc_f_n(int64_t n, char const * a, char * b, CTF_int::algstrct const * sr_A, CTF_int::algstrct const * sr_B) const {
+        dtype_A const * ta = (dtype_A const*)a;
+        dtype_B * tb = (dtype_B*)b;
+        for (int64_t i=0; i<n; i++){
+          f(ta[i], tb[i]);
+        }
+      }
+
       bool is_accumulator() const { return true; }
   };
 
 
   /**
    * \brief custom bivariate function on two tensors: 
-   *          e.g. C["ij"] = f(A["ik"],B["kj"])
+   *          e.g. C["ij"] = f(A["ik"],B["kj"]), F may be the type of the functor to
+   *          inline f into the sparse kernels below
    */
-  template<typename dtype_A=double, typename dtype_B=dtype_A, typename dtype_C=dtype_A>
+  template<typename dtype_A=double, typename dtype_B=dtype_A, typename dtype_C=dtype_A, typename F=std::function<dtype_C (dtype_A, dtype_B)>>
   class Bivar_Function : public CTF_int::bivar_function {
     public:
       /**
        * \brief function signature for element-wise multiplication, compute C=f(A,B)
        */
       //dtype_C (*f)(dtype_A, dtype_B);
-      std::function<dtype_C (dtype_A, dtype_B)> f;
+      F f;
      
       /**
        * \brief constructor takes function pointers to compute C=f(A,B);
        * \param[in] f_ bivariate function (type_A,type_B)->(type_C)
        */
-      Bivar_Function(std::function<dtype_C (dtype_A, dtype_B)> f_)
-        : CTF_int::bivar_function(){
-        f=f_; commutative=0; 
+      Bivar_Function(F f_)
+        : CTF_int::bivar_function(), f(f_) {
+        commutative=0; 
       }
       
       /**
@@ -156,11 +222,9 @@ namespace CTF {
        * \param[in] f_ bivariate function (type_A,type_B)->(type_C)
        * \param[in] is_comm whether function is commutative
        */
-      Bivar_Function(std::function<dtype_C (dtype_A, dtype_B)> f_, 
-                     bool                                      is_comm)
-        : CTF_int::bivar_function(is_comm){
-        f=f_;
-      }
+      Bivar_Function(F    f_, 
+                     bool is_comm)
+        : CTF_int::bivar_function(is_comm), f(f_) { }
 
       /**
        * \brief default constructor sets function pointer to NULL
@@ -0,0 +1,323 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "common.h"
+#ifdef _OPENMP
+#include "omp.h"
+#endif
+
+namespace CTF_int {
+  /**
+   * \brief squared absolute value of a, the squared modulus for complex numbers
+   */
+  template <typename dtype>
+  inline dtype fused_abs2(dtype a){
+    return a*a;
+  }
+
+  template <typename dtype>
+  inline std::complex<dtype> fused_abs2(std::complex<dtype> a){
+    return std::norm(a);
+  }
+
+  template <typename dtype>
+  void char_fused_abs2(char const * a, char * b){
+    ((dtype*)b)[0] = fused_abs2(((dtype const*)a)[0]);
+  }
+
+  /**
+   * \brief largest absolute value of a tensor by the general routines, which needs an ordered type
+   */
+  template <typename dtype>
+  dtype general_maxabs(CTF::Tensor<dtype> & A){
+    return A.reduce(CTF::OP_MAXABS);
+  }
+
+  template <typename dtype>
+  std::complex<dtype> general_maxabs(CTF::Tensor< std::complex<dtype> > & A){
+    if (A.wrld->rank == 0)
+      printf("CTF ERROR: norm_infty() not available for complex tensor %s\n",A.name);
+    IASSERT(0);
+    return std::complex<dtype>();
+  }
+
+  /**
+   * \brief threaded reduction of local data, padding is assumed to be zero
+   * \param[in] type 0 for sum, 1 for sum of absolute values, 2 for sum of squares, 3 for dot product, 4 for max absolute value
+   * \param[in] n number of local elements
+   * \param[in] A local data of first operand
+   * \param[in] B local data of second operand (dot product only), mapped like A
+   * \return local partial reduction
+   */
+  template <typename dtype>
+  dtype fused_local_reduce(int n_type, int64_t n, dtype const * A, dtype const * B){
+    int const is_ord = CTF_int::get_default_is_ord<dtype>();
+    int ntd = 1;
+#ifdef _OPENMP
+    ntd = omp_get_max_threads();
+    if (n < FUSED_RED_MIN_PAR) ntd = 1;
+#endif
+    std::vector<dtype> part(ntd, dtype());
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(ntd)
+#endif
+    {
+      int tid = 0;
+#ifdef _OPENMP
+      tid = omp_get_thread_num();
+#endif
+      int64_t st = (n*tid)/ntd;
+      int64_t en = (n*(tid+1))/ntd;
+      dtype acc = dtype();
+      switch (n_type){
+        case 0:
+          for (int64_t i=st; i<en; i++) acc += A[i];
+          break;
+        case 1:
+          for (int64_t i=st; i<en; i++) acc += default_abs<dtype,is_ord>(A[i]);
+          break;
+        case 2:
+          for (int64_t i=st; i<en; i++) acc += fused_abs2(A[i]);
+          break;
+        case 3:
+          for (int64_t i=st; i<en; i++) acc += A[i]*B[i];
+          break;
+        case 4:
+          for (int64_t i=st; i<en; i++) acc = default_max<dtype,is_ord>(acc, default_abs<dtype,is_ord>(A[i]));
+          break;
+      }
+      part[tid] = acc;
+    }
+    dtype red = part[0];
+    for (int i=1; i<ntd; i++){
+      if (n_type == 4) red = default_max<dtype,is_ord>(red, part[i]);
+      else red += part[i];
+    }
+    return red;
+  }
+
+  /**
+   * \brief MPI reduction operator for a packed buffer of partial reductions, the buffer starts
+   *        with the number of sums (int64_t), followed by the partial sums and then partial maxima
+   */
+  template <typename dtype>
+  void fused_reduce_op(void * in, void * inout, int * len, MPI_Datatype * dt){
+    int const is_ord = CTF_int::get_default_is_ord<dtype>();
+    int sz;
+    MPI_Type_size(*dt, &sz);
+    int64_t nval = (sz-sizeof(int64_t))/sizeof(dtype);
+    for (int j=0; j<*len; j++){
+      char const * a = ((char const*)in)+j*(int64_t)sz;
+      char * b = ((char*)inout)+j*(int64_t)sz;
+      int64_t nsum;
+      memcpy(&nsum, a, sizeof(int64_t));
+      for (int64_t i=0; i<nval; i++){
+        dtype x, y;
+        memcpy(&x, a+sizeof(int64_t)+i*sizeof(dtype), sizeof(dtype));
+        memcpy(&y, b+sizeof(int64_t)+i*sizeof(dtype), sizeof(dtype));
+        if (i < nsum) y = x+y;
+        else y = default_max<dtype,is_ord>(x, y);
+        memcpy(b+sizeof(int64_t)+i*sizeof(dtype), &y, sizeof(dtype));
+      }
+    }
+  }
+
+  /**
+   * \brief MPI operator fused_reduce_op<dtype>, created on first use and kept for later batches
+   */
+  template <typename dtype>
+  MPI_Op get_fused_reduce_op(){
+    static MPI_Op op = MPI_OP_NULL;
+    if (op == MPI_OP_NULL)
+      MPI_Op_create(&fused_reduce_op<dtype>, 1, &op);
+    return op;
+  }
+}
+
+namespace CTF {
+  template<typename dtype>
+  Fused_Reduction<dtype>::Fused_Reduction(World & wrld_){
+    wrld    = &wrld_;
+    is_done = false;
+  }
+
+  template<typename dtype>
+  int Fused_Reduction<dtype>::add_term(red_type type, Tensor<dtype> & A, Tensor<dtype> * B, bool take_sqrt){
+    IASSERT(A.wrld->comm == wrld->comm);
+    if (B != NULL){
+      IASSERT(B->wrld->comm == wrld->comm);
+      IASSERT(B->order == A.order);
+      for (int i=0; i<A.order; i++){
+        IASSERT(B->lens[i] == A.lens[i]);
+      }
+    }
+    red_term t;
+    t.type      = type;
+    t.A         = &A;
+    t.B         = B;
+    t.take_sqrt = take_sqrt;
+    terms.push_back(t);
+    is_done = false;
+    return (int)terms.size()-1;
+  }
+
+  template<typename dtype>
+  bool Fused_Reduction<dtype>::is_fusable(Tensor<dtype> const & A){
+    if (A.is_sparse || !A.is_mapped) return false;
+    // the local data is reduced with the operators of dtype, so other algebraic structures go the general way
+    Semiring<dtype> const * sr = dynamic_cast<Semiring<dtype> const *>(A.sr);
+    if (sr == NULL || !sr->is_def) return false;
+    for (int i=0; i<A.order; i++){
+      if (A.sym[i] != NS) return false;
+    }
+    return true;
+  }
+
+  template<typename dtype>
+  int Fused_Reduction<dtype>::sum(Tensor<dtype> & A){
+    return add_term(RED_SUM, A, NULL, false);
+  }
+
+  template<typename dtype>
+  int Fused_Reduction<dtype>::norm1(Tensor<dtype> & A){
+    return add_term(RED_SUMABS, A, NULL, false);
+  }
+
+  template<typename dtype>
+  int Fused_Reduction<dtype>::norm2(Tensor<dtype> & A){
+    return add_term(RED_SUMSQ, A, NULL, true);
+  }
+
+  template<typename dtype>
+  int Fused_Reduction<dtype>::sumsq(Tensor<dtype> & A){
+    return add_term(RED_SUMSQ, A, NULL, false);
+  }
+
+  template<typename dtype>
+  int Fused_Reduction<dtype>::norm_infty(Tensor<dtype> & A){
+    return add_term(RED_MAXABS, A, NULL, false);
+  }
+
+  template<typename dtype>
+  int Fused_Reduction<dtype>::dot(Tensor<dtype> & A, Tensor<dtype> & B){
+    return add_term(RED_DOT, A, &B, false);
+  }
+
+  template<typename dtype>
+  void Fused_Reduction<dtype>::execute(){
+    int nterm = terms.size();
+    int nsum = 0;
+    for (int i=0; i<nterm; i++){
+      if (terms[i].type != RED_MAXABS) nsum++;
+    }
+    // sums are packed before maxima so the reduction operator knows which is which
+    int64_t bsz = sizeof(int64_t)+nterm*sizeof(dtype);
+    char * buf = (char*)CTF_int::alloc(bsz);
+    int64_t nsum64 = nsum;
+    memcpy(buf, &nsum64, sizeof(int64_t));
+    std::vector<int> slot(nterm);
+    int isum = 0, imax = nsum;
+    for (int i=0; i<nterm; i++){
+      slot[i] = terms[i].type == RED_MAXABS ? imax++ : isum++;
+    }
+
+    for (int i=0; i<nterm; i++){
+      red_term & t = terms[i];
+      Tensor<dtype> & A = *t.A;
+      dtype loc = dtype();
+      bool fusable = is_fusable(A) && (t.B == NULL || is_fusable(*t.B));
+      if (fusable){
+        A.unfold();
+        Tensor<dtype> * B = t.B;
+        Tensor<dtype> * Bc = NULL;
+        if (B != NULL){
+          B->unfold();
+          bool is_aligned = (A.topo == B->topo);
+          for (int j=0; j<A.order; j++){
+            if (!CTF_int::comp_dim_map(A.edge_map+j, B->edge_map+j)) is_aligned = false;
+          }
+          if (!is_aligned){
+            // redistribute a copy of B to the mapping of A
+            Bc = new Tensor<dtype>(*B);
+            Bc->align(A);
+            B = Bc;
+          }
+        }
+        // replicated copies of the local data contribute only once, for the max any copy is fine
+        if (t.type == RED_MAXABS || A.is_replica_root())
+          loc = CTF_int::fused_local_reduce<dtype>((int)t.type, A.size, (dtype const*)A.data,
+                                                   B == NULL ? NULL : (dtype const*)B->data);
+        if (Bc != NULL) delete Bc;
+      } else {
+        // symmetric or sparse operands are reduced by the general routines, whose result is
+        // available on every process, so for sums only the root contributes it
+        switch (t.type){
+          case RED_SUM:
+            A.reduce_sum((char*)&loc);
+            break;
+          case RED_SUMABS:
+            A.reduce_sumabs((char*)&loc);
+            break;
+          case RED_SUMSQ:
+            {
+              // sum of squared absolute values, as for the local data above
+              int idx[A.order];
+              for (int j=0; j<A.order; j++){
+                idx[j] = j;
+              }
+              CTF_int::univar_function func = CTF_int::univar_function(&CTF_int::char_fused_abs2<dtype>);
+              CTF_int::tensor sc = CTF_int::tensor(A.sr, 0, NULL, NULL, wrld, 1);
+              CTF_int::summation sm = CTF_int::summation(&A, idx, A.sr->mulid(), &sc, NULL, A.sr->mulid(), &func);
+              sm.execute();
+              A.sr->copy((char*)&loc, sc.data);
+            }
+            break;
+          case RED_MAXABS:
+            loc = CTF_int::general_maxabs(A);
+            break;
+          case RED_DOT:
+            {
+              int idx[A.order];
+              for (int j=0; j<A.order; j++){
+                idx[j] = j;
+              }
+              CTF_int::tensor sc = CTF_int::tensor(A.sr, 0, NULL, NULL, wrld, 1);
+              CTF_int::contraction ctr = CTF_int::contraction(&A, idx, t.B, idx, A.sr->mulid(), &sc, NULL, A.sr->addid());
+              ctr.execute();
+              A.sr->copy((char*)&loc, sc.data);
+            }
+            break;
+        }
+        if (t.type != RED_MAXABS && wrld->rank != 0) loc = dtype();
+      }
+      memcpy(buf+sizeof(int64_t)+slot[i]*sizeof(dtype), &loc, sizeof(dtype));
+    }
+
+    MPI_Datatype dt;
+    MPI_Type_contiguous(bsz, MPI_BYTE, &dt);
+    MPI_Type_commit(&dt);
+    MPI_Allreduce(MPI_IN_PLACE, buf, 1, dt, CTF_int::get_fused_reduce_op<dtype>(), wrld->comm);
+    MPI_Type_free(&dt);
+
+    results.resize(nterm);
+    for (int i=0; i<nterm; i++){
+      memcpy(&results[i], buf+sizeof(int64_t)+slot[i]*sizeof(dtype), sizeof(dtype));
+      if (terms[i].take_sqrt) results[i] = sqrt(results[i]);
+    }
+    CTF_int::cdealloc(buf);
+    is_done = true;
+  }
+
+  template<typename dtype>
+  dtype Fused_Reduction<dtype>::operator[](int i) const {
+    IASSERT(is_done);
+    IASSERT(i >= 0 && i < (int)results.size());
+    return results[i];
+  }
+
+  template<typename dtype>
+  void Fused_Reduction<dtype>::clear(){
+    terms.clear();
+    results.clear();
+    is_done = false;
+  }
+}
@@ -0,0 +1,151 @@
+#ifndef __FUSED_REDUCTION_H__
+#define __FUSED_REDUCTION_H__
+
+#ifndef FUSED_RED_MIN_PAR
+/** \brief minimum number of local elements for which local partial reductions are threaded */
+#define FUSED_RED_MIN_PAR 16384
+#endif
+
+namespace CTF {
+  /**
+   * \defgroup CTF CTF Tensor
+   * \addtogroup CTF
+   * @{
+   */
+  /**
+   * \brief a batch of scalar reductions (norms, sums, dot products) over tensors of one world,
+   *        local partial results are computed directly over the local blocks of each tensor and
+   *        are combined across processes by a single MPI_Allreduce, so that e.g. several norms
+   *        and inner products in an iterative solver cost one collective per iteration
+   *
+   *        Fused_Reduction<> fr(dw);
+   *        int ir = fr.norm2(r);
+   *        int ipq = fr.dot(p, q);
+   *        fr.execute();
+   *        double alpha = fr[ir]*fr[ir]/fr[ipq];
+   *
+   *        dense nonsymmetric tensors over the default Ring take the fused path, symmetric and sparse
+   *        tensors and those with other algebraic structures fall back to Tensor::reduce() and
+   *        contraction, whose results still enter the same collective
+   */
+  template<typename dtype=double>
+  class Fused_Reduction {
+    protected:
+      /** \brief kind of reduction registered */
+      enum red_type { RED_SUM, RED_SUMABS, RED_SUMSQ, RED_DOT, RED_MAXABS };
+
+      /** \brief a single registered reduction */
+      struct red_term {
+        red_type        type;
+        Tensor<dtype> * A;
+        Tensor<dtype> * B;
+        bool            take_sqrt;
+      };
+
+      /** \brief registered reductions, in order of registration */
+      std::vector<red_term> terms;
+
+      /** \brief results of the last call to execute() */
+      std::vector<dtype> results;
+
+      /** \brief whether execute() has been called since the last registration */
+      bool is_done;
+
+      /**
+       * \brief registers a reduction and returns its handle
+       * \param[in] type kind of reduction
+       * \param[in] A first operand
+       * \param[in] B second operand (for dot products)
+       * \param[in] take_sqrt whether the square root of the reduced value is returned
+       */
+      int add_term(red_type type, Tensor<dtype> & A, Tensor<dtype> * B, bool take_sqrt);
+
+      /**
+       * \brief whether the local data of A may be reduced directly
+       * \param[in] A tensor
+       */
+      static bool is_fusable(Tensor<dtype> const & A);
+
+    public:
+      /** \brief world over which the reductions are combined */
+      World * wrld;
+
+      /**
+       * \brief creates an empty batch of reductions
+       * \param[in] wrld world in which all operands live
+       */
+      Fused_Reduction(World & wrld=get_universe());
+
+      /**
+       * \brief registers the sum of all elements of A
+       * \param[in] A tensor
+       * \return handle with which to retrieve result via operator[] after execute()
+       */
+      int sum(Tensor<dtype> & A);
+
+      /**
+       * \brief registers the entrywise 1-norm of A
+       * \param[in] A tensor
+       * \return handle with which to retrieve result via operator[] after execute()
+       */
+      int norm1(Tensor<dtype> & A);
+
+      /**
+       * \brief registers the frobenius norm of A (needs sqrt()!)
+       * \param[in] A tensor
+       * \return handle with which to retrieve result via operator[] after execute()
+       */
+      int norm2(Tensor<dtype> & A);
+
+      /**
+       * \brief registers the sum of squares of the elements of A
+       * \param[in] A tensor
+       * \return handle with which to retrieve result via operator[] after execute()
+       */
+      int sumsq(Tensor<dtype> & A);
+
+      /**
+       * \brief registers the max absolute value element of A
+       * \param[in] A tensor
+       * \return handle with which to retrieve result via operator[] after execute()
+       */
+      int norm_infty(Tensor<dtype> & A);
+
+      /**
+       * \brief registers the inner product A["ij..."]*B["ij..."], B is redistributed
+       *        to the mapping of A if the two are mapped differently
+       * \param[in] A tensor
+       * \param[in] B tensor with the same lengths as A
+       * \return handle with which to retrieve result via operator[] after execute()
+       */
+      int dot(Tensor<dtype> & A, Tensor<dtype> & B);
+
+      /**
+       * \brief computes all registered reductions, collective over wrld,
+       *        results are available on every process afterwards
+       */
+      void execute();
+
+      /**
+       * \brief returns the result of a reduction (execute() must have been called)
+       * \param[in] i handle returned when the reduction was registered
+       */
+      dtype operator[](int i) const;
+
+      /**
+       * \brief number of registered reductions
+       */
+      int size() const { return (int)terms.size(); }
+
+      /**
+       * \brief removes all registered reductions
+       */
+      void clear();
+  };
+  /**
+   * @}
+   */
+}
+
+#include "fused_reduction.cxx"
+#endif
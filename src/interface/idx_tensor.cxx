@@ -82,10 +82,13 @@ namespace CTF {
 
   Idx_Tensor::Idx_Tensor(CTF_int::tensor * parent_,
                          const char *      idx_map_,
-                         int               copy) : Term(parent_->sr) {
-    idx_map = (char*)CTF_int::alloc(parent_->order*sizeof(char));
+                         int               copy) : Term(parent_->sr, copy) {
+    if (parent_->order <= TERM_INLINE_ORDER)
+      idx_map = idx_buf;
+    else
+      idx_map = (char*)CTF_int::alloc(parent_->order*sizeof(char));
     if (copy){
-      parent = new CTF_int::tensor(parent,1);
+      parent = new CTF_int::tensor(parent_,1);
     } else {
       parent        = parent_;
     }
@@ -115,7 +118,9 @@ namespace CTF {
 
   Idx_Tensor::Idx_Tensor(Idx_Tensor const & other,
                          int                copy,
-      std::map<tensor*, tensor*>* remap) : Term(other.sr) {
+      std::map<tensor*, tensor*>* remap)
+    // the algebraic structure of a tensor the user indexed is shared, that of others copied
+    : Term(other.sr, !other.shares_sr() || copy || remap != NULL) {
     if (other.parent == NULL){
       parent  = NULL;
       idx_map = NULL;
@@ -135,10 +140,13 @@ namespace CTF {
         // leave parent as is - already correct
         is_intm = 0;
       }
-      idx_map = (char*)CTF_int::alloc(other.parent->order*sizeof(char));
+      if (other.parent->order <= TERM_INLINE_ORDER)
+        idx_map = idx_buf;
+      else
+        idx_map = (char*)CTF_int::alloc(other.parent->order*sizeof(char));
       memcpy(idx_map, other.idx_map, parent->order*sizeof(char));
     }
-    sr->safecopy(scale,other.scale);
+    set_scale(other.scale);
   }
 
 /*  Idx_Tensor::Idx_Tensor(){
@@ -161,7 +169,7 @@ namespace CTF {
       delete parent;
       is_intm = 0;
     }
-    if (parent != NULL)  cdealloc(idx_map);
+    if (parent != NULL && idx_map != idx_buf)  cdealloc(idx_map);
     idx_map = NULL;
   }
 
@@ -176,16 +184,16 @@ namespace CTF {
 
   void Idx_Tensor::operator=(Idx_Tensor const & B){
     if (global_schedule != NULL) {
-      std::cout << "op= tensor" << std::endl;
-      assert(false);
+      global_schedule->add_operation(
+          new TensorOperation(TENSOR_OP_SET, new Idx_Tensor(*this), B.clone()));
     } else {
       if (sr->has_mul()){
-        sr->safecopy(scale,sr->addid());
+        set_scale(sr->addid());
       } else {
         this->parent->set_zero();
       }
       B.execute(*this);
-      sr->safecopy(scale,sr->mulid());
+      set_scale(sr->mulid());
     }
   }
 
@@ -195,12 +203,12 @@ namespace CTF {
           new TensorOperation(TENSOR_OP_SET, new Idx_Tensor(*this), B.clone()));
     } else {
       if (sr->has_mul()){
-        sr->safecopy(scale,sr->addid());
+        set_scale(sr->addid());
       } else {
         this->parent->set_zero();
       }
       B.execute(*this);
-      sr->safecopy(scale,sr->mulid());
+      set_scale(sr->mulid());
     }
   }
 
@@ -211,7 +219,7 @@ namespace CTF {
     } else {
       //sr->copy(scale,sr->mulid());
       B.execute(*this);
-      sr->safecopy(scale,sr->mulid());
+      set_scale(sr->mulid());
     }
   }
   
@@ -245,9 +253,9 @@ namespace CTF {
       Term * Bcpy = B.clone();
       char * ainv = NULL;
       B.sr->safeaddinv(B.sr->mulid(),ainv);
-      B.sr->safemul(Bcpy->scale,ainv,Bcpy->scale);
+      Bcpy->mul_scale(Bcpy->scale,ainv);
       Bcpy->execute(*this);
-      sr->safecopy(scale,sr->mulid());
+      set_scale(sr->mulid());
       if (ainv != NULL) cdealloc(ainv);
       delete Bcpy;
     }
@@ -308,7 +316,9 @@ namespace CTF {
   }
 
   void Idx_Tensor::get_inputs(std::set<Idx_Tensor*, tensor_name_less >* inputs_set) const {
-    inputs_set->insert((Idx_Tensor*)this);
+    // scalar operands (without a parent tensor) carry no data dependence
+    if (parent != NULL)
+      inputs_set->insert((Idx_Tensor*)this);
   }
 
   /*template<typename dtype, bool is_ord>
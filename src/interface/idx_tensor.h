@@ -17,6 +17,8 @@ namespace CTF {
       CTF_int::tensor * parent;
       char * idx_map;
       int is_intm;
+      /** \brief storage idx_map points to for tensors of order at most TERM_INLINE_ORDER */
+      char idx_buf[TERM_INLINE_ORDER];
 
     
       // derived clone calls copy constructor
@@ -50,6 +52,9 @@ namespace CTF {
       Idx_Tensor(CTF_int::algstrct const * sr, double scl);
       Idx_Tensor(CTF_int::algstrct const * sr, int64_t scl);
       ~Idx_Tensor();
+
+      // intermediates own the tensor whose algebraic structure they point to
+      bool shares_sr() const { return !own_sr && !is_intm; }
       
 
       /**
@@ -155,7 +160,7 @@ namespace CTF {
   class Typ_Idx_Tensor;
 
   
-  template<typename dtype_A, typename dtype_B>
+  template<typename dtype_A, typename dtype_B, typename F>
   class Univar_Transform;
   
   template<typename dtype_A, typename dtype_B, typename dtype_C>
@@ -264,13 +269,13 @@ namespace CTF {
      /* 
       template <typename dtype_A, typename dtype_B>
       Typ_Contract_Term<dtype_A, dtype_B, dtype> operator&=(Typ_Sum_Term<dtype_A,dtype_B> t){
-        sr->safecopy(scale,sr->addid());
+        set_scale(sr->addid());
         return Typ_Contract_Term<dtype_A,dtype_B,dtype>(this->clone(), t);
       }*/
       
       template <typename dtype_A, typename dtype_B>
       Typ_Contract_Term<dtype_A, dtype_B, dtype> operator=(Typ_Sum_Term<dtype_A,dtype_B> t){
-        sr->safecopy(scale,sr->addid());
+        set_scale(sr->addid());
         return Typ_Contract_Term<dtype_A,dtype_B,dtype>(this, t);
       }
 
@@ -281,7 +286,7 @@ namespace CTF {
       
       template <typename dtype_A>
       Typ_Sum_Term<dtype_A, dtype> operator=(Typ_AIdx_Tensor<dtype_A> t){
-        sr->safecopy(scale,sr->addid());
+        set_scale(sr->addid());
         return Typ_Sum_Term<dtype_A,dtype>(t.tclone(), this->tclone());
       }
       
@@ -2,6 +2,7 @@
 
 #include "common.h"
 #include "../shared/blas_symbs.h"
+#include "../shared/lapack_symbs.h"
 namespace CTF_int{
   struct int2
   {
@@ -16,6 +17,209 @@ namespace CTF_int{
       return i;
     }
   };
+
+#ifdef USE_LAPACK
+  /**
+   * \brief computes thin QR factorization of a tall-skinny matrix whose rows are distributed over cm,
+   *        via local QR and a binary reduction tree over the n-by-n triangular factors (TSQR),
+   *        the Householder factors of the tree are kept to assemble Q top-down
+   * \param[in] m number of (nonpadded) rows stored locally, may be less than n or zero
+   * \param[in] n number of columns
+   * \param[in,out] A local rows of the matrix with leading dimension lda, overwritten by local rows of Q
+   * \param[in] lda leading dimension of A
+   * \param[out] R n-by-n upper-triangular factor with nonnegative diagonal, same on all processors
+   * \param[in] cm communicator over which rows of A are distributed
+   */
+  template <typename dtype>
+  void tsqr(int      m,
+            int      n,
+            dtype *  A,
+            int      lda,
+            dtype *  R,
+            MPI_Comm cm){
+    int rank, np, info, lvl, nlvl, mb;
+    MPI_Status stat;
+    MPI_Comm_rank(cm, &rank);
+    MPI_Comm_size(cm, &np);
+    mb = std::max(m, n);
+    nlvl = 0;
+    while ((1<<nlvl) < np) nlvl++;
+    // sufficient for blocked geqrf/ormqr with block size up to 64
+    int lwork = 64*n+4160;
+    dtype * work = (dtype*)alloc(sizeof(dtype)*lwork);
+    dtype * tau = (dtype*)alloc(sizeof(dtype)*n*(nlvl+1));
+    dtype * T = (dtype*)alloc(sizeof(dtype)*2*n*n*std::max(nlvl,1));
+    dtype * W = (dtype*)alloc(sizeof(dtype)*2*n*n);
+    dtype * C = (dtype*)alloc(sizeof(dtype)*n*n);
+
+    // local QR of own rows, padded with zero rows to be at least square
+    dtype * Y = (dtype*)alloc(sizeof(dtype)*mb*n);
+    std::fill(Y, Y+((int64_t)mb)*n, (dtype)0);
+    for (int j=0; j<n; j++){
+      memcpy(Y+((int64_t)j)*mb, A+((int64_t)j)*lda, sizeof(dtype)*m);
+    }
+    CTF_LAPACK::cxgeqrf<dtype>(mb, n, Y, mb, tau, work, lwork, &info);
+    IASSERT(info == 0);
+    for (int j=0; j<n; j++){
+      for (int i=0; i<n; i++){
+        R[i+j*n] = i<=j ? Y[i+((int64_t)j)*mb] : (dtype)0;
+      }
+    }
+
+    // processor rank+2^lvl sends its R to rank, which factors the two stacked triangles
+    for (lvl=0; lvl<nlvl; lvl++){
+      int s = 1<<lvl;
+      if (rank % (2*s) == s){
+        MPI_Send(R, n*n*sizeof(dtype), MPI_CHAR, rank-s, lvl, cm);
+        break;
+      } else if (rank+s < np){
+        dtype * Tl = T+2*n*n*lvl;
+        MPI_Recv(C, n*n*sizeof(dtype), MPI_CHAR, rank+s, lvl, cm, &stat);
+        for (int j=0; j<n; j++){
+          memcpy(Tl+2*n*j,   R+n*j, sizeof(dtype)*n);
+          memcpy(Tl+2*n*j+n, C+n*j, sizeof(dtype)*n);
+        }
+        CTF_LAPACK::cxgeqrf<dtype>(2*n, n, Tl, 2*n, tau+n*(lvl+1), work, lwork, &info);
+        IASSERT(info == 0);
+        for (int j=0; j<n; j++){
+          for (int i=0; i<n; i++){
+            R[i+j*n] = i<=j ? Tl[i+2*n*j] : (dtype)0;
+          }
+        }
+      }
+    }
+
+    // the root starts Q from the signs that make diag(R) nonnegative, then Q is formed top-down
+    std::fill(C, C+n*n, (dtype)0);
+    if (rank == 0){
+      for (int i=0; i<n; i++){
+        if (R[i+i*n] < (dtype)0){
+          C[i+i*n] = (dtype)-1;
+          for (int j=i; j<n; j++) R[i+j*n] = -R[i+j*n];
+        } else
+          C[i+i*n] = (dtype)1;
+      }
+    }
+    MPI_Bcast(R, n*n*sizeof(dtype), MPI_CHAR, 0, cm);
+    for (lvl=nlvl-1; lvl>=0; lvl--){
+      int s = 1<<lvl;
+      if (rank % (2*s) == s){
+        MPI_Recv(C, n*n*sizeof(dtype), MPI_CHAR, rank-s, nlvl+lvl, cm, &stat);
+      } else if (rank % (2*s) == 0 && rank+s < np){
+        std::fill(W, W+2*n*n, (dtype)0);
+        for (int j=0; j<n; j++){
+          memcpy(W+2*n*j, C+n*j, sizeof(dtype)*n);
+        }
+        CTF_LAPACK::cxormqr<dtype>('L', 'N', 2*n, n, n, T+2*n*n*lvl, 2*n, tau+n*(lvl+1), W, 2*n, work, lwork, &info);
+        IASSERT(info == 0);
+        for (int j=0; j<n; j++){
+          memcpy(C+n*j, W+2*n*j, sizeof(dtype)*n);
+          memcpy(W+n*j, W+2*n*j+n, sizeof(dtype)*n);
+        }
+        MPI_Send(W, n*n*sizeof(dtype), MPI_CHAR, rank+s, nlvl+lvl, cm);
+      }
+    }
+    dtype * Qb = (dtype*)alloc(sizeof(dtype)*mb*n);
+    std::fill(Qb, Qb+((int64_t)mb)*n, (dtype)0);
+    for (int j=0; j<n; j++){
+      memcpy(Qb+((int64_t)j)*mb, C+n*j, sizeof(dtype)*n);
+    }
+    CTF_LAPACK::cxormqr<dtype>('L', 'N', mb, n, n, Y, mb, tau, Qb, mb, work, lwork, &info);
+    IASSERT(info == 0);
+    for (int j=0; j<n; j++){
+      memcpy(A+((int64_t)j)*lda, Qb+((int64_t)j)*mb, sizeof(dtype)*m);
+    }
+    cdealloc(Qb);
+    cdealloc(Y);
+    cdealloc(C);
+    cdealloc(W);
+    cdealloc(T);
+    cdealloc(tau);
+    cdealloc(work);
+  }
+
+  /**
+   * \brief whether the rows of a dense nonsymmetric matrix are spread over all processors without
+   *        replication while its columns are not distributed, so that each processor owns whole rows
+   * \param[in] A matrix, unfolded if folded
+   */
+  inline bool is_row_local(tensor * A){
+    if (A->is_sparse || A->sym[0] != NS || A->sym[1] != NS) return false;
+    A->unfold();
+    return A->is_mapped && A->edge_map[1].type == NOT_MAPPED &&
+           A->edge_map[0].calc_phys_phase() == A->wrld->np;
+  }
+
+  /**
+   * \brief copies the nonpadded rows a processor owns of a matrix for which is_row_local holds
+   *        to or from a column-major array, in which they are stacked by virtual block
+   * \param[in,out] A matrix
+   * \param[in,out] rows array with leading dimension lda, may be NULL to only count rows
+   * \param[in] lda leading dimension of rows
+   * \param[in] to_rows whether to copy from A to rows rather than from rows to A
+   * \return number of rows owned by this processor
+   */
+  template <typename dtype>
+  int copy_local_rows(tensor * A, dtype * rows, int lda, bool to_rows){
+    int np    = A->wrld->np;
+    int phase = A->edge_map[0].calc_phase();
+    int nvirt = phase/np;
+    int prank = A->edge_map[0].calc_phys_rank(A->topo);
+    int ncol  = A->lens[1];
+    int64_t br = A->pad_edge_len[0]/phase;
+    dtype * data = (dtype*)A->data;
+    int m = 0;
+    for (int b=0; b<nvirt; b++){
+      // local row l of virtual block b is global row l*phase+b*np+prank
+      int64_t nr = 0;
+      if (A->lens[0] > b*np+prank) nr = std::min(br, (int64_t)((A->lens[0]-b*np-prank+phase-1)/phase));
+      if (rows != NULL){
+        dtype * blk = data+b*br*ncol;
+        for (int j=0; j<ncol; j++){
+          if (to_rows)
+            memcpy(rows+m+((int64_t)j)*lda, blk+j*br, sizeof(dtype)*nr);
+          else
+            memcpy(blk+j*br, rows+m+((int64_t)j)*lda, sizeof(dtype)*nr);
+        }
+      }
+      m += nr;
+    }
+    return m;
+  }
+
+  /**
+   * \brief computes A=QR via TSQR over the rows each processor owns, in the mapping of A when
+   *        is_row_local holds for it and otherwise after redistributing A once to rows
+   *        distributed cyclically over all processors
+   * \param[in] A nrow-by-ncol matrix with nrow >= ncol
+   * \param[out] R ncol-by-ncol upper-triangular factor, same on all processors
+   * \return newly allocated Q, with rows distributed as those of A after any redistribution
+   */
+  template <typename dtype>
+  CTF::Matrix<dtype> * tsqr_matrix(CTF::Matrix<dtype> & A, dtype * R){
+    int np = A.wrld->np;
+    int ncol = A.ncol;
+    CTF::Matrix<dtype> * Q;
+    if (is_row_local(&A)){
+      Q = new CTF::Matrix<dtype>(A);
+    } else {
+      CTF::Partition pe_line(1, &np);
+      Q = new CTF::Matrix<dtype>(A.nrow, ncol, "ij", pe_line["i"], CTF::Idx_Partition(), 0, *A.wrld, *A.sr);
+      dtype * A_loc = A.read("ij", pe_line["i"]);
+      memcpy(Q->data, A_loc, sizeof(dtype)*Q->size);
+      cdealloc(A_loc);
+      IASSERT(is_row_local(Q));
+    }
+    int m = copy_local_rows<dtype>(Q, (dtype*)NULL, 0, true);
+    int lda = std::max(m, 1);
+    dtype * Y = (dtype*)alloc(sizeof(dtype)*lda*ncol);
+    copy_local_rows<dtype>(Q, Y, lda, true);
+    tsqr<dtype>(m, ncol, Y, lda, R, A.wrld->comm);
+    copy_local_rows<dtype>(Q, Y, lda, false);
+    cdealloc(Y);
+    return Q;
+  }
+#endif
 }
 
 
@@ -34,7 +238,7 @@ namespace CTF {
   template<typename dtype>
   Matrix<dtype>::Matrix(Tensor<dtype> const & A)
     : Tensor<dtype>(A) {
-    ASSERT(A.order == 2);
+    IASSERT(A.order == 2);
     nrow = A.lens[0];
     ncol = A.lens[1];
     switch (A.sym[0]){
@@ -339,4 +543,124 @@ namespace CTF {
   }
 
 
+
+#ifdef USE_LAPACK
+  template<typename dtype>
+  void Matrix<dtype>::qr(Matrix<dtype> & Q, Matrix<dtype> & R){
+    IASSERT(nrow >= ncol);
+    IASSERT(!this->is_sparse);
+    dtype * R_loc = (dtype*)CTF_int::alloc(sizeof(dtype)*ncol*ncol);
+    Matrix<dtype> * Qd = CTF_int::tsqr_matrix<dtype>(*this, R_loc);
+    Q = *Qd;
+    delete Qd;
+
+    Matrix<dtype> Rd(ncol, ncol, *this->wrld, *this->sr);
+    int64_t nw = 0;
+    int64_t * inds = (int64_t*)CTF_int::alloc(sizeof(int64_t)*ncol*(ncol+1)/2);
+    dtype * vals = (dtype*)CTF_int::alloc(sizeof(dtype)*ncol*(ncol+1)/2);
+    if (this->wrld->rank == 0){
+      for (int j=0; j<ncol; j++){
+        for (int i=0; i<=j; i++){
+          inds[nw] = i+((int64_t)j)*ncol;
+          vals[nw] = R_loc[i+j*ncol];
+          nw++;
+        }
+      }
+    }
+    Rd.write(nw, inds, vals);
+    CTF_int::cdealloc(inds);
+    CTF_int::cdealloc(vals);
+    CTF_int::cdealloc(R_loc);
+    R = Rd;
+  }
+
+  template<typename dtype>
+  void Matrix<dtype>::svd(Matrix<dtype> & U, Vector<dtype> & S, Matrix<dtype> & VT, int rank){
+    IASSERT(!this->is_sparse);
+    if (nrow < ncol){
+      // A^T = V*S*U^T
+      Matrix<dtype> At(ncol, nrow, *this->wrld, *this->sr);
+      At["ij"] = (*this)["ji"];
+      Matrix<dtype> V, UT;
+      At.svd(V, S, UT, rank);
+      Matrix<dtype> Ud(nrow, UT.nrow, *this->wrld, *this->sr);
+      Matrix<dtype> VTd(V.ncol, ncol, *this->wrld, *this->sr);
+      Ud["ij"] = UT["ji"];
+      VTd["ij"] = V["ji"];
+      U = Ud;
+      VT = VTd;
+      return;
+    }
+    int n = ncol;
+    int k = (rank > 0 && rank < n) ? rank : n;
+    dtype * R_loc = (dtype*)CTF_int::alloc(sizeof(dtype)*n*n);
+    Matrix<dtype> * Qd = CTF_int::tsqr_matrix<dtype>(*this, R_loc);
+
+    // SVD of the small triangular factor on the root, R = U_R*S*VT
+    dtype * U_R = (dtype*)CTF_int::alloc(sizeof(dtype)*n*n);
+    dtype * VT_R = (dtype*)CTF_int::alloc(sizeof(dtype)*n*n);
+    dtype * S_R = (dtype*)CTF_int::alloc(sizeof(dtype)*n);
+    if (this->wrld->rank == 0){
+      int info;
+      int lwork = std::max(64*n+4160, 5*n);
+      dtype * work = (dtype*)CTF_int::alloc(sizeof(dtype)*lwork);
+      CTF_LAPACK::cxgesvd<dtype>('A', 'A', n, n, R_loc, n, S_R, U_R, n, VT_R, n, work, lwork, &info);
+      IASSERT(info == 0);
+      CTF_int::cdealloc(work);
+    }
+    MPI_Bcast(U_R, n*n*sizeof(dtype), MPI_CHAR, 0, this->wrld->comm);
+
+    // U = Q*U_R, computed on the local rows of Q and kept in its mapping
+    int m = CTF_int::copy_local_rows<dtype>(Qd, (dtype*)NULL, 0, true);
+    int lda = std::max(m, 1);
+    dtype * Q_loc = (dtype*)CTF_int::alloc(sizeof(dtype)*lda*n);
+    dtype * U_loc = (dtype*)CTF_int::alloc(sizeof(dtype)*lda*n);
+    CTF_int::copy_local_rows<dtype>(Qd, Q_loc, lda, true);
+    if (m > 0)
+      this->sr->gemm('N', 'N', m, n, n, this->sr->mulid(), (char const*)Q_loc, (char const*)U_R, this->sr->addid(), (char*)U_loc);
+    CTF_int::copy_local_rows<dtype>(Qd, U_loc, lda, false);
+    CTF_int::cdealloc(U_loc);
+    CTF_int::cdealloc(Q_loc);
+    if (k < n){
+      Matrix<dtype> Ud(Qd->slice(0, ((int64_t)k-1)*nrow+nrow-1));
+      U = Ud;
+    } else
+      U = *Qd;
+    delete Qd;
+
+    Vector<dtype> Sd(k, *this->wrld, *this->sr);
+    Matrix<dtype> VTd(k, n, *this->wrld, *this->sr);
+    int64_t nw = 0;
+    int64_t * inds = (int64_t*)CTF_int::alloc(sizeof(int64_t)*k*n);
+    dtype * vals = (dtype*)CTF_int::alloc(sizeof(dtype)*k*n);
+    if (this->wrld->rank == 0){
+      for (int i=0; i<k; i++){
+        inds[i] = i;
+        vals[i] = S_R[i];
+      }
+      nw = k;
+    }
+    Sd.write(nw, inds, vals);
+    nw = 0;
+    if (this->wrld->rank == 0){
+      for (int j=0; j<n; j++){
+        for (int i=0; i<k; i++){
+          inds[nw] = i+((int64_t)j)*k;
+          vals[nw] = VT_R[i+j*n];
+          nw++;
+        }
+      }
+    }
+    VTd.write(nw, inds, vals);
+    CTF_int::cdealloc(inds);
+    CTF_int::cdealloc(vals);
+    CTF_int::cdealloc(S_R);
+    CTF_int::cdealloc(VT_R);
+    CTF_int::cdealloc(U_R);
+    CTF_int::cdealloc(R_loc);
+    S = Sd;
+    VT = VTd;
+  }
+#endif
+
 }
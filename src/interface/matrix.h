@@ -2,6 +2,8 @@
 #define __MATRIX_H__
 
 namespace CTF {
+  template<typename dtype> class Vector;
+
   /**
    * \addtogroup CTF
    * @{
@@ -246,6 +248,30 @@ namespace CTF {
        * \brief prints matrix by row and column (modify print(...) overload in set.h if you would like a different print format)
        */
       void print_matrix();
+
+#ifdef USE_LAPACK
+      /**
+       * \brief computes thin QR factorization A=QR of a tall-skinny matrix (nrow >= ncol) via TSQR,
+       *        local LAPACK QR of the rows owned by each processor followed by a binary reduction tree
+       *        over the ncol-by-ncol triangular factors (no ScaLAPACK layout needed), R has a nonnegative
+       *        diagonal, available for float and double when CTF is built with LAPACK (USE_LAPACK),
+       *        A is used in place if its rows are spread over all processors and its columns are not
+       *        distributed, otherwise it is redistributed once to rows cyclic over all processors
+       * \param[out] Q nrow-by-ncol matrix with orthonormal columns, with rows distributed as those of A
+       * \param[out] R ncol-by-ncol upper-triangular matrix
+       */
+      void qr(Matrix<dtype> & Q, Matrix<dtype> & R);
+
+      /**
+       * \brief computes singular value decomposition A=U*diag(S)*VT via TSQR of A (or its transpose
+       *        if nrow < ncol) and a sequential SVD of the small triangular factor
+       * \param[out] U left singular vectors, nrow-by-rank
+       * \param[out] S singular values in decreasing order, of length rank
+       * \param[out] VT right singular vectors, rank-by-ncol
+       * \param[in] rank number of singular values and vectors to keep, all min(nrow,ncol) if 0
+       */
+      void svd(Matrix<dtype> & U, Vector<dtype> & S, Matrix<dtype> & VT, int rank=0);
+#endif
   };
   /**
    * @}
@@ -0,0 +1,110 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "timer.h"
+#include "common.h"
+#include "../tensor/untyped_tensor.h"
+#include "../shared/util.h"
+#include "../shared/memcontrol.h"
+
+namespace CTF_int {
+  bool op_stats_on = false;
+  std::string op_stats_log;
+  std::vector<CTF::Op_stats> op_stats_recs;
+  CTF::Op_stats * op_stats_cur = NULL;
+  double op_stats_st_time;
+  int64_t op_stats_st_bytes;
+
+  bool begin_op_stats(char const * type, std::string const & expr){
+    if (!op_stats_on || op_stats_cur != NULL) return false;
+    op_stats_cur = new CTF::Op_stats();
+    op_stats_cur->type           = type;
+    op_stats_cur->expr           = expr;
+    op_stats_cur->folded         = false;
+    op_stats_cur->redist_bytes_A = 0;
+    op_stats_cur->redist_bytes_B = 0;
+    op_stats_cur->redist_bytes_C = 0;
+    op_stats_cur->comm_bytes     = 0;
+    op_stats_cur->est_time       = 0.;
+    op_stats_cur->time           = 0.;
+    op_stats_cur->mem_peak       = 0;
+    reset_proc_bytes_peak();
+    op_stats_st_bytes = get_comm_bytes();
+    op_stats_st_time  = MPI_Wtime();
+    return true;
+  }
+
+  void end_op_stats(int rank){
+    CTF::Op_stats * st = op_stats_cur;
+    ASSERT(st != NULL);
+    st->time       = MPI_Wtime()-op_stats_st_time;
+    st->comm_bytes = get_comm_bytes()-op_stats_st_bytes;
+    st->mem_peak   = proc_bytes_peak();
+    if (rank == 0 && op_stats_log.size() > 0){
+      FILE * f = fopen(op_stats_log.c_str(), "a");
+      if (f != NULL){
+        fprintf(f, "{\"type\": \"%s\", \"expr\": \"%s\", \"topo\": \"%s\", \"map_A\": \"%s\", \"map_B\": \"%s\", "
+                   "\"map_C\": \"%s\", \"folded\": %s, \"kernel\": \"%s\", \"redist_bytes_A\": %ld, "
+                   "\"redist_bytes_B\": %ld, \"redist_bytes_C\": %ld, \"comm_bytes\": %ld, "
+                   "\"est_time\": %.6e, \"time\": %.6e, \"mem_peak\": %ld}\n",
+                   st->type.c_str(), st->expr.c_str(), st->topo.c_str(), st->map_A.c_str(),
+                   st->map_B.c_str(), st->map_C.c_str(), st->folded ? "true" : "false",
+                   st->kernel.c_str(), st->redist_bytes_A, st->redist_bytes_B, st->redist_bytes_C,
+                   st->comm_bytes, st->est_time, st->time, st->mem_peak);
+        fclose(f);
+      }
+    }
+    op_stats_recs.push_back(*st);
+    delete st;
+    op_stats_cur = NULL;
+  }
+
+  CTF::Op_stats * cur_op_stats(){
+    return op_stats_cur;
+  }
+
+  /**
+   * \brief appends the name of a tensor and its indices, as letters, to str
+   */
+  static void append_term(std::string & str, tensor const * T, int const * idx){
+    str += T->name;
+    str += "[";
+    for (int i=0; i<T->order; i++){
+      str += (char)('a'+idx[i]%26);
+    }
+    str += "]";
+  }
+
+  std::string op_stats_expr(tensor const * A, int const * idx_A,
+                            tensor const * B, int const * idx_B,
+                            tensor const * C, int const * idx_C,
+                            bool is_acc){
+    std::string str;
+    if (C == NULL){
+      append_term(str, B, idx_B);
+      str += is_acc ? "+=" : "=";
+      append_term(str, A, idx_A);
+    } else {
+      append_term(str, C, idx_C);
+      str += is_acc ? "+=" : "=";
+      append_term(str, A, idx_A);
+      str += "*";
+      append_term(str, B, idx_B);
+    }
+    return str;
+  }
+}
+
+namespace CTF {
+  void set_op_stats(bool on, char const * log_file){
+    CTF_int::op_stats_on = on;
+    CTF_int::op_stats_log = log_file == NULL ? "" : log_file;
+  }
+
+  std::vector<Op_stats> const & get_op_stats(){
+    return CTF_int::op_stats_recs;
+  }
+
+  void clear_op_stats(){
+    CTF_int::op_stats_recs.clear();
+  }
+}
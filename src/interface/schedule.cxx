@@ -1,5 +1,11 @@
 #include "common.h"
 #include "schedule.h"
+#include "../shared/util.h"
+#include "../shared/memcontrol.h"
+#include <algorithm>
+#include <functional>
+#include <typeinfo>
+#include <unistd.h>
 
 using namespace CTF_int;
 
@@ -24,6 +30,77 @@ namespace CTF {
     }
   }
 
+  /**
+   * \brief appends a key identifying the value of a term to key, indices are renamed
+   * in order of appearance and tensors are identified along with their version
+   * \param[in] term expression
+   * \param[in] write_count version of each tensor (by wrld_tsr_id) written by recorded operations
+   * \param[in,out] idx_rename canonical name of each index encountered so far
+   * \param[in,out] key key to append to
+   * \return false if the value of the term cannot be identified (e.g. it applies a function)
+   */
+  static bool get_term_key(Term const *                    term,
+                           std::map<int64_t, int> const & write_count,
+                           std::map<char, char> &         idx_rename,
+                           std::string &                  key) {
+    if (term->scale == NULL) key.push_back('n');
+    else key.append(term->scale, term->sr->el_size);
+    Idx_Tensor const * itsr = dynamic_cast<Idx_Tensor const*>(term);
+    if (itsr != NULL) {
+      if (itsr->parent == NULL) {
+        key.push_back('s');
+        return true;
+      }
+      if (itsr->is_intm) return false;
+      std::map<int64_t, int>::const_iterator ver = write_count.find(itsr->parent->wrld_tsr_id);
+      char buf[64];
+      snprintf(buf, 64, "T%ld:%d[", (long)itsr->parent->wrld_tsr_id, ver == write_count.end() ? 0 : ver->second);
+      key.append(buf);
+      for (int i=0; i<itsr->parent->order; i++) {
+        if (idx_rename.count(itsr->idx_map[i]) == 0) {
+          int nidx = idx_rename.size();
+          idx_rename[itsr->idx_map[i]] = (char)('!'+nidx);
+        }
+        key.push_back(idx_rename[itsr->idx_map[i]]);
+      }
+      key.push_back(']');
+      return true;
+    }
+    term_list const * operands;
+    Sum_Term const * sum = dynamic_cast<Sum_Term const*>(term);
+    Contract_Term const * ctr = dynamic_cast<Contract_Term const*>(term);
+    if (sum != NULL) {
+      key.push_back('S');
+      operands = &sum->operands;
+    } else if (ctr != NULL) {
+      key.push_back('C');
+      operands = &ctr->operands;
+    } else return false;
+    key.push_back('(');
+    for (int i=0; i<(int)operands->size(); i++) {
+      if (!get_term_key((*operands)[i], write_count, idx_rename, key)) return false;
+      key.push_back(',');
+    }
+    key.push_back(')');
+    return true;
+  }
+
+  /**
+   * \brief whether the output of op is a dense nonsymmetric tensor all of whose entries it
+   * writes, i.e. its output indices are distinct
+   */
+  static bool writes_all_entries(Idx_Tensor const * lhs) {
+    tensor const * tsr = lhs->parent;
+    if (tsr->is_sparse) return false;
+    for (int i=0; i<tsr->order; i++) {
+      if (tsr->sym[i] != NS) return false;
+      for (int j=0; j<i; j++) {
+        if (lhs->idx_map[i] == lhs->idx_map[j]) return false;
+      }
+    }
+    return true;
+  }
+
   bool tensor_op_cost_greater(TensorOperation* A, TensorOperation* B) {
     return A->estimate_time() > B->estimate_time();
     //return A->successors.size() > B->successors.size();
@@ -37,13 +114,207 @@ namespace CTF {
     World * world;
 
     std::vector<TensorOperation*> ops;  // operations to execute
-    std::set<Idx_Tensor*, tensor_name_less > local_tensors; // all local tensors used
+    std::vector<tensor*> local_tensors; // all local tensors used
     std::map<tensor*, tensor*> remap; // mapping from global tensor -> local tensor
 
     std::set<Idx_Tensor*, tensor_name_less > global_tensors; // all referenced tensors stored as global tensors
     std::set<Idx_Tensor*, tensor_name_less > output_tensors; // tensors to be written back out, stored as global tensors
   };
 
+  /**
+   * \brief collects the tensors read and written by the operations of each partition
+   */
+  static void gather_partition_tensors(std::vector<PartitionOps> & comm_ops) {
+    typename std::vector<PartitionOps >::iterator comm_op_iter;
+    for (comm_op_iter=comm_ops.begin(); comm_op_iter!=comm_ops.end(); comm_op_iter++) {
+      typename std::vector<TensorOperation*>::iterator op_iter;
+      for (op_iter=comm_op_iter->ops.begin(); op_iter!=comm_op_iter->ops.end(); op_iter++) {
+        assert(*op_iter != NULL);
+        (*op_iter)->get_inputs(&comm_op_iter->global_tensors);
+        (*op_iter)->get_outputs(&comm_op_iter->global_tensors);
+        (*op_iter)->get_outputs(&comm_op_iter->output_tensors);
+      }
+    }
+  }
+
+  /**
+   * \brief copies the tensors referenced by each partition into its subworld,
+   * collective over the whole world, processes outside a partition pass a placeholder
+   */
+  static void send_to_partitions(std::vector<PartitionOps> & comm_ops) {
+    typename std::vector<PartitionOps >::iterator comm_op_iter;
+    for (comm_op_iter=comm_ops.begin(); comm_op_iter!=comm_ops.end(); comm_op_iter++) {
+      typename std::set<Idx_Tensor*, tensor_name_less >::iterator global_tensor_iter;
+      for (global_tensor_iter=comm_op_iter->global_tensors.begin(); global_tensor_iter!=comm_op_iter->global_tensors.end(); global_tensor_iter++) {
+        tensor* global_tsr = (*global_tensor_iter)->parent;
+        if (comm_op_iter->world != NULL) {
+          tensor* local_clone = new tensor(global_tsr->sr, global_tsr->order, global_tsr->lens, global_tsr->sym,
+                                           comm_op_iter->world, 1, global_tsr->name, global_tsr->profile, global_tsr->is_sparse);
+          comm_op_iter->local_tensors.push_back(local_clone);
+          comm_op_iter->remap[global_tsr] = local_clone;
+          global_tsr->add_to_subworld(local_clone, global_tsr->sr->mulid(), global_tsr->sr->addid());
+        } else {
+          tensor t = tensor();
+          t.sr = global_tsr->sr->clone();
+          global_tsr->add_to_subworld(&t, global_tsr->sr->mulid(), global_tsr->sr->addid());
+          delete t.sr;
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief writes the outputs of each partition back to the global tensors and frees
+   * the local tensors, collective over the whole world
+   */
+  static void receive_from_partitions(std::vector<PartitionOps> & comm_ops) {
+    typename std::vector<PartitionOps >::iterator comm_op_iter;
+    for (comm_op_iter=comm_ops.begin(); comm_op_iter!=comm_ops.end(); comm_op_iter++) {
+      typename std::set<Idx_Tensor*, tensor_name_less >::iterator output_tensor_iter;
+      for (output_tensor_iter=comm_op_iter->output_tensors.begin(); output_tensor_iter!=comm_op_iter->output_tensors.end(); output_tensor_iter++) {
+        tensor* global_tsr = (*output_tensor_iter)->parent;
+        if (comm_op_iter->world != NULL) {
+          assert(comm_op_iter->remap.find(global_tsr) != comm_op_iter->remap.end());
+          global_tsr->add_from_subworld(comm_op_iter->remap[global_tsr], global_tsr->sr->mulid(), global_tsr->sr->addid());
+        } else {
+          tensor t = tensor();
+          t.sr = global_tsr->sr->clone();
+          global_tsr->add_from_subworld(&t, global_tsr->sr->mulid(), global_tsr->sr->addid());
+          delete t.sr;
+        }
+      }
+    }
+    for (comm_op_iter=comm_ops.begin(); comm_op_iter!=comm_ops.end(); comm_op_iter++) {
+      if (comm_op_iter->world != NULL) {
+        for (int i=0; i<(int)comm_op_iter->local_tensors.size(); i++) {
+          delete comm_op_iter->local_tensors[i];
+        }
+        MPI_Comm comm = comm_op_iter->world->comm;
+        delete comm_op_iter->world;
+        MPI_Comm_free(&comm);
+        comm_op_iter->world = NULL;
+      }
+    }
+  }
+
+  /**
+   * \brief measures the spread of execution times across the world
+   */
+  static void measure_imbalance(ScheduleTimer & schedule_timer, double my_exec_time, MPI_Comm comm) {
+    double min_exec, max_exec, my_imbal, accum_imbal;
+    MPI_Allreduce(&my_exec_time, &min_exec, 1, MPI_DOUBLE, MPI_MIN, comm);
+    MPI_Allreduce(&my_exec_time, &max_exec, 1, MPI_DOUBLE, MPI_MAX, comm);
+    schedule_timer.imbalance_wall_time = max_exec - min_exec;
+
+    my_imbal = my_exec_time - min_exec;
+    MPI_Allreduce(&my_imbal, &accum_imbal, 1, MPI_DOUBLE, MPI_SUM, comm);
+    schedule_timer.imbalance_acuum_time = accum_imbal;
+  }
+
+  /**
+   * \brief tensor holding the mapping of tsr, and if keep_data a local copy of its data,
+   * the copy is counted as used memory and is not made if it does not fit on some process,
+   * collective over the world of tsr if keep_data
+   */
+  static tensor* snapshot_home(tensor* tsr, bool keep_data) {
+    if (keep_data) {
+      int fits = tsr->size*tsr->sr->el_size < proc_bytes_available(tsr->size*tsr->sr->el_size);
+      MPI_Allreduce(MPI_IN_PLACE, &fits, 1, MPI_INT, MPI_MIN, tsr->wrld->comm);
+      keep_data = fits;
+    }
+    tensor* home = new tensor(tsr, keep_data, keep_data);
+    home->topo = tsr->topo;
+    copy_mapping(tsr->order, tsr->edge_map, home->edge_map);
+    home->set_padding();
+    if (keep_data) home->register_size(home->size*home->sr->el_size);
+    return home;
+  }
+
+  ScheduleTimer Schedule::execute_in_place(std::vector<TensorOperation*> const & ops) {
+    ScheduleTimer schedule_timer;
+    schedule_timer.total_time = MPI_Wtime();
+
+    schedule_timer.exec_time = MPI_Wtime();
+    for (int i=0; i<(int)ops.size(); i++) {
+      TensorOperation* op = ops[i];
+      std::set<Idx_Tensor*, tensor_name_less > outputs;
+      op->get_outputs(&outputs);
+      std::set<tensor*> written;
+      typename std::set<Idx_Tensor*, tensor_name_less >::iterator oit;
+      for (oit=outputs.begin(); oit!=outputs.end(); oit++) {
+        written.insert((*oit)->parent);
+      }
+      // pinned tensors leave home, so the mapping chosen for op is kept afterwards
+      for (int j=0; j<(int)op->pinned.size(); j++) {
+        tensor* tsr = op->pinned[j];
+        if (tsr->has_home && !tsr->is_sparse && tsr->order > 0 && !tsr->is_folded) {
+          // remember the home mapping, and for an input also the home data if memory
+          // allows, which is what an operation on the home layout would have kept, so
+          // that returning an unmodified input home needs no communication, otherwise
+          // it is remapped home from the pinned layout
+          unhomed[tsr] = snapshot_home(tsr, written.count(tsr) == 0);
+          tsr->leave_home_with_buffer();
+        }
+      }
+      op->execute();
+      // home data of a tensor written away from home is stale
+      for (oit=outputs.begin(); oit!=outputs.end(); oit++) {
+        std::map<tensor*, tensor*>::iterator uit = unhomed.find((*oit)->parent);
+        if (uit != unhomed.end() && uit->second->data != NULL) {
+          tensor* home = snapshot_home(uit->second, false);
+          delete uit->second;
+          uit->second = home;
+        }
+      }
+      // after the last pinned use tensors are mapped back home, while observing right away
+      std::set<Idx_Tensor*, tensor_name_less > tensors;
+      op->get_inputs(&tensors);
+      op->get_outputs(&tensors);
+      typename std::set<Idx_Tensor*, tensor_name_less >::iterator it;
+      for (it=tensors.begin(); it!=tensors.end(); it++) {
+        tensor* tsr = (*it)->parent;
+        if (!layouts_planned && unhomed.count(tsr) != 0 && !tsr->is_folded) {
+          // record the layout chosen for tsr, from which plan_layouts() decides whether
+          // tsr should keep it until its next use, or an empty one if it is the home
+          // layout, which costs nothing to redistribute to, so pinning it saves nothing
+          char * buffer, * home_buffer;
+          int bufsz, home_bufsz;
+          distribution dstrib(tsr);
+          dstrib.serialize(&buffer, &bufsz);
+          distribution home_dstrib(unhomed[tsr]);
+          home_dstrib.serialize(&home_buffer, &home_bufsz);
+          std::string layout(buffer, bufsz);
+          if (layout == std::string(home_buffer, home_bufsz)) layout.clear();
+          observed_layouts[std::make_pair(op, tsr)] = layout;
+          cdealloc(buffer);
+          cdealloc(home_buffer);
+        }
+        if (unhomed.count(tsr) != 0 && (!layouts_planned ||
+            std::find(op->pinned.begin(), op->pinned.end(), tsr) == op->pinned.end())) {
+          return_home(tsr);
+        }
+      }
+    }
+    schedule_timer.exec_time = MPI_Wtime() - schedule_timer.exec_time;
+
+    // Update ready tasks
+    std::set<TensorOperation*> executed(ops.begin(), ops.end());
+    for (int i=0; i<(int)ops.size(); i++) {
+      schedule_op_successors(ops[i]);
+    }
+    std::deque<TensorOperation*> remaining_tasks;
+    typename std::deque<TensorOperation*>::iterator ready_tasks_iter;
+    for (ready_tasks_iter=ready_tasks.begin(); ready_tasks_iter!=ready_tasks.end(); ready_tasks_iter++) {
+      if (executed.count(*ready_tasks_iter) == 0) {
+        remaining_tasks.push_back(*ready_tasks_iter);
+      }
+    }
+    ready_tasks.swap(remaining_tasks);
+
+    schedule_timer.total_time = MPI_Wtime() - schedule_timer.total_time;
+    return schedule_timer;
+  }
+
   ScheduleTimer Schedule::partition_and_execute() {
     ScheduleTimer schedule_timer;
     schedule_timer.total_time = MPI_Wtime();
@@ -69,7 +340,7 @@ namespace CTF {
 
     int max_starting_task = 0;
     int max_num_tasks = 0;
-    int max_cost = 0;
+    double max_cost = 0;
     // Try to find the longest sequence of tasks that aren't too imbalanced
     for (int starting_task=0; starting_task<(int64_t)ready_tasks.size(); starting_task++) {
       double  sum_cost = 0;
@@ -98,10 +369,15 @@ namespace CTF {
       }
     }
 
+    // A single task gets all processors, so it runs on the global tensors
+    if (max_num_tasks == 1) {
+      return execute_in_place(std::vector<TensorOperation*>(1, ready_tasks[max_starting_task]));
+    }
+
     // Do processor division according to estimated cost
     // Algorithm: divide sum_cost into size blocks, and each processor samples the
     // middle of its block to determine which task it works on
-    int color_sample_point = (max_cost / size) * rank + (max_cost / size / 2);
+    double color_sample_point = (max_cost / size) * rank + (max_cost / size / 2);
     int my_color = 0;
     for (int i=0; i<max_num_tasks; i++) {
       my_color = i;
@@ -115,6 +391,7 @@ namespace CTF {
     MPI_Comm my_comm;
     MPI_Comm_split(world->comm, my_color, rank, &my_comm);
 
+#ifdef VERBOSE
     if (rank == 0) {
       std::cout << "Maxparts " << max_colors << ", start " << max_starting_task <<
           ", tasks " << max_num_tasks << " // ";
@@ -124,6 +401,7 @@ namespace CTF {
       }
       std::cout << std::endl;
     }
+#endif
 
     for (int color=0; color<max_num_tasks; color++) {
       comm_ops.push_back(PartitionOps());
@@ -140,39 +418,12 @@ namespace CTF {
       ready_tasks.erase(ready_tasks.begin() + max_starting_task);
     }
 
-    typename std::vector<PartitionOps >::iterator comm_op_iter;
     // Initialize local data structures
-    for (comm_op_iter=comm_ops.begin(); comm_op_iter!=comm_ops.end(); comm_op_iter++) {
-      // gather required tensors
-      typename std::vector<TensorOperation*>::iterator op_iter;
-      for (op_iter=comm_op_iter->ops.begin(); op_iter!=comm_op_iter->ops.end(); op_iter++) {
-        assert(*op_iter != NULL);
-        (*op_iter)->get_inputs(&comm_op_iter->global_tensors);
-        (*op_iter)->get_outputs(&comm_op_iter->global_tensors);
-        (*op_iter)->get_outputs(&comm_op_iter->output_tensors);
-      }
-    }
+    gather_partition_tensors(comm_ops);
 
     // Create and communicate tensors to subworlds
     schedule_timer.comm_down_time = MPI_Wtime();
-    for (comm_op_iter=comm_ops.begin(); comm_op_iter!=comm_ops.end(); comm_op_iter++) {
-      typename std::set<Idx_Tensor*, tensor_name_less >::iterator global_tensor_iter;
-      for (global_tensor_iter=comm_op_iter->global_tensors.begin(); global_tensor_iter!=comm_op_iter->global_tensors.end(); global_tensor_iter++) {
-        Idx_Tensor* local_clone;
-        if (comm_op_iter->world != NULL) {
-          local_clone = new Idx_Tensor(*(*global_tensor_iter));//, *comm_op_iter->world);
-        } else {
-          local_clone = NULL;
-        }
-        comm_op_iter->local_tensors.insert(local_clone);
-        comm_op_iter->remap[(*global_tensor_iter)->parent] = local_clone->parent;
-        (*global_tensor_iter)->parent->add_to_subworld(local_clone->parent, (*global_tensor_iter)->sr->mulid(), (*global_tensor_iter)->sr->addid());
-      }
-      typename std::set<Idx_Tensor*, tensor_name_less >::iterator output_tensor_iter;
-      for (output_tensor_iter=comm_op_iter->output_tensors.begin(); output_tensor_iter!=comm_op_iter->output_tensors.end(); output_tensor_iter++) {
-        assert(comm_op_iter->remap.find((*output_tensor_iter)->parent) != comm_op_iter->remap.end());
-      }
-    }
+    send_to_partitions(comm_ops);
     schedule_timer.comm_down_time = MPI_Wtime() - schedule_timer.comm_down_time;
 
     // Run my tasks
@@ -189,35 +440,15 @@ namespace CTF {
     schedule_timer.exec_time = MPI_Wtime() - schedule_timer.exec_time;
 
     // Instrument imbalance
-    double min_exec, max_exec, my_imbal, accum_imbal;
-    MPI_Allreduce(&my_exec_time, &min_exec, 1, MPI_DOUBLE, MPI_MIN, world->comm);
-    MPI_Allreduce(&my_exec_time, &max_exec, 1, MPI_DOUBLE, MPI_MAX, world->comm);
-    schedule_timer.imbalance_wall_time = max_exec - min_exec;
+    measure_imbalance(schedule_timer, my_exec_time, world->comm);
 
-    my_imbal = my_exec_time - min_exec;
-    MPI_Allreduce(&my_imbal, &accum_imbal, 1, MPI_DOUBLE, MPI_SUM, world->comm);
-    schedule_timer.imbalance_acuum_time = accum_imbal;
-
-    // Communicate results back into global
+    // Communicate results back into global and clean up local tensors & world
     schedule_timer.comm_up_time = MPI_Wtime();
-    for (comm_op_iter=comm_ops.begin(); comm_op_iter!=comm_ops.end(); comm_op_iter++) {
-      typename std::set<Idx_Tensor*, tensor_name_less >::iterator output_tensor_iter;
-      for (output_tensor_iter=comm_op_iter->output_tensors.begin(); output_tensor_iter!=comm_op_iter->output_tensors.end(); output_tensor_iter++) {
-        (*output_tensor_iter)->parent->add_from_subworld(comm_op_iter->remap[(*output_tensor_iter)->parent], (*output_tensor_iter)->sr->mulid(), (*output_tensor_iter)->sr->addid());
-      }
-    }
+    receive_from_partitions(comm_ops);
     schedule_timer.comm_up_time = MPI_Wtime() - schedule_timer.comm_up_time;
 
-    // Clean up local tensors & world
-    if ((int64_t)comm_ops.size() > my_color) {
-      typename std::set<Idx_Tensor*, tensor_name_less >::iterator local_tensor_iter;
-      for (local_tensor_iter=comm_ops[my_color].local_tensors.begin(); local_tensor_iter!=comm_ops[my_color].local_tensors.end(); local_tensor_iter++) {
-        delete *local_tensor_iter;
-      }
-      delete comm_ops[my_color].world;
-    }
-
     // Update ready tasks
+    typename std::vector<PartitionOps >::iterator comm_op_iter;
     for (comm_op_iter=comm_ops.begin(); comm_op_iter!=comm_ops.end(); comm_op_iter++) {
       typename std::vector<TensorOperation*>::iterator op_iter;
       for (op_iter=comm_op_iter->ops.begin(); op_iter!=comm_op_iter->ops.end(); op_iter++) {
@@ -229,6 +460,382 @@ namespace CTF {
     return schedule_timer;
   }
 
+  /**
+   * \brief position of an operation in recording order
+   */
+  static int get_op_index(std::deque<TensorOperation*> const & steps, TensorOperation* op) {
+    return std::find(steps.begin(), steps.end(), op) - steps.begin();
+  }
+
+  /**
+   * \brief whether op may be executed by partition color using only the tensors already
+   * copied to it, and without touching tensors referenced by any other partition,
+   * an output that is overwritten (not read) in all of its entries may also be one that
+   * no partition holds yet, otherwise the entries it does not write would be lost when
+   * the partition's zero-initialized copy is written back
+   */
+  static bool is_pullable(TensorOperation* op,
+                          int color,
+                          std::vector< std::set<tensor*> > const & resident,
+                          std::vector< std::set<tensor*> > const & written) {
+    if (op->is_dummy()) return false;
+    std::set<Idx_Tensor*, tensor_name_less > inputs, outputs;
+    op->get_inputs(&inputs);
+    op->get_outputs(&outputs);
+    typename std::set<Idx_Tensor*, tensor_name_less >::iterator it;
+    for (it=inputs.begin(); it!=inputs.end(); it++) {
+      if (resident[color].count((*it)->parent) == 0) return false;
+      for (int q=0; q<(int)written.size(); q++) {
+        if (q != color && written[q].count((*it)->parent) != 0) return false;
+      }
+    }
+    // an output that is also read was checked above, so any other output is overwritten
+    for (it=outputs.begin(); it!=outputs.end(); it++) {
+      if (resident[color].count((*it)->parent) == 0 && !writes_all_entries(*it)) return false;
+      for (int q=0; q<(int)resident.size(); q++) {
+        if (q != color && resident[q].count((*it)->parent) != 0) return false;
+      }
+    }
+    return true;
+  }
+
+  ScheduleTimer Schedule::partition_and_execute_dynamic() {
+    ScheduleTimer schedule_timer;
+    schedule_timer.total_time = MPI_Wtime();
+
+    int rank, size;
+    MPI_Comm_rank(world->comm, &rank);
+    MPI_Comm_size(world->comm, &size);
+
+    // Ready operations that do nothing complete right away
+    for (bool found=true; found; ) {
+      found = false;
+      for (int i=0; i<(int)ready_tasks.size(); i++) {
+        if (ready_tasks[i]->is_dummy()) {
+          TensorOperation* op = ready_tasks[i];
+          ready_tasks.erase(ready_tasks.begin()+i);
+          schedule_op_successors(op);
+          found = true;
+          break;
+        }
+      }
+    }
+    if (ready_tasks.empty()) {
+      schedule_timer.total_time = MPI_Wtime() - schedule_timer.total_time;
+      return schedule_timer;
+    }
+
+    // Group ready tasks by the tensor they write, the initial assignment of groups to
+    // partitions decides which tensors each partition holds and how many processors
+    // it gets, while the order in which operations run is decided as they complete
+    std::vector< std::vector<TensorOperation*> > groups;
+    std::vector<double> group_cost;
+    std::map<tensor*, int> group_of;
+    typename std::deque<TensorOperation*>::iterator ready_tasks_iter;
+    for (ready_tasks_iter=ready_tasks.begin(); ready_tasks_iter!=ready_tasks.end(); ready_tasks_iter++) {
+      std::set<Idx_Tensor*, tensor_name_less > outputs;
+      (*ready_tasks_iter)->get_outputs(&outputs);
+      tensor* output = (*outputs.begin())->parent;
+      std::map<tensor*, int>::iterator group_iter = group_of.find(output);
+      int group;
+      if (group_iter == group_of.end()) {
+        group = groups.size();
+        group_of[output] = group;
+        groups.push_back(std::vector<TensorOperation*>());
+        group_cost.push_back(0.0);
+      } else {
+        group = group_iter->second;
+      }
+      groups[group].push_back(*ready_tasks_iter);
+      group_cost[group] += (*ready_tasks_iter)->estimate_time();
+    }
+    int num_groups = groups.size();
+
+    int num_parts = size <= num_groups ? size : num_groups;
+    if (partitions > 0 && num_parts > partitions) {
+      num_parts = partitions;
+    }
+
+    // A single partition spans all processors, so its tasks run on the global tensors
+    if (num_parts == 1) {
+      std::vector<TensorOperation*> ops(ready_tasks.begin(), ready_tasks.end());
+      std::sort(ops.begin(), ops.end(),
+                [&](TensorOperation* a, TensorOperation* b){
+                  return get_op_index(steps_original, a) < get_op_index(steps_original, b); });
+      return execute_in_place(ops);
+    }
+
+    // Longest-processing-time-first assignment of groups to partitions
+    std::vector<int> group_order(num_groups);
+    for (int i=0; i<num_groups; i++) {
+      group_order[i] = i;
+    }
+    std::stable_sort(group_order.begin(), group_order.end(),
+                     [&](int a, int b){ return group_cost[a] > group_cost[b]; });
+    std::vector<double> load(num_parts, 0.0);
+    std::vector<PartitionOps > comm_ops(num_parts);
+    for (int i=0; i<num_groups; i++) {
+      int part = 0;
+      for (int p=1; p<num_parts; p++) {
+        if (load[p] < load[part]) part = p;
+      }
+      load[part] += group_cost[group_order[i]];
+      comm_ops[part].ops.insert(comm_ops[part].ops.end(), groups[group_order[i]].begin(), groups[group_order[i]].end());
+    }
+
+    // Size each partition in proportion to its predicted load (at least one processor
+    // each), rounding by largest remainder
+    double total_load = 0.0;
+    for (int p=0; p<num_parts; p++) {
+      total_load += load[p];
+    }
+    std::vector<int> num_procs(num_parts);
+    std::vector<double> remainder(num_parts);
+    int num_assigned = 0;
+    for (int p=0; p<num_parts; p++) {
+      double share = load[p] / total_load * size;
+      num_procs[p] = std::max(1, (int)share);
+      remainder[p] = share - num_procs[p];
+      num_assigned += num_procs[p];
+    }
+    while (num_assigned < size) {
+      int part = 0;
+      for (int p=1; p<num_parts; p++) {
+        if (remainder[p] > remainder[part]) part = p;
+      }
+      num_procs[part]++;
+      remainder[part] -= 1.0;
+      num_assigned++;
+    }
+    while (num_assigned > size) {
+      int part = -1;
+      for (int p=0; p<num_parts; p++) {
+        if (num_procs[p] > 1 && (part == -1 || remainder[p] < remainder[part])) part = p;
+      }
+      num_procs[part]--;
+      remainder[part] += 1.0;
+      num_assigned--;
+    }
+
+    // Partitions are contiguous ranges of ranks, the first rank of each is its root
+    std::vector<int> first_rank(num_parts);
+    int my_color = 0;
+    for (int p=0, r=0; p<num_parts; r+=num_procs[p], p++) {
+      first_rank[p] = r;
+      if (rank >= r && rank < r+num_procs[p]) my_color = p;
+    }
+
+    MPI_Comm my_comm;
+    MPI_Comm_split(world->comm, my_color, rank, &my_comm);
+
+    std::vector< std::set<tensor*> > resident(num_parts), written(num_parts);
+    for (int p=0; p<num_parts; p++) {
+      comm_ops[p].color = p;
+      comm_ops[p].world = (p == my_color) ? new World(my_comm) : NULL;
+      std::sort(comm_ops[p].ops.begin(), comm_ops[p].ops.end(),
+                [&](TensorOperation* a, TensorOperation* b){
+                  return get_op_index(steps_original, a) < get_op_index(steps_original, b); });
+    }
+    gather_partition_tensors(comm_ops);
+    for (int p=0; p<num_parts; p++) {
+      typename std::set<Idx_Tensor*, tensor_name_less >::iterator it;
+      for (it=comm_ops[p].global_tensors.begin(); it!=comm_ops[p].global_tensors.end(); it++) {
+        resident[p].insert((*it)->parent);
+      }
+      for (it=comm_ops[p].output_tensors.begin(); it!=comm_ops[p].output_tensors.end(); it++) {
+        written[p].insert((*it)->parent);
+      }
+    }
+
+#ifdef VERBOSE
+    if (rank == 0) {
+      std::cout << "Dynamic parts " << num_parts << " // ";
+      for (int p=0; p<num_parts; p++) {
+        std::cout << num_procs[p] << " procs (" << load[p] << ") ";
+      }
+      std::cout << std::endl;
+    }
+#endif
+
+    // Create and communicate tensors to subworlds
+    schedule_timer.comm_down_time = MPI_Wtime();
+    send_to_partitions(comm_ops);
+    schedule_timer.comm_down_time = MPI_Wtime() - schedule_timer.comm_down_time;
+
+    // The shared ready queue lives in a window on world rank 0: which partition claimed
+    // each operation (num_parts for ones that do nothing), which are done, and which
+    // partitions found nothing to pull since an operation last completed
+    int nops = steps_original.size();
+    std::map<TensorOperation*, int> op_index;
+    for (int i=0; i<nops; i++) {
+      op_index[steps_original[i]] = i;
+    }
+    int nstate = 2*nops + num_parts;
+    std::vector<int> state(nstate, 0);
+    int * claim = state.data();
+    int * done = claim + nops;
+    int * idle = done + nops;
+    std::fill(claim, claim+nops, -1);
+    int * state_base;
+    MPI_Win win;
+    MPI_Win_allocate(rank == 0 ? nstate*sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, world->comm, &state_base, &win);
+    if (rank == 0) {
+      MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, win);
+      MPI_Put(state.data(), nstate, MPI_INT, 0, 0, nstate, MPI_INT, win);
+      MPI_Win_unlock(0, win);
+    }
+
+    // Ready tasks of this process follow the shared queue: successors of completed
+    // operations become ready in recording order, operations that do nothing complete
+    // as soon as they are ready, and tensors claimed operations write become held by
+    // the partition that claimed them
+    std::vector<char> applied(nops, 0), seen(nops, 0);
+    std::function<void()> update_ready = [&]() {
+      for (bool changed=true; changed; ) {
+        changed = false;
+        for (ready_tasks_iter=ready_tasks.begin(); ready_tasks_iter!=ready_tasks.end(); ready_tasks_iter++) {
+          int i = op_index[*ready_tasks_iter];
+          if ((*ready_tasks_iter)->is_dummy() && claim[i] == -1) {
+            claim[i] = num_parts;
+            done[i] = 1;
+          }
+        }
+        for (int i=0; i<nops; i++) {
+          if (claim[i] != -1 && claim[i] != my_color && claim[i] < num_parts && !seen[i]) {
+            std::set<Idx_Tensor*, tensor_name_less > outputs;
+            steps_original[i]->get_outputs(&outputs);
+            typename std::set<Idx_Tensor*, tensor_name_less >::iterator it;
+            for (it=outputs.begin(); it!=outputs.end(); it++) {
+              resident[claim[i]].insert((*it)->parent);
+              written[claim[i]].insert((*it)->parent);
+            }
+            seen[i] = 1;
+          }
+          if (done[i] && !applied[i]) {
+            schedule_op_successors(steps_original[i]);
+            applied[i] = 1;
+            changed = true;
+          }
+        }
+      }
+    };
+
+    // Each partition root repeatedly claims the most expensive ready operation that its
+    // partition can execute with the tensors it holds, marking the previous one done,
+    // until every partition has run out of such operations with none still running
+    MPI_Barrier(world->comm);
+    schedule_timer.exec_time = MPI_Wtime();
+    PartitionOps & my_ops = comm_ops[my_color];
+    bool is_root = (rank == first_rank[my_color]);
+    int cur = -1;
+    for (;;) {
+      int next = -1;
+      if (is_root) {
+        for (;;) {
+          MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, win);
+          MPI_Get(state.data(), nstate, MPI_INT, 0, 0, nstate, MPI_INT, win);
+          MPI_Win_flush(0, win);
+          if (cur != -1) {
+            done[cur] = 1;
+            std::fill(idle, idle+num_parts, 0);
+            cur = -1;
+          }
+          update_ready();
+          double next_cost = 0.0;
+          for (ready_tasks_iter=ready_tasks.begin(); ready_tasks_iter!=ready_tasks.end(); ready_tasks_iter++) {
+            int i = op_index[*ready_tasks_iter];
+            if (claim[i] != -1 || !is_pullable(*ready_tasks_iter, my_color, resident, written)) continue;
+            double cost = (*ready_tasks_iter)->estimate_time();
+            if (next == -1 || cost > next_cost || (cost == next_cost && i < next)) {
+              next = i;
+              next_cost = cost;
+            }
+          }
+          if (next != -1) {
+            claim[next] = my_color;
+            idle[my_color] = 0;
+          } else {
+            idle[my_color] = 1;
+          }
+          MPI_Put(state.data(), nstate, MPI_INT, 0, 0, nstate, MPI_INT, win);
+          MPI_Win_unlock(0, win);
+          if (next != -1 || std::count(idle, idle+num_parts, 1) == num_parts) break;
+          usleep(100);
+        }
+      }
+      MPI_Bcast(&next, 1, MPI_INT, 0, my_ops.world->comm);
+      if (next == -1) break;
+      TensorOperation* op = steps_original[next];
+      // outputs not yet held by this partition are overwritten in all entries, so they are
+      // created locally
+      std::set<Idx_Tensor*, tensor_name_less > outputs;
+      op->get_outputs(&outputs);
+      typename std::set<Idx_Tensor*, tensor_name_less >::iterator it;
+      for (it=outputs.begin(); it!=outputs.end(); it++) {
+        tensor* global_tsr = (*it)->parent;
+        if (resident[my_color].count(global_tsr) == 0) {
+          tensor* local_tsr = new tensor(global_tsr->sr, global_tsr->order, global_tsr->lens, global_tsr->sym,
+                                         my_ops.world, 1, global_tsr->name, global_tsr->profile, global_tsr->is_sparse);
+          my_ops.local_tensors.push_back(local_tsr);
+          my_ops.remap[global_tsr] = local_tsr;
+          resident[my_color].insert(global_tsr);
+        }
+        written[my_color].insert(global_tsr);
+      }
+      op->execute(&my_ops.remap);
+      cur = next;
+    }
+    double my_exec_time = MPI_Wtime() - schedule_timer.exec_time;
+    MPI_Barrier(world->comm);
+    schedule_timer.exec_time = MPI_Wtime() - schedule_timer.exec_time;
+
+    // Instrument imbalance
+    measure_imbalance(schedule_timer, my_exec_time, world->comm);
+
+    // Let every process know which partition executed each operation
+    if (rank == 0) {
+      MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, win);
+      MPI_Get(state.data(), nstate, MPI_INT, 0, 0, nstate, MPI_INT, win);
+      MPI_Win_unlock(0, win);
+    }
+    MPI_Bcast(state.data(), nstate, MPI_INT, 0, world->comm);
+    MPI_Win_free(&win);
+    for (int i=0; i<nops; i++) {
+      int p = claim[i];
+      if (p >= 0 && p < num_parts &&
+          std::find(comm_ops[p].ops.begin(), comm_ops[p].ops.end(), steps_original[i]) == comm_ops[p].ops.end()) {
+        comm_ops[p].ops.push_back(steps_original[i]);
+        steps_original[i]->get_outputs(&comm_ops[p].output_tensors);
+      }
+    }
+
+    // Communicate results back into global and clean up local tensors & world
+    schedule_timer.comm_up_time = MPI_Wtime();
+    receive_from_partitions(comm_ops);
+    schedule_timer.comm_up_time = MPI_Wtime() - schedule_timer.comm_up_time;
+
+    // Update ready tasks with the operations this process has not yet applied, and keep
+    // them in recording order so that the next phase is the same on all processes
+    for (int i=0; i<nops; i++) {
+      if (done[i] && !applied[i]) {
+        schedule_op_successors(steps_original[i]);
+        applied[i] = 1;
+      }
+    }
+    std::deque<TensorOperation*> remaining_tasks;
+    for (ready_tasks_iter=ready_tasks.begin(); ready_tasks_iter!=ready_tasks.end(); ready_tasks_iter++) {
+      if (!done[op_index[*ready_tasks_iter]]) {
+        remaining_tasks.push_back(*ready_tasks_iter);
+      }
+    }
+    std::sort(remaining_tasks.begin(), remaining_tasks.end(),
+              [&](TensorOperation* a, TensorOperation* b){ return op_index[a] < op_index[b]; });
+    ready_tasks.swap(remaining_tasks);
+
+    schedule_timer.total_time = MPI_Wtime() - schedule_timer.total_time;
+    return schedule_timer;
+  }
+
   /*
   // The dead simple scheduler
   void Schedule::partition_and_execute() {
@@ -253,31 +860,191 @@ namespace CTF {
       (*it)->dependency_left = (*it)->dependency_count;
     }
     ready_tasks = root_tasks;
+    plan_layouts();
 
     // Preprocess dummy operations
-    while (!ready_tasks.empty()) {
-      if (ready_tasks.front()->is_dummy()) {
-        schedule_op_successors(ready_tasks.front());
-        ready_tasks.pop_front();
+    std::deque<TensorOperation*> roots;
+    roots.swap(ready_tasks);
+    for (it = roots.begin(); it != roots.end(); it++) {
+      if ((*it)->is_dummy()) {
+        schedule_op_successors(*it);
       } else {
-        break;
+        ready_tasks.push_back(*it);
       }
     }
 
+    if (world == NULL) {
+      world = &get_universe();
+    }
     while (!ready_tasks.empty()) {
       int rank;
       MPI_Comm_rank(world->comm, &rank);
-      ScheduleTimer iter_timer = partition_and_execute();
+      ScheduleTimer iter_timer = dynamic ? partition_and_execute_dynamic() : partition_and_execute();
       if (rank == 0) {
-        printf("Schedule imbalance, wall: %lf; accum: %lf\n", iter_timer.imbalance_wall_time, iter_timer.imbalance_acuum_time);
+        VPRINTF(1, "Schedule imbalance, wall: %lf; accum: %lf\n", iter_timer.imbalance_wall_time, iter_timer.imbalance_acuum_time);
       }
       schedule_timer += iter_timer;
     }
+
+    // Tensors whose later uses ran first still need their home back, in the same order
+    // on all processes as it is collective
+    std::vector<tensor*> rest;
+    std::map<tensor*, tensor*>::iterator uit;
+    for (uit=unhomed.begin(); uit!=unhomed.end(); uit++) {
+      rest.push_back(uit->first);
+    }
+    std::sort(rest.begin(), rest.end(), [](tensor* A, tensor* B) {
+      int d = strcmp(A->name, B->name);
+      return d != 0 ? d < 0 : A->wrld_tsr_id < B->wrld_tsr_id;
+    });
+    for (int i=0; i<(int)rest.size(); i++) {
+      return_home(rest[i]);
+    }
     return schedule_timer;
   }
 
+  void Schedule::plan_layouts() {
+    if (layouts_planned) return;
+    bool refine = !observed_layouts.empty();
+    std::map<tensor*, TensorOperation*> next_use;
+    for (int i=(int)steps_original.size()-1; i>=0; i--) {
+      TensorOperation* op = steps_original[i];
+      if (op->is_dummy()) continue;
+      std::set<Idx_Tensor*, tensor_name_less > tensors;
+      op->get_outputs(&tensors);
+      op->get_inputs(&tensors);
+      op->pinned.clear();
+      typename std::set<Idx_Tensor*, tensor_name_less >::iterator it;
+      for (it=tensors.begin(); it!=tensors.end(); it++) {
+        tensor* tsr = (*it)->parent;
+        if (std::find(op->pinned.begin(), op->pinned.end(), tsr) != op->pinned.end()) continue;
+        if (!refine) {
+          // the first execution only observes, every tensor leaves home for the operation
+          // and is returned right after, once the layout chosen for it is recorded
+          op->pinned.push_back(tsr);
+        } else if (next_use.count(tsr) != 0) {
+          // a tensor keeps its layout only if its next use settled on the same one and it
+          // is not the home layout, otherwise both operations are executed directly
+          std::map<std::pair<TensorOperation*, tensor*>, std::string>::iterator cur, nxt;
+          cur = observed_layouts.find(std::make_pair(op, tsr));
+          nxt = observed_layouts.find(std::make_pair(next_use[tsr], tsr));
+          if (cur != observed_layouts.end() && nxt != observed_layouts.end() &&
+              !cur->second.empty() && cur->second == nxt->second) {
+            op->pinned.push_back(tsr);
+          }
+        }
+      }
+      for (it=tensors.begin(); it!=tensors.end(); it++) {
+        next_use[(*it)->parent] = op;
+      }
+    }
+    if (refine) {
+      layouts_planned = true;
+      observed_layouts.clear();
+    }
+  }
+
+  void Schedule::return_home(tensor* tsr) {
+    tensor* home = unhomed[tsr];
+    unhomed.erase(tsr);
+    if (tsr->is_folded) tsr->unfold();
+    if (home->data != NULL) {
+      // the home data is still current, so the pinned copy is discarded
+      tsr->topo = home->topo;
+      copy_mapping(tsr->order, home->edge_map, tsr->edge_map);
+      tsr->set_padding();
+      cdealloc(tsr->data);
+      tsr->data = (char*)data_alloc(tsr->size*tsr->sr->el_size);
+      memcpy(tsr->data, home->data, tsr->size*tsr->sr->el_size);
+    } else {
+      tsr->align(home);
+    }
+    tsr->reset_home();
+    delete home;
+  }
+
+  void Schedule::eliminate_common_subexpression(TensorOperation* op) {
+    if (dynamic_cast<Idx_Tensor const*>(op->rhs) != NULL) return;
+    std::map<char, char> idx_rename;
+    std::string key;
+    if (!get_term_key(op->rhs, write_count, idx_rename, key)) return;
+
+    std::map<std::string, AssignedExpression>::iterator prev = assigned_exprs.find(key);
+    if (prev != assigned_exprs.end()) {
+      tensor* prev_lhs = prev->second.lhs;
+      // the earlier output must still hold the value and have the same algebraic structure
+      bool is_reusable = write_count[prev_lhs->wrld_tsr_id] == prev->second.version &&
+                         typeid(*prev_lhs->sr) == typeid(*op->lhs->parent->sr);
+      // indices of the output must be the same, up to renaming, as those of the earlier one
+      std::map<char, char> idx_restore;
+      std::map<char, char>::iterator rit;
+      for (rit=idx_rename.begin(); rit!=idx_rename.end(); rit++) {
+        idx_restore[rit->second] = rit->first;
+      }
+      std::set<char> out_idx, prev_out_idx(prev->second.out_idx.begin(), prev->second.out_idx.end());
+      for (int i=0; i<op->lhs->parent->order; i++) {
+        if (idx_rename.count(op->lhs->idx_map[i]) != 0) out_idx.insert(idx_rename[op->lhs->idx_map[i]]);
+      }
+      if (is_reusable && out_idx == prev_out_idx) {
+        char * idx_map = (char*)alloc(prev_lhs->order*sizeof(char));
+        for (int i=0; i<prev_lhs->order; i++) {
+          idx_map[i] = idx_restore[prev->second.out_idx[i]];
+        }
+        if (world != NULL && world->rank == 0)
+          DPRINTF(2,"Schedule reuses %s for the right-hand side of an operation on %s\n", prev_lhs->name, op->name());
+        delete op->rhs;
+        op->rhs = new Idx_Tensor(prev_lhs, idx_map);
+        cdealloc(idx_map);
+        return;
+      }
+    }
+
+    if (op->op == TENSOR_OP_SET && writes_all_entries(op->lhs)) {
+      AssignedExpression expr;
+      expr.lhs = op->lhs->parent;
+      for (int i=0; i<op->lhs->parent->order; i++) {
+        // an output index not in the right-hand side broadcasts, the value is not reusable
+        if (idx_rename.count(op->lhs->idx_map[i]) == 0) return;
+        expr.out_idx.push_back(idx_rename[op->lhs->idx_map[i]]);
+      }
+      expr.version = write_count[op->lhs->parent->wrld_tsr_id]+1;
+      assigned_exprs[key] = expr;
+    }
+  }
+
+  void Schedule::remove_operation(TensorOperation* op) {
+    std::vector<TensorOperation*> preds;
+    typename std::deque<TensorOperation*>::iterator it;
+    for (it=steps_original.begin(); it!=steps_original.end(); it++) {
+      std::vector<TensorOperation*> & succ = (*it)->successors;
+      if (std::find(succ.begin(), succ.end(), op) != succ.end()) {
+        preds.push_back(*it);
+        succ.erase(std::remove(succ.begin(), succ.end(), op), succ.end());
+        std::vector<TensorOperation*> & reads = (*it)->reads;
+        reads.erase(std::remove(reads.begin(), reads.end(), op), reads.end());
+      }
+    }
+    for (int i=0; i<(int)op->successors.size(); i++) {
+      TensorOperation* succ = op->successors[i];
+      succ->dependency_count--;
+      for (int j=0; j<(int)preds.size(); j++) {
+        std::vector<TensorOperation*> & pred_succ = preds[j]->successors;
+        if (std::find(pred_succ.begin(), pred_succ.end(), succ) == pred_succ.end()) {
+          pred_succ.push_back(succ);
+          succ->dependency_count++;
+        }
+      }
+    }
+    steps_original.erase(std::remove(steps_original.begin(), steps_original.end(), op), steps_original.end());
+    root_tasks.erase(std::remove(root_tasks.begin(), root_tasks.end(), op), root_tasks.end());
+    delete op;
+  }
+
   void Schedule::add_operation_typed(TensorOperation* op) {
+    if (optimize) eliminate_common_subexpression(op);
     steps_original.push_back(op);
+    layouts_planned = false;
+    observed_layouts.clear();
 
     std::set<Idx_Tensor*, tensor_name_less > op_lhs_set;
     op->get_outputs(&op_lhs_set);
@@ -319,9 +1086,35 @@ namespace CTF {
           op->dependency_count++;
         }
       }
+      // an overwrite must also follow the previous write itself, otherwise both could
+      // be ready at once and run in either order
+      bool reads_lhs = false;
+      for (deps_iter = op_deps.begin(); deps_iter != op_deps.end(); deps_iter++) {
+        if ((*deps_iter)->parent == op_lhs) reads_lhs = true;
+      }
+      if (!reads_lhs) {
+        prev_loc->second->successors.push_back(op);
+        op->dependency_count++;
+      }
     }
 
     latest_write[op_lhs] = op;
+
+    write_count[op_lhs->wrld_tsr_id]++;
+    for (deps_iter = op_deps.begin(); deps_iter != op_deps.end(); deps_iter++) {
+      unread_writes.erase((*deps_iter)->parent->wrld_tsr_id);
+    }
+    if (optimize && op->op == TENSOR_OP_SET && writes_all_entries(op->lhs)) {
+      // earlier writes to the output are overwritten without having been read
+      std::vector<TensorOperation*> & dead = unread_writes[op_lhs->wrld_tsr_id];
+      for (int i=0; i<(int)dead.size(); i++) {
+        if (world != NULL && world->rank == 0)
+          DPRINTF(2,"Schedule removes an operation on %s overwritten before use\n", op_lhs->name);
+        remove_operation(dead[i]);
+      }
+      dead.clear();
+    }
+    unread_writes[op_lhs->wrld_tsr_id].push_back(op);
   }
 
   void Schedule::add_operation(TensorOperationBase* op) {
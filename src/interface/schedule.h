@@ -2,6 +2,7 @@
 #define __SCHEDULE_H__
 #include "common.h"
 #include <queue>
+#include <map>
 #include "idx_tensor.h"
 
 namespace CTF {
@@ -80,6 +81,12 @@ namespace CTF {
     std::vector<TensorOperation* > successors;
     std::vector<TensorOperation* > reads;
 
+    /**
+     * Schedule Planning Variables
+     */
+    // Tensors whose next use chose the same layout, these keep the layout chosen for this one
+    std::vector<CTF_int::tensor* > pinned;
+
     /**
      * Schedule Execution Variables
      */
@@ -98,6 +105,9 @@ namespace CTF {
     const CTF_int::Term* rhs;
 
     double  cached_estimated_cost;
+
+    // the schedule may rewrite rhs when optimizing recorded operations
+    friend class Schedule;
   };
 
   // untemplatized scheduler abstract base class to assist in global operations
@@ -143,7 +153,10 @@ namespace CTF {
      */
     Schedule(World* world = NULL) :
       world(world),
-      partitions(0) {}
+      optimize(false),
+      partitions(0),
+      dynamic(false),
+      layouts_planned(false) {}
 
     /**
      * \brief Starts recording all tensor operations to this schedule
@@ -162,6 +175,59 @@ namespace CTF {
      */
     inline ScheduleTimer partition_and_execute();
 
+    /**
+     * \brief Executes the ready_queue and the tasks it enables from a shared ready
+     * queue: the root of each partition claims the most expensive ready task whose
+     * tensors its partition holds whenever its previous task completes, and successors
+     * of completed tasks join the queue through schedule_op_successors. Tensors are
+     * copied to partitions, and partitions are sized in proportion to their load, by a
+     * longest-processing-time-first assignment of the initially ready tasks, so
+     * partition sizes assume tasks scale perfectly, and tensors do not move between
+     * partitions until all of them are idle
+     */
+    inline ScheduleTimer partition_and_execute_dynamic();
+
+    /**
+     * \brief Executes operations with all processors on the global tensors, in the given
+     * order, tensors pinned by plan_layouts() stay in the layout chosen by the operation
+     * instead of being mapped back home after it
+     */
+    inline ScheduleTimer execute_in_place(std::vector<TensorOperation*> const & ops);
+
+    /**
+     * \brief Plans data placement over the whole recorded DAG. The first execution only
+     * observes: each operation starts from the home layouts, as without a plan, and the
+     * layout it chooses for each of its tensors is recorded. Afterwards an operation pins
+     * a tensor if the next operation using it chose the same layout other than its home
+     * layout, so that the tensor is redistributed once for the pair rather than once for
+     * each (a tensor left in its home layout costs nothing to redistribute, and is left
+     * home so that both operations are executed directly), and an output is
+     * mapped back home once after its last pinned use. An input that was only read is
+     * returned home by restoring a copy of its home data, without communication
+     */
+    void plan_layouts();
+
+    /**
+     * \brief Maps a tensor that left home for a pinned layout back to its home mapping
+     * \param[in] tsr tensor in unhomed
+     */
+    void return_home(CTF_int::tensor* tsr);
+
+    /**
+     * \brief Replaces the right-hand side of op by a tensor that an earlier recorded
+     * assignment computed it into, if there is one, and makes op available for reuse
+     * if it is such an assignment itself
+     * \param[in,out] op operation being recorded
+     */
+    void eliminate_common_subexpression(TensorOperation* op);
+
+    /**
+     * \brief Removes a recorded operation whose output is overwritten before it is read,
+     * its predecessors take over its successors so that no ordering is lost
+     * \param[in] op operation to remove
+     */
+    void remove_operation(TensorOperation* op);
+
     /**
      * \brief Call when a tensor op finishes, this adds newly enabled ops to the ready queue
      */
@@ -182,6 +248,26 @@ namespace CTF {
       partitions = in_partitions;
     }
 
+    /**
+     * \brief Selects dynamic load balancing from a shared ready queue (see
+     * partition_and_execute_dynamic) instead of the static one-task-per-partition
+     * assignment
+     */
+    void set_dynamic(bool in_dynamic) {
+      dynamic = in_dynamic;
+    }
+
+    /**
+     * \brief Selects whether operations are optimized as they are recorded: an operation
+     * whose right-hand side was already computed into a tensor by an earlier assignment
+     * (from the same versions of the same operands, up to renaming of indices) reads that
+     * tensor instead, and an assignment that fully overwrites a tensor removes earlier
+     * writes to it that nothing has read
+     */
+    void set_optimize(bool in_optimize) {
+      optimize = in_optimize;
+    }
+
   protected:
     World* world;
 
@@ -222,6 +308,25 @@ namespace CTF {
     // Last operation writing to the key tensor
     std::map<CTF_int::tensor*, TensorOperation*> latest_write;
 
+    // Whether recorded operations are optimized (see set_optimize)
+    bool optimize;
+
+    // Number of recorded writes to each tensor (by wrld_tsr_id), distinguishing versions of its values
+    std::map<int64_t, int> write_count;
+
+    // Recorded assignments by their right-hand side, each with the output tensor, the
+    // canonical indices of the output and the version of the output holding the value
+    // (the operation itself is not kept, as it may be removed as a dead write)
+    struct AssignedExpression {
+      CTF_int::tensor* lhs;
+      std::string out_idx;
+      int version;
+    };
+    std::map<std::string, AssignedExpression> assigned_exprs;
+
+    // Operations writing the tensor of the key wrld_tsr_id since it was last read
+    std::map<int64_t, std::vector<TensorOperation*> > unread_writes;
+
     /**
      * Schedule Execution Variables
      */
@@ -233,6 +338,20 @@ namespace CTF {
      */
     int partitions;
 
+    // Whether execute() uses partition_and_execute_dynamic()
+    bool dynamic;
+
+    // Tensors that left their home mapping to keep a pinned layout, each with a
+    // tensor that holds its home mapping and, while they are only read, their home data
+    std::map<CTF_int::tensor*, CTF_int::tensor*> unhomed;
+
+    // Whether plan_layouts() has pinned tensors by observed layouts
+    bool layouts_planned;
+
+    // Serialized distribution of each unhomed tensor after each operation executed in place,
+    // empty if it is the home distribution
+    std::map<std::pair<TensorOperation*, CTF_int::tensor*>, std::string> observed_layouts;
+
   };
 
 }
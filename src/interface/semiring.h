@@ -3,6 +3,9 @@
 
 #include "functions.h"
 #include "../sparse_formats/csr.h"
+#ifdef _OPENMP
+#include "omp.h"
+#endif
 
 
 namespace CTF_int {
@@ -315,7 +318,7 @@ namespace CTF {
           memcpy(c,b,this->el_size);
         } else if (b == NULL) {
           if (c==NULL) c = (char*)CTF_int::alloc(this->el_size);
-          memcpy(c,b,this->el_size);
+          memcpy(c,a,this->el_size);
         } else {
           if (c==NULL) c = (char*)CTF_int::alloc(this->el_size);
           ((dtype*)c)[0] = fmul(((dtype*)a)[0],((dtype*)b)[0]);
@@ -553,9 +556,9 @@ namespace CTF {
             for (int i_B=IB[row_B]-1; i_B<IB[row_B+1]-1; i_B++){
               int col_B = JB[i_B]-1;
               if (!this->isequal((char const*)&alpha, this->mulid()))
-                this->fadd(C[col_B*m+row_A], this->fmul(alpha,this->fmul(A[i_A],B[i_B])));
+                C[col_B*m+row_A] = this->fadd(C[col_B*m+row_A], this->fmul(alpha,this->fmul(A[i_A],B[i_B])));
               else
-                this->fadd(C[col_B*m+row_A], this->fmul(A[i_A],B[i_B]));
+                C[col_B*m+row_A] = this->fadd(C[col_B*m+row_A], this->fmul(A[i_A],B[i_B]));
             }
           }
         }
@@ -811,6 +814,244 @@ namespace CTF {
         }
       }
 
+      /** \brief product alpha*A(i,j)*B(j,c) contributing to C(i,c) */
+      struct spmspv_prod {
+        int   i;
+        int   c;
+        dtype v;
+      };
+
+      /**
+       * \brief computes the products alpha*A(i,j)*B(j,c) of each nonzero B(j,c) with column j of A, so with
+       *        work proportional to the number of products rather than to the number of nonzeros of A,
+       *        and splits them into buckets of contiguous ranges of rows i
+       * \param[in] m number of rows of A and C
+       * \param[in] k number of columns of A and rows of B
+       * \param[in] alpha scaling factor
+       * \param[in] A values of A stored by column (compressed sparse column layout, so CSR of A^T)
+       * \param[in] JA one-based row indices of the values of A
+       * \param[in] IA one-based offsets of the k columns of A
+       * \param[in] B values of B in CSR layout
+       * \param[in] JB one-based column indices of the values of B
+       * \param[in] IB one-based offsets of the k rows of B
+       * \param[in] nbkt number of buckets
+       * \param[out] bkts products computed by thread t that fall into bucket b are in bkts[t*nbkt+b]
+       */
+      void gen_cscmult_gather
+                     (int                                     m,
+                      int                                     k,
+                      dtype                                   alpha,
+                      dtype const *                           A,
+                      int const *                             JA,
+                      int const *                             IA,
+                      dtype const *                           B,
+                      int const *                             JB,
+                      int const *                             IB,
+                      int                                     nbkt,
+                      std::vector< std::vector<spmspv_prod> > & bkts) const {
+        // only the rows of B with nonzeros select columns of A
+        std::vector<int> act;
+        for (int j=0; j<k; j++){
+          if (IB[j+1] > IB[j]) act.push_back(j);
+        }
+        bool do_scal = !this->isequal((char const*)&alpha, this->mulid());
+        int ntd = bkts.size()/nbkt;
+#ifdef _OPENMP
+        #pragma omp parallel num_threads(ntd)
+#endif
+        {
+          int tid = 0;
+#ifdef _OPENMP
+          tid = omp_get_thread_num();
+#endif
+          std::vector<spmspv_prod> * my_bkts = &bkts[tid*nbkt];
+#ifdef _OPENMP
+          #pragma omp for schedule(dynamic,16)
+#endif
+          for (int64_t a=0; a<(int64_t)act.size(); a++){
+            int j = act[a];
+            for (int i_B=IB[j]-1; i_B<IB[j+1]-1; i_B++){
+              int c = JB[i_B]-1;
+              for (int i_A=IA[j]-1; i_A<IA[j+1]-1; i_A++){
+                spmspv_prod p;
+                p.i = JA[i_A]-1;
+                p.c = c;
+                p.v = this->fmul(A[i_A],B[i_B]);
+                if (do_scal) p.v = this->fmul(alpha,p.v);
+                my_bkts[(((int64_t)p.i)*nbkt)/m].push_back(p);
+              }
+            }
+          }
+        }
+      }
+
+      /**
+       * \brief C = beta*C + alpha*A*B for sparse A given by columns, sparse B with few nonzeros in CSR layout
+       *        and dense C, see gen_cscmult_gather
+       */
+      void gen_cscmultd
+                     (int           m,
+                      int           n,
+                      int           k,
+                      dtype         alpha,
+                      dtype const * A,
+                      int const *   JA,
+                      int const *   IA,
+                      dtype const * B,
+                      int const *   JB,
+                      int const *   IB,
+                      dtype         beta,
+                      dtype *       C) const {
+        if (!this->isequal((char const*)&beta, this->mulid())){
+          this->scal(m*n, (char const *)&beta, (char*)C, 1);
+        }
+        int ntd = 1;
+#ifdef _OPENMP
+        ntd = omp_get_max_threads();
+#endif
+        std::vector< std::vector<spmspv_prod> > bkts(ntd*ntd);
+        this->gen_cscmult_gather(m, k, alpha, A, JA, IA, B, JB, IB, ntd, bkts);
+        // each bucket covers its own rows of C, so is accumulated by one thread
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static,1) num_threads(ntd)
+#endif
+        for (int b=0; b<ntd; b++){
+          for (int t=0; t<ntd; t++){
+            std::vector<spmspv_prod> const & bkt = bkts[t*ntd+b];
+            for (int64_t l=0; l<(int64_t)bkt.size(); l++){
+              int64_t off = ((int64_t)bkt[l].c)*m+bkt[l].i;
+              C[off] = this->fadd(C[off], bkt[l].v);
+            }
+          }
+        }
+      }
+
+      /**
+       * \brief C = beta*C + alpha*A*B for sparse A given by columns, sparse B with few nonzeros in CSR layout
+       *        and C in CSR layout, see gen_cscmult_gather, the products of each bucket are sorted and those
+       *        with the same index are combined by addition
+       */
+      void gen_cscmultcsr
+                     (int           m,
+                      int           n,
+                      int           k,
+                      dtype         alpha,
+                      dtype const * A,
+                      int const *   JA,
+                      int const *   IA,
+                      dtype const * B,
+                      int const *   JB,
+                      int const *   IB,
+                      dtype         beta,
+                      char *&       C_CSR) const {
+        int ntd = 1;
+#ifdef _OPENMP
+        ntd = omp_get_max_threads();
+#endif
+        std::vector< std::vector<spmspv_prod> > bkts(ntd*ntd);
+        this->gen_cscmult_gather(m, k, this->tmulid, A, JA, IA, B, JB, IB, ntd, bkts);
+        std::vector< std::vector<spmspv_prod> > merged(ntd);
+        int * IC = (int*)CTF_int::alloc(sizeof(int)*(m+1));
+        memset(IC, 0, sizeof(int)*(m+1));
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static,1) num_threads(ntd)
+#endif
+        for (int b=0; b<ntd; b++){
+          std::vector<spmspv_prod> & mrg = merged[b];
+          for (int t=0; t<ntd; t++){
+            mrg.insert(mrg.end(), bkts[t*ntd+b].begin(), bkts[t*ntd+b].end());
+            std::vector<spmspv_prod>().swap(bkts[t*ntd+b]);
+          }
+          std::sort(mrg.begin(), mrg.end(), [](spmspv_prod const & p, spmspv_prod const & q){
+            return p.i < q.i || (p.i == q.i && p.c < q.c);
+          });
+          int64_t nm = 0;
+          for (int64_t l=0; l<(int64_t)mrg.size(); l++){
+            if (nm > 0 && mrg[nm-1].i == mrg[l].i && mrg[nm-1].c == mrg[l].c){
+              mrg[nm-1].v = this->fadd(mrg[nm-1].v, mrg[l].v);
+            } else {
+              mrg[nm] = mrg[l];
+              IC[mrg[nm].i+1]++;
+              nm++;
+            }
+          }
+          mrg.resize(nm);
+        }
+        IC[0] = 1;
+        for (int i=0; i<m; i++){
+          IC[i+1] += IC[i];
+        }
+        CTF_int::CSR_Matrix C(IC[m]-1, m, n, sizeof(dtype));
+        memcpy(C.IA(), IC, sizeof(int)*(m+1));
+        CTF_int::cdealloc(IC);
+        int * JC = C.JA();
+        dtype * vC = (dtype*)C.vals();
+        // buckets hold increasing ranges of rows, so are laid out one after the other
+        std::vector<int64_t> bkt_off(ntd+1, 0);
+        for (int b=0; b<ntd; b++){
+          bkt_off[b+1] = bkt_off[b]+merged[b].size();
+        }
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static,1) num_threads(ntd)
+#endif
+        for (int b=0; b<ntd; b++){
+          for (int64_t l=0; l<(int64_t)merged[b].size(); l++){
+            JC[bkt_off[b]+l] = merged[b][l].c+1;
+            vC[bkt_off[b]+l] = merged[b][l].v;
+          }
+        }
+        CTF_int::CSR_Matrix C_in(C_CSR);
+        if (!this->isequal((char const *)&alpha, this->mulid())){
+          this->scal(C.nnz(), (char const *)&alpha, C.vals(), 1);
+        }
+        if (C_CSR == NULL || C_in.nnz() == 0 || this->isequal((char const *)&beta, this->addid())){
+          C_CSR = C.all_data;
+        } else {
+          if (!this->isequal((char const *)&beta, this->mulid())){
+            this->scal(C_in.nnz(), (char const *)&beta, C_in.vals(), 1);
+          }
+          char * ans = this->csr_add(C_CSR, C.all_data);
+          CTF_int::cdealloc(C.all_data);
+          C_CSR = ans;
+        }
+      }
+
+      void cscmultd
+                (int          m,
+                 int          n,
+                 int          k,
+                 char const * alpha,
+                 char const * A,
+                 int const *  JA,
+                 int const *  IA,
+                 int64_t      nnz_A,
+                 char const * B,
+                 int const *  JB,
+                 int const *  IB,
+                 int64_t      nnz_B,
+                 char const * beta,
+                 char *       C) const {
+        this->gen_cscmultd(m,n,k,((dtype const*)alpha)[0],(dtype const*)A,JA,IA,(dtype const*)B,JB,IB,((dtype const*)beta)[0],(dtype*)C);
+      }
+
+      void cscmultcsr
+                (int          m,
+                 int          n,
+                 int          k,
+                 char const * alpha,
+                 char const * A,
+                 int const *  JA,
+                 int const *  IA,
+                 int64_t      nnz_A,
+                 char const * B,
+                 int const *  JB,
+                 int const *  IB,
+                 int64_t      nnz_B,
+                 char const * beta,
+                 char *&      C_CSR) const {
+        this->gen_cscmultcsr(m,n,k,((dtype const*)alpha)[0],(dtype const*)A,JA,IA,(dtype const*)B,JB,IB,((dtype const*)beta)[0],C_CSR);
+      }
+
   };
   /**
    * @}
@@ -49,10 +49,18 @@ namespace CTF_int {
         }
     };
 
-    comp_ref crc(coo_cs);
-    std::sort(csr_ja, csr_ja+nz, crc);
-    comp_ref crr(coo_rs);
-    std::stable_sort(csr_ja, csr_ja+nz, crr);
+    // entries already ordered by row and then column, such as those of the transpose of a matrix
+    // read out by columns, need no sort
+    bool is_ordered = true;
+    for (int64_t i=1; i<nz && is_ordered; i++){
+      is_ordered = coo_rs[i-1] < coo_rs[i] || (coo_rs[i-1] == coo_rs[i] && coo_cs[i-1] <= coo_cs[i]);
+    }
+    if (!is_ordered){
+      comp_ref crc(coo_cs);
+      std::sort(csr_ja, csr_ja+nz, crc);
+      comp_ref crr(coo_rs);
+      std::stable_sort(csr_ja, csr_ja+nz, crr);
+    }
 #ifdef _OPENMP
     #pragma omp parallel for
 #endif
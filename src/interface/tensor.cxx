@@ -4,6 +4,66 @@
 #include "world.h"
 #include "idx_tensor.h"
 #include "../tensor/untyped_tensor.h"
+#include "../shared/fft.h"
+
+namespace CTF_int {
+  /**
+   * \brief orders pairs by value, ascending or descending, and pairs of equal value by key
+   */
+  template <typename dtype>
+  struct pair_val_cmp {
+    bool desc;
+    pair_val_cmp(bool desc_) : desc(desc_) { }
+    bool operator()(CTF::Pair<dtype> const & a, CTF::Pair<dtype> const & b) const {
+      if (a.d < b.d) return !desc;
+      if (b.d < a.d) return desc;
+      return a.k < b.k;
+    }
+  };
+
+  /**
+   * \brief MPI reduction operator for lists of k pairs ordered by pair_val_cmp<dtype>(desc),
+   *        merging the two lists and keeping the first k pairs, unused pairs have key -1
+   */
+  template <typename dtype, bool desc>
+  void top_k_op(void * in, void * inout, int * len, MPI_Datatype * dt){
+    int sz;
+    MPI_Type_size(*dt, &sz);
+    int64_t k = sz/sizeof(CTF::Pair<dtype>);
+    pair_val_cmp<dtype> cmp(desc);
+    std::vector< CTF::Pair<dtype> > mrg(k);
+    for (int j=0; j<*len; j++){
+      CTF::Pair<dtype> const * a = ((CTF::Pair<dtype> const*)in)+j*k;
+      CTF::Pair<dtype> * b = ((CTF::Pair<dtype>*)inout)+j*k;
+      int64_t ia = 0, ib = 0;
+      for (int64_t i=0; i<k; i++){
+        bool has_a = ia < k && a[ia].k >= 0;
+        bool has_b = ib < k && b[ib].k >= 0;
+        if (has_a && (!has_b || cmp(a[ia], b[ib]))) mrg[i] = a[ia++];
+        else if (has_b) mrg[i] = b[ib++];
+        else mrg[i].k = -1;
+      }
+      std::copy(mrg.begin(), mrg.end(), b);
+    }
+  }
+
+  /**
+   * \brief reads the nonzeros of a sparse tensor or the elements of a dense one stored on
+   *        this process, each element of the tensor being read by one process only
+   */
+  template <typename dtype>
+  void read_unique_pairs(CTF::Tensor<dtype> const * T, int64_t * npair, CTF::Pair<dtype> ** pairs){
+    if (T->is_sparse){
+      T->read_local_nnz(npair, pairs);
+      if (!T->is_replica_root()){
+        if (*pairs != NULL) cdealloc(*pairs);
+        *npair = 0;
+        *pairs = NULL;
+      }
+    } else
+      T->read_local(npair, pairs);
+  }
+}
 
 namespace CTF {
 
@@ -690,6 +750,44 @@ namespace CTF {
     return ans;
   }
 
+  template<typename dtype>
+  void Tensor<dtype>::scan(int mode, bool exclusive){
+    int ret = CTF_int::tensor::scan(mode, sr, exclusive);
+    assert(ret == CTF_int::SUCCESS);
+  }
+
+  template<typename dtype>
+  void Tensor<dtype>::scan(int mode, Monoid<dtype> const & mon, bool exclusive){
+    int ret = CTF_int::tensor::scan(mode, &mon, exclusive);
+    assert(ret == CTF_int::SUCCESS);
+  }
+
+  template<typename dtype>
+  void Tensor<dtype>::fft(int mode, bool inverse, bool restore_layout){
+    if (wrld->rank == 0)
+      printf("CTF ERROR: fft(mode, inverse, restore_layout) not available for the type of tensor %s\n",name);
+    assert(0);
+  }
+
+  template <typename real>
+  void fft_base(int mode, bool inverse, bool restore_layout, Tensor< std::complex<real> > & T){
+    CTF_int::fft_plan<real> plan(T.lens[mode], inverse);
+    int ret = T.transform_fibers(mode, [&](int64_t nfib, int64_t ld, char * fib){
+      plan.execute(nfib, ld, (std::complex<real>*)fib);
+    }, restore_layout);
+    assert(ret == CTF_int::SUCCESS);
+  }
+
+  template<>
+  inline void Tensor< std::complex<double> >::fft(int mode, bool inverse, bool restore_layout){
+    fft_base<double>(mode, inverse, restore_layout, *this);
+  }
+
+  template<>
+  inline void Tensor< std::complex<float> >::fft(int mode, bool inverse, bool restore_layout){
+    fft_base<float>(mode, inverse, restore_layout, *this);
+  }
+
   template<typename dtype>
   void Tensor<dtype>::get_max_abs(int     n,
                                   dtype * data) const {
@@ -698,6 +796,121 @@ namespace CTF {
     assert(ret == CTF_int::SUCCESS);
   }
 
+  template<typename dtype>
+  void Tensor<dtype>::sort(int64_t *      npair,
+                           Pair<dtype> ** pairs,
+                           bool           descending) const {
+    IASSERT(sr->is_ordered());
+    int np = wrld->np;
+    int64_t nloc;
+    Pair<dtype> * loc;
+    CTF_int::read_unique_pairs(this, &nloc, &loc);
+    CTF_int::pair_val_cmp<dtype> cmp(descending);
+    std::sort(loc, loc+nloc, cmp);
+    if (np == 1){
+      *npair = nloc;
+      *pairs = loc;
+      return;
+    }
+
+    // np-1 regular samples of the sorted local pairs of each process
+    int psz = sizeof(Pair<dtype>);
+    std::vector< Pair<dtype> > smp;
+    if (nloc > 0){
+      for (int i=1; i<np; i++){
+        smp.push_back(loc[(i*nloc)/np]);
+      }
+    }
+    int nsmp = smp.size()*psz;
+    std::vector<int> smp_counts(np), smp_displs(np, 0);
+    MPI_Allgather(&nsmp, 1, MPI_INT, &smp_counts[0], 1, MPI_INT, wrld->comm);
+    for (int i=1; i<np; i++){
+      smp_displs[i] = smp_displs[i-1]+smp_counts[i-1];
+    }
+    int64_t nall = (smp_displs[np-1]+smp_counts[np-1])/psz;
+    std::vector< Pair<dtype> > all_smp(std::max((int64_t)1,nall));
+    MPI_Allgatherv(smp.size() > 0 ? &smp[0] : NULL, nsmp, MPI_BYTE,
+                   &all_smp[0], &smp_counts[0], &smp_displs[0], MPI_BYTE, wrld->comm);
+    if (nall == 0){
+      *npair = 0;
+      *pairs = loc;
+      return;
+    }
+    std::sort(all_smp.begin(), all_smp.begin()+nall, cmp);
+
+    // pairs preceding splitter i go to process i, the splitters are elements, so are distinct
+    std::vector<int64_t> send_counts(np), send_displs(np, 0), recv_counts(np), recv_displs(np, 0);
+    int64_t prv = 0;
+    for (int i=0; i<np; i++){
+      int64_t nxt = nloc;
+      if (i < np-1)
+        nxt = std::lower_bound(loc, loc+nloc, all_smp[((i+1)*nall)/np], cmp)-loc;
+      nxt = std::max(prv, nxt);
+      send_counts[i] = nxt-prv;
+      if (i > 0) send_displs[i] = prv;
+      prv = nxt;
+    }
+    MPI_Alltoall(&send_counts[0], 1, MPI_INT64_T, &recv_counts[0], 1, MPI_INT64_T, wrld->comm);
+    for (int i=1; i<np; i++){
+      recv_displs[i] = recv_displs[i-1]+recv_counts[i-1];
+    }
+    int64_t nrecv = recv_displs[np-1]+recv_counts[np-1];
+    Pair<dtype> * rcv = (Pair<dtype>*)CTF_int::alloc(std::max((int64_t)1,nrecv)*psz);
+    wrld->cdt.all_to_allv(loc, &send_counts[0], &send_displs[0], psz, rcv, &recv_counts[0], &recv_displs[0]);
+    if (loc != NULL) CTF_int::cdealloc(loc);
+
+    // the pairs received from each process are sorted, merge them pairwise
+    for (int w=1; w<np; w*=2){
+      for (int i=0; i+w<np; i+=2*w){
+        int l = std::min(i+2*w, np)-1;
+        std::inplace_merge(rcv+recv_displs[i], rcv+recv_displs[i+w],
+                           rcv+recv_displs[l]+recv_counts[l], cmp);
+      }
+    }
+    *npair = nrecv;
+    *pairs = rcv;
+  }
+
+  template<typename dtype>
+  int64_t Tensor<dtype>::top_k(int64_t       k,
+                               Pair<dtype> * pairs,
+                               bool          smallest) const {
+    IASSERT(sr->is_ordered());
+    IASSERT(k >= 0 && k*(int64_t)sizeof(Pair<dtype>) <= INT_MAX);
+    if (k == 0) return 0;
+    int64_t nloc;
+    Pair<dtype> * loc;
+    CTF_int::read_unique_pairs(this, &nloc, &loc);
+    CTF_int::pair_val_cmp<dtype> cmp(!smallest);
+    int64_t m = std::min(k, nloc);
+    std::partial_sort(loc, loc+m, loc+nloc, cmp);
+    std::vector< Pair<dtype> > buf(k);
+    std::copy(loc, loc+m, buf.begin());
+    for (int64_t i=m; i<k; i++){
+      buf[i].k = -1;
+    }
+    if (loc != NULL) CTF_int::cdealloc(loc);
+
+    MPI_Datatype dt;
+    MPI_Op op;
+    MPI_Type_contiguous(k*sizeof(Pair<dtype>), MPI_BYTE, &dt);
+    MPI_Type_commit(&dt);
+    if (smallest)
+      MPI_Op_create(&CTF_int::top_k_op<dtype,false>, 1, &op);
+    else
+      MPI_Op_create(&CTF_int::top_k_op<dtype,true>, 1, &op);
+    MPI_Allreduce(MPI_IN_PLACE, &buf[0], 1, dt, op, wrld->comm);
+    MPI_Op_free(&op);
+    MPI_Type_free(&dt);
+
+    int64_t nk = 0;
+    while (nk < k && buf[nk].k >= 0){
+      pairs[nk] = buf[nk];
+      nk++;
+    }
+    return nk;
+  }
+
   template<typename dtype>
   void Tensor<dtype>::fill_random(dtype rmin, dtype rmax){
     if (wrld->rank == 0) 
@@ -711,6 +924,7 @@ namespace CTF {
     for (int64_t i=0; i<T.size; i++){
       ((dtype*)T.data)[i] = CTF_int::get_rand48()*(rmax-rmin)+rmin;
     }
+    T.data_modified();
     T.zero_out_padding();
   }
 
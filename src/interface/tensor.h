@@ -776,6 +776,41 @@ namespace CTF {
        */    
       dtype norm_infty(){ return reduce(OP_MAXABS); };
 
+      /**
+       * \brief replaces each element by the sum of the elements up to it along a mode, e.g.
+       *        A.scan(1) gives A[i,j] = sum_{k<=j} A[i,k], each process scans its cyclic slice
+       *        of the mode and the partial sums are combined by a scan along the processor grid
+       *        dimension the mode is mapped to, so the cost is O(n/p) work and communication
+       *        and O(log p) messages; the tensor must be dense and not symmetric in mode
+       * \param[in] mode mode to scan along
+       * \param[in] exclusive if true each element is left out of its own sum, the first becomes zero
+       */
+      void scan(int mode, bool exclusive=false);
+
+      /**
+       * \brief replaces each element by the sum of the elements up to it along a mode,
+       *        as scan(mode, exclusive), but with the addition and identity of mon, e.g. a
+       *        Monoid with max to obtain running maxima
+       * \param[in] mode mode to scan along
+       * \param[in] mon monoid defining the summation operation and its identity
+       * \param[in] exclusive if true each element is left out of its own sum, the first becomes the identity of mon
+       */
+      void scan(int mode, Monoid<dtype> const & mon, bool exclusive=false);
+
+      /**
+       * \brief discrete Fourier transform along a mode of a complex tensor,
+       *        A.fft(1) gives A[i,k] = sum_j A[i,j]*exp(-2 pi i jk/n), the tensor is redistributed
+       *        so that the mode is local to each process and all its fibers are transformed by
+       *        a mixed-radix FFT threaded over fibers, so O(n log n) work per fiber; the tensor
+       *        must be dense and nonsymmetric, and a vector is transformed redundantly by all processes
+       * \param[in] mode mode to transform along
+       * \param[in] inverse if true use exp(+2 pi i jk/n) and scale by 1/n
+       * \param[in] restore_layout if true the tensor is mapped back to its previous distribution,
+       *                           otherwise it keeps the one with the mode local, which is cheaper
+       *                           when several transforms or operations follow
+       */
+      void fft(int mode, bool inverse=false, bool restore_layout=false);
+
       /**
        * \brief gives the raw current local data with padding included
        * \param[out] size of local data chunk
@@ -858,6 +893,36 @@ namespace CTF {
        */
       void get_max_abs(int     n,
                        dtype * data) const;
+
+      /**
+       * \brief sorts the elements of the tensor by value with a sample sort, the values of each
+       *        process are sorted locally, np-1 splitters are chosen from regular samples of all
+       *        processes, and the elements are exchanged with one all-to-all and merged, so that
+       *        the returned pairs of process i precede those of process i+1 and each process
+       *        has at most about twice its share of the elements
+       *        only nonzeros are sorted for sparse tensors and only unique elements for symmetric
+       *        ones, equal values are ordered by key, dtype must be ordered (e.g. not complex)
+       * \param[out] npair number of pairs on this process
+       * \param[out] pairs sorted pairs on this process, allocated with CTF_int::alloc
+       * \param[in] descending if true sort from largest to smallest value
+       */
+      void sort(int64_t *      npair,
+                Pair<dtype> ** pairs,
+                bool           descending=false) const;
+
+      /**
+       * \brief obtains the k pairs with the largest (or smallest) values of the tensor without
+       *        sorting it, each process selects its best k elements, which are merged by an
+       *        allreduction that keeps the best k, so the communication is O(k log p)
+       *        the elements considered and their order are as in sort()
+       * \param[in] k number of pairs to obtain
+       * \param[out] pairs preallocated array of size at least k, filled on all processes in order
+       * \param[in] smallest if true obtain the k smallest values rather than the largest
+       * \return number of pairs obtained, less than k only if the tensor has fewer elements
+       */
+      int64_t top_k(int64_t       k,
+                    Pair<dtype> * pairs,
+                    bool          smallest=false) const;
   
       /**
        * \brief fills local unique tensor elements to random values in the range [min,max]
@@ -942,6 +1007,8 @@ namespace CTF {
 #include "vector.h"
 #include "scalar.h"
 #include "sparse_tensor.h"
+#include "fused_reduction.h"
+#include "batched_contraction.h"
 
 
 #endif
@@ -175,17 +175,74 @@ namespace CTF_int {
   //}
 
 
-  Term::Term(algstrct const * sr_){
-    sr = sr_->clone();
-    scale = NULL; // (char*)alloc(sr->el_size);
-    sr->safecopy(scale,sr->mulid());
+  term_list::term_list(){
+    n   = 0;
+    cap = TERM_INLINE_OPS;
+    ptr = buf;
+  }
+
+  term_list::term_list(term_list const & other){
+    n   = 0;
+    cap = TERM_INLINE_OPS;
+    ptr = buf;
+    *this = other;
+  }
+
+  term_list & term_list::operator=(term_list const & other){
+    if (this == &other) return *this;
+    n = 0;
+    while (cap < other.n) grow();
+    memcpy(ptr, other.ptr, other.n*sizeof(Term*));
+    n = other.n;
+    return *this;
+  }
+
+  term_list::~term_list(){
+    if (ptr != buf) cdealloc(ptr);
+  }
+
+  void term_list::grow(){
+    Term ** new_ptr = (Term**)alloc(2*cap*sizeof(Term*));
+    memcpy(new_ptr, ptr, n*sizeof(Term*));
+    if (ptr != buf) cdealloc(ptr);
+    ptr = new_ptr;
+    cap = 2*cap;
+  }
+
+  Term::Term(algstrct const * sr_, bool own_sr_){
+    own_sr = own_sr_;
+    if (own_sr) sr = sr_->clone();
+    else sr = const_cast<algstrct*>(sr_);
+    // without a multiplicative identity scale stays NULL
+    scale = NULL;
+    set_scale(sr->mulid());
   }
   
   Term::~Term(){
-    delete sr;
-    if (scale != NULL){
-      cdealloc(scale);
+    set_scale(NULL);
+    if (own_sr) delete sr;
+  }
+
+  void Term::set_scale(char const * val){
+    if (val == NULL){
+      if (scale != NULL && scale != scale_buf) cdealloc(scale);
       scale = NULL;
+    } else {
+      if (scale == NULL){
+        if (sr->el_size <= TERM_INLINE_SCALE) scale = scale_buf;
+        else scale = (char*)alloc(sr->el_size);
+      }
+      if (scale != val) sr->copy(scale, val);
+    }
+  }
+
+  void Term::mul_scale(char const * a, char const * b){
+    if (a == NULL || b == NULL)
+      set_scale(a == NULL ? b : a);
+    else {
+      // scale is only allocated here when it is neither of the factors
+      if (scale == NULL) set_scale(sr->mulid());
+      sr->safemul(a, b, scale);
     }
   }
 
@@ -285,7 +342,7 @@ namespace CTF_int {
 
   //functions spectific to Sum_Term
 
-  Sum_Term::Sum_Term(Term * B, Term * A) : Term(A->sr) {
+  Sum_Term::Sum_Term(Term * B, Term * A) : Term(A->sr, !A->shares_sr()) {
     operands.push_back(B);
     operands.push_back(A);
   }
@@ -300,8 +357,8 @@ namespace CTF_int {
 
   Sum_Term::Sum_Term(
       Sum_Term const & other,
-      std::map<tensor*, tensor*>* remap) : Term(other.sr) {
-    sr->safecopy(this->scale, other.scale);
+      std::map<tensor*, tensor*>* remap) : Term(other.sr, !other.shares_sr() || remap != NULL) {
+    set_scale(other.scale);
     for (int i=0; i<(int)other.operands.size(); i++){
       this->operands.push_back(other.operands[i]->clone(remap));
     }
@@ -333,7 +390,7 @@ namespace CTF_int {
   }
 
   Idx_Tensor Sum_Term::estimate_time(double & cost) const {
-    std::vector< Term* > tmp_ops;
+    term_list tmp_ops;
     for (int i=0; i<(int)operands.size(); i++){
       tmp_ops.push_back(operands[i]->clone());
     }
@@ -363,10 +420,7 @@ namespace CTF_int {
 
 
   double Sum_Term::estimate_time(Idx_Tensor output) const{
-    std::vector< Term* > tmp_ops;
-    for (int i=0; i<(int)operands.size(); i++){
-      tmp_ops.push_back(operands[i]->clone());
-    }
+    term_list tmp_ops = operands;
     double cost = 0.0;
     for (int i=0; i<((int)tmp_ops.size())-1; i++){
       cost += tmp_ops[i]->estimate_time(output);
@@ -379,7 +433,7 @@ namespace CTF_int {
   }
 
   Idx_Tensor Sum_Term::execute() const {
-    std::vector< Term* > tmp_ops;
+    term_list tmp_ops;
     for (int i=0; i<(int)operands.size(); i++){
       tmp_ops.push_back(operands[i]->clone());
     }
@@ -402,7 +456,7 @@ namespace CTF_int {
       delete pop_A;
       delete pop_B;
     }
-    sr->safemul(tmp_ops[0]->scale, this->scale, tmp_ops[0]->scale); 
+    tmp_ops[0]->mul_scale(tmp_ops[0]->scale, this->scale);
     Idx_Tensor ans = tmp_ops[0]->execute();
     delete tmp_ops[0];
     tmp_ops.clear();
@@ -411,14 +465,28 @@ namespace CTF_int {
 
 
   void Sum_Term::execute(Idx_Tensor output) const{
-    std::vector< Term* > tmp_ops = operands;
+    // the scaling factor of the sum applies to each of its operands
+    bool is_scl = !sr->isequal(this->scale, sr->mulid());
+    term_list tmp_ops;
+    for (int i=0; i<(int)operands.size(); i++){
+      if (is_scl){
+        tmp_ops.push_back(operands[i]->clone());
+        tmp_ops[i]->mul_scale(tmp_ops[i]->scale, this->scale);
+      } else
+        tmp_ops.push_back(operands[i]);
+    }
     for (int i=0; i<((int)tmp_ops.size())-1; i++){
       tmp_ops[i]->execute(output);
-      sr->safecopy(output.scale, sr->mulid());
+      output.set_scale(sr->mulid());
     }
     Idx_Tensor itsr = tmp_ops.back()->execute();
     summation s(itsr.parent, itsr.idx_map, itsr.scale, output.parent, output.idx_map, output.scale);
     s.execute();
+    if (is_scl){
+      for (int i=0; i<(int)tmp_ops.size(); i++){
+        delete tmp_ops[i];
+      }
+    }
   }
 
 
@@ -461,7 +529,7 @@ namespace CTF_int {
   }
 
 
-  Contract_Term::Contract_Term(Term * B, Term * A) : Term(A->sr) {
+  Contract_Term::Contract_Term(Term * B, Term * A) : Term(A->sr, !A->shares_sr()) {
     operands.push_back(B);
     operands.push_back(A);
   }
@@ -469,8 +537,8 @@ namespace CTF_int {
 
   Contract_Term::Contract_Term(
       Contract_Term const & other,
-      std::map<tensor*, tensor*>* remap) : Term(other.sr) {
-    sr->safecopy(this->scale, other.scale);
+      std::map<tensor*, tensor*>* remap) : Term(other.sr, !other.shares_sr() || remap != NULL) {
+    set_scale(other.scale);
     for (int i=0; i<(int)other.operands.size(); i++){
       Term * t = other.operands[i]->clone(remap);
       operands.push_back(t);
@@ -491,12 +559,21 @@ namespace CTF_int {
 
 
   void Contract_Term::execute(Idx_Tensor output)const {
-    std::vector< Term* > tmp_ops;
-    for (int i=0; i<(int)operands.size(); i++){
-      tmp_ops.push_back(operands[i]->clone());
+    // a pair of operands is executed without copies, since none of them is consumed
+    bool is_pair = operands.size() == 2;
+    term_list tmp_ops;
+    if (is_pair) tmp_ops = operands;
+    else {
+      for (int i=0; i<(int)operands.size(); i++){
+        tmp_ops.push_back(operands[i]->clone());
+      }
     }
     char * tscale = NULL;
     sr->safecopy(tscale, this->scale);
+    // whether the last intermediate was laid out in the mapping of the final contraction,
+    // and whether the final contraction should keep the intermediate in the layout it is produced in
+    bool premapped = false;
+    bool keep_intm = false;
     while (tmp_ops.size() > 2){
       Term * pop_A = tmp_ops.back();
       tmp_ops.pop_back();
@@ -505,10 +582,10 @@ namespace CTF_int {
       Idx_Tensor op_A = pop_A->execute();
       Idx_Tensor op_B = pop_B->execute();
       if (op_A.parent == NULL) {
-        sr->safemul(op_A.scale, op_B.scale, op_B.scale);
+        op_B.mul_scale(op_A.scale, op_B.scale);
         tmp_ops.push_back(op_B.clone());
       } else if (op_B.parent == NULL) {
-        sr->safemul(op_A.scale, op_B.scale, op_A.scale);
+        op_A.mul_scale(op_A.scale, op_B.scale);
         tmp_ops.push_back(op_A.clone());
       } else {
         std::set<char> uniq_inds;
@@ -529,11 +606,26 @@ namespace CTF_int {
         std::vector<char> arr(uniq_inds.begin(), uniq_inds.end());
 
         Idx_Tensor * intm = get_full_intm(op_A, op_B, uniq_inds.size(), &(arr[0]));
+        Idx_Tensor * next = tmp_ops.size() == 1 ? dynamic_cast<Idx_Tensor*>(tmp_ops[0]) : NULL;
+        if (next != NULL && next->parent != NULL && output.parent != NULL &&
+            next->parent != output.parent){
+          // the last intermediate is created in the mapping the final contraction will
+          // select for it, so that it is written once rather than produced and redistributed,
+          // if that fails the final contraction keeps it in the layout its producer writes
+          contraction c_next(next->parent, next->idx_map,
+                             intm->parent, intm->idx_map, this->scale,
+                             output.parent, output.idx_map, output.scale);
+          premapped = c_next.premap_operand(intm->parent) == SUCCESS;
+          keep_intm = true;
+        }
         sr->safemul(tscale, op_A.scale, tscale);
         sr->safemul(tscale, op_B.scale, tscale);
         contraction c(op_A.parent, op_A.idx_map,
                       op_B.parent, op_B.idx_map, tscale,
                       intm->parent, intm->idx_map, intm->scale);
+        // the producer only considers mappings that keep the premapped intermediate in place,
+        // which also makes its search short
+        if (premapped) c.keep_map = 4;
         c.execute(); 
         sr->safecopy(tscale, sr->mulid());
         tmp_ops.push_back(intm);
@@ -569,18 +661,23 @@ namespace CTF_int {
         contraction c(op_A.parent, op_A.idx_map,
                       op_B.parent, op_B.idx_map, tscale,
                       output.parent, output.idx_map, output.scale);
+        // the intermediate is not moved again, whether it was premapped or the premapped
+        // layout was replicated and could not be written, unless no mapping can keep it
+        if (keep_intm) c.keep_map = 2;
         c.execute();
       }
       if (tscale != NULL) cdealloc(tscale);
       tscale = NULL;
-      delete pop_A;
-      delete pop_B;
+      if (!is_pair){
+        delete pop_A;
+        delete pop_B;
+      }
     } 
   }
 
 
   Idx_Tensor Contract_Term::execute() const {
-    std::vector< Term* > tmp_ops;
+    term_list tmp_ops;
     for (int i=0; i<(int)operands.size(); i++){
       tmp_ops.push_back(operands[i]->clone());
     }
@@ -593,11 +690,15 @@ namespace CTF_int {
       tmp_ops.pop_back();
       Idx_Tensor op_A = pop_A->execute();
       Idx_Tensor op_B = pop_B->execute();
+      // the scaling factor of the term is applied to the first product, whether or not
+      // one of its factors is a scalar
       if (op_A.parent == NULL) {
-        sr->safemul(op_B.scale, op_A.scale, op_B.scale);
+        op_B.mul_scale(op_B.scale, op_A.scale);
+        op_B.mul_scale(op_B.scale, tscale);
         tmp_ops.push_back(op_B.clone());
       } else if (op_B.parent == NULL) {
-        sr->safemul(op_B.scale, op_A.scale, op_A.scale);
+        op_A.mul_scale(op_B.scale, op_A.scale);
+        op_A.mul_scale(op_A.scale, tscale);
         tmp_ops.push_back(op_A.clone());
       } else {
         Idx_Tensor * intm = get_full_intm(op_A, op_B);
@@ -626,9 +727,13 @@ namespace CTF_int {
 
   double Contract_Term::estimate_time(Idx_Tensor output)const {
     double cost = 0.0;
-    std::vector< Term* > tmp_ops;
-    for (int i=0; i<(int)operands.size(); i++){
-      tmp_ops.push_back(operands[i]->clone());
+    bool is_pair = operands.size() == 2;
+    term_list tmp_ops;
+    if (is_pair) tmp_ops = operands;
+    else {
+      for (int i=0; i<(int)operands.size(); i++){
+        tmp_ops.push_back(operands[i]->clone());
+      }
     }
     while (tmp_ops.size() > 2){
       Term * pop_A = tmp_ops.back();
@@ -677,15 +782,17 @@ namespace CTF_int {
                       output.parent, output.idx_map, output.scale);
         cost += c.estimate_time();
       }
-      delete pop_A;
-      delete pop_B;
+      if (!is_pair){
+        delete pop_A;
+        delete pop_B;
+      }
     } 
     return cost;
   }
 
 
   Idx_Tensor Contract_Term::estimate_time(double & cost) const {
-    std::vector< Term* > tmp_ops;
+    term_list tmp_ops;
     for (int i=0; i<(int)operands.size(); i++){
       tmp_ops.push_back(operands[i]->clone());
     }
@@ -764,12 +871,14 @@ namespace CTF_int {
     } else if (A->parent == NULL || B->parent == NULL) {
       return false;
     }
+    // names are drawn from the world's common generator and equally named tensors are told
+    // apart by their order of creation, so the ordering is consistent across processes
+    // (only tensors of different worlds may remain tied, those are ordered by address)
     int d = strcmp(A->parent->name, B->parent->name);
-    if (d>0) return d; 
-    else return 1;
-    /*assert(0);//FIXME
-    //return A->tid < B->tid;
-    return -1;*/
+    if (d != 0) return d < 0;
+    if (A->parent->wrld_tsr_id != B->parent->wrld_tsr_id)
+      return A->parent->wrld_tsr_id < B->parent->wrld_tsr_id;
+    return A->parent < B->parent;
   }
 }
 
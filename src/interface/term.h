@@ -4,6 +4,7 @@
 #include <map>
 #include <set>
 #include "../tensor/untyped_tensor.h"
+#include "../shared/util.h"
 
 namespace CTF {
   class Idx_Tensor;
@@ -15,9 +16,42 @@ namespace CTF_int {
    * \addtogroup expression
    * @{
    */
+  class Term;
   class Sum_Term;
   class Contract_Term;
 
+  /**
+   * \brief list of the operands of a term, which stores up to TERM_INLINE_OPS of them inline
+   *        and moves to the heap only for longer chains
+   */
+  class term_list {
+    public:
+      term_list();
+      term_list(term_list const & other);
+      term_list & operator=(term_list const & other);
+      ~term_list();
+
+      void push_back(Term * t){
+        if (n == cap) grow();
+        ptr[n++] = t;
+      }
+      void pop_back(){ n--; }
+      Term *& back(){ return ptr[n-1]; }
+      Term * const & back() const { return ptr[n-1]; }
+      Term *& operator[](int i){ return ptr[i]; }
+      Term * const & operator[](int i) const { return ptr[i]; }
+      int size() const { return n; }
+      void clear(){ n = 0; }
+
+    private:
+      int n, cap;
+      Term ** ptr;
+      Term * buf[TERM_INLINE_OPS];
+
+      /** \brief doubles the capacity */
+      void grow();
+  };
+
   /**
    * \brief comparison function for sets of tensor pointers
    * This ensures the set iteration order is consistent across nodes
@@ -34,11 +68,42 @@ namespace CTF_int {
     public:
       char * scale;
       algstrct * sr;
+      /** \brief whether sr is a copy owned by the term rather than that of a tensor the user indexed */
+      bool own_sr;
+      /** \brief storage scale points to when the element size permits */
+      alignas(16) char scale_buf[TERM_INLINE_SCALE];
      
-      Term(algstrct const * sr);
+      /**
+       * \brief creates a term with unit scaling factor
+       * \param[in] sr algebraic structure of the term
+       * \param[in] own_sr whether to keep a copy of sr, otherwise sr must belong to a tensor
+       *            that outlives the term and its copies, as do the tensors the term refers to
+       */
+      Term(algstrct const * sr, bool own_sr=true);
 
       virtual ~Term();
 
+      /**
+       * \brief sets the scaling factor (NULL for none) without freeing the inline buffer,
+       *        which sr->safecopy() would do
+       * \param[in] val new scaling factor
+       */
+      void set_scale(char const * val);
+
+      /**
+       * \brief sets the scaling factor to a*b, where NULL stands for no scaling, without freeing
+       *        the inline buffer, which sr->safemul() would do
+       * \param[in] a first factor, may be scale
+       * \param[in] b second factor, may be scale
+       */
+      void mul_scale(char const * a, char const * b);
+
+      /**
+       * \brief whether sr belongs to a tensor the user indexed, so that terms built from this one
+       *        may share it rather than copy it
+       */
+      virtual bool shares_sr() const { return !own_sr; }
+
       /**
        * \brief base classes must implement this copy function to retrieve pointer
        */ 
@@ -153,7 +218,7 @@ namespace CTF_int {
 
   class Sum_Term : public Term {
     public:
-      std::vector< Term* > operands;
+      term_list operands;
 
       /**
        * \brief creates sum term for B+A
@@ -239,7 +304,7 @@ namespace CTF_int {
    */
   class Contract_Term : public Term {
     public:
-      std::vector< Term* > operands;
+      term_list operands;
 
  
       /**
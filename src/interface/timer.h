@@ -120,11 +120,94 @@ namespace CTF {
 
   };
 
+  /**
+   * \brief how one contraction or summation invoked by the user was executed on this
+   *        process, recorded while enabled by set_op_stats(); where the operation is
+   *        decomposed (e.g. over symmetric permutations) the mapping, topology and kernel
+   *        are those of its last part and bytes and estimates are summed over the parts
+   */
+  struct Op_stats {
+    /** \brief "contraction" or "summation" */
+    std::string type;
+    /** \brief operation with tensor names and indices, e.g. C[ij]+=A[ik]*B[kj] */
+    std::string expr;
+    /** \brief lengths of the processor grid the operation was mapped to, e.g. 2x2, or 1 on one process */
+    std::string topo;
+    /** \brief mappings of the operands as displayed by print_map(), map_C is empty for summations */
+    std::string map_A, map_B, map_C;
+    /** \brief whether the operands were transposed (folded) into matrices for the local kernel */
+    bool folded;
+    /** \brief local kernel, one of gemm, reference, custom (dense contraction), coomm, csrmm,
+     *         csrmultd, csrmultcsr, cscmultd, cscmultcsr, sparse_reference (sparse contraction), axpy, reference,
+     *         custom, sparse (summation) */
+    std::string kernel;
+    /** \brief bytes sent by this process to redistribute each operand for the operation */
+    int64_t redist_bytes_A, redist_bytes_B, redist_bytes_C;
+    /** \brief bytes sent by this process during the operation */
+    int64_t comm_bytes;
+    /** \brief execution time of the mapped operation predicted by the performance model */
+    double est_time;
+    /** \brief measured execution time including redistribution */
+    double time;
+    /** \brief largest number of bytes held by tensors, and by bounded-memory redistributions of them,
+     *         on this process during the operation */
+    int64_t mem_peak;
+  };
+
+  /**
+   * \brief starts or stops recording an Op_stats for each contraction and summation
+   * \param[in] on whether to record
+   * \param[in] log_file if not NULL, rank 0 of the World of each operation also appends
+   *            its record as a line of JSON to this file
+   */
+  void set_op_stats(bool on, char const * log_file=NULL);
+
+  /**
+   * \brief records of the operations executed on this process since they were last cleared
+   */
+  std::vector<Op_stats> const & get_op_stats();
+
+  /**
+   * \brief discards the recorded operation statistics
+   */
+  void clear_op_stats();
+
 /**
  * @}
  */
 }
 
+namespace CTF_int {
+  class tensor;
+
+  /**
+   * \brief starts the record of a contraction or summation if statistics are enabled and no
+   *        operation is being recorded (operations inside another one are part of it)
+   * \param[in] type "contraction" or "summation"
+   * \param[in] expr operation with tensor names and indices
+   * \return whether the record was started and end_op_stats() must be called
+   */
+  bool begin_op_stats(char const * type, std::string const & expr);
+
+  /**
+   * \brief completes and stores the record started by begin_op_stats()
+   * \param[in] rank rank in the World of the operation, which logs the record if 0
+   */
+  void end_op_stats(int rank);
+
+  /**
+   * \brief record of the operation being executed, NULL if none
+   */
+  CTF::Op_stats * cur_op_stats();
+
+  /**
+   * \brief operation in index notation, e.g. C[ij]+=A[ik]*B[kj], B[ij]+=A[ji] if C is NULL
+   */
+  std::string op_stats_expr(tensor const * A, int const * idx_A,
+                            tensor const * B, int const * idx_B,
+                            tensor const * C, int const * idx_C,
+                            bool is_acc);
+}
 
 #endif
 
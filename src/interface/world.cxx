@@ -85,6 +85,7 @@ namespace CTF {
         delete topovec[i];
       }
       delete phys_topology;
+      cdt.free_node_comm();
       if (this->cdt.cm == MPI_COMM_WORLD){
         ASSERT(universe_exists);
         universe_exists = false;
@@ -112,6 +113,8 @@ namespace CTF {
                   int             argc,
                   const char * const *  argv){
     cdt = CommData(comm);
+    if (!(comm == MPI_COMM_WORLD && universe_exists))
+      cdt.init_node_comm();
     if (mach == TOPOLOGY_GENERIC)
       phys_topology = NULL;
     else
@@ -127,6 +130,8 @@ namespace CTF {
                   const char * const * argv){
 
     cdt = CommData(global_context);
+    if (!(comm == MPI_COMM_WORLD && universe_exists))
+      cdt.init_node_comm();
     phys_topology = new topology(order, dim_len, cdt, 1);
 
     return initialize(argc, argv);
@@ -134,7 +139,7 @@ namespace CTF {
 
   int World::initialize(int                   argc,
                         const char * const *  argv){
-    char * mst_size, * stack_size, * mem_size, * ppn;
+    char * mst_size, * stack_size, * mem_size, * ppn, * desym_frac;
     if (comm == MPI_COMM_WORLD && universe_exists){
       delete phys_topology;
       *this = universe;
@@ -224,6 +229,13 @@ namespace CTF {
                     imem_size);
         CTF_int::set_mem_size(imem_size);
       }
+      desym_frac = getenv("CTF_DESYM_MEM_FRAC");
+      if (desym_frac != NULL){
+        if (rank == 0)
+          VPRINTF(1,"Unpacked operands may use %lf of available memory by CTF_DESYM_MEM_FRAC environment variable\n",
+                    atof(desym_frac));
+        CTF_int::set_desym_mem_frac(atof(desym_frac));
+      }
       ppn = getenv("CTF_PPN");
       if (ppn != NULL){
         if (rank == 0)
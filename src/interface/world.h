@@ -37,6 +37,8 @@ namespace CTF {
                                0x5555555555555555, 17,
                                0x71d67fffeda60000, 37,
                                0xfff7eee000000000, 43, 6364136223846793005> glob_wrld_rng;
+      /** \brief number of tensors created on this world, the same on each rank */
+      int64_t ntsr_created = 0;
 
 
 
@@ -1,5 +1,6 @@
 /*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
 
+#include <map>
 #include "topology.h"
 #include "../shared/util.h"
 #include "../mapping/mapping.h"
@@ -9,12 +10,32 @@
 #endif
 
 namespace CTF_int {
+  /**
+   * \brief active topologies of each global communicator, most recently used first;
+   *        all processes of a communicator activate its topologies in the same order,
+   *        so they agree on which ones to evict, which would not hold for a single pool
+   *        shared by the topologies of different Worlds
+   */
+  static std::map< MPI_Comm, std::list<topology*> > topo_pool;
+
+  /** \brief number of communicators the topologies of each global communicator may keep alive */
+  static int topo_pool_comms = TOPO_POOL_COMMS;
+
+  void set_topo_pool_comms(int ncomm){
+    topo_pool_comms = ncomm;
+  }
+
+  int get_topo_pool_comms(){
+    return topo_pool_comms;
+  }
+
 /*
   topology::topology(){
     order        = 0;
     lens         = NULL;
     lda          = NULL;
     is_activated = false;
+    nuse         = 0;
     dim_comm     = NULL;
   }*/
   
@@ -39,7 +60,9 @@ namespace CTF_int {
       dim_comm[i] = CommData(other.dim_comm[i]);
     }
 
+    //the copy of the communicators is not owned and not pooled
     is_activated = other.is_activated;
+    nuse         = 0;
   }
 
   topology::topology(int         order_,
@@ -51,6 +74,7 @@ namespace CTF_int {
     lda          = (int*)CTF_int::alloc(order_*sizeof(int));
     dim_comm     = (CommData*)CTF_int::alloc(order_*sizeof(CommData));
     is_activated = false;
+    nuse         = 0;
    
     memcpy(lens, lens_, order_*sizeof(int));
     //reverse FIXME: this is assumed somewhere...
@@ -65,6 +89,8 @@ namespace CTF_int {
       dim_comm[i] = CommData(((rank/stride)%lens[i]),
                              (((rank/(stride*lens[i]))*stride)+cut),
                              lens[i]);
+      //the dimension spans aligned blocks of stride*lens[i] ranks, which are on one node if they divide ppn
+      dim_comm[i].intra_node = (glb_comm.ppn > 1 && glb_comm.ppn % (stride*lens[i]) == 0);
 //      SETUP_SUB_COMM_SHELL(cdt, dim_comm[i],
       stride*=lens[i];
       cut = (rank - (rank/stride)*stride);
@@ -75,19 +101,62 @@ namespace CTF_int {
 
   void topology::activate(){
     if (!is_activated){
+      TAU_FSTART(topology_activate);
+      std::list<topology*> & pool = topo_pool[glb_comm.cm];
+      int ncomm = order;
+      for (std::list<topology*>::iterator it=pool.begin(); it!=pool.end(); it++){
+        ncomm += (*it)->order;
+      }
+      std::list<topology*>::iterator it = pool.end();
+      while (ncomm > topo_pool_comms && it != pool.begin()){
+        it--;
+        if ((*it)->nuse == 0){
+          topology * lru = *it;
+          it = pool.erase(it);
+          ncomm -= lru->order;
+          lru->free_comms();
+        }
+      }
       for (int i=0; i<order; i++){
         dim_comm[i].activate(glb_comm.cm);
       }
-    } 
-    is_activated = true;
+      pool.push_front(this);
+      is_activated = true;
+      TAU_FSTOP(topology_activate);
+    } else {
+      TAU_FSTART(topology_pool_hit);
+      std::map< MPI_Comm, std::list<topology*> >::iterator pit = topo_pool.find(glb_comm.cm);
+      if (pit != topo_pool.end()){
+        std::list<topology*>::iterator it = std::find(pit->second.begin(), pit->second.end(), this);
+        if (it != pit->second.end())
+          pit->second.splice(pit->second.begin(), pit->second, it);
+      }
+      TAU_FSTOP(topology_pool_hit);
+    }
+    nuse++;
+  }
+
+  void topology::release(){
+    ASSERT(nuse > 0);
+    if (nuse > 0) nuse--;
   }
 
   void topology::deactivate(){
     if (is_activated){
-      for (int i=0; i<order; i++){
-        dim_comm[i].deactivate();
+      std::map< MPI_Comm, std::list<topology*> >::iterator pit = topo_pool.find(glb_comm.cm);
+      if (pit != topo_pool.end()){
+        pit->second.remove(this);
+        if (pit->second.empty()) topo_pool.erase(pit);
       }
-    } 
+      free_comms();
+    }
+    nuse = 0;
+  }
+
+  void topology::free_comms(){
+    for (int i=0; i<order; i++){
+      dim_comm[i].deactivate();
+    }
     is_activated = false;
   }
 
@@ -446,6 +515,20 @@ namespace CTF_int {
     return topos;
   }
 
+  /**
+   * \brief determines whether a product of leading topology dimensions equals the number of ranks per node
+   * \param[in] topo topology
+   * \return true if some set of leading dimensions is exactly intra-node
+   */
+  static bool is_node_aligned(topology const * topo){
+    int ppn = topo->glb_comm.ppn;
+    int stride = 1;
+    for (int i=0; i<topo->order && stride<ppn; i++){
+      stride *= topo->lens[i];
+    }
+    return stride == ppn;
+  }
+
   std::vector< topology* > get_generic_topovec(CommData cdt){
     std::vector<topology*> topovec;
 
@@ -481,7 +564,13 @@ namespace CTF_int {
       } else mults[i_uf]++;
     }
     cdealloc(factors);
-    return get_all_topos(cdt, n_uf, uniq_fact, mults, 0, NULL);
+    topovec = get_all_topos(cdt, n_uf, uniq_fact, mults, 0, NULL);
+    if (cdt.ppn > 1 && cdt.ppn < cdt.np){
+      //list topologies whose leading dimensions exactly tile a node first,
+      //so that ties in mapping cost are broken in favor of intra-node dimensions
+      std::stable_partition(topovec.begin(), topovec.end(), is_node_aligned);
+    }
+    return topovec;
   }
 
 
@@ -17,6 +17,7 @@ namespace CTF_int {
       int *      lens;
       int *      lda;
       bool       is_activated;
+      int        nuse;
       CommData * dim_comm;
       CommData   glb_comm;
 
@@ -41,13 +42,31 @@ namespace CTF_int {
                CommData    cdt,
                bool        activate=false);
      
-      /* \brief create (split off) MPI communicators, re-entrant */ 
+      /**
+       * \brief create (split off) MPI communicators, re-entrant; once released the
+       *        communicators stay in a pool shared by the topologies of glb_comm and are
+       *        reused by the next activation, the least recently used released topologies
+       *        are evicted from it to keep at most get_topo_pool_comms() communicators alive
+       */
       void activate();
 
-      /* \breif free MPI communicators, re-entrant */
+      /* \brief marks the end of an operation using the communicators, which stay alive */
+      void release();
+
+      /* \brief free MPI communicators, re-entrant */
       void deactivate();
+
+    private:
+      /* \brief frees the communicators of a topology already removed from the pool */
+      void free_comms();
   };
 
+  /** \brief sets the number of communicators the topologies of a global communicator may keep alive */
+  void set_topo_pool_comms(int ncomm);
+
+  /** \brief number of communicators the topologies of a global communicator may keep alive */
+  int get_topo_pool_comms();
+
   /**
    * \brief get dimension and torus lengths of specified topology
    *
@@ -3,6 +3,7 @@
 #include "dgtog_calc_cnt.h"
 #include "dgtog_redist.h"
 #include "../shared/util.h"
+#include "../shared/memcontrol.h"
 #include "dgtog_bucket.h"
 namespace CTF_int {
   //static double init_mdl[] = {COST_LATENCY, COST_LATENCY, COST_NETWBW};
@@ -64,8 +64,10 @@ void isendrecv<0>
 #else
     if (dir)
       MPI_Irecv(buffer+displs[bucket]*sr->el_size, counts[bucket], sr->mdtype(), pe, MTAG, cm, reqs+bucket);
-    else
+    else {
       MPI_Isend(buffer+displs[bucket]*sr->el_size, counts[bucket], sr->mdtype(), pe, MTAG, cm, reqs+bucket);
+      comm_bytes_add(counts[bucket]*sr->el_size);
+    }
 #endif
   }
 }
@@ -154,6 +156,7 @@ void put_buckets<0>(
 #else
     MPI_Put(buckets[rec_bucket_off], counts[rec_bucket_off], sr->mdtype(), rec_pe_off, put_displs[rec_bucket_off], counts[rec_bucket_off], sr->mdtype(), win);
 #endif
+    comm_bytes_add(counts[rec_bucket_off]*sr->el_size);
   }
 }
 #endif
@@ -286,6 +289,7 @@ void redist_bucket_isr<0>
       int bucket = bucket_off + bucket_offset[0][r];
       int pe = pe_off + pe_offset[0][r];
       MPI_Isend(buckets[bucket], counts[bucket], sr->mdtype(), pe, MTAG, cm, rep_reqs+bucket);
+      comm_bytes_add(counts[bucket]*sr->el_size);
     }
     //progressss please
     if (bucket_off > 0){
@@ -436,7 +440,7 @@ void dgtog_reshuffle(int const *          sym,
   CTF_int::cdealloc(all_put_displs);
 
   char * recv_buffer;
-  mst_alloc_ptr(new_dist.size*sr->el_size, (void**)&recv_buffer);
+  data_alloc_ptr(new_dist.size*sr->el_size, (void**)&recv_buffer);
 
   CTF_Win win;
   int suc = MPI_Win_create(recv_buffer, new_dist.size*sr->el_size, sr->el_size, MPI_INFO_NULL, ord_glb_comm.cm, &win);
@@ -452,7 +456,7 @@ void dgtog_reshuffle(int const *          sym,
     SWITCH_ORD_CALL(isendrecv, order-1, recv_pe_offset, recv_bucket_offset, new_rep_phase, recv_counts, recv_displs, recv_reqs, win, recv_buffer, sr, 0, 0, 1);
 #else
   char * recv_buffer;
-  mst_alloc_ptr(new_dist.size*sr->el_size, (void**)&recv_buffer);
+  data_alloc_ptr(new_dist.size*sr->el_size, (void**)&recv_buffer);
   if (new_idx_lyr == 0)
     SWITCH_ORD_CALL(isendrecv, order-1, recv_pe_offset, recv_bucket_offset, new_rep_phase, recv_counts, recv_displs, recv_reqs, ord_glb_comm.cm, recv_buffer, sr, 0, 0, 1);
 #endif
@@ -515,7 +519,7 @@ void dgtog_reshuffle(int const *          sym,
 #ifndef IREDIST
 #ifndef PUTREDIST
   char * recv_buffer;
-  mst_alloc_ptr(new_dist.size*sr->el_size, (void**)&recv_buffer);
+  data_alloc_ptr(new_dist.size*sr->el_size, (void**)&recv_buffer);
 
   /* Communicate data */
   TAU_FSTART(COMM_RESHUFFLE);
@@ -553,7 +557,7 @@ void dgtog_reshuffle(int const *          sym,
   CTF_int::cdealloc(send_counts);
 
   if (new_idx_lyr == 0){
-    char * aux_buf; alloc_ptr(sr->el_size*new_dist.size, (void**)&aux_buf);
+    char * aux_buf; data_alloc_ptr(sr->el_size*new_dist.size, (void**)&aux_buf);
     if (sr->addid() != NULL)
       sr->set(aux_buf, sr->addid(), new_dist.size);
 
@@ -2,6 +2,7 @@
 
 #include "redist.h"
 #include "../shared/util.h"
+#include "../shared/memcontrol.h"
 #include "sparse_rw.h"
 
 namespace CTF_int {
@@ -482,7 +483,7 @@ namespace CTF_int {
     double st_time = MPI_Wtime();
 #endif
 
-    mst_alloc_ptr(sr->el_size*new_dist.size, (void**)&tsr_cyclic_data);
+    data_alloc_ptr(sr->el_size*new_dist.size, (void**)&tsr_cyclic_data);
     alloc_ptr(sizeof(int)*order, (void**)&idx);
     alloc_ptr(sizeof(int)*order, (void**)&old_loc_lda);
     alloc_ptr(sizeof(int)*order, (void**)&new_loc_lda);
@@ -553,6 +554,7 @@ namespace CTF_int {
                 glb_comm.rank, loc_idx, loc_idx, blk_sz, prc_idx, sr->el_size, tsr_data, reqs+num_new_virt+loc_idx);
         MPI_Isend(tsr_data+sr->el_size*loc_idx*blk_sz, blk_sz,
                   sr->mdtype(), prc_idx, loc_idx, glb_comm.cm, reqs+num_new_virt+loc_idx);
+        comm_bytes_add(blk_sz*sr->el_size);
         for (i=0; i<order; i++){
           idx[i]++;
           if (idx[i] >= old_dist.virt_phase[i])
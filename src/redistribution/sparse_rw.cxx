@@ -7,6 +7,17 @@
 
 
 namespace CTF_int {
+  /** \brief bytes of pairs per message of pipelined sparse writes */
+  static int64_t sparse_pipeline_chunk_size = SPARSE_PIPELINE_CHUNK_SIZE;
+
+  void set_sparse_pipeline_chunk_size(int64_t bytes){
+    sparse_pipeline_chunk_size = bytes;
+  }
+
+  int64_t get_sparse_pipeline_chunk_size(){
+    return sparse_pipeline_chunk_size;
+  }
+
   void permute_keys(int              order,
                     int              num_pair,
                     int const *      edge_len,
@@ -424,6 +435,158 @@ namespace CTF_int {
   }
 
 
+  /**
+   * \brief gives the contiguous range of [0,n) processed by part t of ntd parts
+   * \param[in] n number of items
+   * \param[in] ntd number of parts
+   * \param[in] t part index
+   * \param[out] st first item of part
+   * \param[out] num number of items in part
+   */
+  static void get_part_range(int64_t n, int ntd, int t, int64_t & st, int64_t & num){
+    num = n/ntd;
+    st  = num*t + MIN(t, n%ntd);
+    if (t < n%ntd) num++;
+  }
+
+  /**
+   * \brief given per-part bucket counts, computes bucket counts/offsets and
+   *        the offset of each part within each bucket
+   * \param[in] nbkt number of buckets
+   * \param[in] ntd number of parts
+   * \param[in,out] sub_cnts ntd-by-nbkt counts on input, offsets of each part within bucket on output
+   * \param[out] bkt_counts total count of each bucket
+   * \param[out] bkt_off prefix sum of bkt_counts
+   */
+  static void calc_part_offsets(int64_t   nbkt,
+                                int       ntd,
+                                int64_t * sub_cnts,
+                                int64_t * bkt_counts,
+                                int64_t * bkt_off){
+  #ifdef USE_OMP
+    #pragma omp parallel for
+  #endif
+    for (int64_t b=0; b<nbkt; b++){
+      int64_t cnt = 0;
+      for (int t=0; t<ntd; t++){
+        int64_t c = sub_cnts[t*nbkt+b];
+        sub_cnts[t*nbkt+b] = cnt;
+        cnt += c;
+      }
+      bkt_counts[b] = cnt;
+    }
+    if (nbkt > 0) bkt_off[0] = 0;
+    for (int64_t b=1; b<nbkt; b++){
+      bkt_off[b] = bkt_off[b-1] + bkt_counts[b-1];
+    }
+  }
+
+  /**
+   * \brief moves pairs of parts [t_st,t_end) to their buckets, each part writing at its offsets,
+   *        so that pairs retain their relative order within a bucket
+   * \param[in] num_pair number of pairs
+   * \param[in] nbkt number of buckets
+   * \param[in] ntd number of parts
+   * \param[in] t_st first part whose pairs are moved
+   * \param[in] t_end last part (exclusive) whose pairs are moved
+   * \param[in] bkt_idx bucket index of each pair
+   * \param[in] bkt_off starting offset of each bucket
+   * \param[in,out] sub_offs ntd-by-nbkt offsets of each part within bucket, advanced by moved pairs
+   * \param[in] data pairs to move
+   * \param[in,out] bkt_data buffer in which buckets reside
+   */
+  static void scatter_by_bucket(int64_t           num_pair,
+                                int64_t           nbkt,
+                                int               ntd,
+                                int               t_st,
+                                int               t_end,
+                                int const *       bkt_idx,
+                                int64_t const *   bkt_off,
+                                int64_t *         sub_offs,
+                                ConstPairIterator data,
+                                PairIterator      bkt_data){
+  #ifdef USE_OMP
+    #pragma omp parallel
+  #endif
+    {
+  #ifdef USE_OMP
+      int tid = omp_get_thread_num();
+      int nt  = omp_get_num_threads();
+  #else
+      int tid = 0;
+      int nt  = 1;
+  #endif
+      for (int t=t_st+tid; t<t_end; t+=nt){
+        int64_t tst, tnum;
+        get_part_range(num_pair, ntd, t, tst, tnum);
+        int64_t * my_offs = sub_offs + t*nbkt;
+        for (int64_t i=tst; i<tst+tnum; i++){
+          int b = bkt_idx[i];
+          bkt_data[bkt_off[b] + my_offs[b]].write(data[i]);
+          my_offs[b]++;
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief computes destination processor of each pair and per-part counts of pairs destined to each processor
+   * \param[in] order number of tensor dims
+   * \param[in] num_pair numbers of values being written
+   * \param[in] np number of processor buckets
+   * \param[in] ntd number of parts in which to split pairs
+   * \param[in] phys_phase physical distribution phase
+   * \param[in] bucket_lda iterator hop along each bucket dim
+   * \param[in] edge_len padded edge lengths of tensor
+   * \param[in] mapped_data set of sparse key-value pairs
+   * \param[out] pe_idx destination processor of each pair
+   * \param[out] sub_counts ntd-by-np counts of pairs destined to each processor in each part
+   */
+  static void calc_pe_idx(int               order,
+                          int64_t           num_pair,
+                          int64_t           np,
+                          int               ntd,
+                          int const *       phys_phase,
+                          int const *       bucket_lda,
+                          int const *       edge_len,
+                          ConstPairIterator mapped_data,
+                          int *             pe_idx,
+                          int64_t *         sub_counts){
+    TAU_FSTART(bucket_by_pe_count);
+    memset(sub_counts, 0, np*ntd*sizeof(int64_t));
+  #ifdef USE_OMP
+    #pragma omp parallel
+  #endif
+    {
+  #ifdef USE_OMP
+      int tid = omp_get_thread_num();
+      int nt  = omp_get_num_threads();
+  #else
+      int tid = 0;
+      int nt  = 1;
+  #endif
+      for (int t=tid; t<ntd; t+=nt){
+        int64_t tst, tnum;
+        get_part_range(num_pair, ntd, t, tst, tnum);
+        int64_t * my_counts = sub_counts + t*np;
+        for (int64_t i=tst; i<tst+tnum; i++){
+          int64_t k = mapped_data[i].k();
+          int64_t loc = 0;
+          for (int j=0; j<order; j++){
+            //FIXME: fine for dense but need extra mod for sparse :(
+            //loc += (k%phys_phase[j])*bucket_lda[j];
+            loc += ((k%edge_len[j])%phys_phase[j])*bucket_lda[j];
+            k = k/edge_len[j];
+          }
+          ASSERT(loc<np);
+          pe_idx[i] = loc;
+          my_counts[loc]++;
+        }
+      }
+    }
+    TAU_FSTOP(bucket_by_pe_count);
+  }
+
   void bucket_by_pe(int               order,
                     int64_t           num_pair,
                     int64_t           np,
@@ -436,99 +599,135 @@ namespace CTF_int {
                     int64_t *         bucket_off,
                     PairIterator      bucket_data,
                     algstrct const *  sr){
-
-    memset(bucket_counts, 0, sizeof(int64_t)*np); 
   #ifdef USE_OMP
-    int64_t * sub_counts, * sub_offs;
-    CTF_int::alloc_ptr(np*sizeof(int64_t)*omp_get_max_threads(), (void**)&sub_counts);
-    CTF_int::alloc_ptr(np*sizeof(int64_t)*omp_get_max_threads(), (void**)&sub_offs);
-    memset(sub_counts, 0, np*sizeof(int64_t)*omp_get_max_threads());
+    int ntd = omp_get_max_threads();
+  #else
+    int ntd = 1;
   #endif
+    int * pe_idx;
+    int64_t * sub_offs;
+    CTF_int::alloc_ptr(num_pair*sizeof(int), (void**)&pe_idx);
+    CTF_int::alloc_ptr(np*sizeof(int64_t)*ntd, (void**)&sub_offs);
 
+    calc_pe_idx(order, num_pair, np, ntd, phys_phase, bucket_lda, edge_len, mapped_data, pe_idx, sub_offs);
+    calc_part_offsets(np, ntd, sub_offs, bucket_counts, bucket_off);
 
-    TAU_FSTART(bucket_by_pe_count);
-    /* Calculate counts */
-  #ifdef USE_OMP
-    #pragma omp parallel for schedule(static,256) 
-  #endif
-    for (int64_t i=0; i<num_pair; i++){
-      int64_t k = mapped_data[i].k();
-      int64_t loc = 0;
-  //    int tmp_arr[order];
-      for (int j=0; j<order; j++){
-  /*      tmp_arr[j] = (k%edge_len[j])%phase[j];
-        tmp_arr[j] = tmp_arr[j]/virt_phase[j];
-        tmp_arr[j] = tmp_arr[j]*bucket_lda[j];*/
-        //FIXME: fine for dense but need extra mod for sparse :(
-        //loc += (k%phys_phase[j])*bucket_lda[j];
-        loc += ((k%edge_len[j])%phys_phase[j])*bucket_lda[j];
-        k = k/edge_len[j];
-      }
-  /*    for (j=0; j<order; j++){
-        loc += tmp_arr[j];
-      }*/
-      ASSERT(loc<np);
-  #ifdef USE_OMP
-      sub_counts[loc+omp_get_thread_num()*np]++;
-  #else
-      bucket_counts[loc]++;
-  #endif
-    }
-    TAU_FSTOP(bucket_by_pe_count);
+    /* bucket data */
+    TAU_FSTART(bucket_by_pe_move);
+    scatter_by_bucket(num_pair, np, ntd, 0, ntd, pe_idx, bucket_off, sub_offs, mapped_data, bucket_data);
+    TAU_FSTOP(bucket_by_pe_move);
 
+    CTF_int::cdealloc(pe_idx);
+    CTF_int::cdealloc(sub_offs);
+  }
+
+  void bucket_by_pe_exchange(int               order,
+                             int64_t           num_pair,
+                             int64_t           np,
+                             int const *       phys_phase,
+                             int const *       virt_phase,
+                             int const *       bucket_lda,
+                             int const *       edge_len,
+                             ConstPairIterator mapped_data,
+                             int64_t *         bucket_counts,
+                             int64_t *         bucket_off,
+                             PairIterator      bucket_data,
+                             int64_t *         recv_counts,
+                             int64_t *         recv_displs,
+                             char *&           recv_data,
+                             CommData          glb_comm,
+                             algstrct const *  sr){
   #ifdef USE_OMP
-    for (int j=0; j<omp_get_max_threads(); j++){
-      for (int64_t i=0; i<np; i++){
-        bucket_counts[i] = sub_counts[j*np+i] + bucket_counts[i];
-      }
-    }
+    int ntd = omp_get_max_threads();
+  #else
+    int ntd = 1;
   #endif
+    int64_t pair_size = sr->pair_size();
+    // messages hold at most a chunk of pairs, which also keeps their count within an int
+    int64_t chunk_sz = std::max((int64_t)1, std::min((int64_t)INT_MAX, sparse_pipeline_chunk_size/pair_size));
+    // pairs are moved to their buckets in stripes of about a chunk, each split into ntd parts,
+    // with the per-part counts kept within the size of the pairs
+    int64_t nstripe = std::max((int64_t)1, std::min(num_pair/chunk_sz,
+                                                    num_pair*pair_size/(ntd*np*(int64_t)sizeof(int64_t))));
+    nstripe = std::min(nstripe, (int64_t)(INT_MAX/ntd));
+    int npart = nstripe*ntd;
+    int * pe_idx;
+    int64_t * sub_offs;
+    CTF_int::alloc_ptr(num_pair*sizeof(int), (void**)&pe_idx);
+    CTF_int::alloc_ptr(np*sizeof(int64_t)*npart, (void**)&sub_offs);
+
+    calc_pe_idx(order, num_pair, np, npart, phys_phase, bucket_lda, edge_len, mapped_data, pe_idx, sub_offs);
+    calc_part_offsets(np, npart, sub_offs, bucket_counts, bucket_off);
 
-    /* Prefix sum to get offsets */
-    bucket_off[0] = 0;
+    /* Exchange send counts */
+    MPI_Alltoall(bucket_counts, 1, MPI_INT64_T,
+                 recv_counts, 1, MPI_INT64_T, glb_comm.cm);
+    recv_displs[0] = 0;
     for (int64_t i=1; i<np; i++){
-      bucket_off[i] = bucket_counts[i-1] + bucket_off[i-1];
+      recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
     }
-    
-    /* reset counts */
-  #ifdef USE_OMP
-    memset(sub_offs, 0, sizeof(int64_t)*np);
-    for (int i=1; i<omp_get_max_threads(); i++){
-      for (int64_t j=0; j<np; j++){
-        sub_offs[j+i*np]=sub_counts[j+(i-1)*np]+sub_offs[j+(i-1)*np];
+    int64_t new_num_pair = recv_displs[np-1] + recv_counts[np-1];
+    CTF_int::alloc_ptr(pair_size*new_num_pair, (void**)&recv_data);
+
+    TAU_FSTART(bucket_by_pe_exchange);
+    MPI_Datatype mdt;
+    MPI_Type_contiguous(pair_size, MPI_CHAR, &mdt);
+    MPI_Type_commit(&mdt);
+    int64_t nmsg = 0;
+    for (int64_t p=0; p<np; p++){
+      if (p == glb_comm.rank) continue;
+      nmsg += (recv_counts[p]+chunk_sz-1)/chunk_sz + (bucket_counts[p]+chunk_sz-1)/chunk_sz;
+    }
+    MPI_Request * reqs = (MPI_Request*)CTF_int::alloc(std::max((int64_t)1,nmsg)*sizeof(MPI_Request));
+    int64_t nreq = 0;
+    /* the buckets of each sender arrive in chunks, in the order in which they are sent */
+    for (int64_t p=0; p<np; p++){
+      if (p == glb_comm.rank) continue;
+      for (int64_t off=0; off<recv_counts[p]; off+=chunk_sz){
+        MPI_Irecv(recv_data+(recv_displs[p]+off)*pair_size, (int)std::min(chunk_sz, recv_counts[p]-off),
+                  mdt, p, SPARSE_EXCHANGE_TAG, glb_comm.cm, reqs+nreq);
+        nreq++;
       }
     }
-  #else
-    memset(bucket_counts, 0, sizeof(int64_t)*np); 
-  #endif
 
-    /* bucket data */
-    TAU_FSTART(bucket_by_pe_move);
-  #ifdef USE_OMP
-    #pragma omp parallel for schedule(static,256) 
-  #endif
-    for (int64_t i=0; i<num_pair; i++){
-      int64_t k = mapped_data[i].k();
-      int64_t loc = 0;
-      for (int j=0; j<order; j++){
-        //FIXME: fine for dense but need extra mod for sparse :(
-        //loc += (k%phys_phase[j])*bucket_lda[j];
-        loc += ((k%edge_len[j])%phys_phase[j])*bucket_lda[j];
-        k = k/edge_len[j];
+    /* move pairs to their buckets one stripe at a time, sending each full chunk of a bucket as
+       soon as the stripes before it are moved, to destinations starting with the next rank so
+       that ranks do not all target the same destination first */
+    int64_t * sent;
+    CTF_int::alloc_ptr(np*sizeof(int64_t), (void**)&sent);
+    std::fill(sent, sent+np, 0);
+    for (int64_t s=0; s<nstripe; s++){
+      // the buckets are filled up to the offsets of the first part of the next stripe,
+      // which moving this stripe leaves unchanged
+      int64_t const * filled = s+1 < nstripe ? sub_offs+(s+1)*ntd*np : bucket_counts;
+      TAU_FSTART(bucket_by_pe_move);
+      scatter_by_bucket(num_pair, np, npart, s*ntd, (s+1)*ntd, pe_idx, bucket_off, sub_offs, mapped_data, bucket_data);
+      TAU_FSTOP(bucket_by_pe_move);
+      for (int64_t i=0; i<np-1; i++){
+        int64_t lp = (glb_comm.rank+1+i)%np;
+        // the last stripe also sends the remaining partial chunk
+        while (filled[lp]-sent[lp] >= chunk_sz || (s+1 == nstripe && filled[lp] > sent[lp])){
+          int64_t cnt = std::min(chunk_sz, filled[lp]-sent[lp]);
+          MPI_Isend(bucket_data[bucket_off[lp]+sent[lp]].ptr, (int)cnt,
+                    mdt, lp, SPARSE_EXCHANGE_TAG, glb_comm.cm, reqs+nreq);
+          comm_bytes_add(cnt*pair_size);
+          sent[lp] += cnt;
+          nreq++;
+        }
       }
-  #ifdef USE_OMP
-      bucket_data[bucket_off[loc] + sub_offs[loc+omp_get_thread_num()*np]].write(mapped_data[i]);
-      sub_offs[loc+omp_get_thread_num()*np]++;
-  #else
-      bucket_data[bucket_off[loc] + bucket_counts[loc]].write(mapped_data[i]);
-      bucket_counts[loc]++;
-  #endif
     }
-  #ifdef USE_OMP
-    CTF_int::cdealloc(sub_counts);
+    /* pairs staying on this process are copied rather than sent */
+    memcpy(recv_data+recv_displs[glb_comm.rank]*pair_size, bucket_data[bucket_off[glb_comm.rank]].ptr,
+           bucket_counts[glb_comm.rank]*pair_size);
+    ASSERT(nreq == nmsg);
+    MPI_Waitall(nreq, reqs, MPI_STATUSES_IGNORE);
+    MPI_Type_free(&mdt);
+    CTF_int::cdealloc(reqs);
+    CTF_int::cdealloc(sent);
+    TAU_FSTOP(bucket_by_pe_exchange);
+
+    CTF_int::cdealloc(pe_idx);
     CTF_int::cdealloc(sub_offs);
-  #endif
-    TAU_FSTOP(bucket_by_pe_move);
   }
   
   int64_t * bucket_by_virt(int               order,
@@ -540,13 +739,20 @@ namespace CTF_int {
                            ConstPairIterator mapped_data,
                            PairIterator      bucket_data,
                            algstrct const *  sr){
-    int64_t * virt_counts, * virt_prefix, * virt_lda;
+    int64_t * virt_counts, * virt_prefix, * virt_lda, * sub_offs;
+    int * virt_idx;
     TAU_FSTART(bucket_by_virt);
+  #ifdef USE_OMP
+    int ntd = omp_get_max_threads();
+  #else
+    int ntd = 1;
+  #endif
     
     CTF_int::alloc_ptr(num_virt*sizeof(int64_t), (void**)&virt_counts);
     CTF_int::alloc_ptr(num_virt*sizeof(int64_t), (void**)&virt_prefix);
     CTF_int::alloc_ptr(order*sizeof(int64_t),    (void**)&virt_lda);
-   
+    CTF_int::alloc_ptr(num_virt*sizeof(int64_t)*ntd, (void**)&sub_offs);
+    CTF_int::alloc_ptr(num_pair*sizeof(int),     (void**)&virt_idx);
    
     if (order > 0){
       virt_lda[0] = 1;
@@ -556,100 +762,49 @@ namespace CTF_int {
       }
     }
 
-    memset(virt_counts, 0, sizeof(int64_t)*num_virt); 
+    memset(sub_offs, 0, num_virt*sizeof(int64_t)*ntd);
+
+    /* count pairs in each block, remembering block of each pair */
+    TAU_FSTART(bucket_by_virt_omp_cnt);
   #ifdef USE_OMP
-    int64_t * sub_counts, * sub_offs;
-    CTF_int::alloc_ptr(num_virt*sizeof(int64_t)*omp_get_max_threads(), (void**)&sub_counts);
-    CTF_int::alloc_ptr(num_virt*sizeof(int64_t)*omp_get_max_threads(), (void**)&sub_offs);
-    memset(sub_counts, 0, num_virt*sizeof(int64_t)*omp_get_max_threads());
+    #pragma omp parallel
   #endif
-
-
-    /* bucket data */
+    {
   #ifdef USE_OMP
-    TAU_FSTART(bucket_by_virt_omp_cnt);
-    #pragma omp parallel for schedule(static) 
-    for (int64_t i=0; i<num_pair; i++){
-      int64_t k = mapped_data[i].k();
-      int64_t loc = 0;
-      //#pragma unroll
-      for (int j=0; j<order; j++){
-        //FIXME: fine for dense but need extra mod for sparse :(
-        //loc += ((k/phys_phase[j])%virt_phase[j])*virt_lda[j];
-        loc += (((k%edge_len[j])/phys_phase[j])%virt_phase[j])*virt_lda[j];
-        k = k/edge_len[j];
+      int tid = omp_get_thread_num();
+      int nt  = omp_get_num_threads();
+  #else
+      int tid = 0;
+      int nt  = 1;
+  #endif
+      for (int t=tid; t<ntd; t+=nt){
+        int64_t tst, tnum;
+        get_part_range(num_pair, ntd, t, tst, tnum);
+        int64_t * my_counts = sub_offs + t*num_virt;
+        for (int64_t i=tst; i<tst+tnum; i++){
+          int64_t k = mapped_data[i].k();
+          int64_t loc = 0;
+          //#pragma unroll
+          for (int j=0; j<order; j++){
+            //FIXME: fine for dense but need extra mod for sparse :(
+            //loc += ((k/phys_phase[j])%virt_phase[j])*virt_lda[j];
+            loc += (((k%edge_len[j])/phys_phase[j])%virt_phase[j])*virt_lda[j];
+            k = k/edge_len[j];
+          }
+          virt_idx[i] = loc;
+          my_counts[loc]++;
+        }
       }
-      
-      //bucket_data[loc*num_pair_virt + virt_counts[loc]] = mapped_data[i];
-      sub_counts[loc+omp_get_thread_num()*num_virt]++;
     }
     TAU_FSTOP(bucket_by_virt_omp_cnt);
     TAU_FSTART(bucket_by_virt_assemble_offsets);
-    for (int j=0; j<omp_get_max_threads(); j++){
-      for (int64_t i=0; i<num_virt; i++){
-        virt_counts[i] = sub_counts[j*num_virt+i] + virt_counts[i];
-      }
-    }
-    virt_prefix[0] = 0;
-    for (int64_t i=1; i<num_virt; i++){
-      virt_prefix[i] = virt_prefix[i-1] + virt_counts[i-1];
-    }
-
-    memset(sub_offs, 0, sizeof(int64_t)*num_virt);
-    for (int i=1; i<omp_get_max_threads(); i++){
-      for (int64_t j=0; j<num_virt; j++){
-        sub_offs[j+i*num_virt]=sub_counts[j+(i-1)*num_virt]+sub_offs[j+(i-1)*num_virt];
-      }
-    }
+    calc_part_offsets(num_virt, ntd, sub_offs, virt_counts, virt_prefix);
     TAU_FSTOP(bucket_by_virt_assemble_offsets);
+
+    /* bucket data */
     TAU_FSTART(bucket_by_virt_move);
-    #pragma omp parallel for schedule(static)
-    for (int64_t i=0; i<num_pair; i++){
-      int64_t k = mapped_data[i].k();
-      int64_t loc = 0;
-      //#pragma unroll
-      for (int j=0; j<order; j++){
-        //FIXME: fine for dense but need extra mod for sparse :(
-        //loc += ((k/phys_phase[j])%virt_phase[j])*virt_lda[j];
-        loc += (((k%edge_len[j])/phys_phase[j])%virt_phase[j])*virt_lda[j];
-        k = k/edge_len[j];
-      }
-      bucket_data[virt_prefix[loc] + sub_offs[loc+omp_get_thread_num()*num_virt]].write(mapped_data[i]);
-      sub_offs[loc+omp_get_thread_num()*num_virt]++;
-    }
+    scatter_by_bucket(num_pair, num_virt, ntd, 0, ntd, virt_idx, virt_prefix, sub_offs, mapped_data, bucket_data);
     TAU_FSTOP(bucket_by_virt_move);
-  #else
-    for (int64_t i=0; i<num_pair; i++){
-      int64_t k = mapped_data[i].k();
-      int64_t loc = 0;
-      for (int j=0; j<order; j++){
-        //FIXME: fine for dense but need extra mod for sparse :(
-        //loc += ((k/phys_phase[j])%virt_phase[j])*virt_lda[j];
-        loc += (((k%edge_len[j])/phys_phase[j])%virt_phase[j])*virt_lda[j];
-        k = k/edge_len[j];
-      }
-      virt_counts[loc]++;
-    }
-
-    virt_prefix[0] = 0;
-    for (int64_t i=1; i<num_virt; i++){
-      virt_prefix[i] = virt_prefix[i-1] + virt_counts[i-1];
-    }
-    memset(virt_counts, 0, sizeof(int64_t)*num_virt); 
-
-    for (int64_t i=0; i<num_pair; i++){
-      int64_t k = mapped_data[i].k();
-      int64_t loc = 0;
-      for (int j=0; j<order; j++){
-        //FIXME: fine for dense but need extra mod for sparse :(
-        //loc += ((k/phys_phase[j])%virt_phase[j])*virt_lda[j];
-        loc += (((k%edge_len[j])/phys_phase[j])%virt_phase[j])*virt_lda[j];
-        k = k/edge_len[j];
-      }
-      bucket_data[virt_prefix[loc] + virt_counts[loc]].write(mapped_data[i]);
-      virt_counts[loc]++;
-    }
-  #endif
 
     TAU_FSTART(bucket_by_virt_sort);
   #ifdef USE_OMP
@@ -667,10 +822,8 @@ namespace CTF_int {
       ASSERT(bucket_data[i].k != bucket_data[i-1].k);
     }*/
   #endif
-  #ifdef USE_OMP
-    CTF_int::cdealloc(sub_counts);
     CTF_int::cdealloc(sub_offs);
-  #endif
+    CTF_int::cdealloc(virt_idx);
     CTF_int::cdealloc(virt_prefix);
     CTF_int::cdealloc(virt_lda);
     TAU_FSTOP(bucket_by_virt);
@@ -864,6 +1017,45 @@ namespace CTF_int {
     CTF_int::cdealloc(edge_lda);
   }
 
+  /**
+   * \brief maps a key to the key of its representative element in packed symmetric layout
+   * \param[in] order tensor dimension
+   * \param[in] edge_len unpadded edge lengths of tensor
+   * \param[in] sym symmetry of tensor
+   * \param[in] key global key
+   * \param[out] ckey buffer of size order for the index of the key
+   * \param[out] skey key of representative element
+   * \return sign of representative relative to element (-1 only if antisymmetric), 0 if element is zero by symmetry
+   */
+  static int canonicalize_key(int          order,
+                              int const *  edge_len,
+                              int const *  sym,
+                              int64_t      key,
+                              int *        ckey,
+                              int64_t &    skey){
+    int sign = 1;
+    int is_perm = 1;
+    cvrt_idx(order, edge_len, key, ckey);
+    while (is_perm){
+      is_perm = 0;
+      for (int j=0; j<order-1; j++){
+        if ((sym[j] == SH || sym[j] == AS) && ckey[j] == ckey[j+1]){
+          return 0;
+        } else if (sym[j] != NS && ckey[j] > ckey[j+1]){
+          int swp   = ckey[j];
+          ckey[j]   = ckey[j+1];
+          ckey[j+1] = swp;
+          if (sym[j] == AS){
+            sign     *= -1;
+          }
+          is_perm = 1;
+        }
+      }
+    } 
+    cvrt_idx(order, edge_len, ckey, &skey);
+    return sign;
+  }
+
   void wr_pairs_layout(int              order,
                        int              np,
                        int64_t          inwrite,
@@ -888,12 +1080,11 @@ namespace CTF_int {
                        int64_t *        nnz_blk,
                        char *&          pprs_new,
                        int64_t &        nnz_loc_new){
-    int64_t new_num_pair, nwrite, swp;
+    int64_t new_num_pair, nwrite;
     int64_t * bucket_counts, * recv_counts;
     int64_t * recv_displs, * send_displs;
     int * depadding, * depad_edge_len;
-    int * ckey;
-    int j, is_out, sign, is_perm;
+    int j;
     char * swap_datab, * buf_datab;
     int64_t * old_nnz_blk;
     if (is_sparse){
@@ -934,50 +1125,51 @@ namespace CTF_int {
     for (int i=0; i<order; i++){
       depad_edge_len[i] = edge_len[i] - padding[i];
     } 
-    CTF_int::alloc_ptr(order*sizeof(int), (void**)&ckey);
     TAU_FSTART(check_key_ranges);
+  #ifdef USE_OMP
+    int ntd = omp_get_max_threads();
+  #else
+    int ntd = 1;
+  #endif
+    int64_t nwrite_part[ntd], nchanged_part[ntd];
 
     //calculate the number of keys that need to be vchanged first
-    int64_t nchanged = 0;
-    for (int64_t i=0; i<inwrite; i++){
-      cvrt_idx(order, depad_edge_len, wr_pairs[i].k(), ckey);
-      is_out = 0;
-      sign = 1;
-      is_perm = 1;
-      while (is_perm && !is_out){
-        is_perm = 0;
-        for (j=0; j<order-1; j++){
-          if ((sym[j] == SH || sym[j] == AS) && ckey[j] == ckey[j+1]){
-            is_out = 1;
-            break;
-          } else if (sym[j] != NS && ckey[j] > ckey[j+1]){
-            swp       = ckey[j];
-            ckey[j]   = ckey[j+1];
-            ckey[j+1] = swp;
-            if (sym[j] == AS){
-              sign     *= -1;
-            }
-            is_perm = 1;
-          }/* else if (sym[j] == AS && ckey[j] > ckey[j+1]){
-            swp       = ckey[j];
-            ckey[j]   = ckey[j+1];
-            ckey[j+1] = swp;
-            is_perm = 1;
-          } */
-        }
-      } 
-      if (!is_out){
-        int64_t skey;
-        cvrt_idx(order, depad_edge_len, ckey, &skey);
-        if (rw == 'r' && skey != wr_pairs[i].k()){
-          nchanged++;
+  #ifdef USE_OMP
+    #pragma omp parallel
+  #endif
+    {
+  #ifdef USE_OMP
+      int tid = omp_get_thread_num();
+      int nt  = omp_get_num_threads();
+  #else
+      int tid = 0;
+      int nt  = 1;
+  #endif
+      int ckey[order];
+      for (int t=tid; t<ntd; t+=nt){
+        int64_t tst, tnum;
+        get_part_range(inwrite, ntd, t, tst, tnum);
+        int64_t tnwrite = 0, tnchanged = 0;
+        for (int64_t i=tst; i<tst+tnum; i++){
+          int64_t skey;
+          int sign = canonicalize_key(order, depad_edge_len, sym, wr_pairs[i].k(), ckey, skey);
+          if (sign != 0) tnwrite++;
+          if (rw == 'r' && (sign == 0 || skey != wr_pairs[i].k())) tnchanged++;
         }
-      } else if (rw == 'r'){
-        nchanged++;
-      } 
+        nwrite_part[t]   = tnwrite;
+        nchanged_part[t] = tnchanged;
+      }
     }
-
+    int64_t nchanged = 0;
     nwrite = 0;
+    for (int t=0; t<ntd; t++){
+      int64_t nw = nwrite_part[t], nc = nchanged_part[t];
+      nwrite_part[t]   = nwrite;
+      nchanged_part[t] = nchanged;
+      nwrite   += nw;
+      nchanged += nc;
+    }
+
     int64_t * changed_key_indices;
     char * new_changed_pairs;
     int * changed_key_scale;
@@ -985,62 +1177,52 @@ namespace CTF_int {
     CTF_int::alloc_ptr(nchanged*sr->pair_size(),  (void**)&new_changed_pairs);
     CTF_int::alloc_ptr(nchanged*sizeof(int),     (void**)&changed_key_scale);
 
-    nchanged = 0;
-    for (int64_t i=0; i<inwrite; i++){
-      cvrt_idx(order, depad_edge_len, wr_pairs[i].k(), ckey);
-      is_out = 0;
-      sign = 1;
-      is_perm = 1;
-      while (is_perm && !is_out){
-        is_perm = 0;
-        for (j=0; j<order-1; j++){
-          if ((sym[j] == SH || sym[j] == AS) && ckey[j] == ckey[j+1]){
-            is_out = 1;
-            break;
-          } else if (sym[j] != NS && ckey[j] > ckey[j+1]){
-            swp       = ckey[j];
-            ckey[j]   = ckey[j+1];
-            ckey[j+1] = swp;
-            if (sym[j] == AS){
-              sign     *= -1;
+  #ifdef USE_OMP
+    #pragma omp parallel
+  #endif
+    {
+  #ifdef USE_OMP
+      int tid = omp_get_thread_num();
+      int nt  = omp_get_num_threads();
+  #else
+      int tid = 0;
+      int nt  = 1;
+  #endif
+      int ckey[order];
+      for (int t=tid; t<ntd; t+=nt){
+        int64_t tst, tnum;
+        get_part_range(inwrite, ntd, t, tst, tnum);
+        int64_t iw = nwrite_part[t], ic = nchanged_part[t];
+        for (int64_t i=tst; i<tst+tnum; i++){
+          int64_t skey;
+          int sign = canonicalize_key(order, depad_edge_len, sym, wr_pairs[i].k(), ckey, skey);
+          if (sign != 0){
+            swap_data[iw].write_key(skey);
+            if (sign == 1)
+              swap_data[iw].write_val(wr_pairs[i].d());
+            else {
+              char ainv[sr->el_size];
+              sr->addinv(wr_pairs[i].d(), ainv);
+              swap_data[iw].write_val(ainv);
             }
-            is_perm = 1;
-          }/* else if (sym[j] == AS && ckey[j] > ckey[j+1]){
-            swp       = ckey[j];
-            ckey[j]   = ckey[j+1];
-            ckey[j+1] = swp;
-            is_perm = 1;
-          } */
-        }
-      } 
-      if (!is_out){
-        int64_t ky = swap_data[nwrite].k();
-        cvrt_idx(order, depad_edge_len, ckey, &ky);
-        swap_data[nwrite].write_key(ky);
-        if (sign == 1)
-          swap_data[nwrite].write_val(wr_pairs[i].d());
-        else {
-          char ainv[sr->el_size];
-          sr->addinv(wr_pairs[i].d(), ainv);
-          swap_data[nwrite].write_val(ainv);
-        }
-        if (rw == 'r' && swap_data[nwrite].k() != wr_pairs[i].k()){
-          /*printf("the %lldth key has been set from %lld to %lld\n",
-                   i, wr_pairs[i].k, swap_data[nwrite].k);*/
-          changed_key_indices[nchanged]= i;
-          swap_data[nwrite].read(new_changed_pairs+nchanged*sr->pair_size());
-          changed_key_scale[nchanged] = sign;
-          nchanged++;
+            if (rw == 'r' && skey != wr_pairs[i].k()){
+              /*printf("the %lldth key has been set from %lld to %lld\n",
+                       i, wr_pairs[i].k, swap_data[nwrite].k);*/
+              changed_key_indices[ic]= i;
+              swap_data[iw].read(new_changed_pairs+ic*sr->pair_size());
+              changed_key_scale[ic] = sign;
+              ic++;
+            }
+            iw++;
+          } else if (rw == 'r'){
+            changed_key_indices[ic] = i;
+            wr_pairs[i].read(new_changed_pairs+ic*sr->pair_size());
+            changed_key_scale[ic] = 0;
+            ic++;
+          } 
         }
-        nwrite++;
-      } else if (rw == 'r'){
-        changed_key_indices[nchanged] = i;
-        wr_pairs[i].read(new_changed_pairs+nchanged*sr->pair_size());
-        changed_key_scale[nchanged] = 0;
-        nchanged++;
-      } 
+      }
     }
-    CTF_int::cdealloc(ckey);
     TAU_FSTOP(check_key_ranges);
 
     /* If the packed tensor is padded, pad keys */
@@ -1051,22 +1233,41 @@ namespace CTF_int {
       wlen = edge_len;
     } else wlen = depad_edge_len; 
 
-    /* Figure out which processor the value in a packed layout, lies for each key */
-    bucket_by_pe(order, nwrite, np,
-                 phys_phase, virt_phase, bucket_lda,
-                 wlen, swap_data, bucket_counts,
-                 send_displs, buf_data, sr);
-
-    /* Exchange send counts */
-    MPI_Alltoall(bucket_counts, 1, MPI_INT64_T,
-                 recv_counts, 1, MPI_INT64_T, glb_comm.cm);
-
-    /* calculate offsets */
-    recv_displs[0] = 0;
-    for (int i=1; i<np; i++){
-      recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
+    /* Exchange pairs point-to-point if some process has multiple chunks' worth of pairs to send */
+    int64_t max_nwrite;
+    MPI_Allreduce(&nwrite, &max_nwrite, 1, MPI_INT64_T, MPI_MAX, glb_comm.cm);
+    bool is_pipelined = np > 1 && max_nwrite*sr->pair_size() >= 2*sparse_pipeline_chunk_size;
+
+    if (is_pipelined){
+      /* Bucket pairs by processor, sending full chunks of buckets while later pairs are bucketed */
+      char * recv_datab;
+      bucket_by_pe_exchange(order, nwrite, np,
+                            phys_phase, virt_phase, bucket_lda,
+                            wlen, swap_data, bucket_counts,
+                            send_displs, buf_data, recv_counts,
+                            recv_displs, recv_datab, glb_comm, sr);
+      new_num_pair = recv_displs[np-1] + recv_counts[np-1];
+      CTF_int::cdealloc(swap_datab);
+      swap_datab = recv_datab;
+      swap_data = PairIterator(sr, swap_datab);
+    } else {
+      /* Figure out which processor the value in a packed layout, lies for each key */
+      bucket_by_pe(order, nwrite, np,
+                   phys_phase, virt_phase, bucket_lda,
+                   wlen, swap_data, bucket_counts,
+                   send_displs, buf_data, sr);
+
+      /* Exchange send counts */
+      MPI_Alltoall(bucket_counts, 1, MPI_INT64_T,
+                   recv_counts, 1, MPI_INT64_T, glb_comm.cm);
+
+      /* calculate offsets */
+      recv_displs[0] = 0;
+      for (int i=1; i<np; i++){
+        recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
+      }
+      new_num_pair = recv_displs[np-1] + recv_counts[np-1];
     }
-    new_num_pair = recv_displs[np-1] + recv_counts[np-1];
 
     /*for (i=0; i<np; i++){
       bucket_counts[i] = bucket_counts[i]*sizeof(tkv_pair<dtype>);
@@ -1079,16 +1280,18 @@ namespace CTF_int {
     MPI_Allreduce(&new_num_pair, &max_np, 1, MPI_INT64_T, MPI_MAX, glb_comm.cm);
     if (glb_comm.rank == 0) printf("max received elements is %ld, mine are %ld\n", max_np, new_num_pair);*/
 
-    if (new_num_pair > nwrite){
-      CTF_int::cdealloc(swap_datab);
-      CTF_int::alloc_ptr(sr->pair_size()*new_num_pair, (void**)&swap_datab);
-      swap_data = PairIterator(sr, swap_datab);
+    if (!is_pipelined){
+      if (new_num_pair > nwrite){
+        CTF_int::cdealloc(swap_datab);
+        CTF_int::alloc_ptr(sr->pair_size()*new_num_pair, (void**)&swap_datab);
+        swap_data = PairIterator(sr, swap_datab);
+      }
+      /* Exchange data according to counts/offsets */
+      //ALL_TO_ALLV(buf_data, bucket_counts, send_displs, MPI_CHAR,
+      //            swap_data, recv_counts, recv_displs, MPI_CHAR, glb_comm);
+      glb_comm.all_to_allv(buf_data.ptr, bucket_counts, send_displs, sr->pair_size(),
+                      swap_data.ptr, recv_counts, recv_displs);
     }
-    /* Exchange data according to counts/offsets */
-    //ALL_TO_ALLV(buf_data, bucket_counts, send_displs, MPI_CHAR,
-    //            swap_data, recv_counts, recv_displs, MPI_CHAR, glb_comm);
-    glb_comm.all_to_allv(buf_data.ptr, bucket_counts, send_displs, sr->pair_size(),
-                    swap_data.ptr, recv_counts, recv_displs);
     
 
 
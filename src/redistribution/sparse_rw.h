@@ -8,6 +8,12 @@
 
 namespace CTF_int {
 
+  /** \brief sets the bytes of pairs per message of pipelined sparse writes */
+  void set_sparse_pipeline_chunk_size(int64_t bytes);
+
+  /** \brief bytes of pairs per message of pipelined sparse writes */
+  int64_t get_sparse_pipeline_chunk_size();
+
   /**
    * \brief permutes keys
    * \param[in] order tensor dimension
@@ -136,6 +142,45 @@ namespace CTF_int {
                     PairIterator      bucket_data,
                     algstrct const *  sr);
 
+  /**
+   * \brief buckets key-value pairs by processor according to distribution and sends them
+   *        to their destinations, with receives posted before the pairs are bucketed and each
+   *        chunk of get_sparse_pipeline_chunk_size() bytes of a bucket sent as soon as it is filled,
+   *        while later stripes of pairs are still being bucketed
+   * \param[in] order number of tensor dims
+   * \param[in] num_pair numbers of values being written
+   * \param[in] np number of processor buckets
+   * \param[in] phys_phase physical distribution phase
+   * \param[in] virt_phase factor of phase due to local blocking
+   * \param[in] bucket_lda iterator hop along each bucket dim
+   * \param[in] edge_len padded edge lengths of tensor
+   * \param[in] mapped_data set of sparse key-value pairs
+   * \param[out] bucket_counts how many keys belong to each processor
+   * \param[out] bucket_off prefix sum of bucket_counts
+   * \param[out] bucket_data mapped_data reordered by bucket
+   * \param[out] recv_counts how many keys are received from each processor
+   * \param[out] recv_displs prefix sum of recv_counts
+   * \param[out] recv_data newly allocated buffer of received pairs
+   * \param[in] glb_comm communicator over which to exchange pairs
+   * \param[in] sr algstrct context defining values
+   */
+  void bucket_by_pe_exchange(int               order,
+                             int64_t           num_pair,
+                             int64_t           np,
+                             int const *       phys_phase,
+                             int const *       virt_phase,
+                             int const *       bucket_lda,
+                             int const *       edge_len,
+                             ConstPairIterator mapped_data,
+                             int64_t *         bucket_counts,
+                             int64_t *         bucket_off,
+                             PairIterator      bucket_data,
+                             int64_t *         recv_counts,
+                             int64_t *         recv_displs,
+                             char *&           recv_data,
+                             CommData          glb_comm,
+                             algstrct const *  sr);
+
   /**
    * \brief buckets key value pairs by block/virtual-processor
    * \param[in] order number of tensor dims
@@ -79,6 +79,7 @@ namespace CTF_int {
     if (tsr->has_zero_edge_len){
       return SUCCESS;
     }
+    tsr->data_modified();
     TAU_FSTART(scaling);
 
   #if DEBUG>=2
@@ -148,7 +149,7 @@ namespace CTF_int {
           ntsr->set_padding();
           memuse = ntsr->size;
 
-          if (memuse >= proc_bytes_available()){
+          if (memuse >= proc_bytes_available(memuse*ntsr->sr->el_size)){
             DPRINTF(1,"Not enough memory to scale tensor on topo %d\n", itopo);
             continue;
           }
@@ -112,9 +112,9 @@ namespace CTF_int {
                        endomorphism const * func){
     TAU_FSTART(sym_seq_sum_cust)
     int idx, i, idx_max, imin, imax, iA, j, k;
-    int off_idx, sym_pass;
+    int off_idx, sym_pass, inr_stride;
     int * idx_glb, * rev_idx_map;
-    int * dlen_A;
+    int * dlen_A, * inr_len_A;
     int64_t idx_A, off_lda;
 
     inv_idx(order_A,       idx_map_A,
@@ -126,15 +126,34 @@ namespace CTF_int {
     idx_glb = (int*)CTF_int::alloc(sizeof(int)*idx_max);
     memset(idx_glb, 0, sizeof(int)*idx_max);
 
+    // a nonsymmetric leading index that appears once is contiguous, apply f to whole rows
+    inr_stride = 1;
+    inr_len_A = NULL;
+    if (order_A > 0 && sym_A[0] == NS && edge_len_A[0] > 1){
+      inr_stride = edge_len_A[0];
+      for (i=1; i<order_A; i++){
+        if (idx_map_A[i] == idx_map_A[0]) inr_stride = 1;
+      }
+    }
+    if (inr_stride > 1){
+      inr_len_A = (int*)CTF_int::alloc(sizeof(int)*order_A);
+      memcpy(inr_len_A, edge_len_A, sizeof(int)*order_A);
+      inr_len_A[0] = 1;
+      edge_len_A = inr_len_A;
+      dlen_A[0] = 1;
+    }
 
     idx_A = 0;
     sym_pass = 1;
     for (;;){
       if (sym_pass){
-        if (alpha != NULL)
-          sr_A->mul(A+idx_A*sr_A->el_size, alpha, A+idx_A*sr_A->el_size);
-        func->apply_f(A+idx_A*sr_A->el_size);
-        CTF_FLOPS_ADD(1);
+        if (alpha != NULL){
+          for (i=0; i<inr_stride; i++){
+            sr_A->mul(A+(idx_A*inr_stride+i)*sr_A->el_size, alpha, A+(idx_A*inr_stride+i)*sr_A->el_size);
+          }
+        }
+        func->apply_f_n(inr_stride, A+idx_A*inr_stride*sr_A->el_size, sr_A);
+        CTF_FLOPS_ADD(inr_stride);
       }
 
       for (idx=0; idx<idx_max; idx++){
@@ -161,6 +180,7 @@ namespace CTF_int {
       if (order_A > 0)
         RESET_IDX(A);
     }
+    if (inr_len_A != NULL) CTF_int::cdealloc(inr_len_A);
     CTF_int::cdealloc(dlen_A);
     CTF_int::cdealloc(idx_glb);
     CTF_int::cdealloc(rev_idx_map);
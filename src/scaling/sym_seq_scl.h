@@ -18,6 +18,18 @@ namespace CTF_int {
        */
       virtual void apply_f(char * a) const { assert(0); }
 
+      /**
+       * \brief apply function f to n consecutive values starting at a
+       * \param[in] n number of values
+       * \param[in,out] a pointer to first operand, overwritten by results
+       * \param[in] sr_A algebraic structure of operands, defining their size
+       */
+      virtual void apply_f_n(int64_t n, char * a, algstrct const * sr_A) const {
+        for (int64_t i=0; i<n; i++){
+          apply_f(a+i*sr_A->el_size);
+        }
+      }
+
       /** 
        * \brief apply f to A
        * \param[in] A operand tensor with pre-defined indices 
@@ -0,0 +1,190 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include "fft.h"
+
+namespace CTF_int {
+
+  /**
+   * \brief exp(sign*2 pi i t/d) computed in double precision
+   */
+  template <typename real>
+  static std::complex<real> unit_root(int sign, int64_t t, int64_t d){
+    double ang = sign*2.*M_PI*(double)(t%d)/(double)d;
+    return std::complex<real>((real)cos(ang), (real)sin(ang));
+  }
+
+  template <typename real>
+  fft_plan<real>::fft_plan(int n_, bool inverse_){
+    n       = n_;
+    inverse = inverse_;
+    m       = 0;
+    conv    = NULL;
+    int sign = inverse ? 1 : -1;
+    std::vector<int> factors;
+    int rem = n;
+    while (rem % 4 == 0){ factors.push_back(4); rem /= 4; }
+    while (rem % 2 == 0){ factors.push_back(2); rem /= 2; }
+    for (int p=3; p<=rem; p+=2){
+      while (rem % p == 0){ factors.push_back(p); rem /= p; }
+    }
+    if (factors.size() > 0 && factors.back() > FFT_MAX_RADIX){
+      // the product of x_j b_j with the conjugate chirp, as a cyclic convolution of length m,
+      // gives X_k/b_k, since jk = (j^2+k^2-(k-j)^2)/2
+      m = 1;
+      while (m < 2*n-1) m *= 2;
+      conv = new fft_plan<real>(m, false);
+      chirp.resize(n);
+      for (int64_t j=0; j<n; j++){
+        // j^2 is reduced modulo 2n, so that the angle is exact for large j
+        chirp[j] = unit_root<real>(sign, (j*j)%(2*n), 2*n);
+      }
+      chirp_ft.assign(m, cplx(0));
+      for (int64_t j=0; j<n; j++){
+        chirp_ft[j] = std::conj(chirp[j])/(real)m;
+        if (j > 0) chirp_ft[m-j] = chirp_ft[j];
+      }
+      std::vector<cplx> work(conv->work_size());
+      conv->transform(&chirp_ft[0], &work[0]);
+      return;
+    }
+    radices = factors;
+    int64_t ns = 1;
+    for (int s=0; s<(int)radices.size(); s++){
+      int r = radices[s];
+      for (int64_t k=0; k<ns; k++){
+        for (int q=0; q<r; q++){
+          twiddles.push_back(unit_root<real>(sign, k*q, ns*r));
+        }
+      }
+      if (r != 2 && r != 4){
+        for (int t=0; t<r; t++){
+          roots.push_back(unit_root<real>(sign, t, r));
+        }
+      }
+      ns *= r;
+    }
+  }
+
+  template <typename real>
+  fft_plan<real>::~fft_plan(){
+    if (conv != NULL) delete conv;
+  }
+
+  template <typename real>
+  int64_t fft_plan<real>::work_size() const {
+    if (m > 0) return (int64_t)m+conv->work_size();
+    return n;
+  }
+
+  template <typename real>
+  void fft_plan<real>::transform(cplx * x, cplx * work) const {
+    if (m > 0){
+      cplx * a = work;
+      for (int j=0; j<n; j++){
+        a[j] = x[j]*chirp[j];
+      }
+      std::fill(a+n, a+m, cplx(0));
+      conv->transform(a, work+m);
+      for (int j=0; j<m; j++){
+        // the inverse transform of a is the conjugate of the transform of its conjugate
+        a[j] = std::conj(a[j]*chirp_ft[j]);
+      }
+      conv->transform(a, work+m);
+      for (int j=0; j<n; j++){
+        x[j] = std::conj(a[j])*chirp[j];
+      }
+      return;
+    }
+    cplx * in = x;
+    cplx * out = work;
+    cplx const * tw = twiddles.data();
+    cplx const * rt = roots.data();
+    bool is_fwd = !inverse;
+    int64_t ns = 1;
+    for (int s=0; s<(int)radices.size(); s++){
+      int r = radices[s];
+      int64_t nr = n/r;
+      // Stockham stage: the r elements j+q*nr, twiddled by k=j%ns, are combined by a DFT of
+      // length r into the elements (j/ns)*ns*r+k+q*ns
+      for (int64_t jo=0; jo<nr; jo+=ns){
+        cplx * o = out+jo*r;
+        for (int64_t k=0; k<ns; k++){
+          int64_t j = jo+k;
+          cplx const * w = tw+k*r;
+          if (r == 2){
+            cplx v0 = in[j], v1 = in[j+nr]*w[1];
+            o[k]    = v0+v1;
+            o[k+ns] = v0-v1;
+          } else if (r == 4){
+            cplx v0 = in[j], v1 = in[j+nr]*w[1], v2 = in[j+2*nr]*w[2], v3 = in[j+3*nr]*w[3];
+            cplx t0 = v0+v2, t1 = v0-v2, t2 = v1+v3, t3 = v1-v3;
+            // multiplication of t3 by -i for the forward and by i for the inverse transform
+            t3 = is_fwd ? cplx(t3.imag(), -t3.real()) : cplx(-t3.imag(), t3.real());
+            o[k]      = t0+t2;
+            o[k+ns]   = t1+t3;
+            o[k+2*ns] = t0-t2;
+            o[k+3*ns] = t1-t3;
+          } else {
+            cplx v[FFT_MAX_RADIX];
+            for (int q=0; q<r; q++){
+              v[q] = in[j+q*nr]*w[q];
+            }
+            for (int p=0; p<r; p++){
+              cplx acc = v[0];
+              int t = 0;
+              for (int q=1; q<r; q++){
+                t += p;
+                if (t >= r) t -= r;
+                acc += v[q]*rt[t];
+              }
+              o[k+p*ns] = acc;
+            }
+          }
+        }
+      }
+      tw += ns*r;
+      if (r != 2 && r != 4) rt += r;
+      ns *= r;
+      std::swap(in, out);
+    }
+    if (in != x) memcpy(x, in, sizeof(cplx)*n);
+  }
+
+  template <typename real>
+  void fft_plan<real>::execute(int64_t nfib, int64_t ld, cplx * data) const {
+    if (n <= 1) return;
+    real sc = inverse ? (real)1./n : (real)1.;
+    if (nfib == 1 && ld == 1){
+      std::vector<cplx> work(work_size());
+      transform(data, &work[0]);
+      if (inverse){
+        for (int j=0; j<n; j++){
+          data[j] *= sc;
+        }
+      }
+      return;
+    }
+    // the interleaved sequences are gathered into contiguous ones, reading rows of nfib elements
+    std::vector<cplx> buf(nfib*n+work_size());
+    cplx * work = &buf[nfib*n];
+    for (int64_t j=0; j<n; j++){
+      for (int64_t i=0; i<nfib; i++){
+        buf[i*n+j] = data[i+j*ld];
+      }
+    }
+    for (int64_t i=0; i<nfib; i++){
+      transform(&buf[i*n], work);
+    }
+    for (int64_t j=0; j<n; j++){
+      for (int64_t i=0; i<nfib; i++){
+        data[i+j*ld] = buf[i*n+j]*sc;
+      }
+    }
+  }
+
+  template class fft_plan<float>;
+  template class fft_plan<double>;
+}
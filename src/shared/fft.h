@@ -0,0 +1,82 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#ifndef __FFT_H__
+#define __FFT_H__
+
+#include <stdint.h>
+#include <complex>
+#include <vector>
+
+#ifndef FFT_MAX_RADIX
+/** \brief largest prime factor of a transform length done by a direct DFT stage, longer lengths with larger ones use Bluestein's algorithm */
+#define FFT_MAX_RADIX 64
+#endif
+
+namespace CTF_int {
+  /**
+   * \brief precomputed fast Fourier transform of a fixed length n, X_k = sum_j x_j exp(-+2 pi i jk/n),
+   *        by a Stockham autosort FFT with radix 4, 2 and prime radix stages of at most
+   *        FFT_MAX_RADIX, and otherwise by Bluestein's algorithm on a power of two length,
+   *        so O(n log n) work for any n
+   */
+  template <typename real>
+  class fft_plan {
+    private:
+      typedef std::complex<real> cplx;
+
+      /** \brief radix of each stage */
+      std::vector<int> radices;
+
+      /** \brief twiddle factors of each stage, ns*r for a stage of radix r after ns = product of previous radices */
+      std::vector<cplx> twiddles;
+
+      /** \brief roots of unity exp(-+2 pi i t/r) of each stage of odd radix r */
+      std::vector<cplx> roots;
+
+      /** \brief power of two length of the cyclic convolution of Bluestein's algorithm, 0 if not used */
+      int m;
+
+      /** \brief forward transform of length m used by Bluestein's algorithm */
+      fft_plan * conv;
+
+      /** \brief chirp exp(-+pi i j^2/n) and the scaled transform of its conjugate padded to m */
+      std::vector<cplx> chirp, chirp_ft;
+
+      /**
+       * \brief unscaled transform of one contiguous sequence in place
+       * \param[in,out] x sequence of length n
+       * \param[in] work buffer of work_size() elements
+       */
+      void transform(cplx * x, cplx * work) const;
+
+    public:
+      /** \brief transform length */
+      int n;
+
+      /** \brief whether this is the inverse transform, which is scaled by 1/n */
+      bool inverse;
+
+      /**
+       * \brief precomputes the factorization and twiddle factors
+       * \param[in] n transform length
+       * \param[in] inverse if true use exp(+2 pi i jk/n) and scale by 1/n
+       */
+      fft_plan(int n, bool inverse);
+
+      ~fft_plan();
+
+      /** \brief number of elements of the buffer needed by transform() */
+      int64_t work_size() const;
+
+      /**
+       * \brief transforms nfib sequences in place, element j of sequence i being data[i+j*ld],
+       *        safe to call from several threads at once
+       * \param[in] nfib number of sequences
+       * \param[in] ld distance between consecutive elements of a sequence, at least nfib
+       * \param[in,out] data sequences
+       */
+      void execute(int64_t nfib, int64_t ld, cplx * data) const;
+  };
+}
+
+#endif
@@ -15,6 +15,7 @@ double seq_tsr_spctr_k1_init[] = {5.3745E-06, 3.6464E-08, 2.2334E-10};
 double seq_tsr_spctr_k2_init[] = {3.0917E-08, 5.2181E-11, 4.1634E-12};
 double seq_tsr_spctr_k3_init[] = {7.2456E-08, 1.5128E-10, -1.5528E-12};
 double seq_tsr_spctr_k4_init[] = {1.6880E-07, 4.9411E-10, 9.2847E-13};
+double seq_tsr_spctr_k5_init[] = {9.4950E-13, 4.7874E-11, 4.5384E-12};
 double pin_keys_mdl_init[] = {3.1189E-09, 6.6717E-08};
 double seq_tsr_ctr_mdl_cst_init[] = {5.1626E-06, -6.3215E-11, 3.9638E-09};
 double seq_tsr_ctr_mdl_ref_init[] = {4.9138E-08, 5.8290E-10, 4.8575E-11};
@@ -31,6 +32,8 @@ double alltoall_mdl_init[] = {1.0000E-06, 1.0000E-06, 5.0000E-10};
 double alltoallv_mdl_init[] = {2.7437E-06, 2.2416E-05, 1.0469E-08};
 double red_mdl_init[] = {6.2935E-07, 4.6276E-06, 9.2245E-10};
 double red_mdl_cst_init[] = {5.7302E-07, 4.7347E-06, 6.0191E-10};
+double redscat_mdl_init[] = {1.2587E-06, 9.2552E-06, 9.2245E-10};
+double redscat_mdl_cst_init[] = {1.1460E-06, 9.4694E-06, 6.0191E-10};
 double allred_mdl_init[] = {8.4416E-07, 6.8651E-06, 3.5845E-08};
 double allred_mdl_cst_init[] = {-3.3754E-04, 2.1343E-04, 3.0801E-09};
 double bcast_mdl_init[] = {1.5045E-06, 1.4485E-05, 3.2876E-09};
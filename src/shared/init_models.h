@@ -8,6 +8,8 @@ namespace CTF_int{
   extern double alltoallv_mdl_init[];
   extern double red_mdl_init[];
   extern double red_mdl_cst_init[];
+  extern double redscat_mdl_init[];
+  extern double redscat_mdl_cst_init[];
   extern double csrred_mdl_init[];
   extern double csrred_mdl_cst_init[];
   extern double allred_mdl_init[];
@@ -41,6 +43,7 @@ namespace CTF_int{
   extern double seq_tsr_spctr_k2_init[];
   extern double seq_tsr_spctr_k3_init[];
   extern double seq_tsr_spctr_k4_init[];
+  extern double seq_tsr_spctr_k5_init[];
 }
 
 #endif
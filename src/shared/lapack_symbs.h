@@ -1,29 +1,105 @@
 #ifndef __LAPACK_SYMBS__
 #define __LAPACK_SYMBS__
 
+#include <stdio.h>
+
 #if FTN_UNDERSCORE
 #define DGELSD dgelsd_
+#define SGEQRF sgeqrf_
 #define DGEQRF dgeqrf_
+#define SORMQR sormqr_
 #define DORMQR dormqr_
+#define SGESVD sgesvd_
+#define DGESVD dgesvd_
 #else
 #define DGELSD dgelsd
+#define SGEQRF sgeqrf
 #define DGEQRF dgeqrf
+#define SORMQR sormqr
 #define DORMQR dormqr
+#define SGESVD sgesvd
+#define DGESVD dgesvd
 #endif
 
-#ifdef TUNE
 namespace CTF_LAPACK{
+#ifdef TUNE
   extern "C"
   void DGELSD(int * m, int * n, int * k, double const * A, int * lda_A, double * B, int * lda_B, double * S, int * cond, int * rank, double * work, int * lwork, int * iwork, int * info);
+#endif
 
-
+#if defined(TUNE) || defined(USE_LAPACK)
   extern "C"
   void DGEQRF(int const *  M, int const *  N, double * A, int const *  LDA, double * TAU2, double * WORK, int const *  LWORK, int  * INFO);
 
-
   extern "C"
   void DORMQR(char const * SIDE, char const * TRANS, int const *  M, int const *  N, int const *  K, double const * A, int const *  LDA, double const * TAU2, double * C, int const *  LDC, double * WORK, int const *  LWORK, int  * INFO);
-}
 #endif
 
+#ifdef USE_LAPACK
+  extern "C"
+  void SGEQRF(int const *  M, int const *  N, float * A, int const *  LDA, float * TAU2, float * WORK, int const *  LWORK, int  * INFO);
+
+  extern "C"
+  void SORMQR(char const * SIDE, char const * TRANS, int const *  M, int const *  N, int const *  K, float const * A, int const *  LDA, float const * TAU2, float * C, int const *  LDC, float * WORK, int const *  LWORK, int  * INFO);
+
+  extern "C"
+  void SGESVD(char const * JOBU, char const * JOBVT, int const * M, int const * N, float * A, int const * LDA, float * S, float * U, int const * LDU, float * VT, int const * LDVT, float * WORK, int const * LWORK, int * INFO);
+
+  extern "C"
+  void DGESVD(char const * JOBU, char const * JOBVT, int const * M, int const * N, double * A, int const * LDA, double * S, double * U, int const * LDU, double * VT, int const * LDVT, double * WORK, int const * LWORK, int * INFO);
+
+  /**
+   * \brief typed wrappers for the LAPACK routines used by Matrix factorizations,
+   *        only float and double are supported, other types trigger an error
+   */
+  template <typename dtype>
+  void cxgeqrf(int m, int n, dtype * A, int lda, dtype * tau, dtype * work, int lwork, int * info){
+    printf("CTF ERROR: QR factorization is only available for float and double\n");
+    *info = -1;
+  }
+
+  template <>
+  inline void cxgeqrf<float>(int m, int n, float * A, int lda, float * tau, float * work, int lwork, int * info){
+    SGEQRF(&m, &n, A, &lda, tau, work, &lwork, info);
+  }
+
+  template <>
+  inline void cxgeqrf<double>(int m, int n, double * A, int lda, double * tau, double * work, int lwork, int * info){
+    DGEQRF(&m, &n, A, &lda, tau, work, &lwork, info);
+  }
+
+  template <typename dtype>
+  void cxormqr(char side, char trans, int m, int n, int k, dtype const * A, int lda, dtype const * tau, dtype * C, int ldc, dtype * work, int lwork, int * info){
+    printf("CTF ERROR: QR factorization is only available for float and double\n");
+    *info = -1;
+  }
+
+  template <>
+  inline void cxormqr<float>(char side, char trans, int m, int n, int k, float const * A, int lda, float const * tau, float * C, int ldc, float * work, int lwork, int * info){
+    SORMQR(&side, &trans, &m, &n, &k, A, &lda, tau, C, &ldc, work, &lwork, info);
+  }
+
+  template <>
+  inline void cxormqr<double>(char side, char trans, int m, int n, int k, double const * A, int lda, double const * tau, double * C, int ldc, double * work, int lwork, int * info){
+    DORMQR(&side, &trans, &m, &n, &k, A, &lda, tau, C, &ldc, work, &lwork, info);
+  }
+
+  template <typename dtype>
+  void cxgesvd(char jobu, char jobvt, int m, int n, dtype * A, int lda, dtype * S, dtype * U, int ldu, dtype * VT, int ldvt, dtype * work, int lwork, int * info){
+    printf("CTF ERROR: SVD is only available for float and double\n");
+    *info = -1;
+  }
+
+  template <>
+  inline void cxgesvd<float>(char jobu, char jobvt, int m, int n, float * A, int lda, float * S, float * U, int ldu, float * VT, int ldvt, float * work, int lwork, int * info){
+    SGESVD(&jobu, &jobvt, &m, &n, A, &lda, S, U, &ldu, VT, &ldvt, work, &lwork, info);
+  }
+
+  template <>
+  inline void cxgesvd<double>(char jobu, char jobvt, int m, int n, double * A, int lda, double * S, double * U, int ldu, double * VT, int ldvt, double * work, int lwork, int * info){
+    DGESVD(&jobu, &jobvt, &m, &n, A, &lda, S, U, &ldu, VT, &ldvt, work, &lwork, info);
+  }
+#endif
+}
+
 #endif
@@ -32,6 +32,12 @@
 #include "memcontrol.h"
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/statvfs.h>
 using namespace std;
 //#include "../dist_tensor/cyclopstf.hpp"
 
@@ -70,14 +76,18 @@ void read_off_memory_status(statm_t& result)
   /* fraction of total memory which can be saturated */
   double memcap = 0.5;
   int64_t mem_size = 0;
+  /* fraction of available memory which unpacked copies of operands with broken symmetry can use */
+  double desym_mem_frac = DESYM_MEM_FRAC;
   #define MAX_THREADS 256
   int max_threads;
   int instance_counter = 0;
   int64_t mem_used[MAX_THREADS];
   int64_t tot_mem_used;
+  int64_t tot_mem_peak = 0;
   void inc_tot_mem_used(int64_t a){
     tot_mem_used += a;
     ASSERT(tot_mem_used >= 0);
+    tot_mem_peak = std::max(tot_mem_peak, tot_mem_used);
     //int rank;
   //  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 //    if (rank == 0)
@@ -88,6 +98,19 @@ void read_off_memory_status(statm_t& result)
   std::list<mem_loc> mem_stacks[MAX_THREADS];
   #endif
 
+  //directory of files backing out-of-core buffers
+  std::string ooc_dir;
+  //tensor data of at least this many bytes is out-of-core, none if zero
+  int64_t ooc_min_bytes = 0;
+  //number of processes sharing the file system of ooc_dir
+  int ooc_node_np = 1;
+  //number of files created so far, to name new ones
+  int64_t ooc_counter = 0;
+  //lengths of out-of-core buffers
+  std::map<void*,int64_t> ooc_maps;
+  std::mutex ooc_mutex;
+  std::atomic<int64_t> ooc_nmap(0);
+
   //application memory stack
   void * mst_buffer = 0;
   //size of memory stack
@@ -117,6 +140,14 @@ void read_off_memory_status(statm_t& result)
     memcap = cap;
   }
 
+  void set_desym_mem_frac(double frac){
+    desym_mem_frac = frac;
+  }
+
+  double get_desym_mem_frac(){
+    return desym_mem_frac;
+  }
+
   /**
    * \brief gets rid of empty space on the stack
    */
@@ -259,6 +290,99 @@ void read_off_memory_status(statm_t& result)
     return CTF_int::SUCCESS;
   }
 
+  void set_out_of_core(char const * dir, int64_t min_bytes, int node_np){
+    if (dir == NULL){
+      ooc_dir.clear();
+      ooc_min_bytes = 0;
+      return;
+    }
+    ooc_dir = dir;
+    ooc_min_bytes = std::max((int64_t)1, min_bytes);
+    ooc_node_np = std::max(1, node_np);
+  }
+
+  bool is_out_of_core(){
+    return ooc_nmap > 0;
+  }
+
+  /**
+   * \brief backs a buffer by an unlinked file in ooc_dir, which is removed once the buffer is unmapped
+   * \param[in] len number of bytes
+   * \param[in,out] ptr pointer to set to new allocation address
+   */
+  int ooc_alloc_ptr(int64_t const len, void ** const ptr){
+    std::lock_guard<std::mutex> lock(ooc_mutex);
+    char fname[ooc_dir.size()+64];
+    sprintf(fname, "%s/ctf_ooc_%d_%ld", ooc_dir.c_str(), (int)getpid(), ooc_counter++);
+    int fd = open(fname, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) return CTF_int::ERROR;
+    unlink(fname);
+    if (ftruncate(fd, len) != 0){
+      close(fd);
+      return CTF_int::ERROR;
+    }
+    void * p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return CTF_int::ERROR;
+    ooc_maps[p] = len;
+    ooc_nmap++;
+    *ptr = p;
+    return CTF_int::SUCCESS;
+  }
+
+  /**
+   * \brief unmaps an out-of-core buffer
+   * \param[in] ptr buffer
+   * \return false if ptr is not out-of-core
+   */
+  bool ooc_free(void * ptr){
+    if (ooc_nmap == 0) return false;
+    std::lock_guard<std::mutex> lock(ooc_mutex);
+    std::map<void*,int64_t>::iterator it = ooc_maps.find(ptr);
+    if (it == ooc_maps.end()) return false;
+    munmap(ptr, it->second);
+    ooc_maps.erase(it);
+    ooc_nmap--;
+    return true;
+  }
+
+  void * cshrink(void * ptr, int64_t len){
+    if (ooc_nmap > 0){
+      std::lock_guard<std::mutex> lock(ooc_mutex);
+      std::map<void*,int64_t>::iterator it = ooc_maps.find(ptr);
+      if (it != ooc_maps.end()){
+        int64_t pg = sysconf(_SC_PAGESIZE);
+        int64_t new_len = std::max(pg, ((len+pg-1)/pg)*pg);
+        if (new_len < it->second){
+          munmap((char*)ptr+new_len, it->second-new_len);
+          it->second = new_len;
+        }
+        return ptr;
+      }
+    }
+    return realloc(ptr, len);
+  }
+
+  void prefetch_mem(void const * ptr, int64_t len){
+    if (ooc_nmap == 0 || len <= 0) return;
+    int64_t pg = sysconf(_SC_PAGESIZE);
+    char * st = (char*)(((intptr_t)ptr/pg)*pg);
+    madvise(st, (char const*)ptr+len-st, MADV_WILLNEED);
+  }
+
+  int data_alloc_ptr(int64_t const len, void ** const ptr){
+    if (ooc_min_bytes > 0 && len >= ooc_min_bytes && ooc_alloc_ptr(len, ptr) == CTF_int::SUCCESS)
+      return CTF_int::SUCCESS;
+    return alloc_ptr(len, ptr);
+  }
+
+  void * data_alloc(int64_t const len){
+    void * ptr;
+    int ret = data_alloc_ptr(len, &ptr);
+    ASSERT(ret == CTF_int::SUCCESS);
+    return ptr;
+  }
+
   /**
    * \brief mst_alloc abstraction
    * \param[in] len number of bytes
@@ -476,6 +600,7 @@ void read_off_memory_status(statm_t& result)
    * \param[in,out] ptr pointer to set to address to free
    */
   int cdealloc(void * ptr){ 
+    if (ooc_free(ptr)) return CTF_int::SUCCESS;
     free(ptr);
     return CTF_int::SUCCESS;
   }
@@ -595,6 +720,14 @@ void read_off_memory_status(statm_t& result)
     return tot_mem_used;
   }
 
+  int64_t proc_bytes_peak(){
+    return tot_mem_peak;
+  }
+
+  void reset_proc_bytes_peak(){
+    tot_mem_peak = tot_mem_used;
+  }
+
   /* FIXME: only correct for 1 process per node */
   /**
    * \brief gives total memory size per MPI process 
@@ -644,10 +777,7 @@ void read_off_memory_status(statm_t& result)
 #endif
   }
 
-  /**
-   * \brief gives total memory available on this MPI process 
-   */
-  int64_t proc_bytes_available(){
+  int64_t proc_bytes_available(int64_t len){
 #ifdef BGQ
     uint64_t mem_avail;
     Kernel_GetMemorySize(KERNEL_MEMSIZE_HEAPAVAIL, &mem_avail);
@@ -661,8 +791,15 @@ void read_off_memory_status(statm_t& result)
 #else
     int64_t pused = proc_bytes_used();
     int64_t ptotal = proc_bytes_total();
-    if (pused > memcap*ptotal){ printf("CTF ERROR: less than %lf percent of local memory remaining, ensuing segfault likely.\n", (100.*(1.-memcap))); }
-    return memcap*ptotal-pused;
+    int64_t ooc_avail = 0;
+    if (ooc_min_bytes > 0 && len >= ooc_min_bytes){
+      // space on the out-of-core file system is shared by the processes of a node
+      struct statvfs fs;
+      if (statvfs(ooc_dir.c_str(), &fs) == 0)
+        ooc_avail = memcap*((int64_t)fs.f_bavail*fs.f_frsize)/ooc_node_np;
+    }
+    if (pused > memcap*ptotal+ooc_avail){ printf("CTF ERROR: less than %lf percent of local memory remaining, ensuing segfault likely.\n", (100.*(1.-memcap))); }
+    return memcap*ptotal-pused+ooc_avail;
 #endif
   }
 }
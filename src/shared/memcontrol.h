@@ -6,11 +6,72 @@
 namespace CTF_int {
   void inc_tot_mem_used(int64_t a);
   int64_t proc_bytes_used();
+
+  /** \brief largest value of proc_bytes_used() since the last reset_proc_bytes_peak() */
+  int64_t proc_bytes_peak();
+
+  /** \brief restarts tracking the peak of proc_bytes_used() from its current value */
+  void reset_proc_bytes_peak();
   int64_t proc_bytes_total();
-  int64_t proc_bytes_available();
+
+  /**
+   * \brief gives the memory available on this process for buffers of len bytes, which includes
+   *        space on the out-of-core file system only if tensor data of that size is backed by files
+   * \param[in] len size of the buffers the memory is needed for
+   */
+  int64_t proc_bytes_available(int64_t len=0);
   void set_memcap(double cap);
   void set_mem_size(int64_t size);
+
+  /**
+   * \brief sets the fraction of available memory that unpacked copies of operands with broken
+   *        symmetry may use, beyond which contractions are done on the packed operands
+   * \param[in] frac memory fraction, DESYM_MEM_FRAC by default
+   */
+  void set_desym_mem_frac(double frac);
+
+  /** \brief fraction of available memory that unpacked copies of operands with broken symmetry may use */
+  double get_desym_mem_frac();
   int get_num_instances();
+
+  /**
+   * \brief backs tensor data of at least min_bytes by memory-mapped files in directory dir
+   * \param[in] dir directory on local storage, NULL to allocate all buffers in memory
+   * \param[in] min_bytes smallest buffer to map to a file
+   * \param[in] node_np number of processes sharing the file system of dir
+   */
+  void set_out_of_core(char const * dir, int64_t min_bytes, int node_np);
+
+  /** \brief whether any buffer is currently backed by a file */
+  bool is_out_of_core();
+
+  /**
+   * \brief allocates tensor data or a home buffer, backed by a file if set_out_of_core() asks for it
+   * \param[in] len number of bytes
+   * \param[in,out] ptr pointer to set to new allocation address
+   */
+  int data_alloc_ptr(int64_t const len, void ** const ptr);
+
+  /**
+   * \brief allocates tensor data or a home buffer, backed by a file if set_out_of_core() asks for it
+   * \param[in] len number of bytes
+   */
+  void * data_alloc(int64_t const len);
+
+  /**
+   * \brief shrinks a buffer allocated by CTF to its leading len bytes, releasing the rest
+   * \param[in] ptr buffer
+   * \param[in] len new number of bytes
+   * \return shrunk buffer, which may have moved if it was in memory
+   */
+  void * cshrink(void * ptr, int64_t len);
+
+  /**
+   * \brief asks for the pages of an out-of-core buffer to be read ahead of their use
+   * \param[in] ptr start of range
+   * \param[in] len number of bytes
+   */
+  void prefetch_mem(void const * ptr, int64_t len);
 }
 
 
@@ -53,6 +53,8 @@ namespace CTF_int {
   #define COST_MEMBW (1.e-9)
   //network bandwidth: time per byte
   #define COST_NETWBW (5.e-10)
+  //intra-node (shared-memory) bandwidth: time per byte
+  #define COST_SHMBW (1.e-10)
   //flop cost: time per flop
   #define COST_FLOP (2.e-11)
   //flop cost: time per flop
@@ -101,6 +103,86 @@ namespace CTF_int {
   #define HOME_CONTRACT
   #define USE_BLOCK_RESHUFFLE
 
+  //when some process writes at least two chunks of this many bytes of pairs to a tensor,
+  //pairs are exchanged point-to-point, each chunk of a bucket sent as soon as it is filled,
+  //rather than by an all-to-all (default of CTF::set_sparse_pipeline_chunk_size)
+  #ifndef SPARSE_PIPELINE_CHUNK_SIZE
+  #define SPARSE_PIPELINE_CHUNK_SIZE (1<<22)
+  #endif
+
+  //MPI tag of point-to-point messages exchanging written pairs
+  #ifndef SPARSE_EXCHANGE_TAG
+  #define SPARSE_EXCHANGE_TAG 37
+  #endif
+
+  //fraction of available memory that unpacked copies of operands with broken symmetry may use,
+  //beyond it contractions are done on the packed operands as a sum over index permutations
+  //(default of set_desym_mem_frac() and of the CTF_DESYM_MEM_FRAC environment variable)
+  #ifndef DESYM_MEM_FRAC
+  #define DESYM_MEM_FRAC .5
+  #endif
+
+  //reductions with non-builtin MPI ops of at least this many bytes are done by CTF's
+  //pipelined ring reduce-scatter, exchanging chunks of PIPE_RED_CHUNK_SZ bytes
+  #ifndef PIPE_RED_MIN_SZ
+  #define PIPE_RED_MIN_SZ 65536
+  #endif
+  #ifndef PIPE_RED_CHUNK_SZ
+  #define PIPE_RED_CHUNK_SZ 32768
+  #endif
+
+  //default of CTF::NODE_ALLTOALLV_MIN_BYTES, below it all-to-all-v exchanges within a node use MPI,
+  //bench_node_alltoallv has not yet measured the shared-memory path faster anywhere, so it is off
+  #ifndef NODE_ALLTOALLV_MIN_SZ
+  #define NODE_ALLTOALLV_MIN_SZ INT64_MAX
+  #endif
+
+  //bytes of key-value pairs sent per round when a dense tensor is redistributed with bounded memory
+  #ifndef REDIST_CHUNK_BYTES
+  #define REDIST_CHUNK_BYTES (1<<24)
+  #endif
+
+  //elements of custom univariate functions are evaluated in blocks of this many before being accumulated
+  #ifndef FUNC_BLK_SZ
+  #define FUNC_BLK_SZ 256
+  #endif
+
+  //merges of sparse pair lists are split among threads so that each has at least this many pairs
+  #ifndef SPSPSUM_MIN_PAR_LEN
+  #define SPSPSUM_MIN_PAR_LEN 16384
+  #endif
+
+  //index maps of tensors of up to this order are stored inline in Idx_Tensor rather than allocated
+  #ifndef TERM_INLINE_ORDER
+  #define TERM_INLINE_ORDER 8
+  #endif
+
+  //scaling factors of elements of up to this many bytes are stored inline in a Term rather than allocated
+  #ifndef TERM_INLINE_SCALE
+  #define TERM_INLINE_SCALE 16
+  #endif
+
+  //operands of up to this many are stored inline in a Sum_Term or Contract_Term rather than allocated
+  #ifndef TERM_INLINE_OPS
+  #define TERM_INLINE_OPS 4
+  #endif
+
+  //default number of subcommunicators topologies of one World may keep alive between operations,
+  //beyond it those of the least recently used topology are freed (see CTF::set_topo_pool_comms)
+  #ifndef TOPO_POOL_COMMS
+  #define TOPO_POOL_COMMS 64
+  #endif
+
+  //fibers handed at once to the kernel of tensor::transform_fibers, which are interleaved in memory
+  #ifndef FIBER_GROUP_SIZE
+  #define FIBER_GROUP_SIZE 16
+  #endif
+
+  //largest fraction of nonzeros of sparse B for which A*B gathers only the columns of A (in CSC layout) needed by nonzeros of B
+  #ifndef SPMSPV_MAX_NNZ_FRAC
+  #define SPMSPV_MAX_NNZ_FRAC .1
+  #endif
+
   #define MAX_ORD 12
   #define LOOP_MAX_ORD(F,...) \
     F(0,__VA_ARGS__) F(1,__VA_ARGS__) F(2,__VA_ARGS__) F(3,__VA_ARGS__) \
@@ -206,6 +206,24 @@ namespace CTF_int {
 
   }
 
+  void CSR_Matrix::cscmultd(char const * A, algstrct const * sr_A, int m, int n, int k, char const * alpha, char const * B, algstrct const * sr_B, char const * beta, char * C, algstrct const * sr_C){
+    CSR_Matrix cA((char*)A);
+    CSR_Matrix cB((char*)B);
+    ASSERT(cA.nrow() == k && cA.ncol() == m);
+    ASSERT(sr_B->el_size == sr_A->el_size);
+    ASSERT(sr_C->el_size == sr_A->el_size);
+    sr_A->cscmultd(m,n,k,alpha,cA.vals(),cA.JA(),cA.IA(),cA.nnz(),cB.vals(),cB.JA(),cB.IA(),cB.nnz(),beta,C);
+  }
+
+  void CSR_Matrix::cscmultcsr(char const * A, algstrct const * sr_A, int m, int n, int k, char const * alpha, char const * B, algstrct const * sr_B, char const * beta, char *& C, algstrct const * sr_C){
+    CSR_Matrix cA((char*)A);
+    CSR_Matrix cB((char*)B);
+    ASSERT(cA.nrow() == k && cA.ncol() == m);
+    ASSERT(sr_B->el_size == sr_A->el_size);
+    ASSERT(sr_C->el_size == sr_A->el_size);
+    sr_A->cscmultcsr(m,n,k,alpha,cA.vals(),cA.JA(),cA.IA(),cA.nnz(),cB.vals(),cB.JA(),cB.IA(),cB.nnz(),beta,C);
+  }
+
   void CSR_Matrix::partition(int s, char ** parts_buffer, CSR_Matrix ** parts){
     int part_nnz[s], part_nrows[s];
     int m = nrow();
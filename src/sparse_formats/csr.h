@@ -92,6 +92,17 @@ namespace CTF_int {
        */
       static void csrmultcsr(char const * A, algstrct const * sr_A, int m, int n, int k, char const * alpha, char const * B, algstrct const * sr_B, char const * beta, char *& C, algstrct const * sr_C, bivar_function const * func, bool do_offload);
 
+      /**
+       * \brief computes C = beta*C + alpha*A*B where A is a CSR_Matrix of A^T (so A in CSC layout), B is a CSR_Matrix with few nonzeros, and C is dense,
+       *        reading only the columns of A corresponding to rows of B with nonzeros
+       */
+      static void cscmultd(char const * A, algstrct const * sr_A, int m, int n, int k, char const * alpha, char const * B, algstrct const * sr_B, char const * beta, char * C, algstrct const * sr_C);
+
+      /**
+       * \brief computes C = beta*C + alpha*A*B where A is a CSR_Matrix of A^T (so A in CSC layout), and B and C are CSR_Matrices, see cscmultd
+       */
+      static void cscmultcsr(char const * A, algstrct const * sr_A, int m, int n, int k, char const * alpha, char const * B, algstrct const * sr_B, char const * beta, char *& C, algstrct const * sr_C);
+
       static void compute_has_col(
 
                       int const * JA,
@@ -163,41 +163,16 @@ namespace CTF_int{
   }
 
   /**
-   * \brief As pairs in a sparse A set to the 
-   *         sparse set of elements defining the tensor,
-   *         resulting in a set of size between nB and nB+nA
-   * \param[in] sr_A algstrct defining data type of array
-   * \param[in] nA number of elements in sparse tensor
-   * \param[in] prs_A pairs of the sparse tensor
-   * \param[in] beta scaling factor for data of the sparse tensor
-   * \param[in] sr_B algstrct defining data type of array
-   * \param[in] nB number of elements in the A set
-   * \param[in] prs_B pairs of the A set
-   * \param[in] alpha scaling factor for data of the A set
-   * \param[out] nnew number of elements in resulting set
-   * \param[out] pprs_new char array containing the pairs of the resulting set
-   * \param[in] func NULL or pointer to a function to apply elementwise
-   * \param[in] map_pfx how many times each element of A should be replicated
+   * \brief counts the pairs resulting from merging pairs of A into those of B, see spspsum
    */
-
-  void spspsum(algstrct const *        sr_A,
-               int64_t                 nA,
-               ConstPairIterator       prs_A,
-               char const *            beta,
-               algstrct const *        sr_B,
-               int64_t                 nB,
-               ConstPairIterator       prs_B,
-               char const *            alpha,
-               int64_t &               nnew,
-               char *&                 pprs_new,
-               univar_function const * func,
-               int64_t                 map_pfx){
-
-    TAU_FSTART(spA_spB_seq_sum);
-    // determine how many unique keys there are in prs_tsr and prs_Write
-    nnew = nB;
+  static int64_t spspsum_count(int64_t                 nA,
+                               ConstPairIterator       prs_A,
+                               int64_t                 nB,
+                               ConstPairIterator       prs_B,
+                               univar_function const * func,
+                               int64_t                 map_pfx){
+    int64_t nnew = nB;
     bool is_acc = (func != NULL && func->is_accumulator());
-    TAU_FSTART(spA_spB_seq_sum_pre);
     for (int64_t t=0,ww=0; ww<nA*map_pfx; ww++){
       while (ww<nA*map_pfx){
         int64_t w = ww/map_pfx;
@@ -215,14 +190,26 @@ namespace CTF_int{
         }
       }
     }
-    TAU_FSTOP(spA_spB_seq_sum_pre);
-//    printf("nB = %ld nA = %ld nnew = %ld\n",nB,nA,nnew); 
-    alloc_ptr(sr_B->pair_size()*nnew, (void**)&pprs_new);
-    PairIterator prs_new(sr_B, pprs_new);
-    // each for loop computes one new value of prs_new 
-    //    (multiple writes may contribute to it), 
-    //    t, w, and n are incremented within
-    // only incrementing r allows multiple writes of the same val
+    return nnew;
+  }
+
+  /**
+   * \brief merges pairs of A into those of B, writing the nnew pairs counted by spspsum_count
+   *        to prs_new, see spspsum
+   */
+  static void spspsum_merge(algstrct const *        sr_A,
+                            int64_t                 nA,
+                            ConstPairIterator       prs_A,
+                            char const *            beta,
+                            algstrct const *        sr_B,
+                            int64_t                 nB,
+                            ConstPairIterator       prs_B,
+                            char const *            alpha,
+                            int64_t                 nnew,
+                            PairIterator            prs_new,
+                            univar_function const * func,
+                            int64_t                 map_pfx){
+    bool is_acc = (func != NULL && func->is_accumulator());
     int64_t n=0;
     for (int64_t t=0,ww=0; n<nnew; n++){
       /*if (n>0){ 
@@ -320,6 +307,140 @@ namespace CTF_int{
       }*/
     }
     ASSERT(n==nnew);
+  }
+
+  /**
+   * \brief key of the ww-th pair of A once each of its pairs is replicated map_pfx times
+   */
+  static inline int64_t rep_key(ConstPairIterator const & prs_A, int64_t ww, int64_t map_pfx){
+    return ConstPairIterator(prs_A.sr, prs_A.ptr+(ww/map_pfx)*prs_A.sr->pair_size()).k()*map_pfx + ww%map_pfx;
+  }
+
+  /**
+   * \brief number of leading pairs with keys less than key in a sorted list of n pairs
+   */
+  static int64_t key_lower_bound(ConstPairIterator const & prs, int64_t n, int64_t key){
+    int64_t lo = 0, hi = n;
+    while (lo < hi){
+      int64_t mid = lo + (hi-lo)/2;
+      if (ConstPairIterator(prs.sr, prs.ptr+mid*prs.sr->pair_size()).k() < key) lo = mid+1;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+  /**
+   * \brief finds where the d-th pair of the merged (replicated) A and B lists lies along the merge
+   *        path and moves it back to the first pair with its key, rounded down to a multiple of
+   *        map_pfx, so that pairs with equal keys and replicas of a pair of A are never split
+   * \param[out] sA number of pairs of A before the split
+   * \param[out] sB number of pairs of B before the split
+   */
+  static void merge_path_split(int64_t           nA,
+                               ConstPairIterator prs_A,
+                               int64_t           nB,
+                               ConstPairIterator prs_B,
+                               int64_t           map_pfx,
+                               int64_t           d,
+                               int64_t &         sA,
+                               int64_t &         sB){
+    int64_t nAr = nA*map_pfx;
+    int64_t lo = std::max((int64_t)0, d-nB);
+    int64_t hi = std::min(d, nAr);
+    while (lo < hi){
+      int64_t mid = lo + (hi-lo)/2;
+      if (rep_key(prs_A, mid, map_pfx) < ConstPairIterator(prs_B.sr, prs_B.ptr+(d-mid-1)*prs_B.sr->pair_size()).k()) lo = mid+1;
+      else hi = mid;
+    }
+    int64_t a = lo, b = d-lo;
+    if (a >= nAr && b >= nB){
+      sA = nA;
+      sB = nB;
+      return;
+    }
+    int64_t key;
+    if (a >= nAr) key = ConstPairIterator(prs_B.sr, prs_B.ptr+b*prs_B.sr->pair_size()).k();
+    else if (b >= nB) key = rep_key(prs_A, a, map_pfx);
+    else key = std::min(rep_key(prs_A, a, map_pfx), ConstPairIterator(prs_B.sr, prs_B.ptr+b*prs_B.sr->pair_size()).k());
+    key -= key%map_pfx;
+    sA = key_lower_bound(prs_A, nA, key/map_pfx);
+    sB = key_lower_bound(prs_B, nB, key);
+  }
+
+  /**
+   * \brief As pairs in a sparse A set to the 
+   *         sparse set of elements defining the tensor,
+   *         resulting in a set of size between nB and nB+nA
+   * \param[in] sr_A algstrct defining data type of array
+   * \param[in] nA number of elements in sparse tensor
+   * \param[in] prs_A pairs of the sparse tensor
+   * \param[in] beta scaling factor for data of the sparse tensor
+   * \param[in] sr_B algstrct defining data type of array
+   * \param[in] nB number of elements in the A set
+   * \param[in] prs_B pairs of the A set
+   * \param[in] alpha scaling factor for data of the A set
+   * \param[out] nnew number of elements in resulting set
+   * \param[out] pprs_new char array containing the pairs of the resulting set
+   * \param[in] func NULL or pointer to a function to apply elementwise
+   * \param[in] map_pfx how many times each element of A should be replicated
+   */
+
+  void spspsum(algstrct const *        sr_A,
+               int64_t                 nA,
+               ConstPairIterator       prs_A,
+               char const *            beta,
+               algstrct const *        sr_B,
+               int64_t                 nB,
+               ConstPairIterator       prs_B,
+               char const *            alpha,
+               int64_t &               nnew,
+               char *&                 pprs_new,
+               univar_function const * func,
+               int64_t                 map_pfx){
+
+    TAU_FSTART(spA_spB_seq_sum);
+    int ntd = 1;
+#ifdef USE_OMP
+    ntd = std::min((int64_t)omp_get_max_threads(), std::max((int64_t)1, (nA*map_pfx+nB)/SPSPSUM_MIN_PAR_LEN));
+#endif
+    // the merged list is cut into ntd parts along the merge path, part i merges A[sA[i]:sA[i+1]]
+    // into B[sB[i]:sB[i+1]] and writes its pairs starting at prs_new[pfx[i]]
+    int64_t sA[ntd+1], sB[ntd+1], pfx[ntd+1];
+    sA[0] = 0;
+    sB[0] = 0;
+    for (int i=1; i<ntd; i++){
+      merge_path_split(nA, prs_A, nB, prs_B, map_pfx, ((nA*map_pfx+nB)*i)/ntd, sA[i], sB[i]);
+    }
+    sA[ntd] = nA;
+    sB[ntd] = nB;
+    int64_t pA = sr_A->pair_size();
+    int64_t pB = sr_B->pair_size();
+
+    TAU_FSTART(spA_spB_seq_sum_pre);
+    pfx[0] = 0;
+#ifdef USE_OMP
+    #pragma omp parallel for num_threads(ntd)
+#endif
+    for (int i=0; i<ntd; i++){
+      pfx[i+1] = spspsum_count(sA[i+1]-sA[i], ConstPairIterator(sr_A, prs_A.ptr+sA[i]*pA),
+                               sB[i+1]-sB[i], ConstPairIterator(sr_B, prs_B.ptr+sB[i]*pB),
+                               func, map_pfx);
+    }
+    for (int i=0; i<ntd; i++){
+      pfx[i+1] += pfx[i];
+    }
+    nnew = pfx[ntd];
+    TAU_FSTOP(spA_spB_seq_sum_pre);
+//    printf("nB = %ld nA = %ld nnew = %ld\n",nB,nA,nnew); 
+    alloc_ptr(sr_B->pair_size()*nnew, (void**)&pprs_new);
+#ifdef USE_OMP
+    #pragma omp parallel for num_threads(ntd)
+#endif
+    for (int i=0; i<ntd; i++){
+      spspsum_merge(sr_A, sA[i+1]-sA[i], ConstPairIterator(sr_A, prs_A.ptr+sA[i]*pA), beta,
+                    sr_B, sB[i+1]-sB[i], ConstPairIterator(sr_B, prs_B.ptr+sB[i]*pB), alpha,
+                    pfx[i+1]-pfx[i], PairIterator(sr_B, pprs_new+pfx[i]*pB), func, map_pfx);
+    }
     TAU_FSTOP(spA_spB_seq_sum);
   }
 
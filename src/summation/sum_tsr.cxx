@@ -277,7 +277,7 @@ namespace CTF_int {
     if (buf != this->A) cdealloc(buf);
 
     for (i=0; i<ncdt_B; i++){
-      cdt_B[i]->allred(MPI_IN_PLACE, this->B, size_B, sr_B->mdtype(), sr_B->addmop());
+      cdt_B[i]->allred(this->B, size_B, sr_B);
     }
 
   }
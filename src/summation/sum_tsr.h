@@ -37,6 +37,20 @@ namespace CTF_int {
         sr_B->add(b, tb, b);
       }
 
+      /**
+       * \brief compute b[i] = b[i]+f(a[i]) for n consecutive values
+       * \param[in] n number of values
+       * \param[in] a pointer to first operand
+       * \param[in,out] b pointer to first output
+       * \param[in] sr_A algebraic structure for a
+       * \param[in] sr_B algebraic structure for b, needed to do add
+       */
+      virtual void acc_f_n(int64_t n, char const * a, char * b, algstrct const * sr_A, algstrct const * sr_B) const {
+        for (int64_t i=0; i<n; i++){
+          acc_f(a+i*sr_A->el_size, b+i*sr_B->el_size, sr_B);
+        }
+      }
+
       virtual bool is_transform() const { return false; };
 
       univar_function(void (*f_)(char const *, char *)) { f=f_; }
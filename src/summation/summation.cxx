@@ -5,6 +5,7 @@
 #include "../tensor/untyped_tensor.h"
 #include "../shared/util.h"
 #include "../shared/memcontrol.h"
+#include "../interface/timer.h"
 #include "sym_seq_sum.h"
 #include "../symmetry/sym_indices.h"
 #include "../symmetry/symmetrization.h"
@@ -118,13 +119,41 @@ namespace CTF_int {
     print();
 #endif
     //update_all_models(A->wrld->cdt.cm);
+    bool do_stats = begin_op_stats("summation", op_stats_expr(A, idx_A, B, idx_B, NULL, NULL,
+                                   beta != NULL && !B->sr->isequal(beta, B->sr->addid())));
+    B->data_modified();
     int stat = home_sum_tsr(run_diag);
     assert(stat == SUCCESS); 
+    if (do_stats) end_op_stats(A->wrld->rank);
   }
   
   double summation::estimate_time(){
-    assert(0); //FIXME
-    return 0.0;
+    // analytical estimate assuming B is read and written once and A is redistributed once,
+    // symmetry, sparsity, and the actual mappings are not taken into account
+    double nel_A = 1., nel_B = 1.;
+    for (int i=0; i<A->order; i++) nel_A *= A->lens[i];
+    for (int i=0; i<B->order; i++) nel_B *= B->lens[i];
+    double np = A->wrld->np;
+    return COST_MEMBW*(nel_A*A->sr->el_size + 2.*nel_B*B->sr->el_size)/np
+           + COST_NETWBW*nel_A*A->sr->el_size/np + COST_LATENCY*(1.+log2(np));
+  }
+
+  void summation::record_op_stats(bool is_folded){
+    CTF::Op_stats * st = cur_op_stats();
+    st->topo.clear();
+    for (int i=0; i<B->topo->order; i++){
+      if (i > 0) st->topo += "x";
+      st->topo += std::to_string(B->topo->lens[i]);
+    }
+    // a single process is mapped onto a topology of order zero
+    if (B->topo->order == 0) st->topo = "1";
+    st->map_A = A->get_map_str();
+    st->map_B = B->get_map_str();
+    st->folded |= is_folded;
+    if (is_folded) st->kernel = "axpy";
+    else if (A->is_sparse || B->is_sparse) st->kernel = "sparse";
+    else st->kernel = is_custom ? "custom" : "reference";
+    st->est_time += estimate_time();
   }
 
   void summation::get_fold_indices(int *  num_fold,
@@ -1492,6 +1521,7 @@ namespace CTF_int {
       }
       /* Construct the tensor algorithm we would like to use */
       ASSERT(new_sum.check_mapping());
+      bool is_folded = false;
   #if FOLD_TSR
       if (is_custom == false && new_sum.can_fold()){
         //FIXME bit of a guess, no?
@@ -1504,6 +1534,7 @@ namespace CTF_int {
           inner_stride = new_sum.map_fold();
           TAU_FSTOP(map_fold);
           sumf = new_sum.construct_sum(inner_stride);
+          is_folded = true;
         } else {
           /*if (A->wrld->cdt.rank == 0)
             printf("Decided not to fold\n");*/
@@ -1543,6 +1574,7 @@ namespace CTF_int {
       }*/
   #endif
 
+      if (cur_op_stats() != NULL) new_sum.record_op_stats(is_folded);
       TAU_FSTOP(sum_tensors_map);
   #if DEBUG >= 2
       if (tnsr_B->wrld->rank==0)
@@ -1588,7 +1620,7 @@ namespace CTF_int {
       TAU_FSTOP(post_sum_func_barrier);
 #endif
       TAU_FSTART(sum_postprocessing);
-      tnsr_A->topo->deactivate();
+      tnsr_A->topo->release();
       tnsr_A->unfold();
       tnsr_B->unfold();
 #ifndef SEQ
@@ -2300,8 +2332,11 @@ namespace CTF_int {
       }
     } else
       need_remap = 1;
-    if (need_remap)
+    if (need_remap){
+      int64_t st_bytes = get_comm_bytes();
       A->redistribute(dA);
+      if (cur_op_stats() != NULL) cur_op_stats()->redist_bytes_A += get_comm_bytes()-st_bytes;
+    }
     need_remap = 0;
     if (B->topo == old_topo_B){
       for (d=0; d<B->order; d++){
@@ -2310,8 +2345,11 @@ namespace CTF_int {
       }
     } else
       need_remap = 1;
-    if (need_remap)
+    if (need_remap){
+      int64_t st_bytes = get_comm_bytes();
       B->redistribute(dB);
+      if (cur_op_stats() != NULL) cur_op_stats()->redist_bytes_B += get_comm_bytes()-st_bytes;
+    }
 
     TAU_FSTOP(redistribute_for_sum);
     delete [] old_map_A;
@@ -99,6 +99,12 @@ namespace CTF_int {
       
       /** \brief predicts execution time in seconds using performance models */
       double estimate_time();
+
+      /**
+       * \brief fills the mapping, kernel and estimated time of the operation being recorded
+       * \param[in] is_folded whether the local summation is folded into an axpy
+       */
+      void record_op_stats(bool is_folded);
    
       /**
        * \brief returns 1 if summations have same tensors and index map
@@ -539,9 +539,11 @@ namespace CTF_int {
                        univar_function const * func){
     TAU_FSTART(sym_seq_sum_cust);
     int idx, i, idx_max, imin, imax, iA, iB, j, k;
-    int off_idx, sym_pass;
+    int off_idx, sym_pass, inr_stride;
     int * idx_glb, * rev_idx_map;
     int * dlen_A, * dlen_B;
+    int * inr_len_A, * inr_len_B;
+    char * tmp_A;
     int64_t idx_A, idx_B, off_lda;
 
     inv_idx(order_A,       idx_map_A,
@@ -558,22 +560,54 @@ namespace CTF_int {
 
     SCAL_B;
 
+    // if the leading index of A and B is shared, nonsymmetric, and appears once in each,
+    // the innermost loop is contiguous in both, so hand whole rows to the batched kernel
+    inr_stride = 1;
+    inr_len_A = NULL;
+    inr_len_B = NULL;
+    if (order_A > 0 && order_B > 0 && idx_map_A[0] == idx_map_B[0] &&
+        sym_A[0] == NS && sym_B[0] == NS && edge_len_A[0] > 1){
+      inr_stride = edge_len_A[0];
+      for (i=1; i<order_A; i++){
+        if (idx_map_A[i] == idx_map_A[0]) inr_stride = 1;
+      }
+      for (i=1; i<order_B; i++){
+        if (idx_map_B[i] == idx_map_B[0]) inr_stride = 1;
+      }
+    }
+    if (inr_stride > 1){
+      inr_len_A = (int*)CTF_int::alloc(sizeof(int)*order_A);
+      inr_len_B = (int*)CTF_int::alloc(sizeof(int)*order_B);
+      memcpy(inr_len_A, edge_len_A, sizeof(int)*order_A);
+      memcpy(inr_len_B, edge_len_B, sizeof(int)*order_B);
+      inr_len_A[0] = 1;
+      inr_len_B[0] = 1;
+      edge_len_A = inr_len_A;
+      edge_len_B = inr_len_B;
+      dlen_A[0] = 1;
+      dlen_B[0] = 1;
+    }
+    tmp_A = NULL;
+    if (alpha != NULL)
+      tmp_A = (char*)CTF_int::alloc(sr_A->el_size*inr_stride);
+
     idx_A = 0, idx_B = 0;
     sym_pass = 1;
     for (;;){
       if (sym_pass){
         if (alpha != NULL){
-          char tmp_A[sr_A->el_size];
-          sr_A->mul(A+sr_A->el_size*idx_A, alpha, tmp_A);
-          func->acc_f(tmp_A, B+idx_B*sr_B->el_size, sr_B);
+          for (i=0; i<inr_stride; i++){
+            sr_A->mul(A+sr_A->el_size*(idx_A*inr_stride+i), alpha, tmp_A+sr_A->el_size*i);
+          }
+          func->acc_f_n(inr_stride, tmp_A, B+idx_B*inr_stride*sr_B->el_size, sr_A, sr_B);
 //          func->apply_f(tmp_A, tmp_B);
   //        sr_B->add(B+idx_B*sr_B->el_size, tmp_B, B+sr_B->el_size*idx_B);
-          CTF_FLOPS_ADD(2);
+          CTF_FLOPS_ADD(2*inr_stride);
         } else {
-          func->acc_f(A+idx_A*sr_A->el_size, B+idx_B*sr_B->el_size, sr_B);
+          func->acc_f_n(inr_stride, A+idx_A*inr_stride*sr_A->el_size, B+idx_B*inr_stride*sr_B->el_size, sr_A, sr_B);
           //func->apply_f(A+idx_A*sr_A->el_size, tmp_B);
           //sr_B->add(B+idx_B*sr_B->el_size, tmp_B, B+idx_B*sr_B->el_size);
-          CTF_FLOPS_ADD(1);
+          CTF_FLOPS_ADD(inr_stride);
         }
       }
 
@@ -606,6 +640,11 @@ namespace CTF_int {
       if (order_B > 0)
         RESET_IDX(B);
     }
+    if (inr_len_A != NULL){
+      CTF_int::cdealloc(inr_len_A);
+      CTF_int::cdealloc(inr_len_B);
+    }
+    if (tmp_A != NULL) CTF_int::cdealloc(tmp_A);
     CTF_int::cdealloc(dlen_A);
     CTF_int::cdealloc(dlen_B);
     CTF_int::cdealloc(idx_glb);
@@ -239,6 +239,40 @@ namespace CTF_int {
                  char const * beta,
                  char *&      C_CSR) const;
 
+      /** \brief sparse version of gemm with A given by columns (CSC layout, so CSR of A^T), B in CSR format with few nonzeros, and C dense, only columns of A matching nonzeros of B are read */
+      virtual void cscmultd
+                (int          m,
+                 int          n,
+                 int          k,
+                 char const * alpha,
+                 char const * A,
+                 int const *  JA,
+                 int const *  IA,
+                 int64_t      nnz_A,
+                 char const * B,
+                 int const *  JB,
+                 int const *  IB,
+                 int64_t      nnz_B,
+                 char const * beta,
+                 char *       C) const;
+
+      /** \brief version of cscmultd with C in CSR format */
+      virtual void cscmultcsr
+                (int          m,
+                 int          n,
+                 int          k,
+                 char const * alpha,
+                 char const * A,
+                 int const *  JA,
+                 int const *  IA,
+                 int64_t      nnz_A,
+                 char const * B,
+                 int const *  JB,
+                 int const *  IB,
+                 int64_t      nnz_B,
+                 char const * beta,
+                 char *&      C_CSR) const;
+
       /** \brief returns true if algstrct elements a and b are equal */
       virtual bool isequal(char const * a, char const * b) const;
 
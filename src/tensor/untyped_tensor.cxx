@@ -2,6 +2,7 @@
 #include "../interface/common.h"
 #include "../interface/timer.h"
 #include "../interface/idx_tensor.h"
+#include "../interface/set.h"
 #include "../summation/summation.h"
 #include "../contraction/contraction.h"
 #include "untyped_tensor.h"
@@ -33,8 +34,15 @@ namespace CTF_int {
     return idxtsr;
   }
 
+  // last data generation handed out to a tensor of this process
+  static int64_t data_gen_ctr = 0;
+
   tensor::tensor(){
     order=-1;
+    csc_data=NULL;
+    csc_blk=NULL;
+    csc_size=0;
+    data_gen=++data_gen_ctr;
   }
 
   void tensor::free_self(){
@@ -61,6 +69,7 @@ namespace CTF_int {
         if (has_home && !is_home) cdealloc(home_buffer);
       }
       if (is_sparse) cdealloc(nnz_blk);
+      clear_csc();
       order = -1;
       delete sr;
       cdealloc(name);
@@ -106,6 +115,9 @@ namespace CTF_int {
       this->has_home = 0;
 #endif
     } else {
+      this->data = (char*)CTF_int::data_alloc(this->size*this->sr->el_size);
+      if (this->sr->addid() != NULL)
+        this->sr->set(this->data, this->sr->addid(), this->size);
 #ifdef HOME_CONTRACT
       this->home_size = this->size;
       register_size(home_size*sr->el_size);
@@ -115,10 +127,6 @@ namespace CTF_int {
 #else
       this->has_home = 0;
 #endif
-
-      register_size(this->home_size*sr->el_size);
-      this->data = (char*)CTF_int::alloc(this->size*this->sr->el_size);
-      this->sr->set(this->data, this->sr->addid(), this->size);
     }
 
   }
@@ -212,7 +220,7 @@ namespace CTF_int {
         }*/
         this->home_size = other->home_size;
         register_size(this->home_size*sr->el_size);
-        this->home_buffer = (char*)CTF_int::alloc(other->home_size*sr->el_size);
+        this->home_buffer = (char*)CTF_int::data_alloc(other->home_size*sr->el_size);
         if (other->is_home){
           this->is_home = 1;
           this->data = this->home_buffer;
@@ -221,11 +229,11 @@ namespace CTF_int {
           }*/
           this->is_home = 0;
           memcpy(this->home_buffer, other->home_buffer, other->home_size);
-          CTF_int::alloc_ptr(other->size*sr->el_size, (void**)&this->data);
+          CTF_int::data_alloc_ptr(other->size*sr->el_size, (void**)&this->data);
         }
         this->has_home = 1;
       } else {
-        CTF_int::alloc_ptr(other->size*sr->el_size, (void**)&this->data);
+        CTF_int::data_alloc_ptr(other->size*sr->el_size, (void**)&this->data);
 /*          if (this->has_home && !this->is_home){
           CTF_int::cdealloc(this->home_buffer);
         }*/
@@ -233,7 +241,7 @@ namespace CTF_int {
         this->is_home = 0;
       }
   #else
-      CTF_int::alloc_ptr(other->size*sr->el_size, (void**)&this->data);
+      CTF_int::data_alloc_ptr(other->size*sr->el_size, (void**)&this->data);
   #endif
       memcpy(this->data, other->data, sr->el_size*other->size);
     } else {
@@ -321,8 +329,13 @@ namespace CTF_int {
     this->nnz_blk           = NULL;
     this->is_csr            = false;
     this->nrow_idx          = -1;
+    this->csc_data          = NULL;
+    this->csc_blk           = NULL;
+    this->csc_size          = 0;
+    this->data_gen          = ++data_gen_ctr;
 //    this->nnz_loc_max       = 0;
     this->registered_alloc_size = 0;
+    this->wrld_tsr_id       = wrld->ntsr_created++;
     if (name_ != NULL){
       this->name = (char*)alloc(strlen(name_)+1);
       strcpy(this->name, name_);
@@ -483,6 +496,7 @@ namespace CTF_int {
 
   int tensor::set_zero() {
     TAU_FSTART(set_zero_tsr);
+    data_modified();
     int * restricted;
     int i, map_success, btopo;
 //    int64_t nvirt, bnvirt;
@@ -522,8 +536,8 @@ namespace CTF_int {
           this->topo = wrld->topovec[i];
           this->set_padding();
           memuse = (int64_t)this->size;
-          if (!is_sparse && (int64_t)memuse*sr->el_size >= (int64_t)proc_bytes_available()){
-            DPRINTF(1,"Not enough memory %E to map tensor (size %E) on topo %d\n", (double)proc_bytes_available(),(double)memuse*sr->el_size,i);
+          if (!is_sparse && (int64_t)memuse*sr->el_size >= (int64_t)proc_bytes_available(memuse*sr->el_size)){
+            DPRINTF(1,"Not enough memory %E to map tensor (size %E) on topo %d\n", (double)proc_bytes_available(memuse*sr->el_size),(double)memuse*sr->el_size,i);
             continue;
           }
           int64_t sum_phases = 0;
@@ -602,15 +616,15 @@ namespace CTF_int {
           //this->has_home = 0;
     /*      if (wrld->rank == 0)
             DPRINTF(3,"Initial size of tensor %d is " PRId64 ",",tensor_id,this->size);*/
-          CTF_int::alloc_ptr(this->home_size*sr->el_size, (void**)&this->home_buffer);
+          CTF_int::data_alloc_ptr(this->home_size*sr->el_size, (void**)&this->home_buffer);
           if (wrld->rank == 0) DPRINTF(2,"Creating home of %s\n",name);
           register_size(this->size*sr->el_size);
           this->data = this->home_buffer;
         } else {
-          CTF_int::alloc_ptr(this->size*sr->el_size, (void**)&this->data);
+          CTF_int::data_alloc_ptr(this->size*sr->el_size, (void**)&this->data);
         }
         #else
-        CTF_int::mst_alloc_ptr(this->size*sr->el_size, (void**)&this->data);
+        CTF_int::data_alloc_ptr(this->size*sr->el_size, (void**)&this->data);
         #endif
         #if DEBUG >= 2
         if (wrld->rank == 0)
@@ -638,28 +652,7 @@ namespace CTF_int {
         }
       }
       printf("\n");*/
-      char tname[200];
-      tname[0] = '\0';
-      sprintf(tname, "%s[", name);
-      for (int dim=0; dim<order; dim++){
-        if (dim>0)
-          sprintf(tname+strlen(tname), ",");
-        int tp = edge_map[dim].calc_phase();
-        int pp = edge_map[dim].calc_phys_phase();
-        int vp = tp/pp;
-        if (tp==1) sprintf(tname+strlen(tname),"1");
-        else {
-          if (pp > 1){
-            sprintf(tname+strlen(tname),"p%d(%d)",edge_map[dim].np,edge_map[dim].cdt);
-            if (edge_map[dim].has_child && edge_map[dim].child->type == PHYSICAL_MAP) 
-              sprintf(tname+strlen(tname),"p%d(%d)",edge_map[dim].child->np,edge_map[dim].child->cdt);
-          }
-          if (vp > 1) sprintf(tname+strlen(tname),"v%d",vp);
-        }
-//        sprintf(tname+strlen(tname),"c%d",edge_map[dim].has_child);
-      }
-      sprintf(tname+strlen(tname), "]");
-      printf("CTF: Tensor mapping is %s\n",tname);
+      printf("CTF: Tensor mapping is %s%s\n",name,get_map_str().c_str());
 /*      printf("\nCTF: sym  len  tphs  pphs  vphs\n");
       for (int dim=0; dim<order; dim++){
         int tp = edge_map[dim].calc_phase();
@@ -670,6 +663,34 @@ namespace CTF_int {
     }
   }
    
+  std::string tensor::get_map_str() const {
+    std::string str = "[";
+    char buf[64];
+    for (int dim=0; dim<order; dim++){
+      if (dim>0) str += ",";
+      int tp = edge_map[dim].calc_phase();
+      int pp = edge_map[dim].calc_phys_phase();
+      int vp = tp/pp;
+      if (tp==1) str += "1";
+      else {
+        if (pp > 1){
+          sprintf(buf,"p%d(%d)",edge_map[dim].np,edge_map[dim].cdt);
+          str += buf;
+          if (edge_map[dim].has_child && edge_map[dim].child->type == PHYSICAL_MAP){
+            sprintf(buf,"p%d(%d)",edge_map[dim].child->np,edge_map[dim].child->cdt);
+            str += buf;
+          }
+        }
+        if (vp > 1){
+          sprintf(buf,"v%d",vp);
+          str += buf;
+        }
+      }
+    }
+    str += "]";
+    return str;
+  }
+
   void tensor::set_name(char const * name_){
     cdealloc(name);
     this->name = (char*)alloc(strlen(name_)+1);
@@ -706,6 +727,7 @@ namespace CTF_int {
 
     tsr_A = A;
     tsr_B = this;
+    data_modified();
 
     if (permutation_B != NULL){
       ASSERT(permutation_A == NULL);
@@ -849,6 +871,7 @@ namespace CTF_int {
 
     tsr_A = A;
     tsr_B = this;
+    data_modified();
 
     int * padding_A = (int*)CTF_int::alloc(sizeof(int)*tsr_A->order);
     int * toffset_A = (int*)CTF_int::alloc(sizeof(int)*tsr_A->order);
@@ -1025,6 +1048,8 @@ namespace CTF_int {
     mapping * map;
     tensor * tsr;
 
+    if (rw == 'w') data_modified();
+
   #if DEBUG >= 1
     if (wrld->rank == 0){
    /*   if (rw == 'w')
@@ -1163,7 +1188,7 @@ namespace CTF_int {
     if (itopo == -1){
       itopo = wrld->topovec.size();
       wrld->topovec.push_back(top);
-    }
+    } else delete top;
     ASSERT(itopo != -1);
     assert(itopo != -1);
 
@@ -1270,6 +1295,7 @@ namespace CTF_int {
   int tensor::sparsify(std::function<bool(char const*)> f){
     if (is_sparse){
       TAU_FSTART(sparsify);
+      data_modified();
       int64_t nnz_loc_new = 0;
       PairIterator pi(sr, data);
       int64_t nnz_blk_old[calc_nvirt()];
@@ -1308,6 +1334,7 @@ namespace CTF_int {
     } else {
       TAU_FSTART(sparsify_dense);
       ASSERT(!has_home || is_home);
+      data_modified();
       int nvirt = calc_nvirt();
       this->nnz_blk = (int64_t*)alloc(sizeof(int64_t)*nvirt);
 
@@ -1505,6 +1532,59 @@ namespace CTF_int {
     }
   }
 
+  void tensor::read_local_offsets(int64_t *  num_pair,
+                                  int64_t ** keys,
+                                  int64_t ** offsets) const {
+    ASSERT(!is_sparse);
+    ASSERT(!is_folded);
+    ASSERT(is_mapped);
+    *num_pair = 0;
+    *keys     = NULL;
+    *offsets  = NULL;
+    if (has_zero_edge_len || size == 0) return;
+
+    int * virt_phase, * virt_phys_rank, * phys_phase, * phase;
+    CTF_int::alloc_ptr(sizeof(int)*order, (void**)&virt_phase);
+    CTF_int::alloc_ptr(sizeof(int)*order, (void**)&phys_phase);
+    CTF_int::alloc_ptr(sizeof(int)*order, (void**)&phase);
+    CTF_int::alloc_ptr(sizeof(int)*order, (void**)&virt_phys_rank);
+    int num_virt = 1;
+    for (int i=0; i<order; i++){
+      mapping * map     = edge_map + i;
+      phase[i]          = map->calc_phase();
+      phys_phase[i]     = map->calc_phys_phase();
+      virt_phase[i]     = phase[i]/phys_phase[i];
+      virt_phys_rank[i] = map->calc_phys_rank(topo);
+      num_virt          = num_virt*virt_phase[i];
+    }
+    // keys are assigned to a buffer of local offsets, as if it were the data
+    CTF::Set<int64_t> osr;
+    int64_t * loc_offs = (int64_t*)CTF_int::alloc(sizeof(int64_t)*size);
+    for (int64_t i=0; i<size; i++){
+      loc_offs[i] = i;
+    }
+    char * pairs;
+    read_loc_pairs(order, size, num_virt, sym, pad_edge_len, padding,
+                   phase, phys_phase, virt_phase, virt_phys_rank, num_pair,
+                   (char const*)loc_offs, &pairs, &osr);
+    CTF_int::cdealloc(loc_offs);
+    if (*num_pair > 0){
+      *keys    = (int64_t*)CTF_int::alloc(sizeof(int64_t)*(*num_pair));
+      *offsets = (int64_t*)CTF_int::alloc(sizeof(int64_t)*(*num_pair));
+      for (int64_t i=0; i<*num_pair; i++){
+        ConstPairIterator pi(&osr, pairs+i*osr.pair_size());
+        (*keys)[i] = pi.k();
+        memcpy((*offsets)+i, pi.d(), sizeof(int64_t));
+      }
+    }
+    if (pairs != NULL) CTF_int::cdealloc(pairs);
+
+    CTF_int::cdealloc((void*)virt_phase);
+    CTF_int::cdealloc((void*)phys_phase);
+    CTF_int::cdealloc((void*)phase);
+    CTF_int::cdealloc((void*)virt_phys_rank);
+  }
+
   PairIterator tensor::read_all_pairs(int64_t * num_pair, bool unpack){
     int numPes;
     int * nXs;
@@ -1666,6 +1746,204 @@ namespace CTF_int {
     return SUCCESS;
   }
 
+  int tensor::scan(int mode, algstrct const * sr_other, bool exclusive){
+    IASSERT(!is_sparse);
+    IASSERT(mode >= 0 && mode < order);
+    IASSERT(sym[mode] == NS && (mode == 0 || sym[mode-1] == NS));
+    IASSERT(sr_other->el_size == sr->el_size);
+    if (has_zero_edge_len) return SUCCESS;
+    TAU_FSTART(scan);
+    unfold();
+
+    // each virtual block is stored as [modes before mode][mode][modes after mode], the mode
+    // not being symmetric with its neighbors, element l of block v along the mode has global
+    // index g = (l*nvirt_mode+v)*np_mode+rank_mode, the round of g being g/np_mode
+    mapping const * map = edge_map+mode;
+    int np_mode    = map->calc_phys_phase();
+    int nvirt_mode = map->calc_phase()/np_mode;
+    int rank_mode  = map->calc_phys_rank(topo);
+    int64_t nvirt  = calc_nvirt();
+    int64_t bsz    = size/nvirt;
+    int64_t vlen   = pad_edge_len[mode]/map->calc_phase();
+    int64_t vstr   = 1;
+    std::vector<int> vlens(order);
+    for (int i=0; i<mode; i++){
+      vlens[i] = pad_edge_len[i]/edge_map[i].calc_phase();
+      vstr *= edge_map[i].calc_phase()/edge_map[i].calc_phys_phase();
+    }
+    int64_t inner  = sy_packed_size(mode, &vlens[0], sym);
+    int64_t outer  = bsz/(inner*vlen);
+    int64_t nround = vlen*nvirt_mode;
+    // rounds in which this process has an element that is not padding
+    int64_t nvalid = std::min(nround, (int64_t)(lens[mode]-rank_mode+np_mode-1)/np_mode);
+    int64_t es     = sr->el_size;
+
+    // the processes along the mode hold the same layout, so the local data is combined as is,
+    // with the padding along the mode set to the identity
+    char * pre = (char*)alloc(size*es);
+    char * tot = (char*)alloc(size*es);
+    for (int64_t t=nvalid; t<nround; t++){
+      int64_t v = t%nvirt_mode, l = t/nvirt_mode;
+      for (int64_t bo=0; bo<nvirt/nvirt_mode; bo++){
+        int64_t b = (bo%vstr)+v*vstr+(bo/vstr)*vstr*nvirt_mode;
+        for (int64_t o=0; o<outer; o++){
+          sr_other->set(data+(b*bsz+(o*vlen+l)*inner)*es, sr_other->addid(), inner);
+        }
+      }
+    }
+
+    // sums of each element over preceding processes and over all processes along the mode
+    if (np_mode > 1){
+      MPI_Comm cm;
+      bool is_split = !(map->type == PHYSICAL_MAP && !map->has_child);
+      if (!is_split){
+        topo->activate();
+        cm = topo->dim_comm[map->cdt].cm;
+      } else {
+        // the mode is folded onto several processor grid dimensions
+        int color = wrld->rank;
+        for (mapping const * m = map; m != NULL; m = m->has_child ? m->child : NULL){
+          if (m->type == PHYSICAL_MAP) color -= topo->lda[m->cdt]*topo->dim_comm[m->cdt].rank;
+        }
+        MPI_Comm_split(wrld->comm, color, rank_mode, &cm);
+      }
+      ASSERT(size <= INT_MAX);
+      MPI_Exscan(data, pre, size, sr_other->mdtype(), sr_other->addmop(), cm);
+      MPI_Allreduce(data, tot, size, sr_other->mdtype(), sr_other->addmop(), cm);
+      if (rank_mode == 0) sr_other->set(pre, sr_other->addid(), size);
+      if (is_split) MPI_Comm_free(&cm);
+      else topo->release();
+    } else {
+      sr_other->set(pre, sr_other->addid(), size);
+      sr->copy(tot, data, size);
+    }
+
+    // the prefix of an element is the sum of the previous rounds, of the elements of its round
+    // on preceding processes, and unless exclusive of itself, the sums over rounds are formed
+    // in tot in place, adding vectors along the contiguous modes before mode
+    if (!exclusive) sr_other->axpy(size, sr_other->mulid(), data, 1, pre, 1);
+    sr->copy(data, pre, size);
+    int64_t ngrp = (nvirt/nvirt_mode)*outer;
+  #ifdef USE_OMP
+    #pragma omp parallel for
+  #endif
+    for (int64_t grp=0; grp<ngrp; grp++){
+      int64_t o = grp%outer, bo = grp/outer;
+      int64_t off0 = ((bo%vstr)+(bo/vstr)*vstr*nvirt_mode)*bsz+o*vlen*inner;
+      int64_t prv = off0;
+      for (int64_t t=1; t<nvalid; t++){
+        int64_t off = off0+(t%nvirt_mode)*vstr*bsz+(t/nvirt_mode)*inner;
+        if (inner == 1){
+          sr_other->add(tot+prv*es, data+off*es, data+off*es);
+          sr_other->add(tot+prv*es, tot+off*es, tot+off*es);
+        } else {
+          sr_other->axpy(inner, sr_other->mulid(), tot+prv*es, 1, data+off*es, 1);
+          sr_other->axpy(inner, sr_other->mulid(), tot+prv*es, 1, tot+off*es, 1);
+        }
+        prv = off;
+      }
+    }
+    cdealloc(pre);
+    cdealloc(tot);
+    // padding of all modes may hold sums with the identity of sr_other
+    zero_out_padding();
+    TAU_FSTOP(scan);
+    return SUCCESS;
+  }
+
+  int tensor::transform_fibers(int                                                  mode,
+                               std::function<void(int64_t, int64_t, char*)> const & f,
+                               bool                                                 restore_layout){
+    IASSERT(!is_sparse);
+    IASSERT(mode >= 0 && mode < order);
+    for (int i=0; i<order; i++){
+      IASSERT(sym[i] == NS);
+    }
+    if (has_zero_edge_len) return SUCCESS;
+    TAU_FSTART(transform_fibers);
+    unfold();
+    tensor * home = NULL;
+    bool had_home = has_home;
+    if (edge_map[mode].calc_phase() > 1){
+      if (restore_layout){
+        // remember the current mapping in a tensor without data
+        home = new tensor(this, 0, 0);
+        home->topo = topo;
+        copy_mapping(order, edge_map, home->edge_map);
+        home->set_padding();
+      }
+      // the prime factors of the number of processes, largest first, are given to the modes
+      // other than mode with the most elements per process, leftover factors replicate the tensor
+      int nfact;
+      int * factors;
+      factorize(wrld->np, &nfact, &factors);
+      std::vector<int> phase(order, 1);
+      int nrep = 1;
+      for (int k=nfact-1; k>=0; k--){
+        int imax = -1;
+        for (int i=0; i<order; i++){
+          if (i != mode && lens[i] >= phase[i]*factors[k] &&
+              (imax == -1 || lens[i]/phase[i] > lens[imax]/phase[imax])) imax = i;
+        }
+        if (imax == -1) nrep *= factors[k];
+        else phase[imax] *= factors[k];
+      }
+      if (nfact > 0) cdealloc(factors);
+      std::vector<char> idx(order);
+      std::vector<int> plens;
+      std::string pidx;
+      for (int i=0; i<order; i++){
+        idx[i] = 'a'+i;
+        if (phase[i] > 1){
+          plens.push_back(phase[i]);
+          pidx.push_back(idx[i]);
+        }
+      }
+      if (nrep > 1 || plens.size() == 0){
+        plens.push_back(nrep);
+        pidx.push_back('a'+order);
+      }
+      Partition prl(plens.size(), &plens[0]);
+      distribution old_dist(this);
+      clear_mapping();
+      set_distribution(&idx[0], prl[pidx.c_str()], Idx_Partition());
+      redistribute(old_dist);
+    }
+
+    // each virtual block is stored as [modes before mode][mode][modes after mode], so the inner
+    // fibers starting at consecutive elements of the modes before mode are interleaved
+    int64_t nvirt = calc_nvirt();
+    int64_t bsz   = size/nvirt;
+    int64_t len   = pad_edge_len[mode];
+    ASSERT(len == lens[mode]);
+    int64_t inner = 1;
+    for (int i=0; i<mode; i++){
+      inner *= pad_edge_len[i]/edge_map[i].calc_phase();
+    }
+    int64_t outer  = bsz/(inner*len);
+    int64_t nchunk = (inner+FIBER_GROUP_SIZE-1)/FIBER_GROUP_SIZE;
+    int64_t ngrp   = nvirt*outer*nchunk;
+    int64_t es     = sr->el_size;
+  #ifdef USE_OMP
+    #pragma omp parallel for schedule(dynamic)
+  #endif
+    for (int64_t grp=0; grp<ngrp; grp++){
+      int64_t c = grp%nchunk, bo = grp/nchunk;
+      int64_t nfib = std::min((int64_t)FIBER_GROUP_SIZE, inner-c*FIBER_GROUP_SIZE);
+      f(nfib, inner, data+(bo*len*inner+c*FIBER_GROUP_SIZE)*es);
+    }
+    // fibers in the padding of the other modes may not remain zero
+    zero_out_padding();
+
+    if (home != NULL){
+      align(home);
+      delete home;
+    }
+    if (had_home) reset_home();
+    TAU_FSTOP(transform_fibers);
+    return SUCCESS;
+  }
+
   void tensor::print(FILE * fp, char const * cutoff) const {
     int my_sz;
     int64_t imy_sz, tot_sz =0;
@@ -1871,9 +2149,11 @@ namespace CTF_int {
         }
       } else {
         ASSERT(this->nrow_idx != -1);
-        if (was_mod)
-          despmatricize(this->nrow_idx, this->is_csr);
-        cdealloc(this->rec_tsr->data);
+        if (this->rec_tsr->data != this->csc_data){
+          if (was_mod)
+            despmatricize(this->nrow_idx, this->is_csr);
+          cdealloc(this->rec_tsr->data);
+        } else ASSERT(!was_mod);
       }
       CTF_int::cdealloc(all_edge_len);
       CTF_int::cdealloc(sub_edge_len);
@@ -2001,6 +2281,7 @@ namespace CTF_int {
       copy_mapping(other->order, other->edge_map, 
                    this->edge_map);
       this->data = other->data;
+      this->data_gen = other->data_gen;
       this->is_home = other->is_home;
       ASSERT(this->has_home == other->has_home);
       this->home_buffer = other->home_buffer;
@@ -2032,6 +2313,9 @@ namespace CTF_int {
   #endif
 
     distribution new_dist = distribution(this);
+    // redistribution keeps the values and so the data generation, a CSC layout cached for
+    // the old mapping is kept for a return to it unless memory is short
+    if (this->csc_data != NULL && proc_bytes_available() < this->csc_size) clear_csc();
     if (is_sparse) can_block_shuffle = 0;
     else {
   #ifdef USE_BLOCK_RESHUFFLE
@@ -2048,6 +2332,45 @@ namespace CTF_int {
     if (size > INT_MAX && !is_sparse && wrld->cdt.rank == 0)
       printf("CTF WARNING: Tensor %s is being redistributed to a mapping where its size is %ld, which is greater than INT_MAX=%d, so MPI could run into problems\n", name, size, INT_MAX);
 
+    // dense nonsymmetric tensors may be moved in rounds with bounded extra memory,
+    // always if requested and otherwise when a regular redistribution does not fit
+    if (!is_sparse && !can_block_shuffle && !has_zero_edge_len &&
+        old_offsets == NULL && old_permutation == NULL &&
+        new_offsets == NULL && new_permutation == NULL){
+      bool is_ns = true;
+      for (int i=0; i<order; i++){
+        if (sym[i] != NS) is_ns = false;
+      }
+      int use_bounded = 0;
+      int64_t chunk_bytes = REDIST_CHUNK_BYTES;
+      if (is_ns && CTF::BOUNDED_REDIST_BYTES > 0){
+        use_bounded = 1;
+        chunk_bytes = CTF::BOUNDED_REDIST_BYTES;
+      } else if (is_ns){
+        int64_t reg_mem = (int64_t)(sr->el_size*std::max(size,old_dist.size)*2.5);
+  #ifdef HOME_CONTRACT
+        if (is_home) reg_mem += sr->el_size*old_dist.size;
+  #endif
+        use_bounded = reg_mem >= proc_bytes_available(sr->el_size*std::min(size,old_dist.size));
+        MPI_Allreduce(MPI_IN_PLACE, &use_bounded, 1, MPI_INT, MPI_MAX, wrld->cdt.cm);
+      }
+      if (use_bounded){
+        bool own_old_data = true;
+  #ifdef HOME_CONTRACT
+        // the home buffer is read directly rather than copied and stays intact
+        if (is_home){
+          if (wrld->cdt.rank == 0)
+            DPRINTF(2,"Tensor %s leaving home %d\n", name, is_sparse);
+          own_old_data = false;
+          this->is_home = 0;
+        }
+  #endif
+        if (wrld->cdt.rank == 0)
+          VPRINTF(1,"Remapping tensor %s via bounded-memory reshuffle to mapping\n",this->name);
+        return bounded_redistribute(old_dist, this->data, own_old_data, chunk_bytes);
+      }
+    }
+
   #ifdef HOME_CONTRACT
     if (this->is_home){    
       if (wrld->cdt.rank == 0)
@@ -2059,7 +2382,7 @@ namespace CTF_int {
         }
         this->is_home = 0;
       } else {
-        this->data = (char*)CTF_int::mst_alloc(old_dist.size*sr->el_size);
+        this->data = (char*)CTF_int::data_alloc(old_dist.size*sr->el_size);
         memcpy(this->data, this->home_buffer, old_dist.size*sr->el_size);
         this->is_home = 0;
       }
@@ -2105,7 +2428,11 @@ namespace CTF_int {
         cdealloc(nnz_blk);
         nnz_blk = (int64_t*)alloc(sizeof(int64_t)*calc_nvirt());
         std::fill(nnz_blk, nnz_blk+calc_nvirt(), 0);
+        // writing the pairs would renew the data generation and drop the cached CSC layout
+        tensor csc_hold;
+        csc_hold.take_csc(this);
         this->write(old_nnz, sr->mulid(), sr->addid(), old_data);
+        this->take_csc(&csc_hold);
         //this->set_new_nnz_glb(nnz_blk);
         shuffled_data = this->data;
         cdealloc(old_data);
@@ -2162,6 +2489,118 @@ namespace CTF_int {
   }
 
 
+  int tensor::bounded_redistribute(distribution const & old_dist,
+                                   char *               old_data,
+                                   bool                 own_old_data,
+                                   int64_t              chunk_bytes){
+    TAU_FSTART(bounded_redistribute);
+    // only the first of the processes holding replicas of the old data sends it
+    int idx_lyr = wrld->cdt.rank;
+    int old_nvirt = 1;
+    for (int i=0; i<order; i++){
+      idx_lyr -= old_dist.perank[i]*old_dist.pe_lda[i];
+      old_nvirt *= old_dist.virt_phase[i];
+    }
+    int64_t old_size = idx_lyr == 0 ? old_dist.size : 0;
+    int64_t blk_sz = old_dist.size/old_nvirt;
+
+    int64_t chunk_el = std::max((int64_t)1, chunk_bytes/sr->pair_size());
+    int64_t nround = (old_size+chunk_el-1)/chunk_el;
+    MPI_Allreduce(MPI_IN_PLACE, &nround, 1, MPI_INT64_T, MPI_MAX, wrld->cdt.cm);
+    // the old data we own, the new data, and the pairs are counted as used memory until
+    // they are released, so that the peak of proc_bytes_used() reflects the redistribution
+    int64_t old_bytes = 0;
+    if (own_old_data){
+      old_bytes = sr->el_size*old_size;
+      if (old_size == 0){
+        CTF_int::cdealloc(old_data);
+        old_data = NULL;
+      }
+    }
+
+    int64_t new_bytes = sr->el_size*this->size;
+    int64_t pair_bytes = sr->pair_size()*std::min(chunk_el, std::max(old_size,(int64_t)1));
+    inc_tot_mem_used(old_bytes+new_bytes+pair_bytes);
+    this->data = (char*)CTF_int::data_alloc(new_bytes);
+    if (sr->addid() != NULL)
+      sr->set(this->data, sr->addid(), this->size);
+
+    int * loc_len, * idx, * virt_idx;
+    int64_t * lda;
+    CTF_int::alloc_ptr(order*sizeof(int), (void**)&loc_len);
+    CTF_int::alloc_ptr(order*sizeof(int), (void**)&idx);
+    CTF_int::alloc_ptr(order*sizeof(int), (void**)&virt_idx);
+    CTF_int::alloc_ptr(order*sizeof(int64_t), (void**)&lda);
+    for (int i=0; i<order; i++){
+      loc_len[i] = old_dist.pad_edge_len[i]/old_dist.phase[i];
+      lda[i] = i == 0 ? 1 : lda[i-1]*lens[i-1];
+    }
+
+    char * pairs = (char*)CTF_int::alloc(pair_bytes);
+    int64_t en = old_size;
+    for (int64_t r=0; r<nround; r++){
+      // rounds consume the old data from its end so that it may be shrunk in place
+      int64_t st = std::max((int64_t)0, en-chunk_el);
+      int64_t npair = 0;
+      if (st < en){
+        int64_t blk = st/blk_sz;
+        int64_t off = st%blk_sz;
+        for (int i=0; i<order; i++){
+          virt_idx[i] = blk%old_dist.virt_phase[i];
+          blk = blk/old_dist.virt_phase[i];
+          idx[i] = off%loc_len[i];
+          off = off/loc_len[i];
+        }
+        for (int64_t p=st; p<en; p++){
+          int64_t key = 0;
+          bool is_pad = false;
+          for (int i=0; i<order; i++){
+            int gidx = idx[i]*old_dist.phase[i] + old_dist.perank[i] + virt_idx[i]*old_dist.phys_phase[i];
+            if (gidx >= lens[i]) is_pad = true;
+            key += gidx*lda[i];
+          }
+          if (!is_pad){
+            sr->set_pair(pairs+npair*sr->pair_size(), key, old_data+p*sr->el_size);
+            npair++;
+          }
+          for (int i=0; i<order; i++){
+            idx[i]++;
+            if (idx[i] < loc_len[i]) break;
+            idx[i] = 0;
+            if (i == order-1){
+              for (int j=0; j<order; j++){
+                virt_idx[j]++;
+                if (virt_idx[j] < old_dist.virt_phase[j]) break;
+                virt_idx[j] = 0;
+              }
+            }
+          }
+        }
+        if (own_old_data){
+          if (st == 0){
+            CTF_int::cdealloc(old_data);
+            old_data = NULL;
+          } else
+            old_data = (char*)CTF_int::cshrink(old_data, sr->el_size*st);
+          inc_tot_mem_used(-sr->el_size*(en-st));
+          old_bytes -= sr->el_size*(en-st);
+        }
+        en = st;
+      }
+      // writes are collective, so processes that have sent all their data still take part
+      this->write(npair, NULL, NULL, pairs);
+    }
+    if (own_old_data && old_data != NULL) CTF_int::cdealloc(old_data);
+    CTF_int::cdealloc(pairs);
+    inc_tot_mem_used(-(old_bytes+new_bytes+pair_bytes));
+    CTF_int::cdealloc(loc_len);
+    CTF_int::cdealloc(idx);
+    CTF_int::cdealloc(virt_idx);
+    CTF_int::cdealloc(lda);
+    TAU_FSTOP(bounded_redistribute);
+    return SUCCESS;
+  }
+
   double tensor::est_redist_time(distribution const & old_dist, double nnz_frac){
     int nvirt = (int64_t)calc_nvirt();
     bool can_blres;
@@ -2208,8 +2647,16 @@ namespace CTF_int {
     else {
       if (is_sparse)
         return (int64_t)this->sr->pair_size()*std::max(this->size,old_dist.size)*nnz_frac*3;
-      else
-        return (int64_t)this->sr->el_size*std::max(this->size,old_dist.size)*nnz_frac*2.5;
+      else {
+        int64_t reg_mem = (int64_t)this->sr->el_size*std::max(this->size,old_dist.size)*nnz_frac*2.5;
+        for (int i=0; i<order; i++){
+          if (sym[i] != NS) return reg_mem;
+        }
+        // a bounded-memory redistribution needs the new layout and one round of pairs
+        int64_t chunk_bytes = CTF::BOUNDED_REDIST_BYTES > 0 ? CTF::BOUNDED_REDIST_BYTES : REDIST_CHUNK_BYTES;
+        int64_t bnd_mem = (int64_t)this->sr->el_size*this->size*nnz_frac + 3*chunk_bytes;
+        return std::min(reg_mem, bnd_mem);
+      }
     }
   }
 
@@ -2377,6 +2824,24 @@ namespace CTF_int {
   }
                                      
 
+  bool tensor::is_replica_root() const {
+    if (!is_mapped) return wrld->rank == 0;
+    bool is_root = true;
+    for (int i=0; i<topo->order; i++){
+      bool is_phys_mapped = false;
+      for (int j=0; j<order; j++){
+        mapping const * map = edge_map+j;
+        while (map->type == PHYSICAL_MAP){
+          if (map->cdt == i) is_phys_mapped = true;
+          if (map->has_child) map = map->child;
+          else break;
+        }
+      }
+      if (!is_phys_mapped && topo->dim_comm[i].rank != 0) is_root = false;
+    }
+    return is_root;
+  }
+
   int tensor::zero_out_padding(){
     int i, num_virt, idx_lyr;
     int64_t np;
@@ -2491,6 +2956,7 @@ namespace CTF_int {
 
   void tensor::addinv(){
     if (is_sparse){
+      data_modified();
       PairIterator pi(sr,data);
 #ifdef USE_OMP
       #pragma omp parallel for
@@ -2525,6 +2991,7 @@ namespace CTF_int {
 
   void tensor::set_new_nnz_glb(int64_t const * nnz_blk_){
     if (is_sparse){
+      data_modified();
       nnz_loc = 0;
       for (int i=0; i<calc_nvirt(); i++){
         nnz_blk[i] = nnz_blk_[i];
@@ -2597,6 +3064,103 @@ namespace CTF_int {
 #endif
   }
 
+  void tensor::spmatricize_csc(int m, int n, int nrow_idx){
+    ASSERT(is_sparse);
+    int nvirt_A = calc_nvirt();
+    int phase[this->order];
+    for (int i=0; i<this->order; i++){
+      phase[i] = this->edge_map[i].calc_phase();
+    }
+    std::vector<int64_t> key;
+    key.push_back(this->data_gen);
+    key.push_back(this->nnz_loc);
+    key.push_back(m);
+    key.push_back(n);
+    key.push_back(nrow_idx);
+    key.push_back((int64_t)this->topo);
+    for (int i=0; i<this->order; i++){
+      key.push_back(phase[i]);
+      key.push_back(this->edge_map[i].calc_phys_rank(this->topo));
+      key.push_back(this->inner_ordering[i]);
+    }
+    if (this->csc_data == NULL || key != this->csc_key){
+      clear_csc();
+      TAU_FSTART(sparse_transpose_csc);
+      this->csc_blk = (int64_t*)alloc(nvirt_A*sizeof(int64_t));
+      int64_t new_sz_A = 0;
+      for (int i=0; i<nvirt_A; i++){
+        this->csc_blk[i] = get_csr_size(this->nnz_blk[i], n, this->sr->el_size); 
+        new_sz_A += this->csc_blk[i];
+      }
+      this->csc_data = (char*)alloc(new_sz_A);
+      this->csc_size = new_sz_A;
+      inc_tot_mem_used(this->csc_size);
+      char * data_ptr_out = this->csc_data;
+      char const * data_ptr_in = this->data;
+      for (int i=0; i<nvirt_A; i++){
+        COO_Matrix cm(this->nnz_blk[i], this->sr);
+        cm.set_data(this->nnz_blk[i], this->order, this->lens, this->inner_ordering, nrow_idx, data_ptr_in, this->sr, phase);
+        // the CSR layout of the transpose is built from the COO layout with rows and columns exchanged
+        std::swap_ranges(cm.rows(), cm.rows()+this->nnz_blk[i], cm.cols());
+        CSR_Matrix cs(cm, n, m, this->sr, data_ptr_out);
+        cdealloc(cm.all_data);
+        data_ptr_in += this->nnz_blk[i]*this->sr->pair_size();
+        data_ptr_out += this->csc_blk[i];
+      }
+      this->csc_key = key;
+      TAU_FSTOP(sparse_transpose_csc);
+    }
+    this->rec_tsr->is_sparse = 1;
+    this->rec_tsr->nnz_blk = (int64_t*)alloc(nvirt_A*sizeof(int64_t));
+    memcpy(this->rec_tsr->nnz_blk, this->csc_blk, nvirt_A*sizeof(int64_t));
+    this->rec_tsr->data = this->csc_data;
+    this->rec_tsr->is_data_aliased = true;
+    this->is_csr = true;
+    this->nrow_idx = nrow_idx;
+  }
+
+  void tensor::clear_csc(){
+    if (this->csc_data != NULL){
+      cdealloc(this->csc_data);
+      cdealloc(this->csc_blk);
+      inc_tot_mem_used(-this->csc_size);
+      this->csc_data = NULL;
+      this->csc_blk = NULL;
+      this->csc_size = 0;
+      this->csc_key.clear();
+    }
+  }
+
+  bool tensor::has_csc() const {
+    if (this->csc_data == NULL) return false;
+    // matrix dimensions (key entries 2-4) are not known before the contraction is mapped
+    if (this->csc_key[0] != this->data_gen || this->csc_key[1] != this->nnz_loc ||
+        this->csc_key[5] != (int64_t)this->topo) return false;
+    for (int i=0; i<this->order; i++){
+      if (this->csc_key[6+3*i] != this->edge_map[i].calc_phase() ||
+          this->csc_key[7+3*i] != this->edge_map[i].calc_phys_rank(this->topo)) return false;
+    }
+    return true;
+  }
+
+  void tensor::data_modified(){
+    this->data_gen = ++data_gen_ctr;
+    clear_csc();
+  }
+
+  void tensor::take_csc(tensor * other){
+    clear_csc();
+    this->data_gen = other->data_gen;
+    this->csc_data = other->csc_data;
+    this->csc_blk = other->csc_blk;
+    this->csc_size = other->csc_size;
+    this->csc_key.swap(other->csc_key);
+    other->csc_data = NULL;
+    other->csc_blk = NULL;
+    other->csc_size = 0;
+    other->csc_key.clear();
+  }
+
   void tensor::despmatricize(int nrow_idx, bool csr){
     ASSERT(is_sparse);
 
@@ -2685,6 +3249,21 @@ namespace CTF_int {
 #endif    
   }
 
+  void tensor::reset_home(){
+#ifdef HOME_CONTRACT
+    if (is_sparse || order == 0 || !is_mapped) return;
+    if (has_home && is_home) return;
+    if (is_folded) unfold();
+    if (has_home) cdealloc(home_buffer);
+    if (wrld->rank == 0) DPRINTF(2,"Resetting home of %s\n",name);
+    home_size   = size;
+    home_buffer = data;
+    is_home     = 1;
+    has_home    = 1;
+    register_size(size*sr->el_size);
+#endif
+  }
+
   void tensor::register_size(int64_t sz){
     deregister_size();
     registered_alloc_size = sz;
@@ -82,6 +82,8 @@ namespace CTF_int {
       int * padding;
       /** \brief name given to tensor */
       char * name;
+      /** \brief number of tensors created on wrld before this one, the same on each rank */
+      int64_t wrld_tsr_id;
       /** \brief whether tensor data has additional padding */
       int is_scp_padded;
       /** \brief additional padding, may be greater than ScaLAPACK phase */
@@ -137,6 +139,16 @@ namespace CTF_int {
       int64_t nnz_tot;
       /** \brief nonzero elements in each block owned locally */
       int64_t * nnz_blk;
+      /** \brief cached CSC layout of each local block of a sparse tensor, built by spmatricize_csc */
+      char * csc_data;
+      /** \brief sizes in bytes of each block of csc_data */
+      int64_t * csc_blk;
+      /** \brief size in bytes of csc_data, counted as used memory while it is cached */
+      int64_t csc_size;
+      /** \brief data generation, nonzero count, matrix dimensions, and mapping for which csc_data was built */
+      std::vector<int64_t> csc_key;
+      /** \brief generation of the data, renewed by data_modified() with a value unique in the process */
+      int64_t data_gen;
       
       /**
        * \brief associated an index map with the tensor for future operation
@@ -262,6 +274,12 @@ namespace CTF_int {
        */
       int zero_out_padding();
 
+      /**
+       * \brief whether this process holds the representative copy of its local data, i.e. has
+       *        rank zero along every processor grid dimension the tensor is replicated over
+       */
+      bool is_replica_root() const;
+
       /**
        * \brief scales each element by 1/(number of entries equivalent to it after permutation of indices for which sym_mask is 1)
        * \param[in] sym_mask identifies which tensor indices are part of the symmetric group which diagonals we want to scale (i.e. sym_mask [1,1] does A["ii"]= (1./2.)*A["ii"])
@@ -278,6 +296,13 @@ namespace CTF_int {
        */
       void print_map(FILE * stream=stdout, bool allcall=1) const;
 
+      /**
+       * \brief string describing how each dimension is mapped, as displayed by print_map,
+       *        e.g. [p2(0),v2] for a matrix whose rows are cyclic over dimension 0 of a
+       *        topology of 2 processes and whose columns are in 2 virtual blocks
+       */
+      std::string get_map_str() const;
+
       /**
        * \brief set the tensor name 
        * \param[in] name to set
@@ -458,6 +483,17 @@ namespace CTF_int {
       int read_local_nnz(int64_t * num_pair,
                          char **   mapped_data) const;
 
+      /**
+       * \brief gives the global index and the offset in data of every element of a dense tensor
+       *        stored on this processor, padding excluded, but including replicated copies
+       * \param[out] num_pair number of local elements
+       * \param[out] keys global indices, allocated with alloc (NULL if there are none)
+       * \param[out] offsets offsets into data in units of elements, allocated with alloc
+       */
+      void read_local_offsets(int64_t *  num_pair,
+                              int64_t ** keys,
+                              int64_t ** offsets) const;
+
       /** 
        * brief copy A into this (B). Realloc if necessary 
        * param[in] A tensor to copy
@@ -506,6 +542,31 @@ namespace CTF_int {
        */
       int reduce_sumsq(char * result);
 
+      /**
+       * \brief replaces the elements of a dense tensor by their prefix sums along one mode,
+       *        a local scan over the cyclic slice of the mode held by each process is combined
+       *        with an exclusive scan and a sum of the per-process partials over the processor
+       *        grid dimension(s) the mode is mapped to, so moving about one local data size
+       * \param[in] mode mode to scan along, which may not be in a symmetric group
+       * \param[in] sr_other an algebraic structure (at least a monoid) defining the summation operation
+       * \param[in] exclusive if true element i becomes the sum of elements 0 to i-1, otherwise 0 to i
+       */
+      int scan(int mode, algstrct const * sr_other, bool exclusive);
+
+      /**
+       * \brief applies f to every fiber of a dense nonsymmetric tensor along one mode, after
+       *        redistributing the tensor so that the mode is not distributed, with the other modes
+       *        spread over as many processes as their lengths allow and the rest replicated
+       * \param[in] mode mode along which the fibers lie
+       * \param[in] f called concurrently on groups of nfib fibers of length lens[mode],
+       *              element j of fiber i being at (i+j*ld)*el_size from the pointer given
+       * \param[in] restore_layout if true the tensor is mapped back to its previous distribution,
+       *                           otherwise it keeps the one in which the mode is local
+       */
+      int transform_fibers(int                                              mode,
+                           std::function<void(int64_t, int64_t, char*)> const & f,
+                           bool                                             restore_layout);
+
       /* map data of tid_A with the given function */
 /*      int map_tensor(int tid,
                      dtype (*map_func)(int order, 
@@ -632,6 +693,21 @@ namespace CTF_int {
                        int const *  new_offsets = NULL,
                        int * const * new_permutation = NULL);
 
+      /**
+       * \brief permutes the data of a dense nonsymmetric tensor to its new layout in rounds,
+       *        each of which sends at most chunk_bytes of key-value pairs, the old data is
+       *        consumed from its end and shrunk after every round, so that the extra memory
+       *        needed is that of the new layout and one round of pairs
+       * \param[in] old_dist previous distribution to remap data from
+       * \param[in] old_data data in the previous distribution
+       * \param[in] own_old_data whether old_data may be shrunk and freed (false if it is the home buffer)
+       * \param[in] chunk_bytes bytes of pairs to send per round
+       */
+      int bounded_redistribute(distribution const & old_dist,
+                               char *               old_data,
+                               bool                 own_old_data,
+                               int64_t              chunk_bytes);
+
       double est_redist_time(distribution const & old_dist, double nnz_frac);
   
       int64_t get_redist_mem(distribution const & old_dist, double nnz_frac);
@@ -686,10 +762,47 @@ namespace CTF_int {
        */
       void despmatricize(int nrow_idx, bool csr);
 
+      /**
+       * \brief makes the folded data the CSR layout of the transpose (CSC layout) of the matrix spmatricize would make,
+       *        which is kept with the tensor and reused by later calls until the tensor data or mapping changes
+       * \param[in] m number of rows in matrix
+       * \param[in] n number of columns in matrix
+       * \param[in] nrow_idx number of indices to fold into column
+       */
+      void spmatricize_csc(int m, int n, int nrow_idx);
+
+      /**
+       * \brief discards the cached CSC layout of the tensor data
+       */
+      void clear_csc();
+
+      /**
+       * \brief whether a CSC layout is cached for the current data and mapping of the tensor
+       */
+      bool has_csc() const;
+
+      /**
+       * \brief renews the generation of the data and discards layouts cached for the previous data,
+       *        to be called whenever the data is modified
+       */
+      void data_modified();
+
+      /**
+       * \brief moves the cached CSC layout and data generation of another tensor with the same data to this tensor
+       * \param[in,out] other tensor whose cached CSC layout is taken
+       */
+      void take_csc(tensor * other);
+
       /**
        * \brief degister home buffer 
        */
       void leave_home_with_buffer();
+
+      /**
+       * \brief makes the current mapping and buffer the home of a dense tensor,
+       *        undoing leave_home_with_buffer() after the tensor has been remapped
+       */
+      void reset_home();
     
       /**
         * \brief register buffer allocation for this tensor
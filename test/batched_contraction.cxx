@@ -0,0 +1,151 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup batched_contraction batched_contraction
+  * @{
+  * \brief tests batches of small contractions against contractions done one at a time
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int batched_contraction(int     n,
+                        World & dw){
+
+  int nb = 7;
+  int pass = 1;
+  srand48(dw.rank*13+1);
+
+  // matrix products, more of them than processes for small runs
+  {
+    std::vector< Matrix<> * > A(nb), B(nb), C(nb);
+    Batched_Contraction<> bc("ik", "kj", "ij", dw);
+    for (int b=0; b<nb; b++){
+      A[b] = new Matrix<>(n, n+1, dw);
+      B[b] = new Matrix<>(n+1, n+2, dw);
+      C[b] = new Matrix<>(n, n+2, dw);
+      A[b]->fill_random(-1., 1.);
+      B[b]->fill_random(-1., 1.);
+      C[b]->fill_random(-1., 1.);
+      bc.add(*A[b], *B[b], *C[b]);
+    }
+    bc.execute();
+    for (int b=0; b<nb; b++){
+      (*C[b])["ij"] -= (*A[b])["ik"]*(*B[b])["kj"];
+      if (C[b]->norm2() >= 1.E-6) pass = 0;
+      delete A[b];
+      delete B[b];
+      delete C[b];
+    }
+  }
+
+  // transposed operands, an index present in all three tensors, and accumulation
+  {
+    int lens_A[] = {n, n+1, n+2};
+    int lens_B[] = {n+2, n+3, n+1};
+    int lens_C[] = {n+3, n+1, n};
+    int shapeN3[] = {NS,NS,NS};
+    std::vector< Tensor<> * > A(nb), B(nb), C(nb), C_ref(nb);
+    Batched_Contraction<> bc("iak", "kja", "jai", dw);
+    for (int b=0; b<nb; b++){
+      A[b] = new Tensor<>(3, lens_A, shapeN3, dw);
+      B[b] = new Tensor<>(3, lens_B, shapeN3, dw);
+      C[b] = new Tensor<>(3, lens_C, shapeN3, dw);
+      A[b]->fill_random(-1., 1.);
+      B[b]->fill_random(-1., 1.);
+      C[b]->fill_random(-1., 1.);
+      C_ref[b] = new Tensor<>(*C[b]);
+      bc.add(*A[b], *B[b], *C[b], 2., .5);
+    }
+    bc.execute();
+    for (int b=0; b<nb; b++){
+      (*C_ref[b])["jai"] = .5*(*C_ref[b])["jai"] + 2.*(*A[b])["iak"]*(*B[b])["kja"];
+      (*C[b])["jai"] -= (*C_ref[b])["jai"];
+      if (C[b]->norm2() >= 1.E-6) pass = 0;
+      delete A[b];
+      delete B[b];
+      delete C[b];
+      delete C_ref[b];
+    }
+  }
+
+  // symmetric operands are contracted one at a time
+  {
+    Matrix<> S(n, n, SY, dw);
+    Matrix<> B(n, n, dw);
+    Matrix<> C1(n, n, dw);
+    Matrix<> C2(n, n, dw);
+    S.fill_random(-1., 1.);
+    B.fill_random(-1., 1.);
+    Batched_Contraction<> bc("ik", "kj", "ij", dw);
+    bc.add(S, B, C1);
+    bc.add(B, S, C2);
+    bc.execute();
+    C1["ij"] -= S["ik"]*B["kj"];
+    C2["ij"] -= B["ik"]*S["kj"];
+    if (C1.norm2() >= 1.E-6 || C2.norm2() >= 1.E-6) pass = 0;
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ batches of small contractions } passed\n");
+    } else {
+      printf("{ batches of small contractions } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 6;
+  } else n = 6;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Contracting batches of small tensors\n");
+    }
+    batched_contraction(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,142 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup bounded_redist bounded_redist
+  * @{
+  * \brief tests redistribution of a dense tensor in rounds with bounded memory against a regular redistribution,
+  *        and that its peak memory use exceeds the old and new local data by at most BOUNDED_REDIST_BYTES
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int bounded_redist(int     n,
+                   World & dw){
+
+  int shapeN3[] = {NS,NS,NS};
+  int sizeN3[]  = {n+1,n,n+3};
+
+  Tensor<> A(3, sizeN3, shapeN3, dw);
+  srand48(dw.rank*3+1);
+  A.fill_random(-.5, .5);
+
+  int np = dw.np;
+  int two = 2;
+  Partition pe_line(1, &np);
+  Partition blk(1, &two);
+
+  int64_t old_bytes = CTF::BOUNDED_REDIST_BYTES;
+  int pass = 1;
+  // the local data in a layout with k distributed and i blocked, read regularly
+  // and then in rounds of a few pairs, each of which gets split among the processes
+  CTF::BOUNDED_REDIST_BYTES = 0;
+  double * reg_data = A.read("ijk", pe_line["k"], blk["i"]);
+  CTF::BOUNDED_REDIST_BYTES = 7*(sizeof(int64_t)+sizeof(double));
+  double * bnd_data = A.read("ijk", pe_line["k"], blk["i"]);
+
+  Tensor<> B(3, sizeN3, shapeN3, dw, "ijk", pe_line["k"], blk["i"]);
+  for (int64_t i=0; i<B.size; i++){
+    if (fabs(reg_data[i]-bnd_data[i]) >= 1.E-10) pass = 0;
+  }
+
+  // moving the data back to a default mapping and transposing also take the bounded path
+  int64_t npair;
+  int64_t * inds;
+  double * vals;
+  A.read_local(&npair, &inds, &vals);
+  B.write(npair, inds, vals);
+  free(inds);
+  free(vals);
+  Tensor<> C(3, sizeN3, shapeN3, dw);
+  Tensor<> C2(3, sizeN3, shapeN3, dw);
+  int sizeT3[] = {n+3,n+1,n};
+  Tensor<> CT(3, sizeT3, shapeN3, dw);
+
+  // the first summation moves no data, so its peak is the memory held by the tensors, beyond which
+  // the bounded redistribution of the second only holds the old and new local data and one round of pairs
+  int64_t max_size = std::max(B.size, C.size);
+  CTF::clear_op_stats();
+  CTF::set_op_stats(true);
+  C2["ijk"] = C["ijk"];
+  C["ijk"] = B["ijk"];
+  CTF::set_op_stats(false);
+  max_size = std::max(max_size, std::max(B.size, C.size));
+  std::vector<Op_stats> const & st = CTF::get_op_stats();
+  if (st.size() != 2 ||
+      st[1].mem_peak - st[0].mem_peak > (int64_t)(2*sizeof(double)*max_size) + CTF::BOUNDED_REDIST_BYTES)
+    pass = 0;
+  CTF::clear_op_stats();
+
+  CT["kij"] = C["ijk"];
+  C["ijk"] = CT["kij"];
+  CTF::BOUNDED_REDIST_BYTES = old_bytes;
+
+  C["ijk"] -= A["ijk"];
+  if (C.norm2() >= 1.E-6) pass = 0;
+
+  CTF_int::cdealloc(reg_data);
+  CTF_int::cdealloc(bnd_data);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ bounded-memory redistribution equals regular redistribution } passed\n");
+    } else {
+      printf("{ bounded-memory redistribution equals regular redistribution } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Redistributing an order 3 tensor with bounded memory\n");
+    }
+    bounded_redist(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
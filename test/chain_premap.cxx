@@ -0,0 +1,104 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup chain_premap chain_premap
+  * @{
+  * \brief tests that the last intermediate of a chain of contractions is produced in the mapping of the contraction consuming it, so that it is never redistributed
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int chain_premap(int     n,
+                 World & dw){
+  // a tall intermediate B*C, which the final contraction distributes over its rows
+  int m = 32*(n+8);
+  Matrix<> A(4, m, NS, dw, "A");
+  Matrix<> B(m, 4, NS, dw, "B");
+  Matrix<> C(4, n+2, NS, dw, "C");
+  Matrix<> D(4, n+2, NS, dw, "D");
+  Matrix<> T(m, n+2, NS, dw, "T");
+  Matrix<> D_ref(4, n+2, NS, dw, "D_ref");
+  srand48(dw.rank*7+3);
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  C.fill_random(-1., 1.);
+
+  int pass = 1;
+  CTF::clear_op_stats();
+  CTF::set_op_stats(true);
+  D["ij"] = A["ik"]*B["kl"]*C["lj"];
+  CTF::set_op_stats(false);
+
+  // the intermediate is the output of the first contraction and the right operand of the second
+  std::vector<Op_stats> const & st = CTF::get_op_stats();
+  if (st.size() != 2) pass = 0;
+  else {
+    if (st[0].redist_bytes_C != 0 || st[1].redist_bytes_B != 0) pass = 0;
+    if (st[0].map_C != st[1].map_B) pass = 0;
+  }
+  CTF::clear_op_stats();
+
+  T["kj"] = B["kl"]*C["lj"];
+  D_ref["ij"] = A["ik"]*T["kj"];
+  D["ij"] -= D_ref["ij"];
+  if (D.norm2() >= 1.E-6) pass = 0;
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ last intermediate of a contraction chain is not redistributed } passed\n");
+    } else {
+      printf("{ last intermediate of a contraction chain is not redistributed } failed\n");
+    }
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 8;
+  } else n = 8;
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Contracting a chain of three matrices with n = %d\n",n);
+    }
+    chain_premap(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
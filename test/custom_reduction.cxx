@@ -0,0 +1,107 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup custom_reduction custom_reduction
+  * @{
+  * \brief tests reductions and allreductions of buffers larger than PIPE_RED_MIN_SZ over a monoid
+  *        with a user-defined MPI operator, which are done by the pipelined ring reduce-scatter
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int64_t cred_add(int64_t a, int64_t b){
+  return a+b;
+}
+
+void mpi_cred_add(void * a, void * b, int * len, MPI_Datatype * d){
+  for (int i=0; i<*len; i++){
+    ((int64_t*)b)[i] = cred_add(((int64_t*)a)[i], ((int64_t*)b)[i]);
+  }
+}
+
+int custom_reduction(int     n,
+                     World & dw){
+  MPI_Op mop;
+  MPI_Op_create(&mpi_cred_add, 1, &mop);
+  Monoid<int64_t> m(0, &cred_add, mop);
+
+  // well above PIPE_RED_MIN_SZ bytes and not a multiple of the number of processes or of chunks
+  int64_t cnt = (1<<18) + 13*n;
+  int64_t * buf = (int64_t*)malloc(sizeof(int64_t)*cnt);
+  int64_t np = dw.np;
+
+  int pass = 1;
+  for (int root=0; root<2; root++){
+    for (int64_t i=0; i<cnt; i++){
+      buf[i] = (dw.rank+1)*i + dw.rank;
+    }
+    if (root == 0) dw.cdt.allred(buf, cnt, &m);
+    else dw.cdt.red(buf, cnt, &m, np-1);
+    if (root == 0 || dw.rank == np-1){
+      for (int64_t i=0; i<cnt; i++){
+        if (buf[i] != i*(np*(np+1)/2) + np*(np-1)/2) pass = 0;
+      }
+    }
+  }
+  free(buf);
+  MPI_Op_free(&mop);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ reductions with a user-defined MPI operator are correct } passed\n");
+    } else {
+      printf("{ reductions with a user-defined MPI operator are correct } failed\n");
+    }
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Reducing buffers with a user-defined MPI operator with n = %d\n",n);
+    }
+    custom_reduction(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,122 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup expr_terms expr_terms
+  * @{
+  * \brief tests expressions on order 10 tensors and chains of more than two scaled operands
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int expr_terms(int     n,
+               World & dw){
+
+  int lens10[]   = {2,2,2,2,2,2,2,2,2,2};
+  int shapeN10[] = {NS,NS,NS,NS,NS,NS,NS,NS,NS,NS};
+
+  srand48(dw.rank*7+3);
+  int pass = 1;
+
+  // index strings longer than the inline index storage of a term
+  Tensor<> A(10, lens10, shapeN10, dw);
+  Tensor<> B(10, lens10, shapeN10, dw);
+  Tensor<> A2(10, lens10, shapeN10, dw);
+  A.fill_random(-1., 1.);
+  B["abcdefghij"] = A["jihgfedcba"];
+  A2["jihgfedcba"] = 2.*B["abcdefghij"];
+  A2["abcdefghij"] -= 2.*A["abcdefghij"];
+  if (A2.norm2() >= 1.E-6) pass = 0;
+
+  Matrix<> M(2, 2, dw);
+  M["ak"] = A["abcdefghij"]*A["kbcdefghij"];
+  double nrm = A.norm2();
+  Scalar<> tr(dw);
+  tr[""] = M["aa"];
+  if (fabs(tr.get_val() - nrm*nrm) >= 1.E-6*nrm*nrm) pass = 0;
+
+  // a chain of more than two operands, with scaling factors on each
+  Matrix<> P(n, n+1, dw);
+  Matrix<> Q(n+1, n+2, dw);
+  Matrix<> R(n+2, n, dw);
+  P.fill_random(-1., 1.);
+  Q.fill_random(-1., 1.);
+  R.fill_random(-1., 1.);
+  Matrix<> C(n, n, dw);
+  Matrix<> PQ(n, n+2, dw);
+  C["ij"] = (2.*P["ik"])*Q["kl"]*(.5*R["lj"]);
+  PQ["il"] = P["ik"]*Q["kl"];
+  C["ij"] -= PQ["il"]*R["lj"];
+  if (C.norm2() >= 1.E-6) pass = 0;
+
+  // sums of more operands than a term stores inline
+  Matrix<> S(n, n+1, dw);
+  Matrix<> T(n, n+1, dw);
+  T.fill_random(-1., 1.);
+  S["ij"] = P["ij"]+T["ij"]+2.*P["ij"]+.5*T["ij"]+P["ij"]-T["ij"];
+  S["ij"] -= 4.*P["ij"]+.5*T["ij"];
+  if (S.norm2() >= 1.E-6) pass = 0;
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ expressions with long index strings and operand chains } passed\n");
+    } else {
+      printf("{ expressions with long index strings and operand chains } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 6;
+  } else n = 6;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Evaluating expressions with long index strings and operand chains\n");
+    }
+    expr_terms(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,194 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup fused_reduction fused_reduction
+  * @{
+  * \brief tests several norms and dot products computed with one collective against individual reductions
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int fused_reduction(int     n,
+                    World & dw){
+
+  int shapeN4[] = {NS,NS,NS,NS};
+  int sizeN4[]  = {n+1,n,n+2,n+3};
+
+  Tensor<> A(4, sizeN4, shapeN4, dw);
+  Tensor<> B(4, sizeN4, shapeN4, dw);
+  Matrix<> S(n, n, SY, dw);
+  Matrix<> M(2, 3, dw);
+
+  srand48(dw.rank*3+1);
+  A.fill_random(-.5, .5);
+  B.fill_random(-.5, .5);
+  S.fill_random(-.5, .5);
+  M.fill_random(-.5, .5);
+
+  // a copy of B transposed back so that its mapping likely differs from that of A
+  int sizeT4[] = {n+3,n+2,n,n+1};
+  Tensor<> BT(4, sizeT4, shapeN4, dw);
+  BT["lkji"] = B["ijkl"];
+  Tensor<> C(4, sizeN4, shapeN4, dw);
+  C["ijkl"] = BT["lkji"];
+
+  Fused_Reduction<> fr(dw);
+  int ia1 = fr.norm1(A);
+  int ia2 = fr.norm2(A);
+  int iai = fr.norm_infty(A);
+  int ias = fr.sum(A);
+  int iab = fr.dot(A, B);
+  int iac = fr.dot(A, C);
+  int is2 = fr.norm2(S);
+  int iss = fr.dot(S, S);
+  int im2 = fr.norm2(M);
+  int imi = fr.norm_infty(M);
+  fr.execute();
+
+  Scalar<> sab(dw), sss(dw);
+  sab[""] = A["ijkl"]*B["ijkl"];
+  sss[""] = S["ij"]*S["ij"];
+
+  int pass = 1;
+  if (fabs(fr[ia1]-A.norm1()) >= 1.E-6) pass = 0;
+  if (fabs(fr[ia2]-A.norm2()) >= 1.E-6) pass = 0;
+  if (fabs(fr[iai]-A.norm_infty()) >= 1.E-6) pass = 0;
+  if (fabs(fr[ias]-A.reduce(OP_SUM)) >= 1.E-6) pass = 0;
+  if (fabs(fr[iab]-sab.get_val()) >= 1.E-6) pass = 0;
+  if (fabs(fr[iac]-sab.get_val()) >= 1.E-6) pass = 0;
+  if (fabs(fr[is2]-S.norm2()) >= 1.E-6) pass = 0;
+  if (fabs(fr[iss]-sss.get_val()) >= 1.E-6) pass = 0;
+  if (fabs(fr[im2]-M.norm2()) >= 1.E-6) pass = 0;
+  if (fabs(fr[imi]-M.norm_infty()) >= 1.E-6) pass = 0;
+
+  // complex norms sum squared moduli, for dense data and for the general routines on sparse data
+  {
+    typedef std::complex<double> cdouble;
+    Matrix<cdouble> Z(n+1, n+2, dw, "Z");
+    Vector<cdouble> Zs(n*n, SP, dw, "Zs");
+    int64_t nz = dw.rank == 0 ? (n+1)*(n+2) : 0;
+    std::vector<int64_t> inds(nz);
+    std::vector<cdouble> vals(nz);
+    double nrm2 = 0.;
+    for (int64_t i=0; i<(n+1)*(n+2); i++){
+      cdouble z(.1*(i%7)-.3, .2*(i%5)-.4);
+      nrm2 += std::norm(z);
+      if (i < nz){
+        inds[i] = i;
+        vals[i] = z;
+      }
+    }
+    Z.write(nz, inds.data(), vals.data());
+    int64_t nzs = dw.rank == 0 ? n : 0;
+    double nrm2s = 0.;
+    for (int64_t i=0; i<n; i++){
+      cdouble z(-.5*i, 1.);
+      nrm2s += std::norm(z);
+      if (i < nzs){
+        inds[i] = i*n;
+        vals[i] = z;
+      }
+    }
+    Zs.write(nzs, inds.data(), vals.data());
+
+    Fused_Reduction<cdouble> frz(dw);
+    int iz2 = frz.norm2(Z);
+    int izs2 = frz.norm2(Zs);
+    frz.execute();
+    if (std::abs(frz[iz2]-sqrt(nrm2)) >= 1.E-6) pass = 0;
+    if (std::abs(frz[izs2]-sqrt(nrm2s)) >= 1.E-6) pass = 0;
+  }
+
+  // over a max-plus semiring, sums and dot products use its operators rather than those of double
+  {
+    Semiring<double> mp(-INFINITY, [](double a, double b){ return std::max(a,b); }, MPI_MAX,
+                        0., [](double a, double b){ return a+b; });
+    Tensor<> T(4, sizeN4, shapeN4, dw, mp);
+    T["ijkl"] = A["ijkl"];
+    Scalar<> stt(dw, mp);
+    stt[""] = T["ijkl"]*T["ijkl"];
+
+    int64_t npt, * it;
+    double * vt;
+    T.read_local(&npt, &it, &vt);
+    double tmax = -INFINITY;
+    for (int64_t i=0; i<npt; i++){
+      tmax = std::max(tmax, vt[i]);
+    }
+    free(it);
+    free(vt);
+    MPI_Allreduce(MPI_IN_PLACE, &tmax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+    Fused_Reduction<> frt(dw);
+    int its = frt.sum(T);
+    int itt = frt.dot(T, T);
+    frt.execute();
+    if (fabs(frt[its]-tmax) >= 1.E-6) pass = 0;
+    if (fabs(frt[itt]-2.*tmax) >= 1.E-6) pass = 0;
+    if (fabs(frt[itt]-stt.get_val()) >= 1.E-6) pass = 0;
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ fused norms and dot products } passed\n");
+    } else {
+      printf("{ fused norms and dot products } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 5;
+  } else n = 5;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Computing fused norms and dot products of order 4 tensors\n");
+    }
+    fused_reduction(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
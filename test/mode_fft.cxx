@@ -0,0 +1,157 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup mode_fft mode_fft
+  * @{
+  * \brief tests fast Fourier transforms along tensor modes against contractions with DFT matrices
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+typedef std::complex<double> cmplx;
+
+/**
+ * \brief gets the DFT matrix D(k,j) = exp(-+2 pi i jk/n), scaled by 1/n if inverse
+ */
+Matrix<cmplx> mode_fft_matrix(int n, bool inverse, World & dw){
+  Matrix<cmplx> D(n, n, NS, dw, "D");
+  int64_t np;
+  int64_t * idx;
+  cmplx * data;
+  D.read_local(&np, &idx, &data);
+  for (int64_t i=0; i<np; i++){
+    double ang = (inverse ? 2. : -2.)*M_PI*(double)(((idx[i]/n)*(idx[i]%n))%n)/n;
+    data[i] = cmplx(cos(ang), sin(ang))*(inverse ? 1./n : 1.);
+  }
+  D.write(np, idx, data);
+  free(idx);
+  free(data);
+  return D;
+}
+
+/**
+ * \brief checks that A and B hold the same elements up to a relative tolerance
+ */
+int check_mode_fft(Tensor<cmplx> & A, Tensor<cmplx> & B){
+  int64_t n, nB;
+  cmplx * a, * b;
+  A.read_all(&n, &a);
+  B.read_all(&nB, &b);
+  int pass = (n == nB);
+  for (int64_t i=0; i<n && pass; i++){
+    if (std::abs(a[i]-b[i]) > 1.E-9*(1.+std::abs(b[i]))) pass = 0;
+  }
+  free(a);
+  free(b);
+  return pass;
+}
+
+int mode_fft(int     n,
+             World & dw){
+
+  int pass = 1;
+  srand48(dw.rank*13+5);
+  Transform<cmplx> set_rand([](cmplx & d){ d = cmplx(drand48()-.5, drand48()-.5); });
+
+  // every mode of an order 3 tensor, with lengths handled by radix 2 and 4, odd prime
+  // and Bluestein stages, forward and inverse
+  {
+    int lens[] = {2*n+2, 3*n, 67};
+    int shapeN3[] = {NS,NS,NS};
+    Tensor<cmplx> A(3, lens, shapeN3, dw);
+    set_rand(A["ijk"]);
+    char const * idx_ref[] = {"ljk", "ilk", "ijl"};
+    char const * idx_D[] = {"il", "jl", "kl"};
+    for (int mode=0; mode<3; mode++){
+      for (int inv=0; inv<2; inv++){
+        Matrix<cmplx> D = mode_fft_matrix(lens[mode], inv, dw);
+        Tensor<cmplx> R(3, lens, shapeN3, dw);
+        R["ijk"] = D[idx_D[mode]]*A[idx_ref[mode]];
+        Tensor<cmplx> B(A);
+        B.fft(mode, inv);
+        if (!check_mode_fft(B, R)) pass = 0;
+      }
+    }
+
+    // a transform and its inverse in the original layout give back the tensor
+    Tensor<cmplx> B(A);
+    B.fft(1, false, true);
+    B.fft(1, true, true);
+    if (!check_mode_fft(B, A)) pass = 0;
+  }
+
+  // a vector, which is transformed as a whole by every process
+  {
+    Vector<cmplx> v(n*n+1, dw);
+    set_rand(v["i"]);
+    Matrix<cmplx> D = mode_fft_matrix(n*n+1, false, dw);
+    Vector<cmplx> r(n*n+1, dw);
+    r["i"] = D["ij"]*v["j"];
+    v.fft(0);
+    if (!check_mode_fft(v, r)) pass = 0;
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ FFT along tensor modes = DFT } passed\n");
+    } else {
+      printf("{ FFT along tensor modes = DFT } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Transforming tensors along each of their modes by FFT\n");
+    }
+    mode_fft(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
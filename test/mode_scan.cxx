@@ -0,0 +1,157 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup mode_scan mode_scan
+  * @{
+  * \brief tests prefix sums and running maxima along tensor modes against sequential scans
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief checks that B, unpacked to a nonsymmetric tensor, is A scanned along mode in sequence
+ */
+int check_mode_scan(Tensor<> & A, Tensor<> & B, int mode, bool exclusive){
+  int64_t n, nB;
+  double * a, * b;
+  std::vector<int> nsym(A.order, NS);
+  Tensor<> An(A, &nsym[0]);
+  Tensor<> Bn(B, &nsym[0]);
+  An.read_all(&n, &a);
+  Bn.read_all(&nB, &b);
+  int64_t str = 1;
+  for (int i=0; i<mode; i++){
+    str *= A.lens[i];
+  }
+  int pass = (n == nB);
+  for (int64_t i=0; i<n && pass; i++){
+    if ((i/str)%A.lens[mode] != 0) continue;
+    double acc = 0.;
+    for (int64_t j=0; j<A.lens[mode]; j++){
+      double v = a[i+j*str];
+      if (!exclusive) acc += v;
+      if (fabs(b[i+j*str]-acc) > 1.E-10*(1.+fabs(acc))) pass = 0;
+      if (exclusive) acc += v;
+    }
+  }
+  free(a);
+  free(b);
+  return pass;
+}
+
+int mode_scan(int     n,
+              World & dw){
+
+  int pass = 1;
+
+  // every mode of a nonsymmetric order 3 tensor, inclusive and exclusive
+  {
+    int lens[] = {n, n+1, n+2};
+    int shapeN3[] = {NS,NS,NS};
+    Tensor<> A(3, lens, shapeN3, dw);
+    A.fill_random(-1., 1.);
+    for (int mode=0; mode<3; mode++){
+      for (int ex=0; ex<2; ex++){
+        Tensor<> B(A);
+        B.scan(mode, ex);
+        if (!check_mode_scan(A, B, mode, ex)) pass = 0;
+      }
+    }
+  }
+
+  // the nonsymmetric mode of a tensor symmetric in its first two modes
+  {
+    int lens[] = {n, n, n+3};
+    int shapeS3[] = {SY,NS,NS};
+    Tensor<> A(3, lens, shapeS3, dw);
+    A.fill_random(-1., 1.);
+    Tensor<> B(A);
+    B.scan(2);
+    if (!check_mode_scan(A, B, 2, false)) pass = 0;
+  }
+
+  // running maxima of a long vector with a max monoid
+  {
+    int len = n*n+3;
+    Vector<int> v(len, dw);
+    v.fill_random(0, 1000);
+    Monoid<int> mmax(INT_MIN, [](int a, int b){ return std::max(a,b); }, MPI_MAX);
+    Vector<int> w(v);
+    w.scan(0, mmax);
+    int64_t nv;
+    int * a, * b;
+    v.read_all(&nv, &a);
+    w.read_all(&nv, &b);
+    int mx = INT_MIN;
+    for (int64_t i=0; i<nv; i++){
+      mx = std::max(mx, a[i]);
+      if (b[i] != mx) pass = 0;
+    }
+    free(a);
+    free(b);
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ prefix scans along tensor modes } passed\n");
+    } else {
+      printf("{ prefix scans along tensor modes } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Scanning tensors along each of their modes\n");
+    }
+    mode_scan(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,186 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup node_comm node_comm
+  * @{
+  * \brief tests detection of ranks sharing a node, all-to-all-v exchanges through the shared-memory
+  *        window of a node, and the node-first ordering of processor grids
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief exchanges datums of known values through w.cdt.all_to_allv, each rank sending
+ *        (rank+p)%3+1 blocks of m datums to rank p, and checks what is received
+ */
+static int check_all_to_allv_path(World & w, int m){
+  int np = w.np;
+  std::vector<int64_t> send_counts(np), send_displs(np), recv_counts(np), recv_displs(np);
+  int64_t ns = 0, nr = 0;
+  for (int p=0; p<np; p++){
+    send_counts[p] = ((w.rank+p)%3+1)*m;
+    recv_counts[p] = ((p+w.rank)%3+1)*m;
+    send_displs[p] = ns;
+    recv_displs[p] = nr;
+    ns += send_counts[p];
+    nr += recv_counts[p];
+  }
+  std::vector<int64_t> sbuf(ns), rbuf(nr, -1);
+  for (int p=0; p<np; p++){
+    for (int64_t i=0; i<send_counts[p]; i++){
+      sbuf[send_displs[p]+i] = (w.rank*np+p)*(int64_t)1000+i;
+    }
+  }
+  w.cdt.all_to_allv(sbuf.data(), send_counts.data(), send_displs.data(), sizeof(int64_t),
+                    rbuf.data(), recv_counts.data(), recv_displs.data());
+  int pass = 1;
+  for (int p=0; p<np; p++){
+    for (int64_t i=0; i<recv_counts[p]; i++){
+      if (rbuf[recv_displs[p]+i] != (p*np+w.rank)*(int64_t)1000+i) pass = 0;
+    }
+  }
+  return pass;
+}
+
+/**
+ * \brief checks all_to_allv of m datum blocks once through the shared-memory window
+ *        of the node and once by MPI alone
+ */
+static int check_all_to_allv(World & w, int m){
+  int64_t prev_min_bytes = NODE_ALLTOALLV_MIN_BYTES;
+  int pass = 1;
+  for (int use_node=0; use_node<2; use_node++){
+    NODE_ALLTOALLV_MIN_BYTES = use_node ? 0 : INT64_MAX;
+    if (!check_all_to_allv_path(w, m)) pass = 0;
+  }
+  NODE_ALLTOALLV_MIN_BYTES = prev_min_bytes;
+  return pass;
+}
+
+int node_comm(int     n,
+              World & dw){
+  int pass = 1;
+
+  MPI_Comm scm;
+  MPI_Comm_split_type(dw.comm, MPI_COMM_TYPE_SHARED, dw.rank, MPI_INFO_NULL, &scm);
+  int snp;
+  MPI_Comm_size(scm, &snp);
+  MPI_Comm_free(&scm);
+  int all_snp = snp;
+  MPI_Allreduce(MPI_IN_PLACE, &all_snp, 1, MPI_INT, MPI_MAX, dw.comm);
+
+  // the universe groups the ranks of each node, all of them if there is only one node
+  int ppn = dw.cdt.ppn;
+  if (ppn < 1 || snp%ppn != 0) pass = 0;
+  if (dw.cdt.intra_node != (ppn > 1 && ppn == dw.np)) pass = 0;
+  if ((ppn > 1) != (dw.cdt.node_cm != MPI_COMM_NULL)) pass = 0;
+  if ((ppn > 1) != (dw.cdt.node_win != NULL)) pass = 0;
+  if (getenv("CTF_PPN") == NULL && all_snp == dw.np && dw.np > 1 && ppn != dw.np) pass = 0;
+  if (!check_all_to_allv(dw, 1)) pass = 0;
+
+  // with CTF_PPN=2, a single node holds pairs of consecutive ranks, so grids first split pairs
+  if (dw.np > 2 && dw.np%2 == 0 && all_snp == dw.np){
+    char * old_ppn = getenv("CTF_PPN");
+    std::string old_val = old_ppn == NULL ? "" : old_ppn;
+    setenv("CTF_PPN", "2", 1);
+    MPI_Comm cm;
+    MPI_Comm_dup(dw.comm, &cm);
+    {
+      World w(cm);
+      if (old_ppn == NULL) unsetenv("CTF_PPN");
+      else setenv("CTF_PPN", old_val.c_str(), 1);
+
+      if (w.cdt.ppn != 2 || w.cdt.intra_node) pass = 0;
+      int stride = 1;
+      for (int i=0; i<w.topovec[0]->order && stride<2; i++){
+        stride *= w.topovec[0]->lens[i];
+      }
+      if (stride != 2) pass = 0;
+
+      // the second, larger exchange grows the shared-memory window
+      if (!check_all_to_allv(w, 1)) pass = 0;
+      if (!check_all_to_allv(w, 64*n)) pass = 0;
+
+      // writing and reading pairs exchanges them with all_to_allv, also within nodes
+      int lens[] = {n, n+1, n+2};
+      int syms[] = {NS, NS, NS};
+      Tensor<> A(3, lens, syms, w);
+      int64_t sz = n*(n+1)*(n+2);
+      int64_t nw = w.rank == 0 ? sz : 0;
+      std::vector<int64_t> inds(sz);
+      std::vector<double> vals(sz);
+      for (int64_t i=0; i<sz; i++){
+        inds[i] = i;
+        vals[i] = sin(.1*i);
+      }
+      A.write(nw, inds.data(), vals.data());
+      Tensor<> B(3, lens, syms, w);
+      B["ijk"] = 2.*A["ijk"];
+      std::vector<double> rvals(sz);
+      B.read(nw, inds.data(), rvals.data());
+      for (int64_t i=0; i<nw; i++){
+        if (fabs(rvals[i]-2.*vals[i]) >= 1.E-10) pass = 0;
+      }
+    }
+    MPI_Comm_free(&cm);
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ exchanges within nodes through shared memory and node-first grids } passed\n");
+    } else {
+      printf("{ exchanges within nodes through shared memory and node-first grids } failed\n");
+    }
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Exchanging data within nodes with n = %d\n",n);
+    }
+    node_comm(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,144 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup op_stats op_stats
+  * @{
+  * \brief tests the statistics recorded for a contraction and a summation and the log they are written to
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int op_stats(int     n,
+             World & dw){
+
+  int shapeN3[] = {NS,NS,NS};
+  int sizeN3[]  = {n,n+1,n+2};
+  int sizeT3[]  = {n+2,n+1,n};
+
+  Matrix<> A(n, n+1, dw, "A");
+  Matrix<> B(n+1, n+2, dw, "B");
+  Matrix<> C(n, n+2, dw, "C");
+  Tensor<> S(3, sizeN3, shapeN3, dw, "S");
+  Tensor<> T(3, sizeT3, shapeN3, dw, "T");
+  srand48(dw.rank*5+2);
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  S.fill_random(-1., 1.);
+
+  char const * dir = getenv("TMPDIR");
+  if (dir == NULL) dir = "/tmp";
+  char log_file[256];
+  sprintf(log_file, "%s/ctf_op_stats_%d.json", dir, dw.np);
+  if (dw.rank == 0) remove(log_file);
+  MPI_Barrier(dw.comm);
+
+  int pass = 1;
+  CTF::clear_op_stats();
+  CTF::set_op_stats(true, log_file);
+  C["ij"] = A["ik"]*B["kj"];
+  T["kji"] += S["ijk"];
+  CTF::set_op_stats(false);
+
+  std::vector<Op_stats> const & st = CTF::get_op_stats();
+  if (st.size() != 2) pass = 0;
+  else {
+    if (st[0].type != "contraction" || st[0].expr != "C[ac]=A[ab]*B[bc]") pass = 0;
+    if (!st[0].folded || st[0].kernel != "gemm") pass = 0;
+    if (st[0].map_A.size() == 0 || st[0].map_B.size() == 0 || st[0].map_C.size() == 0) pass = 0;
+    if (st[1].type != "summation" || st[1].expr != "T[cba]+=S[abc]") pass = 0;
+    if (st[1].map_A.size() == 0 || st[1].map_B.size() == 0) pass = 0;
+    for (int i=0; i<(int)st.size(); i++){
+      if (st[i].time <= 0. || st[i].est_time <= 0. || st[i].topo.size() == 0) pass = 0;
+      // the processor grid holds at most all processes
+      int64_t topo_np = 1;
+      for (size_t pos=0, len; pos<st[i].topo.size(); pos+=len+1){
+        topo_np *= std::stol(st[i].topo.substr(pos), &len);
+      }
+      if (topo_np < 1 || topo_np > dw.np) pass = 0;
+    }
+  }
+
+  // operations are no longer recorded once disabled
+  C["ij"] += A["ik"]*B["kj"];
+  if (CTF::get_op_stats().size() != 2) pass = 0;
+  CTF::clear_op_stats();
+
+  if (dw.rank == 0){
+    FILE * f = fopen(log_file, "r");
+    if (f == NULL) pass = 0;
+    else {
+      int nlines = 0;
+      char line[4096];
+      while (fgets(line, sizeof(line), f) != NULL){
+        if (line[0] == '{') nlines++;
+      }
+      fclose(f);
+      if (nlines != 2) pass = 0;
+      remove(log_file);
+    }
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ per-operation statistics are recorded and logged } passed\n");
+    } else {
+      printf("{ per-operation statistics are recorded and logged } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 6;
+  } else n = 6;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Recording statistics of a contraction and a summation\n");
+    }
+    op_stats(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,117 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup out_of_core out_of_core
+  * @{
+  * \brief tests a contraction of tensors backed by memory-mapped files against one in memory
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int out_of_core(int     n,
+                World & dw){
+
+  int shapeN4[] = {NS,NS,NS,NS};
+  int sizeA4[]  = {n,n+1,n+2,n+3};
+  int sizeB4[]  = {n+2,n+3,n,n+1};
+  int sizeC4[]  = {n,n+1,n,n+1};
+
+  Tensor<> A(4, sizeA4, shapeN4, dw);
+  Tensor<> B(4, sizeB4, shapeN4, dw);
+  srand48(dw.rank*3+1);
+  A.fill_random(-.5, .5);
+  B.fill_random(-.5, .5);
+
+  Tensor<> C(4, sizeC4, shapeN4, dw);
+  C["ijkl"] = A["ijmn"]*B["mnkl"];
+
+  char const * dir = getenv("TMPDIR");
+  if (dir == NULL) dir = "/tmp";
+
+  int pass = 1;
+  {
+    // the data of the copies now lives in files, however small
+    CTF::set_out_of_core(dir, 1);
+    Tensor<> A_ooc(A);
+    Tensor<> B_ooc(B);
+    if (!CTF::is_out_of_core()) pass = 0;
+    Tensor<> C_ooc(4, sizeC4, shapeN4, dw);
+    C_ooc["ijkl"] = A_ooc["ijmn"]*B_ooc["mnkl"];
+    C_ooc["ijkl"] += A_ooc["ijmn"]*B_ooc["mnkl"];
+
+    // buffers handed to the user stay in memory and are freed with free()
+    int64_t npair, * inds;
+    double * vals;
+    C_ooc.read_local(&npair, &inds, &vals);
+    free(inds);
+    free(vals);
+    CTF::set_out_of_core(NULL);
+
+    C_ooc["ijkl"] -= 2.*C["ijkl"];
+    if (C_ooc.norm2() >= 1.E-6) pass = 0;
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ contraction of tensors backed by memory-mapped files } passed\n");
+    } else {
+      printf("{ contraction of tensors backed by memory-mapped files } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 6;
+  } else n = 6;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Contracting order 4 tensors backed by memory-mapped files\n");
+    }
+    out_of_core(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,136 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup packed_contract packed_contract
+  * @{
+  * \brief Tests contractions of antisymmetric operands with broken symmetry done on the packed
+  *        operands against the same contractions done on unpacked copies, and that symmetric
+  *        operands are still unpacked when they exceed the memory budget
+  */
+
+#include <ctf.hpp>
+
+using namespace CTF;
+
+int packed_contract(int     n,
+                    World & dw){
+  int pass = 1;
+
+  int shapeAN4[] = {AS,NS,AS,NS};
+  int shapeN4[] = {NS,NS,NS,NS};
+  int sizeN4[] = {n,n,n,n};
+
+  Matrix<> A(n, n, AS, dw, "A");
+  Matrix<> B(n, n, AS, dw, "B");
+  Matrix<> S(n, n, SY, dw, "S");
+  Tensor<> T(4, sizeN4, shapeAN4, dw, "T");
+  Tensor<> V(4, sizeN4, shapeAN4, dw, "V");
+  A.fill_random(-.5, .5);
+  B.fill_random(-.5, .5);
+  S.fill_random(-.5, .5);
+  T.fill_random(-.5, .5);
+  V.fill_random(-.5, .5);
+
+  Matrix<> C_unpacked(n, n, NS, dw, "C_unpacked");
+  Matrix<> C_packed(n, n, NS, dw, "C_packed");
+  Matrix<> D_packed(n, n, NS, dw, "D_packed");
+  Tensor<> Z_unpacked(4, sizeN4, shapeAN4, dw, "Z_unpacked");
+  Tensor<> Z_packed(4, sizeN4, shapeAN4, dw, "Z_packed");
+  Tensor<> W_unpacked(4, sizeN4, shapeN4, dw, "W_unpacked");
+  Tensor<> W_packed(4, sizeN4, shapeN4, dw, "W_packed");
+
+  // with the default budget, the small operands are desymmetrized
+  C_unpacked["ij"] = A["ik"]*B["kj"];
+  Z_unpacked["ijab"] = T["ikac"]*V["kjcb"];
+  W_unpacked["ijab"] = T["ikac"]*V["cbkj"];
+
+  // with no memory for unpacked copies, the packed operands are contracted for each permutation
+  double frac = set_desym_mem_frac(0.);
+  C_packed["ij"] = A["ik"]*B["kj"];
+  Z_packed["ijab"] = T["ikac"]*V["kjcb"];
+  W_packed["ijab"] = T["ikac"]*V["cbkj"];
+  // summing permutations would count the diagonal of S twice, so it is unpacked regardless
+  D_packed["ij"] = S["ik"]*S["kj"];
+  set_desym_mem_frac(frac);
+
+  // check the matrix product against one of nonsymmetric copies of the operands
+  Matrix<> An(n, n, NS, dw, "An");
+  Matrix<> Bn(n, n, NS, dw, "Bn");
+  Matrix<> Cn(n, n, NS, dw, "Cn");
+  An["ij"] = A["ij"];
+  Bn["ij"] = B["ij"];
+  Cn["ij"] = An["ik"]*Bn["kj"];
+  Matrix<> Sn(n, n, NS, dw, "Sn");
+  Matrix<> Dn(n, n, NS, dw, "Dn");
+  Sn["ij"] = S["ij"];
+  Dn["ij"] = Sn["ik"]*Sn["kj"];
+
+  C_unpacked["ij"] -= Cn["ij"];
+  C_packed["ij"] -= Cn["ij"];
+  D_packed["ij"] -= Dn["ij"];
+  Z_packed["ijab"] -= Z_unpacked["ijab"];
+  W_packed["ijab"] -= W_unpacked["ijab"];
+  if (C_unpacked.norm2() > 1.E-10) pass = 0;
+  if (C_packed.norm2() > 1.E-10) pass = 0;
+  if (D_packed.norm2() > 1.E-10) pass = 0;
+  if (Z_packed.norm2() > 1.E-10) pass = 0;
+  if (W_packed.norm2() > 1.E-10) pass = 0;
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ packed C[\"ij\"]=A[\"(ik)\"]*B[\"(kj)\"] = unpacked C[\"ij\"]=A[\"(ik)\"]*B[\"(kj)\"] } passed \n");
+    } else {
+      printf("{ packed C[\"ij\"]=A[\"(ik)\"]*B[\"(kj)\"] = unpacked C[\"ij\"]=A[\"(ik)\"]*B[\"(kj)\"] } failed \n");
+    }
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Contracting packed antisymmetric operands with n = %d\n",n);
+    }
+    packed_contract(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,146 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup qr qr
+  * @{
+  * \brief tests TSQR and QR-based SVD of tall-skinny and short-wide matrices
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int qr(int     m,
+       int     n,
+       World & dw){
+
+  Matrix<> A(m, n, dw);
+  srand48(dw.rank*13+7);
+  A.fill_random(-.5, .5);
+
+  int pass = 1;
+
+  // A = Q*R with Q^T*Q = I
+  Matrix<> Q, R;
+  A.qr(Q, R);
+
+  Matrix<> I(n, n, dw);
+  I["ii"] = 1.0;
+  Matrix<> QTQ(n, n, dw);
+  QTQ["ij"] = Q["ki"]*Q["kj"];
+  QTQ["ij"] -= I["ij"];
+  if (QTQ.norm2() >= 1.E-6) pass = 0;
+
+  Matrix<> QR(m, n, dw);
+  QR["ij"] = Q["ik"]*R["kj"];
+  QR["ij"] -= A["ij"];
+  if (QR.norm2() >= 1.E-6) pass = 0;
+
+  // A = U*diag(S)*VT for A and its transpose
+  Matrix<> U, VT;
+  Vector<> S;
+  A.svd(U, S, VT);
+  Matrix<> USV(m, n, dw);
+  USV["ij"] = U["ik"]*S["k"]*VT["kj"];
+  USV["ij"] -= A["ij"];
+  if (USV.norm2() >= 1.E-6) pass = 0;
+
+  Matrix<> AT(n, m, dw);
+  AT["ij"] = A["ji"];
+  AT.svd(U, S, VT);
+  Matrix<> USVT(n, m, dw);
+  USVT["ij"] = U["ik"]*S["k"]*VT["kj"];
+  USVT["ij"] -= AT["ij"];
+  if (USVT.norm2() >= 1.E-6) pass = 0;
+
+  // matrices whose rows are spread over all processors, with and without virtual blocks,
+  // are factored in place without being redistributed
+  int np = dw.np;
+  int nblk = 3;
+  Partition pe_line(1, &np);
+  Partition blk_line(1, &nblk);
+  for (int iv=0; iv<2; iv++){
+    Matrix<> B(40*m+1, n, "ij", pe_line["i"], iv ? blk_line["i"] : Idx_Partition(), 0, dw);
+    B.fill_random(-.5, .5);
+    Matrix<> QB, RB;
+    int64_t st_bytes = CTF_int::get_comm_bytes();
+    B.qr(QB, RB);
+    // only R is communicated
+    if (CTF_int::get_comm_bytes()-st_bytes > 2*(int64_t)sizeof(double)*n*n*np) pass = 0;
+    Matrix<> QRB(40*m+1, n, dw);
+    QRB["ij"] = QB["ik"]*RB["kj"];
+    QRB["ij"] -= B["ij"];
+    if (QRB.norm2() >= 1.E-6) pass = 0;
+    Matrix<> QTQB(n, n, dw);
+    QTQB["ij"] = QB["ki"]*QB["kj"];
+    QTQB["ij"] -= I["ij"];
+    if (QTQB.norm2() >= 1.E-6) pass = 0;
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ A = QR and A = USVT } passed\n");
+    } else {
+      printf("{ A = QR and A = USVT } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, m, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-m")){
+    m = atoi(getCmdOption(input_str, input_str+in_num, "-m"));
+    if (m < 0) m = 100;
+  } else m = 100;
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0 || n > m) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Computing QR and SVD of %d-by-%d matrix\n", m, n);
+    }
+    qr(m, n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,116 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup redscat_contract redscat_contract
+  * @{
+  * \brief tests contractions whose small output is replicated over processes, with partial sums
+  *        reduced by reduce-scatter and gather, against those reduced by MPI_Reduce
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int redscat_contract(int     n,
+                     World & dw){
+
+  // a long contracted index and a small output, so the output is replicated over all processes
+  int m = 3;
+  int k = 64*n*dw.np;
+
+  srand48(dw.rank*13+7);
+  Matrix<> A(m, k, NS, dw);
+  Matrix<> B(k, m, NS, dw);
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  Matrix<int64_t> IA(m, k, NS, dw);
+  Matrix<int64_t> IB(k, m, NS, dw);
+  IA.fill_random(-8, 8);
+  IB.fill_random(-8, 8);
+
+  Matrix<> * C[3];
+  Matrix<int64_t> * IC[3];
+  int prev_switch = REDSCAT_SWITCH;
+  for (int s=0; s<3; s++){
+    // 0 chooses the reduction by performance models, 1 forces MPI_Reduce, 2 reduce-scatter and gather
+    REDSCAT_SWITCH = s;
+    C[s] = new Matrix<>(m, m, NS, dw);
+    (*C[s])["ij"] = 1.;
+    (*C[s])["ij"] += A["ik"]*B["kj"];
+    (*C[s])["ij"] += .5*A["ik"]*B["kj"];
+    IC[s] = new Matrix<int64_t>(m, m, NS, dw);
+    (*IC[s])["ij"] = IA["ik"]*IB["kj"];
+  }
+  REDSCAT_SWITCH = prev_switch;
+
+  int pass = 1;
+  if (C[1]->norm2() < 1.E-6) pass = 0;
+  for (int s=0; s<3; s+=2){
+    (*C[s])["ij"] -= (*C[1])["ij"];
+    if (C[s]->norm2() >= 1.E-6) pass = 0;
+    (*IC[s])["ij"] -= (*IC[1])["ij"];
+    if (IC[s]->norm1() != 0) pass = 0;
+  }
+  for (int s=0; s<3; s++){
+    delete C[s];
+    delete IC[s];
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ contractions reduced by reduce-scatter and gather equal those reduced by MPI_Reduce } passed\n");
+    } else {
+      printf("{ contractions reduced by reduce-scatter and gather equal those reduced by MPI_Reduce } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Contracting into replicated outputs reduced by reduce-scatter and gather with n = %d\n",n);
+    }
+    redscat_contract(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
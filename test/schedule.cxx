@@ -0,0 +1,205 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup schedule schedule
+  * @{
+  * \brief tests recording a DAG of matrix operations and executing it on subworlds with static and dynamic load balancing, and in place with planned layouts, and with recorded operations optimized
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief bytes communicated by all processes since a process had communicated start_bytes
+ */
+int64_t schedule_bytes(int64_t start_bytes){
+  int64_t bytes = CTF_int::get_comm_bytes()-start_bytes;
+  MPI_Allreduce(MPI_IN_PLACE, &bytes, 1, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+  return bytes;
+}
+
+int schedule(int     n,
+             World & dw){
+
+  Matrix<> A(n, n, NS, dw, "A");
+  Matrix<> B(n, n, NS, dw, "B");
+  srand48(dw.rank*3+1);
+  A.fill_random(-.5, .5);
+  B.fill_random(-.5, .5);
+
+  Matrix<> R_ref(n, n, NS, dw);
+
+  int pass = 1;
+  int64_t ref_bytes = 0;
+  int64_t static_flops = 0;
+  // the first pass executes the operations directly to obtain a reference,
+  // the others record them and execute with static and dynamic load balancing,
+  // and on a single partition, where operations run in place with planned layouts,
+  // the last one also eliminates the repeated and the overwritten contraction
+  for (int mode=0; mode<5; mode++){
+    Matrix<> T1(n, n, NS, dw, "T1");
+    Matrix<> T2(n, n, NS, dw, "T2");
+    Matrix<> T3(n, n, NS, dw, "T3");
+    Matrix<> T4(n, n, NS, dw, "T4");
+    Matrix<> T5(n, n, NS, dw, "T5");
+    Matrix<> T6(n, n, NS, dw, "T6");
+    Matrix<> T7(n, n, NS, dw, "T7");
+    Matrix<> T8(n, n, NS, dw, "T8");
+    Matrix<> U1(n, n, NS, dw, "U");
+    Matrix<> U2(n, n, NS, dw, "U");
+    Matrix<> R(n, n, NS, dw, "R");
+    // written only on its diagonal, its other entries must survive being written back
+    Matrix<> W(n, n, NS, dw, "W");
+    W["ij"] = B["ij"];
+
+    Schedule sched(&dw);
+    sched.set_dynamic(mode == 2);
+    if (mode == 3) sched.set_max_partitions(1);
+    sched.set_optimize(mode == 4);
+    if (mode > 0) sched.record();
+    int64_t bytes = CTF_int::get_comm_bytes();
+    // two independent chains joined at the end, later links of a chain may be pulled
+    T1["ij"] = A["ik"]*B["kj"];
+    T2["ij"] = T1["ik"]*A["kj"];
+    T2["ij"] = 2.0*T2["ij"];
+    T3["ij"] = B["ik"]*B["kj"];
+    T3["ij"] += A["ij"];
+    T4["ij"] = B["ji"];
+    T4["ij"] -= A["ij"];
+    T5["ij"] = T3["ij"]*T4["ij"];
+    T6["ji"] = A["jl"]*B["li"];
+    T7["ij"] = A["ik"]*A["kj"];
+    T7["ij"] = B["ij"];
+    // the removed contraction must not be reused for a repeated one
+    T8["ij"] = A["ik"]*A["kj"];
+    // equally named tensors must be copied to partitions in the same order on all processes
+    U1["ij"] = A["ij"];
+    U2["ij"] = 3.0*B["ij"];
+    U1["ij"] += U2["ji"];
+    W["ii"] = A["ii"];
+    R["ij"] = T2["ij"];
+    R["ij"] += T5["ij"];
+    R["ij"] += T1["ij"];
+    R["ij"] += T6["ij"];
+    R["ij"] -= T7["ij"];
+    R["ij"] += T8["ij"];
+    R["ij"] += U1["ij"];
+    R["ij"] += W["ij"];
+    if (mode == 0){
+      ref_bytes = schedule_bytes(bytes);
+      R_ref["ij"] = R["ij"];
+      continue;
+    }
+    // a repeated execution pins inputs by the layouts observed in the first one
+    if (mode == 3) sched.execute();
+    bytes = CTF_int::get_comm_bytes();
+    Flop_counter fc;
+    sched.execute();
+    int64_t flops = fc.count(dw.comm);
+    // planned layouts communicate no more than direct execution
+    if (mode == 3 && schedule_bytes(bytes) > ref_bytes) pass = 0;
+    // optimization removes the contractions repeated by T6 and overwritten in T7, of
+    // 2n^3 flops each, from the same statically scheduled DAG (more than one of them,
+    // allowing for mappings that differ in padding)
+    if (mode == 1) static_flops = flops;
+    if (mode == 4 && flops > static_flops - 3*(int64_t)n*n*n) pass = 0;
+
+    R["ij"] -= R_ref["ij"];
+    if (R.norm2() >= 1.E-6) pass = 0;
+  }
+
+  // an accumulation chain, with planned layouts the output stays in the layout of the
+  // contractions rather than being mapped back home after each of them
+  for (int mode=0; mode<2; mode++){
+    Matrix<> C(n, n, NS, dw, "C");
+    Matrix<> D(n, n, NS, dw, "D");
+    C["ij"] = A["ik"]*B["kj"];
+
+    Schedule sched(&dw);
+    sched.set_max_partitions(1);
+    if (mode == 1) sched.record();
+    int64_t bytes = CTF_int::get_comm_bytes();
+    C["ij"] += A["ik"]*B["kj"];
+    C["ij"] += 2.0*A["ik"]*B["kj"];
+    C["ij"] += 3.0*A["ik"]*B["kj"];
+    D["ij"] = C["ik"]*C["kj"];
+    if (mode == 0){
+      ref_bytes = schedule_bytes(bytes);
+      R_ref["ij"] = D["ij"];
+      continue;
+    }
+    // the first execution observes the layouts, the second keeps them
+    Matrix<> C0(C);
+    sched.execute();
+    C["ij"] = C0["ij"];
+    bytes = CTF_int::get_comm_bytes();
+    sched.execute();
+    if (schedule_bytes(bytes) > ref_bytes) pass = 0;
+
+    D["ij"] -= R_ref["ij"];
+    if (D.norm2() >= 1.E-6) pass = 0;
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ scheduled DAG of matrix operations equals direct execution } passed\n");
+    } else {
+      printf("{ scheduled DAG of matrix operations equals direct execution } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 16;
+  } else n = 16;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Executing scheduled DAG of %d-by-%d matrix operations\n", n, n);
+    }
+    schedule(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,203 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup sort_tensor sort_tensor
+  * @{
+  * \brief tests distributed sorting and top-k selection of tensor elements against sorting all of them
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief orders pairs as Tensor::sort does
+ */
+struct sort_tensor_cmp {
+  bool desc;
+  sort_tensor_cmp(bool desc_) : desc(desc_) { }
+  bool operator()(Pair<> const & a, Pair<> const & b) const {
+    if (a.d != b.d) return desc ? a.d > b.d : a.d < b.d;
+    return a.k < b.k;
+  }
+};
+
+/**
+ * \brief checks that the pairs sorted by all processes, in rank order, are ref
+ */
+int check_sorted(int64_t npair, Pair<> * pairs, std::vector< Pair<> > const & ref, World & dw){
+  int psz = sizeof(Pair<>);
+  int nb = npair*psz;
+  std::vector<int> counts(dw.np), displs(dw.np, 0);
+  MPI_Allgather(&nb, 1, MPI_INT, &counts[0], 1, MPI_INT, dw.comm);
+  for (int i=1; i<dw.np; i++){
+    displs[i] = displs[i-1]+counts[i-1];
+  }
+  int64_t nall = (displs[dw.np-1]+counts[dw.np-1])/psz;
+  if (nall != (int64_t)ref.size()) return 0;
+  std::vector< Pair<> > all(nall+1);
+  MPI_Allgatherv(pairs, nb, MPI_BYTE, &all[0], &counts[0], &displs[0], MPI_BYTE, dw.comm);
+  for (int64_t i=0; i<nall; i++){
+    if (all[i].k != ref[i].k || all[i].d != ref[i].d) return 0;
+  }
+  return 1;
+}
+
+int sort_tensor(int     n,
+                World & dw){
+
+  int pass = 1;
+  srand48(dw.rank*17+3);
+
+  // dense order 3 tensor in ascending order
+  {
+    int lens[] = {n, n+1, n+2};
+    int shapeN3[] = {NS,NS,NS};
+    Tensor<> A(3, lens, shapeN3, dw);
+    A.fill_random(-1., 1.);
+    int64_t nall;
+    double * vals;
+    A.read_all(&nall, &vals);
+    std::vector< Pair<> > ref(nall);
+    for (int64_t i=0; i<nall; i++){
+      ref[i] = Pair<>(i, vals[i]);
+    }
+    free(vals);
+    std::sort(ref.begin(), ref.end(), sort_tensor_cmp(false));
+
+    int64_t npair;
+    Pair<> * pairs;
+    A.sort(&npair, &pairs);
+    if (!check_sorted(npair, pairs, ref, dw)) pass = 0;
+    if (pairs != NULL) free(pairs);
+
+    int k = 5;
+    std::vector< Pair<> > top(k);
+    if (A.top_k(k, &top[0], true) != k) pass = 0;
+    for (int i=0; i<k; i++){
+      if (top[i].k != ref[i].k || top[i].d != ref[i].d) pass = 0;
+    }
+  }
+
+  // nonzeros of a sparse matrix in descending order
+  {
+    Matrix<> S(n*3, n*2, SP, dw);
+    S.fill_sp_random(-1., 1., .2);
+    Matrix<> D(n*3, n*2, dw);
+    D["ij"] = S["ij"];
+    int64_t nall;
+    double * vals;
+    D.read_all(&nall, &vals);
+    std::vector< Pair<> > ref;
+    for (int64_t i=0; i<nall; i++){
+      if (vals[i] != 0.) ref.push_back(Pair<>(i, vals[i]));
+    }
+    free(vals);
+    std::sort(ref.begin(), ref.end(), sort_tensor_cmp(true));
+
+    int64_t npair;
+    Pair<> * pairs;
+    S.sort(&npair, &pairs, true);
+    if (!check_sorted(npair, pairs, ref, dw)) pass = 0;
+    if (pairs != NULL) free(pairs);
+
+    // asking for more pairs than there are nonzeros gives all of them
+    int64_t k = ref.size()+3;
+    std::vector< Pair<> > top(k);
+    if (S.top_k(k, &top[0]) != (int64_t)ref.size()) pass = 0;
+    for (int64_t i=0; i<(int64_t)ref.size(); i++){
+      if (top[i].k != ref[i].k || top[i].d != ref[i].d) pass = 0;
+    }
+  }
+
+  // many equal values, which are ordered by key
+  {
+    Vector<int> v(n*n, dw);
+    v.fill_random(0, 3);
+    int64_t nall;
+    int * vals;
+    v.read_all(&nall, &vals);
+    std::vector< Pair<int> > ref(nall);
+    for (int64_t i=0; i<nall; i++){
+      ref[i] = Pair<int>(i, vals[i]);
+    }
+    free(vals);
+    std::stable_sort(ref.begin(), ref.end(), [](Pair<int> const & a, Pair<int> const & b){ return a.d < b.d; });
+
+    int64_t npair;
+    Pair<int> * pairs;
+    v.sort(&npair, &pairs);
+    std::vector<int64_t> cnt(dw.np);
+    MPI_Allgather(&npair, 1, MPI_INT64_T, &cnt[0], 1, MPI_INT64_T, dw.comm);
+    int64_t off = 0;
+    for (int i=0; i<dw.rank; i++){
+      off += cnt[i];
+    }
+    for (int64_t i=0; i<npair; i++){
+      if (pairs[i].k != ref[off+i].k || pairs[i].d != ref[off+i].d) pass = 0;
+    }
+    if (pairs != NULL) free(pairs);
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ distributed sort and top-k of tensor elements } passed\n");
+    } else {
+      printf("{ distributed sort and top-k of tensor elements } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Sorting tensor elements and selecting the largest and smallest\n");
+    }
+    sort_tensor(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,129 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup sparse_merge sparse_merge
+  * @{
+  * \brief tests summations of sparse tensors large enough for their pairs to be merged by several threads
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int sparse_merge(int     n,
+                 World & dw){
+
+  int m = 48*n;
+  int shapeN2[] = {NS,NS};
+  int sizeN2[]  = {m,m};
+  int shapeN3[] = {NS,NS,NS};
+  int sizeN3[]  = {m,m,3};
+
+  srand48(dw.rank*11+5);
+  Tensor<> A(2, true, sizeN2, shapeN2, dw);
+  Tensor<> B(2, true, sizeN2, shapeN2, dw);
+  A.fill_sp_random(-1., 1., .4);
+  B.fill_sp_random(-1., 1., .4);
+  Tensor<> A_dn(2, sizeN2, shapeN2, dw);
+  Tensor<> B_dn(2, sizeN2, shapeN2, dw);
+  A_dn["ij"] = A["ij"];
+  B_dn["ij"] = B["ij"];
+
+  int pass = 1;
+
+  // keys of A and B interleave, some coincide
+  B["ij"] += 2.*A["ij"];
+  B_dn["ij"] += 2.*A_dn["ij"];
+  B_dn["ij"] -= B["ij"];
+  if (B_dn.norm2() >= 1.E-6) pass = 0;
+
+  // each pair of A is replicated along the last mode of C
+  Tensor<> C(3, true, sizeN3, shapeN3, dw);
+  Tensor<> C_dn(3, sizeN3, shapeN3, dw);
+  C["ijk"] += A["ij"];
+  C["ijk"] += A["ij"];
+  C_dn["ijk"] += 2.*A_dn["ij"];
+  C_dn["ijk"] -= C["ijk"];
+  if (C_dn.norm2() >= 1.E-6) pass = 0;
+
+  // writes with runs of repeated keys are accumulated
+  int64_t nw = m*m/4;
+  int64_t * inds = (int64_t*)malloc(sizeof(int64_t)*nw);
+  double * vals = (double*)malloc(sizeof(double)*nw);
+  for (int64_t i=0; i<nw; i++){
+    inds[i] = ((i/3)*7)%((int64_t)m*m);
+    vals[i] = 1.;
+  }
+  Tensor<> S(2, true, sizeN2, shapeN2, dw);
+  Tensor<> S_dn(2, sizeN2, shapeN2, dw);
+  S.write(nw, 1., 1., inds, vals);
+  S.write(nw, 1., 1., inds, vals);
+  S_dn.write(nw, 1., 1., inds, vals);
+  S_dn.write(nw, 1., 1., inds, vals);
+  free(inds);
+  free(vals);
+  S_dn["ij"] -= S["ij"];
+  if (S_dn.norm2() >= 1.E-6) pass = 0;
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ sums of large sparse tensors equal dense sums } passed\n");
+    } else {
+      printf("{ sums of large sparse tensors equal dense sums } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 6;
+  } else n = 6;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Summing large sparse tensors\n");
+    }
+    sparse_merge(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
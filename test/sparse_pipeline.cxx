@@ -0,0 +1,121 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup sparse_pipeline sparse_pipeline
+  * @{
+  * \brief tests writes of pairs exchanged point-to-point in chunks, by setting a chunk size small
+  *        enough for them to be pipelined, against writes exchanged by an all-to-all
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int sparse_pipeline(int     n,
+                    World & dw){
+
+  int m = 8*n;
+  int shapeN3[] = {NS,NS,NS};
+  int sizeN3[]  = {m,m,n};
+  int shapeSY3[] = {SY,NS,NS};
+  int sizeSY3[]  = {m,m,n};
+  int64_t sz = (int64_t)m*m*n;
+
+  // each process writes pairs with repeated keys, interleaved with those of other processes
+  int64_t nw = 2*sz/dw.np+dw.rank;
+  int64_t * inds = (int64_t*)malloc(sizeof(int64_t)*nw);
+  double * vals = (double*)malloc(sizeof(double)*nw);
+  for (int64_t i=0; i<nw; i++){
+    inds[i] = ((i*dw.np+dw.rank)*13)%sz;
+    vals[i] = sin(.1*i+dw.rank);
+  }
+
+  // chunks of 16 pairs, so that each process sends many of them
+  int64_t prev_chunk = set_sparse_pipeline_chunk_size(16*(sizeof(int64_t)+sizeof(double)));
+  Tensor<> A(3, sizeN3, shapeN3, dw);
+  Tensor<> S(3, true, sizeN3, shapeN3, dw);
+  Tensor<> Y(3, sizeSY3, shapeSY3, dw);
+  A.write(nw, 1., 1., inds, vals);
+  A.write(nw, 1., 1., inds, vals);
+  S.write(nw, 1., 1., inds, vals);
+  S.write(nw, 1., 1., inds, vals);
+  Y.write(nw, 1., 1., inds, vals);
+  set_sparse_pipeline_chunk_size(prev_chunk);
+
+  Tensor<> A_ref(3, sizeN3, shapeN3, dw);
+  Tensor<> S_ref(3, true, sizeN3, shapeN3, dw);
+  Tensor<> Y_ref(3, sizeSY3, shapeSY3, dw);
+  A_ref.write(nw, 1., 1., inds, vals);
+  A_ref.write(nw, 1., 1., inds, vals);
+  S_ref.write(nw, 1., 1., inds, vals);
+  S_ref.write(nw, 1., 1., inds, vals);
+  Y_ref.write(nw, 1., 1., inds, vals);
+
+  int pass = 1;
+  if (A.norm2() < 1.E-6) pass = 0;
+  A_ref["ijk"] -= A["ijk"];
+  S_ref["ijk"] -= S["ijk"];
+  Y_ref["ijk"] -= Y["ijk"];
+  if (A_ref.norm2() >= 1.E-6 || S_ref.norm2() >= 1.E-6 || Y_ref.norm2() >= 1.E-6) pass = 0;
+
+  free(inds);
+  free(vals);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ pipelined writes of pairs equal writes exchanged by all-to-all } passed\n");
+    } else {
+      printf("{ pipelined writes of pairs equal writes exchanged by all-to-all } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Writing pairs pipelined in small chunks with n = %d\n",n);
+    }
+    sparse_pipeline(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,193 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup spmspv spmspv
+  * @{
+  * \brief tests products of sparse matrices with sparse vectors against products with dense vectors
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief writes a frontier of nf entries of value val(j) at indices spaced by the given stride
+ */
+template <typename dtype>
+void spmspv_frontier(Vector<dtype> & v, int nf, int64_t stride, dtype (*val)(int64_t)){
+  int64_t * inds = (int64_t*)malloc(sizeof(int64_t)*nf);
+  dtype * vals = (dtype*)malloc(sizeof(dtype)*nf);
+  int nw = 0;
+  if (v.wrld->rank == 0){
+    for (int j=0; j<nf; j++){
+      inds[nw] = (j*stride) % v.len;
+      vals[nw] = val(inds[nw]);
+      nw++;
+    }
+  }
+  v.write(nw, inds, vals);
+  free(inds);
+  free(vals);
+}
+
+/**
+ * \brief checks that two integer vectors hold the same elements
+ */
+int check_spmspv(Vector<int> & a, Vector<int> & b){
+  int64_t n, nb;
+  int * va, * vb;
+  a.read_all(&n, &va);
+  b.read_all(&nb, &vb);
+  int pass = (n == nb);
+  for (int64_t i=0; i<n && pass; i++){
+    if (va[i] != vb[i]) pass = 0;
+  }
+  free(va);
+  free(vb);
+  return pass;
+}
+
+int spmspv(int     n,
+           World & dw){
+
+  int m = 40*n;
+  int pass = 1;
+  srand48(dw.rank*17+3);
+
+  // frontiers of growing size, with A modified after the second and third products so that
+  // its transposed layout cached by earlier products is rebuilt, the last time in place
+  // with the same data and number of nonzeros
+  {
+    Matrix<> A(m, m, SP, dw);
+    A.fill_sp_random(1., 2., .1);
+    for (int it=0; it<4; it++){
+      if (it == 2) A["ij"] += A["ij"];
+      if (it == 3) A.scale(.5, "ij");
+      Vector<> p(m, SP, dw, "p");
+      spmspv_frontier<double>(p, 1+it, 7+it, [](int64_t j){ return 1.+j; });
+      Vector<> p_dn(m, dw);
+      p_dn["i"] = p["i"];
+      Vector<> c(m, dw);
+      Vector<> c_sp(m, SP, dw, "c_sp");
+      Vector<> c_dn(m, dw);
+      c["i"] = A["ij"]*p["j"];
+      c_sp["i"] = 2.*A["ij"]*p["j"];
+      c_dn["i"] = A["ij"]*p_dn["j"];
+      c["i"] -= c_dn["i"];
+      c_sp["i"] -= 2.*c_dn["i"];
+      if (c.norm2() >= 1.E-6) pass = 0;
+      if (c_sp.norm2() >= 1.E-6) pass = 0;
+    }
+  }
+
+  // A used between products in contractions with dense matrices that may remap it, which keeps
+  // its data generation, so that its cached layout is used only in the mapping it was built for
+  {
+    Matrix<> A(m, m, SP, dw);
+    A.fill_sp_random(1., 2., .1);
+    Matrix<> D(m, 3, dw);
+    D.fill_random(-1., 1.);
+    for (int it=0; it<3; it++){
+      Vector<> p(m, SP, dw, "p");
+      spmspv_frontier<double>(p, 2+it, 5+it, [](int64_t j){ return 2.-j; });
+      Vector<> p_dn(m, dw);
+      p_dn["i"] = p["i"];
+      Vector<> c(m, dw);
+      Vector<> c_dn(m, dw);
+      c["i"] = A["ij"]*p["j"];
+      c_dn["i"] = A["ij"]*p_dn["j"];
+      c["i"] -= c_dn["i"];
+      if (c.norm2() >= 1.E-6) pass = 0;
+      Matrix<> E(3, m, dw);
+      E["ki"] = D["jk"]*A["ji"];
+    }
+  }
+
+  // relaxation of distances on the tropical semiring, accumulating into the previous distances
+  {
+    Semiring<int> s(m*m,
+                    [](int a, int b){ return std::min(a,b); },
+                    MPI_MIN,
+                    0,
+                    [](int a, int b){ return a+b; });
+    Matrix<int> A(m, m, SP, dw, s);
+    A.fill_sp_random(1, m, .1);
+    Vector<int> d(m, SP, dw, s);
+    spmspv_frontier<int>(d, 3, 11, [](int64_t j){ return (int)(j%5); });
+    Vector<int> d_dn(m, dw, s);
+    d_dn["i"] = d["i"];
+    for (int it=0; it<2; it++){
+      Vector<int> f(m, SP, dw, s);
+      f["i"] = d["i"];
+      d["i"] += A["ij"]*f["j"];
+      Vector<int> f_dn(m, dw, s);
+      f_dn["i"] = d_dn["i"];
+      d_dn["i"] += A["ij"]*f_dn["j"];
+      Vector<int> d_cmp(m, dw, s);
+      d_cmp["i"] = d["i"];
+      if (!check_spmspv(d_cmp, d_dn)) pass = 0;
+    }
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ sparse matrix times sparse vector = sparse matrix times dense vector } passed\n");
+    } else {
+      printf("{ sparse matrix times sparse vector = sparse matrix times dense vector } failed\n");
+    }
+  }
+
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Multiplying sparse matrices by sparse vectors\n");
+    }
+    spmspv(n, dw);
+  }
+
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -17,14 +17,36 @@
 #include "multi_tsr_sym.cxx"
 #include "repack.cxx"
 #include "sy_times_ns.cxx"
+#include "packed_contract.cxx"
 #include "speye.cxx"
 #include "sptensor_sum.cxx"
+#include "spmspv.cxx"
 #include "endomorphism.cxx"
 #include "endomorphism_cust.cxx"
 #include "endomorphism_cust_sp.cxx"
 #include "univar_function.cxx"
 #include "bivar_function.cxx"
 #include "bivar_transform.cxx"
+#ifdef USE_LAPACK
+#include "qr.cxx"
+#endif
+#include "fused_reduction.cxx"
+#include "custom_reduction.cxx"
+#include "schedule.cxx"
+#include "bounded_redist.cxx"
+#include "out_of_core.cxx"
+#include "sparse_merge.cxx"
+#include "sparse_pipeline.cxx"
+#include "op_stats.cxx"
+#include "expr_terms.cxx"
+#include "chain_premap.cxx"
+#include "batched_contraction.cxx"
+#include "sort_tensor.cxx"
+#include "mode_scan.cxx"
+#include "mode_fft.cxx"
+#include "topo_pool.cxx"
+#include "node_comm.cxx"
+#include "redscat_contract.cxx"
 
 #include "../examples/trace.cxx"
 #include "../examples/dft_3D.cxx"
@@ -193,6 +215,10 @@ int main(int argc, char ** argv){
       printf("Testing SY times NS with n = %d:\n",n);
     pass.push_back(sy_times_ns(n,dw));
 
+    if (rank == 0)
+      printf("Testing AS times AS on packed operands with n = %d:\n",n);
+    pass.push_back(packed_contract(n,dw));
+
 #if 0
     if (rank == 0)
       printf("Testing skew-symmetric Strassen's algorithm with n = %d:\n",n*n);
@@ -228,6 +254,10 @@ int main(int argc, char ** argv){
     if (rank == 0)
       printf("Testing sparse identity with n = %d order = %d:\n",n,11);
     pass.push_back(speye(n,11,dw));
+
+    if (rank == 0)
+      printf("Testing sparse matrix times sparse vector with n = %d:\n",n);
+    pass.push_back(spmspv(n,dw));
     
     if (rank == 0)
       printf("Testing endomorphism A_ijkl = A_ijkl^3 with n = %d:\n",n);
@@ -304,6 +334,80 @@ int main(int argc, char ** argv){
     if (rank == 0)
       printf("Testing MP3 calculation using sparse*sparse with %d occupied and %d virtual orbitals:\n",n,2*n);
     pass.push_back(sparse_mp3(2*n,n,dw,.8,1,0,0,0,1));
+
+#ifdef USE_LAPACK
+    if (rank == 0)
+      printf("Testing QR and SVD of %d-by-%d matrix:\n",n*n,n);
+    pass.push_back(qr(n*n,n,dw));
+#endif
+
+    if (rank == 0)
+      printf("Testing fused norms and dot products of order 4 tensors:\n");
+    pass.push_back(fused_reduction(n,dw));
+
+    if (rank == 0)
+      printf("Testing pipelined reductions with a user-defined MPI operator:\n");
+    pass.push_back(custom_reduction(n,dw));
+
+    if (rank == 0)
+      printf("Testing scheduled execution of a DAG of matrix operations:\n");
+    pass.push_back(schedule(n*n,dw));
+
+    if (rank == 0)
+      printf("Testing redistribution of an order 3 tensor with bounded memory:\n");
+    pass.push_back(bounded_redist(n,dw));
+
+    if (rank == 0)
+      printf("Testing a contraction of order 4 tensors backed by memory-mapped files:\n");
+    pass.push_back(out_of_core(n,dw));
+
+    if (rank == 0)
+      printf("Testing summations of large sparse tensors:\n");
+    pass.push_back(sparse_merge(n,dw));
+
+    if (rank == 0)
+      printf("Testing writes of pairs pipelined in small chunks:\n");
+    pass.push_back(sparse_pipeline(n,dw));
+
+    if (rank == 0)
+      printf("Testing statistics recorded for a contraction and a summation:\n");
+    pass.push_back(op_stats(n,dw));
+
+    if (rank == 0)
+      printf("Testing expressions with long index strings and operand chains:\n");
+    pass.push_back(expr_terms(n,dw));
+
+    if (rank == 0)
+      printf("Testing the layout of the last intermediate of a contraction chain:\n");
+    pass.push_back(chain_premap(n,dw));
+
+    if (rank == 0)
+      printf("Testing batches of small contractions:\n");
+    pass.push_back(batched_contraction(n,dw));
+
+    if (rank == 0)
+      printf("Testing distributed sorting and top-k selection of tensor elements:\n");
+    pass.push_back(sort_tensor(n,dw));
+
+    if (rank == 0)
+      printf("Testing prefix scans along tensor modes:\n");
+    pass.push_back(mode_scan(n,dw));
+
+    if (rank == 0)
+      printf("Testing fast Fourier transforms along tensor modes:\n");
+    pass.push_back(mode_fft(n,dw));
+
+    if (rank == 0)
+      printf("Testing contractions on several processor grids with a small topology pool:\n");
+    pass.push_back(topo_pool(n,dw));
+
+    if (rank == 0)
+      printf("Testing exchanges within nodes and node-first processor grids:\n");
+    pass.push_back(node_comm(n,dw));
+
+    if (rank == 0)
+      printf("Testing contractions into replicated outputs reduced by reduce-scatter and gather:\n");
+    pass.push_back(redscat_contract(n,dw));
     
     /*int logn = log2(n)+1;
     if (rank == 0)
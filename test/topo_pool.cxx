@@ -0,0 +1,133 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+/** \addtogroup tests
+  * @{
+  * \defgroup topo_pool topo_pool
+  * @{
+  * \brief tests contractions and summations that cycle through more processor grids than a small
+  *        pool of topology communicators holds against the same operations with the default pool
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int topo_pool(int     n,
+              World & dw){
+
+  // the topologies of a World on a duplicate communicator start out without communicators,
+  // and a pool of one communicator keeps no grid of two or more dimensions alive, so the
+  // contractions keep evicting the communicators of each other's grids and creating them again
+  MPI_Comm cm;
+  MPI_Comm_dup(dw.comm, &cm);
+  int old_ncomm = CTF::set_topo_pool_comms(1);
+  int pass = 1;
+  {
+    World w(cm);
+
+    // matrices of different aspect ratios are contracted on different processor grids
+    int const nshape = 4;
+    int m = 8*n*w.np;
+    int shapes[nshape][3] = {{n, n, n}, {1, m, 1}, {m, n, 2}, {2, m, 2}};
+
+    std::set<std::string> topos;
+    srand48(w.rank*7+3);
+    for (int r=0; r<3; r++){
+      for (int s=0; s<nshape; s++){
+        int ni = shapes[s][0], nk = shapes[s][1], nj = shapes[s][2];
+        Matrix<> A(ni, nk, w);
+        Matrix<> B(nk, nj, w);
+        Matrix<> C(ni, nj, w);
+        A.fill_random(-1., 1.);
+        B.fill_random(-1., 1.);
+        CTF::clear_op_stats();
+        CTF::set_op_stats(true);
+        C["ij"] = A["ik"]*B["kj"];
+        CTF::set_op_stats(false);
+        std::vector<Op_stats> const & st = CTF::get_op_stats();
+        for (int i=0; i<(int)st.size(); i++){
+          topos.insert(st[i].topo);
+        }
+        CTF::clear_op_stats();
+
+        int64_t na, nb, nc;
+        double * a, * b, * c;
+        A.read_all(&na, &a);
+        B.read_all(&nb, &b);
+        C.read_all(&nc, &c);
+        for (int j=0; j<nj; j++){
+          for (int i=0; i<ni; i++){
+            double cij = 0.;
+            for (int k=0; k<nk; k++){
+              cij += a[i+k*ni]*b[k+j*nk];
+            }
+            if (fabs(c[i+j*ni]-cij) >= 1.E-10*nk) pass = 0;
+          }
+        }
+        free(a);
+        free(b);
+        free(c);
+      }
+    }
+    // four processes may be arranged in a line or a square
+    if (w.np == 4 && topos.size() < 2) pass = 0;
+  }
+  CTF::set_topo_pool_comms(old_ncomm);
+  MPI_Comm_free(&cm);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (dw.rank == 0){
+    if (pass){
+      printf("{ operations cycling through a small pool of topology communicators are correct } passed\n");
+    } else {
+      printf("{ operations cycling through a small pool of topology communicators are correct } failed\n");
+    }
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (rank == 0){
+      printf("Contracting matrices on several processor grids with a small topology pool with n = %d\n",n);
+    }
+    topo_pool(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -46,6 +46,36 @@ int univar_function(int     n,
       if (fabs(.5*all_start_data[i]+fquad(.5*all_start_data[i])-all_end_data[i])>=1.E-6) pass =0;
     }
   } 
+
+  // same function with its lambda type as template argument, so it is inlined into the batched kernel
+  auto fq = [](double a){ return a*a*a*a; };
+  Univar_Function<double, double, decltype(fq)> tfun(fq);
+  Tensor<> B(A);
+  Tensor<> C(A);
+  B["ijkl"] += tfun(A["ijkl"]);
+  C["ijkl"] += ufun(A["ijkl"]);
+  C["ijkl"] -= B["ijkl"];
+  if (C.norm2() >= 1.E-6) pass = 0;
+
+  // an inlined endomorphism on local rows longer than FUNC_BLK_SZ, applied to them in one batch
+  auto fe = [](double & a){ a = a*a*a*a; };
+  Endomorphism<double, decltype(fe)> efun(fe);
+  Matrix<> E(FUNC_BLK_SZ*dw.np+3, 2, NS, dw);
+  E.fill_random(-.5, .5);
+  double * e_start_data, * e_end_data;
+  int64_t ne, ne2;
+  E.read_all(&ne, &e_start_data);
+  efun(E["ij"]);
+  E.read_all(&ne2, &e_end_data);
+  if (ne != ne2) pass = 0;
+  else {
+    for (int64_t i=0; i<ne; i++){
+      if (fabs(fquad(e_start_data[i])-e_end_data[i]) >= 1.E-10) pass = 0;
+    }
+  }
+  free(e_start_data);
+  free(e_end_data);
+
   MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
 
   if (dw.rank == 0){